@@ -1,5 +1,5 @@
 /* audispd-pconfig.c --
- * Copyright 2007,2010,2015,2021-23 Red Hat Inc.
+ * Copyright 2007,2010,2015,2021-23,2026 Red Hat Inc.
  * All Rights Reserved.
  *
  * This software may be freely redistributed and/or modified under the
@@ -32,7 +32,9 @@
 #include <stdlib.h>
 #include <libgen.h>
 #include <limits.h>
+#include <ctype.h>
 #include "audispd-pconfig.h"
+#include "audispd-replay.h"
 #include "private.h"
 
 /* Local prototypes */
@@ -73,6 +75,8 @@ static int args_parser(struct nv_pair *nv, int line,
 		plugin_conf_t *config);
 static int format_parser(struct nv_pair *nv, int line,
 		plugin_conf_t *config);
+static int replay_window_parser(struct nv_pair *nv, int line,
+		plugin_conf_t *config);
 static int sanity_check(plugin_conf_t *config, const char *file);
 
 static const struct kw_pair keywords[] =
@@ -83,6 +87,7 @@ static const struct kw_pair keywords[] =
   {"type",                     service_type_parser,		0 },
   {"args",                     args_parser,			-1 },
   {"format",                   format_parser,			0 },
+  {"replay_window",            replay_window_parser,		0 },
   { NULL,                      NULL,				0 }
 };
 
@@ -125,6 +130,8 @@ void clear_pconfig(plugin_conf_t *config)
 	config->checked = 0;
 	config->name = NULL;
 	config->restart_cnt = 0;
+	config->replay_window = 0;
+	config->replay = NULL;
 }
 
 int load_pconfig(plugin_conf_t *config, int dirfd, char *file)
@@ -472,6 +479,57 @@ static int format_parser(struct nv_pair *nv, int line,
 	return 1;
 }
 
+/*
+ * The replay window is given either as a number of events or as a
+ * size in megabytes with an M suffix, such as 4M.
+ */
+#define MAX_REPLAY_EVENTS 1000000
+static int replay_window_parser(struct nv_pair *nv, int line,
+		plugin_conf_t *config)
+{
+	const char *ptr = nv->values[0];
+	unsigned long i;
+	char *end;
+
+	if (!isdigit((unsigned char)*ptr)) {
+		audit_msg(LOG_ERR,
+			"Value %s should only be numbers - line %d",
+			nv->values[0], line);
+		return 1;
+	}
+
+	errno = 0;
+	i = strtoul(ptr, &end, 10);
+	if (errno) {
+		audit_msg(LOG_ERR,
+			"Error converting string to a number (%s) - line %d",
+			strerror(errno), line);
+		return 1;
+	}
+	if (*end == 'M' || *end == 'm') {
+		if (end[1] || i > (MAX_REPLAY_EVENTS * sizeof(event_t)) >> 20) {
+			audit_msg(LOG_ERR,
+				"Value %s is too large or malformed - line %d",
+				nv->values[0], line);
+			return 1;
+		}
+		i = ((i << 20) + sizeof(event_t) - 1) / sizeof(event_t);
+	} else if (*end) {
+		audit_msg(LOG_ERR,
+			"Value %s should only be numbers - line %d",
+			nv->values[0], line);
+		return 1;
+	}
+	if (i > MAX_REPLAY_EVENTS) {
+		audit_msg(LOG_ERR,
+			"Value %s is larger than %d events - line %d",
+			nv->values[0], MAX_REPLAY_EVENTS, line);
+		return 1;
+	}
+	config->replay_window = (unsigned int)i;
+	return 0;
+}
+
 /*
  * This function is where we do the integrated check of the audispd config
  * options. At this point, all fields have been read. Returns 0 if no
@@ -533,6 +591,8 @@ void free_pconfig(plugin_conf_t *config)
 		free(config->args[i]);
 	}
 	free(config->args);
+	replay_destroy(config->replay);
+	config->replay = NULL;
 	if (config->plug_pipe[0] >= 0)
 		close(config->plug_pipe[0]);
 	if (config->plug_pipe[1] >= 0)
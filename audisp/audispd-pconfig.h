@@ -1,5 +1,5 @@
 /* audispd-pconfig.h --
- * Copyright 2007,2013,2023 Red Hat Inc.
+ * Copyright 2007,2013,2023,2026 Red Hat Inc.
  * All Rights Reserved.
  *
  * This software may be freely redistributed and/or modified under the
@@ -45,6 +45,8 @@ typedef struct plugin_conf
 	int checked;		/* Used for internal housekeeping on HUP */
 	char *name;		/* Used to distinguish plugins for HUP */
 	unsigned restart_cnt;	/* Number of times its crashed */
+	unsigned int replay_window; /* Events to hold for redelivery */
+	struct replay_buf *replay; /* Events the plugin may not have read */
 } plugin_conf_t;
 
 void clear_pconfig(plugin_conf_t *config);
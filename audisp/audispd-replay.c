@@ -0,0 +1,253 @@
+/* audispd-replay.c --
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This software may be freely redistributed and/or modified under the
+ * terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING. If not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+ * Boston, MA 02110-1335, USA.
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+#include "audispd-replay.h"
+
+/*
+ * When a plugin dies, whatever was sitting unread in its socket is gone.
+ * The replay window keeps a reference to every event written to the plugin
+ * until the kernel says the plugin has read past it.
+ *
+ * On an AF_UNIX stream socket SIOCOUTQ is not a byte count. It is the
+ * memory charged for the buffers still queued to the reader, which is
+ * several times the payload and is only released once a buffer has been
+ * read completely. So positions are kept in the same units: the queue is
+ * sampled before and after each write and the growth is charged to that
+ * event. If the plugin reads while we write, the charge comes out low.
+ * That only delays confirmation, it never releases an event early. A
+ * restarted plugin may see a few events twice, but never misses one that
+ * is still in the window.
+ */
+
+replay_event_t *replay_event_new(event_t *e)
+{
+	replay_event_t *re = malloc(sizeof(*re));
+
+	if (re == NULL)
+		return NULL;
+	re->e = e;
+	re->refs = 0;
+	return re;
+}
+
+/* Drop a reference. The event is freed once nobody holds it. */
+void replay_event_put(replay_event_t *re)
+{
+	if (re->refs)
+		re->refs--;
+	if (re->refs == 0) {
+		free(re->e);
+		free(re);
+	}
+}
+
+replay_buf_t *replay_create(unsigned int size)
+{
+	replay_buf_t *r;
+
+	if (size == 0)
+		return NULL;
+	r = calloc(1, sizeof(*r));
+	if (r == NULL)
+		return NULL;
+	r->slots = calloc(size, sizeof(replay_slot_t));
+	if (r->slots == NULL) {
+		free(r);
+		return NULL;
+	}
+	r->size = size;
+	return r;
+}
+
+static void pop_oldest(replay_buf_t *r)
+{
+	replay_slot_t *s = &r->slots[r->head];
+
+	replay_event_put(s->re);
+	s->re = NULL;
+	s->end = 0;
+	s->sent = 0;
+	r->head = (r->head + 1) % r->size;
+	r->cnt--;
+}
+
+/* Release every event held without counting them as lost */
+void replay_drop(replay_buf_t *r)
+{
+	while (r->cnt)
+		pop_oldest(r);
+	r->evicted = 0;
+	r->evicted_end = 0;
+	r->evicted_sent = 0;
+	r->written = 0;
+}
+
+/* The plugin is not coming back, so whatever is held is lost */
+void replay_abandon(replay_buf_t *r)
+{
+	r->lost += r->cnt + r->evicted;
+	replay_drop(r);
+}
+
+void replay_destroy(replay_buf_t *r)
+{
+	if (r == NULL)
+		return;
+	replay_drop(r);
+	free(r->slots);
+	free(r);
+}
+
+/*
+ * Add an event to the window before it is written. If the window is full,
+ * the oldest unconfirmed event is evicted. It can no longer be replayed.
+ */
+void replay_push(replay_buf_t *r, replay_event_t *re)
+{
+	unsigned int n;
+
+	if (r->cnt == r->size) {
+		r->evicted++;
+		r->evicted_end = r->slots[r->head].end;
+		r->evicted_sent = r->slots[r->head].sent;
+		pop_oldest(r);
+	}
+	n = (r->head + r->cnt) % r->size;
+	r->slots[n].re = re;
+	r->slots[n].end = 0;
+	r->slots[n].sent = 0;
+	re->refs++;
+	r->cnt++;
+}
+
+/* Take back the newest event because it could not be written */
+void replay_cancel(replay_buf_t *r)
+{
+	replay_slot_t *s;
+
+	if (r->cnt == 0)
+		return;
+	s = &r->slots[(r->head + r->cnt - 1) % r->size];
+	replay_event_put(s->re);
+	s->re = NULL;
+	s->end = 0;
+	s->sent = 0;
+	r->cnt--;
+}
+
+/* Return the memory charged for what is queued to the reader, or -1 */
+long replay_outq(int fd)
+{
+	int outq;
+
+	if (ioctl(fd, SIOCOUTQ, &outq) < 0)
+		return -1;
+	return outq;
+}
+
+/*
+ * Record that the n'th pending event was written to fd. before is what
+ * replay_outq returned just ahead of the write.
+ */
+void replay_wrote(replay_buf_t *r, unsigned int n, long before, int fd)
+{
+	replay_slot_t *s;
+	long after;
+
+	if (n >= r->cnt)
+		return;
+	after = replay_outq(fd);
+	s = &r->slots[(r->head + n) % r->size];
+	if (before < 0 || after < 0)
+		return;		/* Not a socket, it can't be confirmed */
+	r->written += after - before;
+	s->end = r->written;
+	s->sent = 1;
+}
+
+/* Release everything the plugin has read from its end of the socket */
+void replay_confirm(replay_buf_t *r, int fd)
+{
+	long long consumed;
+	long outq = replay_outq(fd);
+
+	if (outq < 0)
+		return;
+	consumed = r->written - outq;
+
+	if (r->evicted && r->evicted_sent && consumed >= r->evicted_end)
+		r->evicted = 0;
+	while (r->cnt && r->slots[r->head].sent &&
+			r->slots[r->head].end <= consumed)
+		pop_oldest(r);
+}
+
+/*
+ * Called when the plugin is found dead. Anything evicted while unconfirmed
+ * is lost. Offsets restart at 0 on the new socket.
+ */
+void replay_failed(replay_buf_t *r)
+{
+	unsigned int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &r->failed);
+	r->lost += r->evicted;
+	r->evicted = 0;
+	r->evicted_end = 0;
+	r->evicted_sent = 0;
+	r->written = 0;
+	for (i = 0; i < r->cnt; i++) {
+		r->slots[(r->head + i) % r->size].end = 0;
+		r->slots[(r->head + i) % r->size].sent = 0;
+	}
+}
+
+void replay_restarted(replay_buf_t *r, unsigned int replayed)
+{
+	struct timespec now;
+	unsigned long usecs;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	usecs = (now.tv_sec - r->failed.tv_sec) * 1000000UL;
+	usecs += now.tv_nsec / 1000;
+	usecs -= r->failed.tv_nsec / 1000;
+	r->last_latency = usecs;
+	if (usecs > r->max_latency)
+		r->max_latency = usecs;
+	r->replayed += replayed;
+}
+
+void replay_write_state(const replay_buf_t *r, FILE *f)
+{
+	fprintf(f, "  replay window size = %u\n", r->size);
+	fprintf(f, "  replay window used = %u\n", r->cnt);
+	fprintf(f, "  events replayed = %lu\n", r->replayed);
+	fprintf(f, "  events lost = %lu\n", r->lost);
+	fprintf(f, "  last restart latency = %lu usecs\n", r->last_latency);
+	fprintf(f, "  max restart latency = %lu usecs\n", r->max_latency);
+}
+
@@ -0,0 +1,88 @@
+/* audispd-replay.h --
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This software may be freely redistributed and/or modified under the
+ * terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING. If not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+ * Boston, MA 02110-1335, USA.
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#ifndef AUDISPD_REPLAY_H
+#define AUDISPD_REPLAY_H
+
+#include <stdio.h>
+#include <time.h>
+#include "libdisp.h"
+
+/* An event that may be held by the replay window of several plugins.
+ * The event is released when the last window lets go of it. */
+typedef struct replay_event {
+	event_t *e;
+	unsigned int refs;
+} replay_event_t;
+
+typedef struct replay_slot {
+	replay_event_t *re;
+	long long end;		/* Socket memory charged up to this event */
+	unsigned char sent;	/* 0 if not written on the current socket */
+} replay_slot_t;
+
+/* Per plugin window of events written but not yet read by the plugin */
+typedef struct replay_buf {
+	replay_slot_t *slots;
+	unsigned int size;		/* Max events held */
+	unsigned int head;		/* Oldest unconfirmed event */
+	unsigned int cnt;		/* Events held */
+	long long written;		/* Socket memory charged by our writes */
+	long long evicted_end;		/* Charged up to the last evicted event */
+	unsigned char evicted_sent;	/* 1 if evicted_end is known */
+	unsigned int evicted;		/* Unconfirmed events pushed out */
+	unsigned long replayed;		/* Events redelivered after restart */
+	unsigned long lost;		/* Events that could not be redelivered */
+	unsigned long last_latency;	/* usecs from failure to redelivery */
+	unsigned long max_latency;
+	struct timespec failed;		/* When the plugin was seen dead */
+} replay_buf_t;
+
+replay_event_t *replay_event_new(event_t *e);
+void replay_event_put(replay_event_t *re);
+
+replay_buf_t *replay_create(unsigned int size);
+void replay_destroy(replay_buf_t *r);
+void replay_push(replay_buf_t *r, replay_event_t *re);
+void replay_cancel(replay_buf_t *r);
+long replay_outq(int fd);
+void replay_wrote(replay_buf_t *r, unsigned int n, long before, int fd);
+void replay_confirm(replay_buf_t *r, int fd);
+void replay_failed(replay_buf_t *r);
+void replay_restarted(replay_buf_t *r, unsigned int replayed);
+void replay_drop(replay_buf_t *r);
+void replay_abandon(replay_buf_t *r);
+void replay_write_state(const replay_buf_t *r, FILE *f);
+
+static inline unsigned int replay_pending(const replay_buf_t *r)
+{
+	return r->cnt;
+}
+
+static inline event_t *replay_nth(const replay_buf_t *r, unsigned int n)
+{
+	return r->slots[(r->head + n) % r->size].re->e;
+}
+
+#endif
+
@@ -1,5 +1,5 @@
 /* audispd.c --
- * Copyright 2007-08,2013,2016-23 Red Hat Inc.
+ * Copyright 2007-08,2013,2016-23,2026 Red Hat Inc.
  * All Rights Reserved.
  *
  * This software may be freely redistributed and/or modified under the
@@ -41,6 +41,7 @@
 #include "audispd-pconfig.h"
 #include "audispd-config.h"
 #include "audispd-llist.h"
+#include "audispd-replay.h"
 #include "queue.h"
 #include "libaudit.h"
 #include "common.h"	// For ATOMIC_LOAD/STORE
@@ -60,6 +61,11 @@ static daemon_conf_t daemon_config;
 static conf_llist plugin_conf;
 static pthread_t outbound_thread;
 static int need_queue_depth_change = 0;
+/* Only the outbound thread changes plugins. It holds this while it links
+ * or frees a plugin or a replay window, and while it updates what the
+ * state report prints, so the report sees neither released memory nor
+ * torn counters. It is never held across a write to a plugin. */
+static pthread_mutex_t plugin_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /* Local function prototypes */
 static void signal_plugins(int sig);
@@ -68,6 +74,7 @@ static int safe_exec(plugin_conf_t *conf);
 static void *outbound_thread_main(void *arg);
 static int write_to_plugin(event_t *e, const char *string, size_t string_len,
 			   lnode *conf) __attr_access ((__read_only__, 2, 3));
+static int replay_to_plugin(lnode *conf);
 
 /*
  * Handle child plugins when they exit
@@ -250,8 +257,10 @@ static int reconfigure(void)
 			/* We have a new service */
 			if (tpconf->p->active == A_YES) {
 				tpconf->p->checked = 1;
+				pthread_mutex_lock(&plugin_lock);
 				plist_last(&plugin_conf);
 				plist_append(&plugin_conf, tpconf->p);
+				pthread_mutex_unlock(&plugin_lock);
 				free(tpconf->p);
 				tpconf->p = NULL;
 				start_one_plugin(plist_get_cur(&plugin_conf));
@@ -272,22 +281,40 @@ static int reconfigure(void)
 						if (opconf->p->pid)
 						  kill(opconf->p->pid, SIGTERM);
 						usleep(50000); // 50 msecs
+						pthread_mutex_lock(&plugin_lock);
+						if (opconf->p->replay)
+						  replay_failed(opconf->p->replay);
+						pthread_mutex_unlock(&plugin_lock);
 						close(opconf->p->plug_pipe[1]);
 						opconf->p->plug_pipe[1] = -1;
 						opconf->p->pid = 0;
-						start_one_plugin(opconf);
+						if (start_one_plugin(opconf) &&
+						    opconf->p->replay)
+						  replay_to_plugin(opconf);
 						opconf->p->inode =
 							tpconf->p->inode;
 					}
 				}
+				/* A new window size takes effect now */
+				if (opconf->p->replay_window !=
+						tpconf->p->replay_window) {
+					pthread_mutex_lock(&plugin_lock);
+					replay_destroy(opconf->p->replay);
+					opconf->p->replay = NULL;
+					opconf->p->replay_window =
+						tpconf->p->replay_window;
+					pthread_mutex_unlock(&plugin_lock);
+				}
 				opconf->p->checked = 1;
 			} else {
 				/* A change in state */
 				if (tpconf->p->active == A_YES) {
 					/* starting - copy config and exec */
+					pthread_mutex_lock(&plugin_lock);
 					free_pconfig(opconf->p);
 					free(opconf->p);
 					opconf->p = tpconf->p;
+					pthread_mutex_unlock(&plugin_lock);
 					opconf->p->checked = 1;
 					start_one_plugin(opconf);
 					tpconf->p = NULL;
@@ -312,6 +339,10 @@ static int reconfigure(void)
 		tpconf->p->plug_pipe[1] = -1;
 		tpconf->p->pid = 0;
 		tpconf->p->checked = 1;
+		pthread_mutex_lock(&plugin_lock);
+		replay_destroy(tpconf->p->replay);
+		tpconf->p->replay = NULL;
+		pthread_mutex_unlock(&plugin_lock);
 	}
 
 	/* Release memory from temp config */
@@ -387,7 +418,10 @@ static void *outbound_thread_main(void *arg)
 
 	/* Start event loop */
 	while (event_loop()) {
-		if (reconfigure() == 0) {
+		int active;
+
+		active = reconfigure();
+		if (active == 0) {
 			audit_msg(LOG_INFO,
 		"After reconfigure, there are no active plugins, exiting");
 			break;
@@ -400,6 +434,7 @@ static void *outbound_thread_main(void *arg)
 	usleep(15000); // 15 milliseconds - let plugins wrap up
 
 	/* Release configs */
+	pthread_mutex_lock(&plugin_lock);
 	plist_first(&plugin_conf);
 	conf = plist_get_cur(&plugin_conf);
 	while (conf) {
@@ -407,6 +442,7 @@ static void *outbound_thread_main(void *arg)
 		conf = plist_next(&plugin_conf);
 	}
 	plist_clear(&plugin_conf);
+	pthread_mutex_unlock(&plugin_lock);
 
 	/* Cleanup the queue */
 	destroy_queue();
@@ -512,14 +548,176 @@ static int write_to_plugin(event_t *e, const char *string, size_t string_len,
 	return rc;
 }
 
-/* Returns 0 on stop, and 1 on HUP */
 static char fmt_buf[FORMAT_BUF_LEN];
+
+/*
+ * Format an event the way plugins expect it. Returns the length of the
+ * string placed in buf, or 0 if the event can't be sent.
+ */
+static int format_event(const event_t *e, char *buf)
+{
+	char *ptr, unknown[32];
+	int len;
+
+	// Protocol 1 is not formatted
+	if (e->hdr.ver == AUDISP_PROTOCOL_VER) {
+		const char *type;
+
+		/* Get the event formatted */
+		type = audit_msg_type_to_name(e->hdr.type);
+		if (type == NULL) {
+			snprintf(unknown, sizeof(unknown),
+				"UNKNOWN[%u]", e->hdr.type);
+			type = unknown;
+		}
+		len = snprintf(buf, FORMAT_BUF_LEN, "type=%s msg=%.*s\n",
+				type, e->hdr.size, e->data);
+	// Protocol 2 events are already formatted - just copy
+	} else if (e->hdr.ver == AUDISP_PROTOCOL_VER2) {
+		size_t to_copy = e->hdr.size;
+
+		if (to_copy > MAX_AUDIT_MESSAGE_LENGTH)
+			to_copy = MAX_AUDIT_MESSAGE_LENGTH;
+
+		// was snprintf, this is faster
+		memcpy(buf, e->data, to_copy);
+
+		buf[to_copy]     = '\n';
+		buf[to_copy + 1] = '\0';
+		len = (int)(to_copy + 1);
+	} else
+		len = 0;
+	if (len <= 0)
+		return 0;
+
+	/* Strip newlines from event record except the last one */
+	ptr = buf;
+	while ((ptr = strchr(ptr, 0x0A)) != NULL) {
+		if (ptr != &buf[len-1])
+			*ptr = ' ';
+		else
+			break; /* Done - exit loop */
+	}
+	return len;
+}
+
+/*
+ * Resend everything in the plugin's replay window. This is called right
+ * after a restart so the new process picks up where the old one stopped.
+ * Returns 0 on success and -1 if the plugin went away again.
+ */
+static char replay_fmt_buf[FORMAT_BUF_LEN];
+static int replay_to_plugin(lnode *conf)
+{
+	replay_buf_t *r = conf->p->replay;
+	unsigned int i, cnt = replay_pending(r);
+
+	for (i = 0; i < cnt; i++) {
+		event_t *e = replay_nth(r, i);
+		long before = replay_outq(conf->p->plug_pipe[1]);
+		int rc, len;
+
+		len = format_event(e, replay_fmt_buf);
+		rc = write_to_plugin(e, replay_fmt_buf, len, conf);
+		if (rc < 0)
+			return -1;
+		pthread_mutex_lock(&plugin_lock);
+		replay_wrote(r, i, before, conf->p->plug_pipe[1]);
+		pthread_mutex_unlock(&plugin_lock);
+	}
+	pthread_mutex_lock(&plugin_lock);
+	replay_restarted(r, cnt);
+	pthread_mutex_unlock(&plugin_lock);
+	if (cnt)
+		audit_msg(LOG_NOTICE, "replayed %u events to plugin %s",
+			  cnt, conf->p->path);
+	return 0;
+}
+
+/*
+ * Send an event to one plugin. If the plugin has died, try to restart it.
+ * Plugins with a replay window get everything they had not read yet,
+ * including this event. Others only get this event again.
+ */
+static void send_to_plugin(event_t *e, replay_event_t *re, int len,
+			   lnode *conf)
+{
+	replay_buf_t *r = conf->p->replay;
+	long before = -1;
+	int rc;
+
+	if (r) {
+		pthread_mutex_lock(&plugin_lock);
+		replay_push(r, re);
+		pthread_mutex_unlock(&plugin_lock);
+		before = replay_outq(conf->p->plug_pipe[1]);
+	}
+
+	rc = write_to_plugin(e, fmt_buf, len, conf);
+	if (rc >= 0) {
+		if (r) {
+			pthread_mutex_lock(&plugin_lock);
+			replay_wrote(r, replay_pending(r) - 1, before,
+				     conf->p->plug_pipe[1]);
+			replay_confirm(r, conf->p->plug_pipe[1]);
+			pthread_mutex_unlock(&plugin_lock);
+		}
+		return;
+	}
+	if (errno != EPIPE) {
+		/* Nothing went out, so there is nothing to confirm */
+		if (r) {
+			pthread_mutex_lock(&plugin_lock);
+			replay_cancel(r);
+			pthread_mutex_unlock(&plugin_lock);
+		}
+		return;
+	}
+
+	/* Child disappeared ? */
+	if (!AUDIT_ATOMIC_LOAD(stop))
+		audit_msg(LOG_ERR, "plugin %s terminated unexpectedly",
+			  conf->p->path);
+	pthread_mutex_lock(&plugin_lock);
+	if (r)
+		replay_failed(r);
+	conf->p->restart_cnt++;
+	pthread_mutex_unlock(&plugin_lock);
+	conf->p->pid = 0;
+	close(conf->p->plug_pipe[1]);
+	conf->p->plug_pipe[1] = -1;
+	conf->p->active = A_NO;
+	if (!AUDIT_ATOMIC_LOAD(stop) &&
+	    conf->p->restart_cnt > daemon_config.max_restarts) {
+		audit_msg(LOG_ERR, "plugin %s has exceeded max_restarts",
+			  conf->p->path);
+		if (r) {
+			pthread_mutex_lock(&plugin_lock);
+			replay_abandon(r);
+			pthread_mutex_unlock(&plugin_lock);
+		}
+	} else if (!AUDIT_ATOMIC_LOAD(stop) && start_one_plugin(conf)) {
+		if (r)
+			replay_to_plugin(conf);
+		else
+			write_to_plugin(e, fmt_buf, len, conf);
+		audit_msg(LOG_NOTICE, "plugin %s was restarted (%ux)",
+			  conf->p->path, conf->p->restart_cnt);
+		conf->p->active = A_YES;
+	} else if (r) {
+		pthread_mutex_lock(&plugin_lock);
+		replay_abandon(r);
+		pthread_mutex_unlock(&plugin_lock);
+	}
+}
+
+/* Returns 0 on stop, and 1 on HUP */
 static int event_loop(void)
 {
 	/* Figure out the format for the af_unix socket */
 	while (AUDIT_ATOMIC_LOAD(stop) == 0) {
 		event_t *e;
-		char *ptr, unknown[32];
+		replay_event_t *re = NULL;
 		int len;
 		lnode *conf;
 
@@ -531,49 +729,12 @@ static int event_loop(void)
 			continue;
 		}
 
-		// Protocol 1 is not formatted
-		if (e->hdr.ver == AUDISP_PROTOCOL_VER) {
-			const char *type;
-
-			/* Get the event formatted */
-			type = audit_msg_type_to_name(e->hdr.type);
-			if (type == NULL) {
-				snprintf(unknown, sizeof(unknown),
-					"UNKNOWN[%u]", e->hdr.type);
-				type = unknown;
-			}
-			len = snprintf(fmt_buf, sizeof(fmt_buf),
-				       "type=%s msg=%.*s\n",
-					type, e->hdr.size, e->data);
-		// Protocol 2 events are already formatted - just copy
-		} else if (e->hdr.ver == AUDISP_PROTOCOL_VER2) {
-			size_t to_copy = e->hdr.size;
-
-			if (to_copy > MAX_AUDIT_MESSAGE_LENGTH)
-				to_copy = MAX_AUDIT_MESSAGE_LENGTH;
-
-			// was snprintf, this is faster
-			memcpy(fmt_buf, e->data, to_copy);
-
-			fmt_buf[to_copy]     = '\n';
-			fmt_buf[to_copy + 1] = '\0';
-			len = (int)(to_copy + 1);
-		} else
-			len = 0;
+		len = format_event(e, fmt_buf);
 		if (len <= 0) {
 			free(e); /* Either corrupted event or no memory */
 			continue;
 		}
 
-		/* Strip newlines from event record except the last one */
-		ptr = fmt_buf;
-		while ((ptr = strchr(ptr, 0x0A)) != NULL) {
-			if (ptr != &fmt_buf[len-1])
-				*ptr = ' ';
-			else
-				break; /* Done - exit loop */
-		}
-
 		/* Distribute event to the plugins */
 		plist_first(&plugin_conf);
 		conf = plist_get_cur(&plugin_conf);
@@ -583,43 +744,40 @@ static int event_loop(void)
 			if (conf->p->active == A_NO || AUDIT_ATOMIC_LOAD(stop))
 				continue;
 
-			/* Now send the event to the child */
-			if (conf->p->type == S_ALWAYS &&
-					!AUDIT_ATOMIC_LOAD(stop)) {
-				int rc;
-				rc = write_to_plugin(e, fmt_buf, len, conf);
-				if (rc < 0 && errno == EPIPE) {
-					/* Child disappeared ? */
-					if (!AUDIT_ATOMIC_LOAD(stop))
-						audit_msg(LOG_ERR,
-					"plugin %s terminated unexpectedly",
-								conf->p->path);
-					conf->p->pid = 0;
-					conf->p->restart_cnt++;
-					close(conf->p->plug_pipe[1]);
-					conf->p->plug_pipe[1] = -1;
-					conf->p->active = A_NO;
-					if (!AUDIT_ATOMIC_LOAD(stop) &&
-					    conf->p->restart_cnt >
-					    daemon_config.max_restarts) {
-						audit_msg(LOG_ERR,
-					"plugin %s has exceeded max_restarts",
-								conf->p->path);
-					} else if (!AUDIT_ATOMIC_LOAD(stop) && start_one_plugin(conf)) {
-						rc = write_to_plugin(e, fmt_buf,
-								     len, conf);
-						audit_msg(LOG_NOTICE,
-						"plugin %s was restarted (%ux)",
-							conf->p->path, conf->p->restart_cnt);
-						conf->p->active = A_YES;
-					}
+			/* Plugins asking for a replay window share the event */
+			if (conf->p->replay_window && conf->p->replay == NULL) {
+				pthread_mutex_lock(&plugin_lock);
+				conf->p->replay =
+					replay_create(conf->p->replay_window);
+				pthread_mutex_unlock(&plugin_lock);
+			}
+			if (conf->p->replay && re == NULL) {
+				re = replay_event_new(e);
+				/* Hold our own reference while distributing.
+				 * A plugin that already read everything lets
+				 * go of the event as soon as it is written. */
+				if (re)
+					re->refs++;
+				else {
+					pthread_mutex_lock(&plugin_lock);
+					replay_destroy(conf->p->replay);
+					conf->p->replay = NULL;
+					pthread_mutex_unlock(&plugin_lock);
 				}
 			}
+
+			/* Now send the event to the child */
+			if (conf->p->type == S_ALWAYS &&
+					!AUDIT_ATOMIC_LOAD(stop))
+				send_to_plugin(e, re, len, conf);
 		} while (!AUDIT_ATOMIC_LOAD(stop) &&
 			 (conf = plist_next(&plugin_conf)));
 
-		/* Done with the memory...release it */
-		free(e);
+		/* Done with the memory...release it unless a window has it */
+		if (re == NULL)
+			free(e);
+		else
+			replay_event_put(re);
 		if (AUDIT_ATOMIC_LOAD(disp_hup))
 			break;
 	}
@@ -673,9 +831,23 @@ void libdisp_reconfigure(const struct daemon_conf *c)
 
 void libdisp_write_queue_state(FILE *f)
 {
+	lnode *conf;
+
 	fprintf(f, "Number of active plugins = %u\n",
 			plist_count(&plugin_conf));
 	write_queue_state(f);
+
+	/* Report on plugins that keep a replay window. The list cursor
+	 * belongs to the outbound thread, so walk the nodes directly. */
+	pthread_mutex_lock(&plugin_lock);
+	for (conf = plugin_conf.head; conf; conf = conf->next) {
+		if (conf->p && conf->p->replay) {
+			fprintf(f, "plugin %s restarts = %u\n",
+				conf->p->path, conf->p->restart_cnt);
+			replay_write_state(conf->p->replay, f);
+		}
+	}
+	pthread_mutex_unlock(&plugin_lock);
 }
 
 void libdisp_resume(void)
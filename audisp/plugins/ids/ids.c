@@ -170,6 +170,9 @@ void output_state(void)
 			fprintf(f, "%s\n\n", metrics);
 			free(metrics);
 		}
+		fprintf(f, "auplugin\n========\n");
+		auplugin_write_metrics(f);
+		fprintf(f, "\n");
 		traverse_origins(f);
 		fprintf(f, "\n");
 		traverse_accounts(f);
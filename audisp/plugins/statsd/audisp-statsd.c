@@ -40,6 +40,7 @@
 
 /* Global Definitions */
 #define STATE_REPORT AUDIT_RUN_DIR"/auditd.state"
+#define METRICS_REPORT AUDIT_RUN_DIR"/audisp-statsd.metrics"
 #define CONFIG "/etc/audit/audisp-statsd.conf"
 
 struct daemon_config
@@ -399,6 +400,7 @@ int main(void)
 		syslog(LOG_ERR, "failed to init auplugin");
 		return 1;
 	}
+	auplugin_metrics_on_sigusr1(METRICS_REPORT);
 
 	auplugin_event_feed(handle_event, d.interval, statsd_timer);
 
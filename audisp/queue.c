@@ -1,5 +1,5 @@
 /* queue.c --
- * Copyright 2007,2013,2015,2018,2022,2025 Red Hat Inc.
+ * Copyright 2007,2013,2015,2018,2022,2025,2026 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -355,6 +355,68 @@ event_t *dequeue_timed(const struct timespec *timeout)
 	return dequeue_common();
 }
 
+/*
+ * Dequeue up to max events into out. The first event is waited for like
+ * dequeue() or dequeue_timed() when timeout is given. After that, whatever
+ * is already queued is taken. If latency is not 0, we keep waiting up to
+ * latency milliseconds past the first event for more to arrive.
+ * Returns the number of events placed in out. When nothing arrives before
+ * timeout, 0 is returned and errno is ETIMEDOUT.
+ */
+unsigned int dequeue_batch(event_t **out, unsigned int max,
+			   const struct timespec *timeout, unsigned int latency)
+{
+	struct timespec deadline;
+	unsigned int cnt = 0;
+	int result;
+
+	if (max == 0)
+		return 0;
+
+	if (timeout) {
+		while ((result = sem_timedwait(&queue_nonempty, timeout)) == -1
+				&& errno == EINTR)
+			;
+	} else {
+		while ((result = sem_wait(&queue_nonempty)) == -1 &&
+				errno == EINTR)
+			;
+	}
+	if (result == -1)
+		return 0;
+
+	if (latency) {
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += latency / 1000;
+		deadline.tv_nsec += (latency % 1000) * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+	}
+
+	do {
+		event_t *e = dequeue_common();
+		if (e)
+			out[cnt++] = e;
+		else if (AUDIT_ATOMIC_LOAD(disp_hup))
+			break;
+		if (cnt == max)
+			break;
+
+		/* Take what is already there */
+		if (sem_trywait(&queue_nonempty) == 0)
+			continue;
+		if (latency == 0)
+			break;
+		while ((result = sem_timedwait(&queue_nonempty,
+					&deadline)) == -1 && errno == EINTR)
+			;
+	} while (result == 0);
+
+	return cnt;
+}
+
 void nudge_queue(void)
 {
 	sem_post(&queue_nonempty);
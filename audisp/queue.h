@@ -1,5 +1,5 @@
 /* queue.h --
- * Copyright 2007,2018,2025 Red Hat Inc.
+ * Copyright 2007,2018,2025,2026 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -45,6 +45,8 @@ int init_queue_extended(unsigned int size, int flags, const char *path);
 int enqueue(event_t *e, struct disp_conf *config);
 event_t *dequeue(void);
 event_t *dequeue_timed(const struct timespec *timeout);
+unsigned int dequeue_batch(event_t **out, unsigned int max,
+			   const struct timespec *timeout, unsigned int latency);
 void nudge_queue(void);
 void increase_queue_depth(unsigned int size);
 void write_queue_state(FILE *f);
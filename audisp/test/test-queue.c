@@ -239,6 +239,75 @@ out_f:
 	return rc;
 }
 
+static int batch_test(const char *logfile)
+{
+	FILE *f = fopen(logfile, "r");
+	char buf[MAX_AUDIT_MESSAGE_LENGTH];
+	event_t *out[4];
+	struct disp_conf conf;
+	struct timespec ts;
+	unsigned int n, total = 0, lines = 0;
+	int rc = 1;
+
+	if (!f) {
+		fprintf(stderr, "batch_test: cannot open %s\n", logfile);
+		return rc;
+	}
+	memset(&conf, 0, sizeof(conf));
+	conf.overflow_action = O_IGNORE;
+
+	if (init_queue(16)) {
+		fprintf(stderr, "batch_test: init_queue failed\n");
+		goto out;
+	}
+
+	while (lines < 10 && fgets(buf, sizeof(buf), f)) {
+		event_t *e = make_event(buf);
+		if (!e || enqueue(e, &conf)) {
+			fprintf(stderr, "batch_test: enqueue failed\n");
+			goto out_q;
+		}
+		lines++;
+	}
+
+	/* Everything queued comes out in groups no bigger than out */
+	while (total < lines) {
+		unsigned int i;
+
+		n = dequeue_batch(out, 4, NULL, 0);
+		if (n == 0 || n > 4) {
+			fprintf(stderr, "batch_test: bad batch size %u\n", n);
+			goto out_q;
+		}
+		for (i = 0; i < n; i++)
+			free(out[i]);
+		total += n;
+	}
+	if (total != lines || queue_current_depth() != 0) {
+		fprintf(stderr, "batch_test: %u of %u dequeued\n",
+			total, lines);
+		goto out_q;
+	}
+
+	/* An empty queue times out */
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_nsec += 10000000;
+	if (ts.tv_nsec >= 1000000000L) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+	if (dequeue_batch(out, 4, &ts, 5) != 0) {
+		fprintf(stderr, "batch_test: empty queue returned events\n");
+		goto out_q;
+	}
+	rc = 0;
+out_q:
+	destroy_queue();
+out:
+	fclose(f);
+	return rc;
+}
+
 int main(void)
 {
 	const char *srcdir = getenv("srcdir") ? getenv("srcdir") : ".";
@@ -251,6 +320,8 @@ int main(void)
 		return 1;
 	if (concurrency_test(path))
 		return 1;
+	if (batch_test(path))
+		return 1;
 	return 0;
 }
 
@@ -0,0 +1,368 @@
+/*
+ * test-replay.c - Test cases for the audispd plugin replay window
+ * Copyright (c) 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This software may be freely redistributed and/or modified under the
+ * terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING. If not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+ * Boston, MA 02110-1335, USA.
+ *
+ * Authors:
+ *   Test cases based on audispd.c usage patterns
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "audispd-replay.h"
+
+static int test_count = 0;
+static int test_passed = 0;
+
+#define TEST_START(name)                      \
+	do {                                      \
+		printf("Running test: %s... ", name); \
+		fflush(stdout);                       \
+		test_count++;                         \
+	} while (0)
+
+#define TEST_PASS()       \
+	do {                  \
+		printf("PASS\n"); \
+		test_passed++;    \
+	} while (0)
+
+#define TEST_FAIL(msg)             \
+	do {                           \
+		printf("FAIL: %s\n", msg); \
+		return 0;                  \
+	} while (0)
+
+static replay_event_t *make_event(unsigned int n)
+{
+	event_t *e = calloc(1, sizeof(*e));
+
+	if (e == NULL)
+		return NULL;
+	e->hdr.ver = AUDISP_PROTOCOL_VER2;
+	e->hdr.size = snprintf(e->data, sizeof(e->data),
+		"type=USER msg=audit(1.000:%u): pid=1\n", n);
+	return replay_event_new(e);
+}
+
+/* Push an event and write it like audispd does */
+static int send_one(replay_buf_t *r, replay_event_t *re, int fd)
+{
+	long before;
+	int rc;
+
+	replay_push(r, re);
+	before = replay_outq(fd);
+	rc = write(fd, re->e->data, re->e->hdr.size);
+	if (rc < 0)
+		return -1;
+	replay_wrote(r, replay_pending(r) - 1, before, fd);
+	replay_confirm(r, fd);
+	return 0;
+}
+
+/*
+ * Test: unread events are held and read events are released
+ */
+static int test_confirm(void)
+{
+	int sv[2];
+	char buf[8192];
+	replay_buf_t *r;
+	unsigned int i;
+
+	TEST_START("confirm");
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+		TEST_FAIL("socketpair failed");
+	r = replay_create(16);
+	if (r == NULL)
+		TEST_FAIL("replay_create failed");
+
+	for (i = 0; i < 4; i++)
+		if (send_one(r, make_event(i), sv[0]))
+			TEST_FAIL("write failed");
+	if (replay_pending(r) != 4)
+		TEST_FAIL("unread events should be held");
+
+	/* Drain the reader side then confirm */
+	while (recv(sv[1], buf, sizeof(buf), MSG_DONTWAIT) > 0)
+		;
+	replay_confirm(r, sv[0]);
+	if (replay_pending(r) != 0)
+		TEST_FAIL("read events should be released");
+
+	replay_destroy(r);
+	close(sv[0]);
+	close(sv[1]);
+	TEST_PASS();
+	return 1;
+}
+
+/*
+ * Test: a plugin that lags behind lets go of what it has read so far.
+ * The socket charges far more than the payload for each write, so this
+ * only works if positions are kept in the same units.
+ */
+static int test_partial_read(void)
+{
+	int sv[2];
+	char buf[8192];
+	replay_buf_t *r;
+	replay_event_t *re[4];
+	size_t want;
+	unsigned int i;
+
+	TEST_START("partial read");
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+		TEST_FAIL("socketpair failed");
+	r = replay_create(16);
+	if (r == NULL)
+		TEST_FAIL("replay_create failed");
+
+	for (i = 0; i < 4; i++) {
+		re[i] = make_event(i);
+		if (send_one(r, re[i], sv[0]))
+			TEST_FAIL("write failed");
+	}
+
+	/* Read the first two events and half of the third */
+	want = re[0]->e->hdr.size + re[1]->e->hdr.size +
+		re[2]->e->hdr.size / 2;
+	if (recv(sv[1], buf, want, MSG_DONTWAIT) != (ssize_t)want)
+		TEST_FAIL("read failed");
+	replay_confirm(r, sv[0]);
+	if (replay_pending(r) != 2)
+		TEST_FAIL("only the events read completely should be released");
+	if (strstr(replay_nth(r, 0)->data, ":2)") == NULL)
+		TEST_FAIL("partly read event should be held");
+
+	/* The rest of the third event */
+	want = re[2]->e->hdr.size - re[2]->e->hdr.size / 2;
+	if (recv(sv[1], buf, want, MSG_DONTWAIT) != (ssize_t)want)
+		TEST_FAIL("read failed");
+	replay_confirm(r, sv[0]);
+	if (replay_pending(r) != 1)
+		TEST_FAIL("third event should be released");
+
+	replay_destroy(r);
+	close(sv[0]);
+	close(sv[1]);
+	TEST_PASS();
+	return 1;
+}
+
+/*
+ * Test: an event that could not be written does not hold up the ones
+ * written after it
+ */
+static int test_cancel(void)
+{
+	int sv[2];
+	char buf[8192];
+	replay_buf_t *r;
+	replay_event_t *re;
+
+	TEST_START("cancel");
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+		TEST_FAIL("socketpair failed");
+	r = replay_create(16);
+	re = make_event(0);
+	if (r == NULL || re == NULL)
+		TEST_FAIL("allocation failed");
+
+	/* The write failed with something other than EPIPE */
+	re->refs++;
+	replay_push(r, re);
+	replay_cancel(r);
+	if (replay_pending(r) != 0 || re->refs != 1)
+		TEST_FAIL("cancelled event should be let go");
+	replay_event_put(re);
+
+	if (send_one(r, make_event(1), sv[0]) ||
+			send_one(r, make_event(2), sv[0]))
+		TEST_FAIL("write failed");
+	while (recv(sv[1], buf, sizeof(buf), MSG_DONTWAIT) > 0)
+		;
+	replay_confirm(r, sv[0]);
+	if (replay_pending(r) != 0 || r->evicted)
+		TEST_FAIL("later events should be released");
+
+	replay_destroy(r);
+	close(sv[0]);
+	close(sv[1]);
+	TEST_PASS();
+	return 1;
+}
+
+/*
+ * Test: a dead plugin gets everything it did not read, eviction is lost
+ */
+static int test_failure(void)
+{
+	int sv[2];
+	replay_buf_t *r;
+	unsigned int i;
+
+	TEST_START("failure");
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv))
+		TEST_FAIL("socketpair failed");
+	r = replay_create(4);
+	if (r == NULL)
+		TEST_FAIL("replay_create failed");
+
+	for (i = 0; i < 6; i++)
+		if (send_one(r, make_event(i), sv[0]))
+			TEST_FAIL("write failed");
+	if (replay_pending(r) != 4)
+		TEST_FAIL("window should be full");
+
+	/* Plugin dies without reading anything */
+	close(sv[1]);
+	replay_failed(r);
+	if (r->lost != 2)
+		TEST_FAIL("evicted events should be counted as lost");
+	if (strstr(replay_nth(r, 0)->data, ":2)") == NULL)
+		TEST_FAIL("oldest held event should be the third one");
+
+	replay_restarted(r, replay_pending(r));
+	if (r->replayed != 4)
+		TEST_FAIL("held events should be counted as replayed");
+
+	replay_abandon(r);
+	if (r->lost != 6 || replay_pending(r))
+		TEST_FAIL("abandoned events should be counted as lost");
+
+	replay_destroy(r);
+	close(sv[0]);
+	TEST_PASS();
+	return 1;
+}
+
+/*
+ * Test: an event shared by two windows lives until both release it
+ */
+static int test_refcount(void)
+{
+	replay_buf_t *r1, *r2;
+	replay_event_t *re;
+
+	TEST_START("refcount");
+	r1 = replay_create(1);
+	r2 = replay_create(2);
+	re = make_event(0);
+	if (!r1 || !r2 || !re)
+		TEST_FAIL("allocation failed");
+
+	replay_push(r1, re);
+	replay_push(r2, re);
+	if (re->refs != 2)
+		TEST_FAIL("event should have 2 references");
+	replay_drop(r1);
+	if (re->refs != 1 || replay_pending(r2) != 1)
+		TEST_FAIL("event should still be held by the second window");
+
+	replay_destroy(r1);
+	replay_destroy(r2);
+	TEST_PASS();
+	return 1;
+}
+
+/*
+ * Test: a plugin that reads everything before the send path confirms lets
+ * go of the event at once. The dispatcher's own reference must keep it
+ * alive for the plugins still to come.
+ */
+static int test_drained_send(void)
+{
+	int sv1[2], sv2[2];
+	char buf[8192];
+	replay_buf_t *r1, *r2;
+	replay_event_t *re;
+	long before;
+
+	TEST_START("drained send");
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv1) ||
+			socketpair(AF_UNIX, SOCK_STREAM, 0, sv2))
+		TEST_FAIL("socketpair failed");
+	r1 = replay_create(4);
+	r2 = replay_create(4);
+	re = make_event(0);
+	if (!r1 || !r2 || !re)
+		TEST_FAIL("allocation failed");
+	re->refs++;	/* Held by the dispatch loop */
+
+	/* The first plugin reads the event before the write is confirmed */
+	replay_push(r1, re);
+	before = replay_outq(sv1[0]);
+	if (write(sv1[0], re->e->data, re->e->hdr.size) < 0)
+		TEST_FAIL("write failed");
+	replay_wrote(r1, replay_pending(r1) - 1, before, sv1[0]);
+	while (recv(sv1[1], buf, sizeof(buf), MSG_DONTWAIT) > 0)
+		;
+	replay_confirm(r1, sv1[0]);
+	if (replay_pending(r1) != 0)
+		TEST_FAIL("read event should be released");
+	if (re->refs != 1)
+		TEST_FAIL("dispatch loop should still hold the event");
+
+	/* The second plugin still gets a live event */
+	if (send_one(r2, re, sv2[0]))
+		TEST_FAIL("write failed");
+	if (replay_pending(r2) != 1 || re->refs != 2)
+		TEST_FAIL("second window should hold the event");
+
+	/* The loop lets go, the second window keeps it */
+	replay_event_put(re);
+	if (strstr(replay_nth(r2, 0)->data, ":0)") == NULL)
+		TEST_FAIL("held event should be intact");
+
+	replay_destroy(r1);
+	replay_destroy(r2);
+	close(sv1[0]);
+	close(sv1[1]);
+	close(sv2[0]);
+	close(sv2[1]);
+	TEST_PASS();
+	return 1;
+}
+
+int main(void)
+{
+	printf("Running audispd replay window tests...\n\n");
+
+	test_confirm();
+	test_partial_read();
+	test_cancel();
+	test_failure();
+	test_refcount();
+	test_drained_send();
+
+	printf("\nTest Results: %d/%d tests passed\n", test_passed, test_count);
+
+	if (test_passed == test_count) {
+		printf("All tests PASSED!\n");
+		return 0;
+	} else {
+		printf("Some tests FAILED!\n");
+		return 1;
+	}
+}
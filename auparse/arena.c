@@ -0,0 +1,92 @@
+/*
+ * arena.c - Per event bump allocator
+ * Copyright (c) 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+static void free_chunks(arena_chunk *c)
+{
+	while (c) {
+		arena_chunk *next = c->next;
+		free(c);
+		c = next;
+	}
+}
+
+/* The current chunk is full. len is already rounded up. */
+void *arena_alloc_slow(arena_t *a, size_t len)
+{
+	arena_chunk *c = a->spare;
+
+	if (c && c->size >= len)
+		a->spare = c->next;
+	else {
+		size_t size = len > ARENA_CHUNK ? len : ARENA_CHUNK;
+
+		c = malloc(sizeof(arena_chunk) + size);
+		if (c == NULL)
+			return NULL;
+		c->size = size;
+		a->chunks++;
+	}
+	c->used = len;
+	c->next = a->head;
+	a->head = c;
+	return c->data;
+}
+
+char *arena_strdup(arena_t *a, const char *s)
+{
+	size_t len = strlen(s) + 1;
+	char *p = arena_alloc(a, len);
+
+	if (p)
+		memcpy(p, s, len);
+	return p;
+}
+
+/* Everything handed out is gone. The chunks are kept for the next use. */
+void arena_reset(arena_t *a)
+{
+	arena_chunk *c = a->head;
+
+	while (c) {
+		arena_chunk *next = c->next;
+
+		c->used = 0;
+		c->next = a->spare;
+		a->spare = c;
+		c = next;
+	}
+	a->head = NULL;
+}
+
+void arena_free(arena_t *a)
+{
+	free_chunks(a->head);
+	free_chunks(a->spare);
+	a->head = NULL;
+	a->spare = NULL;
+}
@@ -0,0 +1,82 @@
+/*
+ * arena.h - Header file for arena.c
+ * Copyright (c) 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#ifndef ARENA_HEADER
+#define ARENA_HEADER
+
+#include "config.h"
+#include "private.h"
+#include <stddef.h>
+
+/*
+ * Bump allocator for everything that lives exactly as long as one event:
+ * the records, their split up copies and the field arrays. Nothing is
+ * freed on its own. arena_reset makes all of it reusable at once and
+ * keeps the chunks so that the next event does not go to the heap.
+ */
+
+#define ARENA_CHUNK 8192
+
+typedef struct arena_chunk {
+	struct arena_chunk *next;
+	size_t size;		// usable bytes in data
+	size_t used;		// bytes handed out
+	char data[];
+} arena_chunk;
+
+typedef struct arena {
+	arena_chunk *head;	// chunks in use, newest first
+	arena_chunk *spare;	// chunks kept by the last reset
+	unsigned long chunks;	// chunks taken from the heap
+} arena_t;
+
+AUDIT_HIDDEN_START
+
+void *arena_alloc_slow(arena_t *a, size_t len);
+char *arena_strdup(arena_t *a, const char *s);
+void arena_reset(arena_t *a);
+void arena_free(arena_t *a);
+
+AUDIT_HIDDEN_END
+
+static inline void arena_init(arena_t *a)
+{
+	a->head = NULL;
+	a->spare = NULL;
+	a->chunks = 0;
+}
+
+static inline void *arena_alloc(arena_t *a, size_t len)
+{
+	arena_chunk *c = a->head;
+
+	len = (len + 7) & ~(size_t)7;
+	if (c && c->size - c->used >= len) {
+		void *p = c->data + c->used;
+		c->used += len;
+		return p;
+	}
+	return arena_alloc_slow(a, len);
+}
+
+#endif
@@ -1,7 +1,7 @@
 /*
  *  auditd-config.c - This is a greatly reduced config file parser
  *
- * Copyright 2007,2014,2016 Red Hat Inc., Durham, North Carolina.
+ * Copyright 2007,2014,2016,2026 Red Hat Inc., Durham, North Carolina.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -228,11 +228,11 @@ static char *get_line(auparse_state_t *au, FILE *f, char *buf, unsigned size,
 static int nv_split(char *buf, struct _pair *nv)
 {
 	/* Get the name part */
-	char *ptr;
+	char *ptr, *saved = NULL;
 
 	nv->name = NULL;
 	nv->value = NULL;
-	ptr = audit_strsplit(buf);
+	ptr = audit_strsplit_r(buf, &saved);
 	if (ptr == NULL)
 		return 0; /* If there's nothing, go to next line */
 	if (ptr[0] == '#')
@@ -240,23 +240,23 @@ static int nv_split(char *buf, struct _pair *nv)
 	nv->name = ptr;
 
 	/* Check for a '=' */
-	ptr = audit_strsplit(NULL);
+	ptr = audit_strsplit_r(NULL, &saved);
 	if (ptr == NULL)
 		return 1;
 	if (strcmp(ptr, "=") != 0)
 		return 2;
 
 	/* get the value */
-	ptr = audit_strsplit(NULL);
+	ptr = audit_strsplit_r(NULL, &saved);
 	if (ptr == NULL)
 		return 1;
 	nv->value = ptr;
 
 	/* Make sure there's nothing else */
-	ptr = audit_strsplit(NULL);
+	ptr = audit_strsplit_r(NULL, &saved);
 	if (ptr) {
 		/* Allow one option, but check that there's not 2 */
-		ptr = audit_strsplit(NULL);
+		ptr = audit_strsplit_r(NULL, &saved);
 		if (ptr)
 			return 1;
 	}
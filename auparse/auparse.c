@@ -1,5 +1,5 @@
 /* auparse.c --
- * Copyright 2006-08,2012-23 Red Hat Inc.
+ * Copyright 2006-08,2012-23,2026 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -27,8 +27,11 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <stdio_ext.h>
 #include <limits.h>
+#include <pthread.h>
 #include "internal.h"
 #include "expression.h"
 #include "auparse.h"
@@ -44,17 +47,22 @@
 static int debug = 0;
 #endif
 
-static time_t	eoe_timeout = EOE_TIMEOUT;
+/*
+ * Each parser takes its end of event timeout from auditd.conf when it is
+ * made. auparse_set_eoe_timeout overrides that for every parser in the
+ * process, so it is the only state here that parsers share.
+ */
+#ifdef HAVE_ATOMIC
+static ATOMIC_INT eoe_timeout_override = 0;
+#else
+static volatile ATOMIC_INT eoe_timeout_override = 0;
+#endif
 
-/* like strchr except string is delimited by length, not null byte */
-static char *strnchr(const char *s, int c, size_t n)
+static inline time_t au_eoe_timeout(const auparse_state_t *au)
 {
-    char *p_char;
-    const char *p_end = s + n;
+	int tmo = AUDIT_ATOMIC_LOAD(eoe_timeout_override);
 
-    for (p_char = (char *)s; p_char < p_end && *p_char != c; p_char++);
-    if (p_char == p_end) return NULL;
-    return p_char;
+	return tmo ? (time_t)tmo : au->eoe_timeout;
 }
 
 static int access_ok(const char *filename)
@@ -71,6 +79,63 @@ static int access_ok(const char *filename)
 #endif
 }
 
+/*
+ * Read only regular files are mapped and their lines are used where they
+ * sit in the mapping. auditd makes logs read only when it rotates them, so
+ * that is where the bulk of the data is. A file that can still be written
+ * may be truncated under us, by logrotate's copytruncate for example, and
+ * touching a mapped page past the new end raises SIGBUS. Those files, pipes,
+ * empty files and anything that can't be mapped are read with plain stdio,
+ * which just sees end of file.
+ */
+#define MAP_READAHEAD	(1024*1024)
+
+static int au_open_source(auparse_state_t *au)
+{
+	const char *path = au->source_list[au->list_idx];
+	struct stat st;
+	void *map;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+			!(st.st_mode & (S_IWUSR|S_IWGRP|S_IWOTH)) &&
+			(unsigned long long)st.st_size <= SIZE_MAX) {
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			close(fd);
+			madvise(map, st.st_size, MADV_SEQUENTIAL);
+			au->map = map;
+			au->map_size = st.st_size;
+			au->map_off = 0;
+			au->map_advised = 0;
+			return 0;
+		}
+	}
+	// No "m", glibc would map the file and the truncation problem is back
+	au->in = fdopen(fd, "r");
+	if (au->in == NULL) {
+		close(fd);
+		return -1;
+	}
+	__fsetlocking(au->in, FSETLOCKING_BYCALLER);
+	return 0;
+}
+
+static void au_close_source(auparse_state_t *au)
+{
+	if (au->map) {
+		munmap(au->map, au->map_size);
+		au->map = NULL;
+	}
+	if (au->in) {
+		fclose(au->in);
+		au->in = NULL;
+	}
+}
+
 static int setup_log_file_array(auparse_state_t *au)
 {
         struct daemon_conf config;
@@ -141,6 +206,54 @@ static int setup_log_file_array(auparse_state_t *au)
 }
 
 
+/*
+ * In flight events are found three ways. Building events are hashed by
+ * their time, serial and node so a new record finds its event directly.
+ * Every in flight event is on a heap ordered by timestamp so the oldest is
+ * at the top. Events are only handed out in timestamp order, so a complete
+ * event waits while an older one is still building. Building events are
+ * also on a timer wheel by second so the eoe timeout only looks at the
+ * events that could have expired. All links are array indexes since the
+ * array moves when it grows.
+ */
+#define LOL_BUCKETS	128
+
+static unsigned int lol_hash(const au_event_t *e)
+{
+	uint32_t h = 2166136261u;
+	const unsigned char *p;
+
+	h = (h ^ (uint32_t)e->serial) * 16777619u;
+	h = (h ^ e->milli) * 16777619u;
+	h = (h ^ (uint32_t)e->sec) * 16777619u;
+	h = (h ^ (uint32_t)((uint64_t)e->sec >> 32)) * 16777619u;
+	if (e->host)
+		for (p = (const unsigned char *)e->host; *p; p++)
+			h = (h ^ *p) * 16777619u;
+	return h ^ (h >> 15);
+}
+
+/* Put every array entry on the free list and empty all the indexes */
+static void au_lol_init_index(au_lol *lol)
+{
+	unsigned int i;
+
+	for (i = 0; i < lol->limit; i++) {
+		lol->array[i].next = i + 1 < lol->limit ? (int)i + 1 : -1;
+		lol->array[i].heap = -1;
+	}
+	lol->free_slot = 0;
+	lol->retired = -1;
+	for (i = 0; i < lol->nbuckets; i++)
+		lol->buckets[i] = -1;
+	lol->building = 0;
+	lol->nheap = 0;
+	for (i = 0; i <= LOL_WHEEL_SLOTS; i++)
+		lol->wheel[i] = -1;
+	lol->wheel_set = 0;
+	lol->maxi = -1;
+}
+
 /*
  * au_lol_create - Create and initialise the base List of List event structure
  * Args:
@@ -156,13 +269,75 @@ static au_lolnode *au_lol_create(au_lol *lol)
 	lol->maxi = -1;
 	if ((lol->array = (au_lolnode *)malloc(sz)) == NULL)
 		return NULL;
+	lol->heap = malloc(ARRAY_LIMIT * sizeof(int));
+	lol->buckets = malloc(LOL_BUCKETS * sizeof(int));
+	if (lol->heap == NULL || lol->buckets == NULL) {
+		free(lol->array);
+		free(lol->heap);
+		free(lol->buckets);
+		lol->array = NULL;
+		lol->heap = NULL;
+		lol->buckets = NULL;
+		return NULL;
+	}
 
 	lol->limit = ARRAY_LIMIT;
+	lol->nbuckets = LOL_BUCKETS;
 	memset(lol->array, 0x00, sz);
+	au_lol_init_index(lol);
 
 	return lol->array;
 }
 
+/*
+ * Events that have been consumed are kept on a short spare list. Their
+ * arenas still hold the chunks from the last event, so building the next
+ * event doesn't go to the heap.
+ */
+#define LOL_SPARE_MAX 32
+
+static event_list_t *au_lol_get_list(au_lol *lol)
+{
+	event_list_t *l = lol->spare;
+
+	if (l) {
+		lol->spare = l->next_spare;
+		lol->nspare--;
+		lol->reused++;
+		l->next_spare = NULL;
+		return l;
+	}
+	l = malloc(sizeof(event_list_t));
+	if (l)
+		aup_list_create(l);
+	return l;
+}
+
+static void au_lol_put_list(au_lol *lol, event_list_t *l)
+{
+	if (lol->nspare < LOL_SPARE_MAX) {
+		aup_list_clear(l);
+		l->next_spare = lol->spare;
+		lol->spare = l;
+		lol->nspare++;
+	} else {
+		aup_list_destroy(l);
+		free(l);
+	}
+}
+
+static void au_lol_free_spares(au_lol *lol)
+{
+	while (lol->spare) {
+		event_list_t *l = lol->spare;
+
+		lol->spare = l->next_spare;
+		aup_list_destroy(l);
+		free(l);
+	}
+	lol->nspare = 0;
+}
+
 /*
  * au_lol_clear - Free or rest the base List of List event structure
  *
@@ -179,117 +354,386 @@ static void au_lol_clear(au_lol *lol, int reset)
 
 	if (lol->array) {
 		for (i = 0; i <= lol->maxi; i++) {
-			if (lol->array[i].l) {
-				aup_list_clear(lol->array[i].l);
-				free(lol->array[i].l);
-			}
+			if (lol->array[i].l)
+				au_lol_put_list(lol, lol->array[i].l);
 		}
 	}
 	if (reset) {
 		/* If resetting, we just zero fields */
-		if (lol->array)
+		if (lol->array) {
 			memset(lol->array, 0x00,
 					lol->limit * sizeof(au_lolnode));
+			au_lol_init_index(lol);
+		}
 		lol->maxi = -1;
 	} else {
 		/* If not resetting, we free everything */
 		if (lol->array) free(lol->array);
 		lol->array = NULL;
+		free(lol->heap);
+		lol->heap = NULL;
+		free(lol->buckets);
+		lol->buckets = NULL;
+		lol->nheap = 0;
 		lol->maxi = -1;
+		au_lol_free_spares(lol);
+	}
+}
+
+/* Heap of in flight events, the oldest timestamp is at index 0 */
+static inline int lol_older(const au_lol *lol, int a, int b)
+{
+	return auparse_timestamp_compare(&lol->array[a].l->e,
+					 &lol->array[b].l->e) < 0;
+}
+
+static void lol_heap_set(au_lol *lol, unsigned int pos, int idx)
+{
+	lol->heap[pos] = idx;
+	lol->array[idx].heap = pos;
+}
+
+static void lol_heap_up(au_lol *lol, unsigned int pos)
+{
+	int idx = lol->heap[pos];
+
+	while (pos) {
+		unsigned int parent = (pos - 1) / 2;
+
+		if (!lol_older(lol, idx, lol->heap[parent]))
+			break;
+		lol_heap_set(lol, pos, lol->heap[parent]);
+		pos = parent;
+	}
+	lol_heap_set(lol, pos, idx);
+}
+
+static void lol_heap_down(au_lol *lol, unsigned int pos)
+{
+	int idx = lol->heap[pos];
+
+	while (1) {
+		unsigned int child = 2 * pos + 1;
+
+		if (child >= lol->nheap)
+			break;
+		if (child + 1 < lol->nheap &&
+		    lol_older(lol, lol->heap[child + 1], lol->heap[child]))
+			child++;
+		if (!lol_older(lol, lol->heap[child], idx))
+			break;
+		lol_heap_set(lol, pos, lol->heap[child]);
+		pos = child;
+	}
+	lol_heap_set(lol, pos, idx);
+}
+
+static int lol_heap_pop(au_lol *lol)
+{
+	int top = lol->heap[0];
+
+	lol->array[top].heap = -1;
+	if (--lol->nheap) {
+		lol_heap_set(lol, 0, lol->heap[lol->nheap]);
+		lol_heap_down(lol, 0);
 	}
+	return top;
+}
+
+/* Timer wheel of building events, one slot per second */
+static void lol_wheel_add(au_lol *lol, int idx, unsigned int slot)
+{
+	au_lolnode *cur = &lol->array[idx];
+
+	cur->wslot = slot;
+	cur->wprev = -1;
+	cur->wnext = lol->wheel[slot];
+	if (cur->wnext >= 0)
+		lol->array[cur->wnext].wprev = idx;
+	lol->wheel[slot] = idx;
+}
+
+static void lol_wheel_del(au_lol *lol, int idx)
+{
+	au_lolnode *cur = &lol->array[idx];
+
+	if (cur->wprev >= 0)
+		lol->array[cur->wprev].wnext = cur->wnext;
+	else
+		lol->wheel[cur->wslot] = cur->wnext;
+	if (cur->wnext >= 0)
+		lol->array[cur->wnext].wprev = cur->wprev;
+}
+
+/* Hash of building events */
+static int lol_hash_grow(au_lol *lol)
+{
+	unsigned int size = lol->nbuckets * 2;
+	int *buckets = malloc(size * sizeof(int));
+	int i;
+
+	if (buckets == NULL)
+		return -1;
+	free(lol->buckets);
+	lol->buckets = buckets;
+	lol->nbuckets = size;
+	memset(buckets, 0xFF, size * sizeof(int));
+	for (i = 0; i <= lol->maxi; i++) {
+		au_lolnode *cur = &lol->array[i];
+		if (cur->status == EBS_BUILDING) {
+			cur->next = buckets[cur->hash & (size - 1)];
+			buckets[cur->hash & (size - 1)] = i;
+		}
+	}
+	return 0;
+}
+
+static void lol_hash_del(au_lol *lol, int idx)
+{
+	int *link = &lol->buckets[lol->array[idx].hash & (lol->nbuckets - 1)];
+
+	while (*link != idx)
+		link = &lol->array[*link].next;
+	*link = lol->array[idx].next;
+}
+
+static int events_are_equal(const au_event_t *e1, const au_event_t *e2)
+{
+	// Check time & serial first since its most likely way
+	// to spot 2 different events
+	if (!(e1->serial == e2->serial && e1->milli == e2->milli &&
+					e1->sec == e2->sec))
+		return 0;
+	// Hmm...same so far, check if both have a host, only a string
+	// compare can tell if they are the same. Otherwise, if only one
+	// of them have a host, they are definitely not the same. Its
+	// a boundary on daemon config.
+	if (e1->host && e2->host) {
+		if (strcmp(e1->host, e2->host))
+			return 0;
+	} else if (e1->host || e2->host)
+		return 0;
+	return 1;
+}
+
+/*
+ * au_lol_find - Find the building event a record belongs to
+ * Args:
+ *  lol	- pointer to memory holding structure (eg the static au_lo variable)
+ *  e	- time stamp of the record
+ *  hash - lol_hash of e
+ * Rtns:
+ *  index of the event in the array or -1 if it is not being built
+ */
+static int au_lol_find(const au_lol *lol, const au_event_t *e,
+		       unsigned int hash)
+{
+	int i = lol->buckets[hash & (lol->nbuckets - 1)];
+
+	while (i >= 0) {
+		const au_lolnode *cur = &lol->array[i];
+		if (cur->hash == hash && events_are_equal(&cur->l->e, e))
+			return i;
+		i = cur->next;
+	}
+	return -1;
 }
 
 /*
  * au_lol_append - Add a new event to our base List of List structure
  *
  * Args:
- *  lol	- pointer to memory holding structure (eg the static au_lo variable)
+ *  au	- the parser state machine
  *  l	- event list structure (which contains an event's constituent records)
+ *  hash - lol_hash of the event's time stamp
  * Rtns:
- *   ptr  - pointer to au_lolnode which holds the event list structure
- *   NULL - failed to reallocate memory
+ *   index of the au_lolnode which holds the event list structure
+ *   -1 - failed to reallocate memory
  */
-static au_lolnode *au_lol_append(au_lol *lol, event_list_t *l)
+static int au_lol_append(auparse_state_t *au, event_list_t *l,
+			 unsigned int hash)
 {
+	au_lol *lol = au->au_lo;
+	au_lolnode *cur;
+	unsigned int slot;
 	int i;
-	size_t new_size;
-	au_lolnode *ptr;
 
-	for (i = 0; i < lol->limit; i++) {
-		au_lolnode *cur = &lol->array[i];
-		if (cur->status == EBS_EMPTY) {
-			cur->l = l;
-			cur->status = EBS_BUILDING;
-			if (i > lol->maxi)
-				lol->maxi = i;
-			return cur;
-		}
-	}
-	/* Over ran the array, make it bigger */
-	new_size = sizeof(au_lolnode) * (lol->limit + ARRAY_LIMIT);
-	ptr = realloc(lol->array, new_size);
-	if (ptr) {
+	if (lol->free_slot < 0) {
+		/* Over ran the array, make it bigger */
+		size_t new_limit = lol->limit + ARRAY_LIMIT;
+		au_lolnode *ptr;
+		int *heap;
+
+		heap = realloc(lol->heap, new_limit * sizeof(int));
+		if (heap == NULL)
+			return -1;
+		lol->heap = heap;
+		ptr = realloc(lol->array, sizeof(au_lolnode) * new_limit);
+		if (ptr == NULL)
+			return -1;
 		lol->array = ptr;
 		memset(&lol->array[lol->limit], 0x00,
 				sizeof(au_lolnode) * ARRAY_LIMIT);
-		lol->array[i].l = l;
-		lol->array[i].status = EBS_BUILDING;
+		for (i = lol->limit; i < (int)new_limit; i++) {
+			lol->array[i].next = i + 1 < (int)new_limit ? i + 1 :-1;
+			lol->array[i].heap = -1;
+		}
+		lol->free_slot = lol->limit;
+		lol->limit = new_limit;
+	}
+	if (lol->building >= lol->nbuckets && lol_hash_grow(lol))
+		return -1;
+
+	i = lol->free_slot;
+	cur = &lol->array[i];
+	lol->free_slot = cur->next;
+	if (i > lol->maxi)
 		lol->maxi = i;
-		lol->limit += ARRAY_LIMIT;
+	cur->l = l;
+	cur->status = EBS_BUILDING;
+	cur->hash = hash;
+	cur->next = lol->buckets[hash & (lol->nbuckets - 1)];
+	lol->buckets[hash & (lol->nbuckets - 1)] = i;
+	lol->building++;
+
+	if (lol->wheel_set && l->e.sec <= lol->wheel_time)
+		slot = LOL_WHEEL_LATE;
+	else
+		slot = l->e.sec & (LOL_WHEEL_SLOTS - 1);
+	lol_wheel_add(lol, i, slot);
+
+	lol_heap_set(lol, lol->nheap, i);
+	lol_heap_up(lol, lol->nheap++);
+	return i;
+}
+
+/*
+ * au_lol_complete - Mark a building event COMPLETE
+ * Args:
+ *  au	- the parser state machine
+ *  idx - the event's index in the array
+ *  eoe - non-zero if a last record ended it, zero for timeouts
+ * Rtns:
+ *	void
+ */
+static void au_lol_complete(auparse_state_t *au, int idx, int eoe)
+{
+	au_lol *lol = au->au_lo;
+
+	lol_hash_del(lol, idx);
+	lol_wheel_del(lol, idx);
+	lol->building--;
+	lol->array[idx].status = EBS_COMPLETE;
+	au->au_ready++;
+	if (eoe)
+		au->eoe_complete++;
+	else
+		au->timeout_complete++;
+}
+
+/*
+ * au_lol_release - Free the events that have been handed out
+ *
+ * Args:
+ *  au	- the parser state machine
+ * Rtns:
+ *	void
+ */
+static void au_lol_release(auparse_state_t *au)
+{
+	au_lol *lol = au->au_lo;
+
+	while (lol->retired >= 0) {
+		au_lolnode *cur = &lol->array[lol->retired];
+		int next = cur->next;
+
+		au_lol_put_list(lol, cur->l);
+		au->le = NULL;	// this should crash any usage
+				// of au->le until reset
+		cur->l = NULL;
+		cur->next = lol->free_slot;
+		lol->free_slot = lol->retired;
+		lol->retired = next;
 	}
-	return ptr;
 }
 
 /*
- * au_get_ready_event - Find the next COMPLETE event in our list and mark EMPTY
+ * au_get_ready_event - Take the oldest event if it is COMPLETE and mark EMPTY
  *
  * Args:
- *  lol	- pointer to memory holding structure (eg the static au_lo variable)
- *  is_test - do not mark the node EMPTY
+ *  au	- the parser state machine
  * Rtns:
- *  ptr	- pointer to complete node (possibly just marked empty)
- *  NULL - no complete nodes exist
+ *  ptr	- pointer to complete node (just marked empty)
+ *  NULL - the oldest event is still building or there are no events
  */
-static event_list_t *au_get_ready_event(auparse_state_t *au, int is_test)
+static event_list_t *au_get_ready_event(auparse_state_t *au)
 {
-        int i;
 	au_lol *lol = au->au_lo;
-	au_lolnode *lowest = NULL;
+	au_lolnode *cur;
+	int idx;
 
 	if (au->au_ready == 0) {
 		//if (debug) printf("No events ready\n");
 		return NULL;
 	}
 
-        for (i=0; i<=lol->maxi; i++) {
-		// Look for the event with the lowest timestamp
-                au_lolnode *cur = &(lol->array[i]);
-		if (cur->status == EBS_EMPTY)
-			continue;
-		// If we are just testing for a complete event, return
-		if (is_test && cur->status == EBS_COMPLETE)
-			return cur->l;
-		if (lowest == NULL)
-			lowest = cur;
-		else if (auparse_timestamp_compare(&(lowest->l->e),
-							 &(cur->l->e)) == 1)
-			lowest = cur;
-        }
+	cur = &lol->array[lol->heap[0]];
+	if (cur->status != EBS_COMPLETE)
+		return NULL;
 
-	if (lowest && lowest->status == EBS_COMPLETE) {
-		lowest->status = EBS_EMPTY;
-		au->au_ready--;
-		return lowest->l;
-	}
+	idx = lol_heap_pop(lol);
+	cur->status = EBS_EMPTY;
+	au->au_ready--;
+	/* The caller uses the list until the next call to au_lol_release */
+	cur->next = lol->retired;
+	lol->retired = idx;
+	return cur->l;
+}
+
+/*
+ * au_lol_take - Take custody of the event au_get_ready_event just handed out
+ *
+ * Args:
+ *  au	- the parser state machine
+ * Rtns:
+ *  the event, which is no longer freed by au_lol_release
+ */
+static event_list_t *au_lol_take(auparse_state_t *au)
+{
+	au_lol *lol = au->au_lo;
+	au_lolnode *cur = &lol->array[lol->retired];
+	event_list_t *l = cur->l;
+	int idx = lol->retired;
+
+	lol->retired = cur->next;
+	cur->l = NULL;
+	cur->next = lol->free_slot;
+	lol->free_slot = idx;
+	au->le = NULL;
+	return l;
+}
+
+/* Complete the events in a wheel slot that are at least limit seconds old */
+static void au_wheel_expire(auparse_state_t *au, unsigned int slot,
+			    time_t limit)
+{
+	au_lol *lol = au->au_lo;
+	int i = lol->wheel[slot];
 
-        return NULL;
+	while (i >= 0) {
+		int next = lol->array[i].wnext;
+
+		if (lol->array[i].l->e.sec <= limit)
+			au_lol_complete(au, i, 0);
+		i = next;
+	}
 }
 
 /*
- * au_check_events  - Run though all events marking those we can mark COMPLETE
+ * au_check_events  - Mark COMPLETE the events that the eoe timeout has ended
  *
  * Args:
- *  lol	- pointer to memory holding structure (eg the static au_lo variable)
+ *  au	- the parser state machine
  *  sec	- time of current event from stream being processed. We use this to see
  *        how old the events are we have in our list
  * Rtns:
@@ -297,49 +741,86 @@ static event_list_t *au_get_ready_event(auparse_state_t *au, int is_test)
  */
 static void au_check_events(auparse_state_t *au, time_t sec)
 {
-	rnode *r;
-        int i;
 	au_lol *lol = au->au_lo;
+	time_t limit = sec - au_eoe_timeout(au), t;
 
-        for(i=0; i<=lol->maxi; i++) {
-                au_lolnode *cur = &lol->array[i];
-                if (cur->status == EBS_BUILDING) {
-                        if ((r = aup_list_get_cur(cur->l)) == NULL)
-				continue;
-                        // If eoe_timeout seconds have elapsed, we are done
-                        if (cur->l->e.sec + eoe_timeout <= sec) {
-                                cur->status = EBS_COMPLETE;
-				au->au_ready++;
-                        } else if (audit_is_last_record(r->type)) {
-                                // If known to be 1 record event, we are done
-				cur->status = EBS_COMPLETE;
-				au->au_ready++;
-                        }
-                }
-        }
+	if (!lol->wheel_set || limit - lol->wheel_time >= LOL_WHEEL_SLOTS) {
+		for (t = 0; t < LOL_WHEEL_SLOTS; t++)
+			au_wheel_expire(au, t, limit);
+		lol->wheel_time = limit;
+		lol->wheel_set = 1;
+	} else {
+		/* Only the slots the wheel turns past can hold expired events */
+		for (t = lol->wheel_time + 1; t <= limit; t++)
+			au_wheel_expire(au, t & (LOL_WHEEL_SLOTS - 1), limit);
+		if (limit > lol->wheel_time)
+			lol->wheel_time = limit;
+	}
+	au_wheel_expire(au, LOL_WHEEL_LATE, limit);
+}
+
+/*
+ * au_check_last_record - Mark an event COMPLETE if its newest record ends it
+ *
+ * Args:
+ *  au	- the parser state machine
+ *  idx	- the event's index in the array
+ * Rtns:
+ *	void
+ */
+static void au_check_last_record(auparse_state_t *au, int idx)
+{
+	au_lolnode *cur = &au->au_lo->array[idx];
+	rnode *r;
+
+	if (cur->status != EBS_BUILDING)
+		return;
+	if ((r = aup_list_get_cur(cur->l)) == NULL)
+		return;
+	// If known to be 1 record event, we are done
+	if (audit_is_last_record(r->type))
+		au_lol_complete(au, idx, 1);
+}
+
+/*
+ * au_age_events - Mark COMPLETE the events older than the eoe timeout
+ *
+ * Args:
+ *  au	- the parser state machine
+ *  sec	- the current time
+ * Rtns:
+ *	void
+ *
+ * Unlike au_check_events, the wheel is not moved. The wall clock can be far
+ * ahead of the times in the stream and events still need to land in the
+ * right slot after this.
+ */
+static void au_age_events(auparse_state_t *au, time_t sec)
+{
+	unsigned int slot;
+
+	for (slot = 0; slot <= LOL_WHEEL_SLOTS; slot++)
+		au_wheel_expire(au, slot, sec - au_eoe_timeout(au));
 }
 
 /*
  * au_terminate_all_events - Mark all events in 'BUILD' state to be COMPLETE
  *
  * Args:
- *  lol	- pointer to memory holding structure (eg the static au_lo variable)
+ *  au	- the parser state machine
  * Rtns:
  *  void
  */
 static void au_terminate_all_events(auparse_state_t *au)
 {
-        int i;
 	au_lol *lol = au->au_lo;
+	unsigned int slot;
 
-        for (i=0; i<=lol->maxi; i++) {
-                au_lolnode *cur = &lol->array[i];
-                if (cur->status == EBS_BUILDING) {
-                        cur->status = EBS_COMPLETE;
-			au->au_ready++;
-			//if (debug) printf("%d events complete\n", au->au_ready);
-                }
-        }
+	for (slot = 0; slot <= LOL_WHEEL_SLOTS; slot++) {
+		while (lol->wheel[slot] >= 0)
+			au_lol_complete(au, lol->wheel[slot], 0);
+	}
+	//if (debug) printf("%d events complete\n", au->au_ready);
 }
 
 #ifdef	LOL_EVENTS_DEBUG01
@@ -403,35 +884,711 @@ void print_lol(char *label, au_lol *lol)
 					lol_status(lol->array[i].status));
 		print_list_t(lol->array[i].l);
 	}
-	if (lol->maxi >= 0)
-		printf("\n");
+	if (lol->maxi >= 0)
+		printf("\n");
+}
+#endif	/* LOL_EVENTS_DEBUG01 */
+
+
+/* General functions that affect operation of the library */
+
+/*
+ * au_setup_userspace_configitems - load userspace configuration items from auditd.conf
+ *
+ * Args:
+ *  au - pointer to auparseing state structure
+ *
+ * Rtns:
+ *      void
+ */
+static void au_setup_userspace_configitems(auparse_state_t *au)
+{
+	struct daemon_conf config;
+
+	/* Load config so we know where logs are */
+	if (secure_getenv("AUPARSE_DEBUG"))
+		set_aumessage_mode(au, MSG_STDERR, DBG_NO);
+	aup_load_config(au, &config, TEST_SEARCH);
+
+	au->eoe_timeout = (time_t)config.end_of_event_timeout;
+
+	aup_free_config(&config);
+}
+
+/*
+ * Parallel file parsing. Each file of an AUSOURCE_LOGS or
+ * AUSOURCE_FILE_ARRAY source gets its own parser. Worker threads take the
+ * files in order and queue the completed events of each one. The caller's
+ * thread merges the queues by timestamp. A file that a worker has not
+ * started yet is taken to hold later events than the files being parsed.
+ *
+ * An event cut by a file boundary comes out of more than one parser. What a
+ * parser still had building at the end of its file, without a last record,
+ * is queued apart as open. The merge joins an open event with the events of
+ * the same time, serial and node anywhere in the next file's queue, and if
+ * that file did not time it out, carries it on to the file after. So the
+ * parts meet, an open event waits until the next file's parser is done
+ * with its second, and any other event waits until the parsers of all the
+ * files before it are. A worker normally stops when its queue is full,
+ * but if the merge is waiting on that file the queue is let grow, however
+ * far apart the parts of an event are.
+ */
+#define PAR_QUEUE_MAX 2048
+
+struct au_par_stream {
+	auparse_state_t *au;	/* parser for this file */
+	event_list_t *head;	/* completed events, linked by next_spare */
+	event_list_t *tail;
+	event_list_t *open;	/* events the end of the file left open */
+	event_list_t *open_tail;
+	unsigned int count;	/* events queued */
+	time_t expired;		/* events up to this second are all queued */
+	int started;		/* a worker took this file */
+	int done;		/* the worker reached its end */
+	int grow;		/* the merge waits on this file, ignore the limit */
+};
+
+struct au_par {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;	/* broadcast whenever a stream changes */
+	pthread_t *threads;
+	unsigned int nthreads;
+	struct au_par_stream *streams;
+	unsigned int nstreams;
+	unsigned int next_stream; /* next file for a worker to take */
+	int stop;		/* workers should quit */
+	int error;		/* a parser returned an error */
+	event_list_t *cur;	/* event handed to the caller */
+};
+
+static int au_auparse_next_event(auparse_state_t *au);
+
+static void au_par_free_list(event_list_t *l)
+{
+	aup_list_destroy(l);
+	free(l);
+}
+
+/* Can the event l be continued by an event with the same time stamp? */
+static int au_par_can_join(event_list_t *l)
+{
+	rnode *r = l->head;
+
+	if (r == NULL)
+		return 0;
+	while (r->next)
+		r = r->next;
+	return !audit_is_last_record(r->type);
+}
+
+/* Every event of a parser up to this second has been handed out */
+static time_t au_par_expired(const auparse_state_t *au)
+{
+	const au_lol *lol = au->au_lo;
+	time_t t;
+
+	if (!lol->wheel_set)
+		return 0;
+	// Events still building or waiting their turn hold it back
+	t = lol->wheel_time;
+	if (lol->nheap && lol->array[lol->heap[0]].l->e.sec <= t)
+		t = lol->array[lol->heap[0]].l->e.sec - 1;
+	return t;
+}
+
+static void *au_par_worker(void *arg)
+{
+	struct au_par *par = arg;
+
+	while (1) {
+		struct au_par_stream *s;
+		unsigned int idx;
+		int rc;
+
+		pthread_mutex_lock(&par->lock);
+		if (par->stop || par->next_stream >= par->nstreams) {
+			pthread_mutex_unlock(&par->lock);
+			break;
+		}
+		idx = par->next_stream++;
+		s = &par->streams[idx];
+		s->started = 1;
+		pthread_cond_broadcast(&par->cond);
+		pthread_mutex_unlock(&par->lock);
+
+		while ((rc = au_auparse_next_event(s->au)) > 0) {
+			event_list_t *l = au_lol_take(s->au);
+			rnode *r;
+			time_t t;
+			int open;
+
+			// Records point at the caller's file list
+			for (r = l->head; r; r = r->next)
+				r->list_idx = idx;
+			l->next_spare = NULL;
+			// Past the end of the file, it may go on in the next
+			open = s->au->list_idx && au_par_can_join(l);
+
+			pthread_mutex_lock(&par->lock);
+			if (!open && s->count >= PAR_QUEUE_MAX) {
+				// The merge may be waiting for this file to fill
+				pthread_cond_broadcast(&par->cond);
+				while (s->count >= PAR_QUEUE_MAX && !s->grow &&
+				       !par->stop)
+					pthread_cond_wait(&par->cond, &par->lock);
+			}
+			if (par->stop) {
+				pthread_mutex_unlock(&par->lock);
+				au_par_free_list(l);
+				break;
+			}
+			if (open) {
+				if (s->open_tail)
+					s->open_tail->next_spare = l;
+				else
+					s->open = l;
+				s->open_tail = l;
+			} else if (s->tail) {
+				s->tail->next_spare = l;
+				s->tail = l;
+				s->count++;
+			} else {
+				// The merge may be waiting on this file
+				s->head = s->tail = l;
+				s->count++;
+				pthread_cond_broadcast(&par->cond);
+			}
+			t = au_par_expired(s->au);
+			if (t > s->expired) {
+				s->expired = t;
+				pthread_cond_broadcast(&par->cond);
+			}
+			pthread_mutex_unlock(&par->lock);
+		}
+
+		pthread_mutex_lock(&par->lock);
+		s->done = 1;
+		if (rc < 0)
+			par->error = 1;
+		pthread_cond_broadcast(&par->cond);
+		pthread_mutex_unlock(&par->lock);
+	}
+	return NULL;
+}
+
+/* Stop the workers and free everything they made */
+static void au_par_stop(auparse_state_t *au)
+{
+	struct au_par *par = au->par;
+	unsigned int i;
+
+	if (par == NULL)
+		return;
+
+	pthread_mutex_lock(&par->lock);
+	par->stop = 1;
+	pthread_cond_broadcast(&par->cond);
+	pthread_mutex_unlock(&par->lock);
+	for (i = 0; i < par->nthreads; i++)
+		pthread_join(par->threads[i], NULL);
+
+	for (i = 0; i < par->nstreams; i++) {
+		struct au_par_stream *s = &par->streams[i];
+
+		while (s->head) {
+			event_list_t *l = s->head;
+
+			s->head = l->next_spare;
+			au_par_free_list(l);
+		}
+		while (s->open) {
+			event_list_t *l = s->open;
+
+			s->open = l->next_spare;
+			au_par_free_list(l);
+		}
+		if (s->au)
+			auparse_destroy_ext(s->au, AUPARSE_DESTROY_COMMON);
+	}
+	if (par->cur)
+		au_par_free_list(par->cur);
+	au->le = NULL;
+	pthread_mutex_destroy(&par->lock);
+	pthread_cond_destroy(&par->cond);
+	free(par->threads);
+	free(par->streams);
+	free(par);
+	au->par = NULL;
+}
+
+static void au_proj_free(aup_proj_t *p)
+{
+	unsigned int i;
+
+	if (p == NULL)
+		return;
+	free(p->types);
+	for (i = 0; i < p->nfields; i++)
+		free(p->fields[i]);
+	free(p->fields);
+	free(p);
+}
+
+static int au_proj_cmp_type(const void *a, const void *b)
+{
+	int x = *(const int *)a, y = *(const int *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Make a projection from ntypes types and nfields fields */
+static aup_proj_t *au_proj_new(const int *types, unsigned int ntypes,
+			       char * const *fields, unsigned int nfields)
+{
+	aup_proj_t *p = calloc(1, sizeof(*p));
+	unsigned int i;
+
+	if (p == NULL)
+		return NULL;
+	if (types) {
+		p->types = malloc((ntypes ? ntypes : 1) * sizeof(int));
+		if (p->types == NULL)
+			goto err;
+		memcpy(p->types, types, ntypes * sizeof(int));
+		qsort(p->types, ntypes, sizeof(int), au_proj_cmp_type);
+		p->ntypes = ntypes;
+	}
+	if (fields) {
+		p->fields = calloc(nfields ? nfields : 1, sizeof(char *));
+		if (p->fields == NULL)
+			goto err;
+		for (i = 0; i < nfields; i++) {
+			p->fields[i] = strdup(fields[i]);
+			if (p->fields[i] == NULL)
+				goto err;
+			p->nfields++;
+		}
+	}
+	return p;
+err:
+	au_proj_free(p);
+	return NULL;
+}
+
+/*
+ * Make a parser for each file and start the workers. Returns 0 on success
+ * and -1 if anything failed, in which case the files are read serially.
+ */
+static int au_par_start(auparse_state_t *au)
+{
+	struct au_par *par;
+	unsigned int i, n = 0;
+
+	while (au->source_list[n])
+		n++;
+	if (n < 2)
+		return -1;
+
+	par = calloc(1, sizeof(*par));
+	if (par == NULL)
+		return -1;
+	par->nstreams = n;
+	par->nthreads = au->par_threads < n ? au->par_threads : n;
+	par->streams = calloc(n, sizeof(struct au_par_stream));
+	par->threads = calloc(par->nthreads, sizeof(pthread_t));
+	pthread_mutex_init(&par->lock, NULL);
+	pthread_cond_init(&par->cond, NULL);
+	au->par = par;
+	if (par->streams == NULL || par->threads == NULL)
+		goto err;
+
+	for (i = 0; i < n; i++) {
+		par->streams[i].au = auparse_init(AUSOURCE_FILE,
+						  au->source_list[i]);
+		if (par->streams[i].au == NULL)
+			break;
+		par->streams[i].au->eoe_timeout = au->eoe_timeout;
+		par->streams[i].au->keep_eoe = 1;
+		if (au->proj) {
+			aup_proj_t *p = au->proj;
+
+			par->streams[i].au->proj = au_proj_new(p->types,
+					p->ntypes, p->fields, p->nfields);
+			if (par->streams[i].au->proj == NULL) {
+				i++;
+				break;
+			}
+		}
+	}
+	if (i < n)
+		goto err;
+
+	for (i = 0; i < par->nthreads; i++) {
+		if (pthread_create(&par->threads[i], NULL, au_par_worker, par))
+			break;
+	}
+	if (i < par->nthreads) {
+		par->nthreads = i;
+		goto err;
+	}
+	return 0;
+err:
+	au_par_stop(au);
+	return -1;
+}
+
+/* Find the event with the same time, serial and node as e in a queue */
+static event_list_t **au_par_find(event_list_t **link, const au_event_t *e)
+{
+	for (; *link; link = &(*link)->next_spare)
+		if (events_are_equal(&(*link)->e, e))
+			return link;
+	return NULL;
+}
+
+/* Take the event link points at off the queue of stream s */
+static event_list_t *au_par_unlink(struct au_par *par,
+				   struct au_par_stream *s, event_list_t **link)
+{
+	event_list_t *l = *link;
+
+	// Wake the worker if it was waiting for room
+	if (s->count == PAR_QUEUE_MAX)
+		pthread_cond_broadcast(&par->cond);
+	if (s->count <= PAR_QUEUE_MAX)
+		s->grow = 0;
+	*link = l->next_spare;
+	if (s->tail == l) {
+		for (s->tail = s->head; s->tail && s->tail->next_spare;
+		     s->tail = s->tail->next_spare)
+			;
+	}
+	s->count--;
+	l->next_spare = NULL;
+	return l;
+}
+
+/* Is the parser of stream s done with the events of second sec? */
+static int au_par_past(const struct au_par_stream *s, time_t sec)
+{
+	return s->done || sec <= s->expired;
+}
+
+/*
+ * The merge can't go on until the parser of stream s gets further, so its
+ * queue may grow past the limit. A file not started yet needs a worker,
+ * and those are only freed by finishing the files they have.
+ */
+static void au_par_need(struct au_par *par, struct au_par_stream *s)
+{
+	unsigned int i;
+
+	if (s->started) {
+		s->grow = 1;
+		return;
+	}
+	for (i = 0; i < par->nstreams; i++)
+		if (par->streams[i].started)
+			par->streams[i].grow = 1;
+}
+
+/* Is l only the EOE of an event that ended in another file? */
+static int au_par_lone_eoe(const event_list_t *l)
+{
+	return l->cnt == 1 && l->head->type == AUDIT_EOE;
+}
+
+/*
+ * Join onto l its parts queued by stream s. The parser there hands out an
+ * EOE that follows a last record on its own, so that goes on last and only
+ * if nothing else ended the event.
+ */
+static void au_par_join(struct au_par *par, event_list_t *l,
+			struct au_par_stream *s)
+{
+	event_list_t **link;
+	int eoe;
+
+	for (eoe = 0; eoe < 2; eoe++) {
+		link = &s->head;
+		while (au_par_can_join(l) &&
+		       (link = au_par_find(link, &l->e))) {
+			if (au_par_lone_eoe(*link) == eoe)
+				aup_list_join(l, au_par_unlink(par, s, link));
+			else
+				link = &(*link)->next_spare;
+		}
+	}
+}
+
+/* Join the head of stream i onto the open event of the file before it */
+static void au_par_stitch(struct au_par *par, unsigned int i)
+{
+	struct au_par_stream *s = &par->streams[i];
+	event_list_t **link;
+
+	while (s->head && (link = au_par_find(&par->streams[i - 1].open,
+					       &s->head->e)) &&
+						au_par_can_join(*link))
+		au_par_join(par, *link, s);
+}
+
+/*
+ * The open event l goes on past the end of the file of stream s. It takes
+ * the place of what s left open of it, or joins the others in time order.
+ */
+static void au_par_carry(struct au_par_stream *s, event_list_t *l)
+{
+	event_list_t **link = au_par_find(&s->open, &l->e);
+
+	if (link) {
+		l->next_spare = (*link)->next_spare;
+		(*link)->next_spare = NULL;
+		aup_list_join(l, *link);
+	} else {
+		for (link = &s->open; *link && auparse_timestamp_compare(
+				&(*link)->e, &l->e) < 0;
+		     link = &(*link)->next_spare)
+			;
+		l->next_spare = *link;
+	}
+	if (l->next_spare == NULL)
+		s->open_tail = l;
+	*link = l;
+}
+
+/*
+ * au_par_next_event - Merge the next event out of the worker queues
+ * Args:
+ * 	au - the parser state machine
+ * Rtns:
+ *	< 0	- error
+ *	== 0	- no more events
+ *	> 0	- we have an event and it's set to the 'current event' au->le
+ */
+static int au_par_next_event(auparse_state_t *au)
+{
+	struct au_par *par = au->par;
+	struct au_par_stream *best, *next;
+	event_list_t *l;
+	unsigned int i, cnt;
+	int open, ready;
+	rnode *r;
+
+	if (par->cur) {
+		au_par_free_list(par->cur);
+		par->cur = NULL;
+		au->le = NULL;
+	}
+
+	pthread_mutex_lock(&par->lock);
+	while (1) {
+		int waiting = 0, pending = 0, bounded = 0;
+		time_t front = 0;	// seconds all earlier files are past
+
+		best = NULL;
+		open = ready = 0;
+		for (i = 0; i < par->nstreams; i++) {
+			struct au_par_stream *s = &par->streams[i];
+
+			if (!s->done)
+				pending = 1;
+			if (s->open && (best == NULL || auparse_timestamp_compare(
+					&s->open->e, open ? &best->open->e :
+						&best->head->e) < 0)) {
+				best = s;
+				open = 1;
+				ready = i + 1 == par->nstreams ||
+					au_par_past(s + 1, s->open->e.sec);
+			}
+			if (i)
+				au_par_stitch(par, i);
+			if (s->head == NULL) {
+				// Can't merge until every running file
+				// has something to offer
+				if (s->started && !s->done)
+					waiting = 1;
+			} else if (best == NULL || auparse_timestamp_compare(
+					&s->head->e, open ? &best->open->e :
+						&best->head->e) < 0) {
+				best = s;
+				open = 0;
+				ready = !bounded || s->head->e.sec <= front;
+			}
+			if (!s->done && (!bounded || s->expired < front)) {
+				front = s->expired;
+				bounded = 1;
+			}
+		}
+		if (!waiting && best && ready) {
+			if (!open) {
+				l = au_par_unlink(par, best, &best->head);
+				if (!au_par_lone_eoe(l))
+					break;
+				// A standalone EOE nothing joined, eaten as
+				// the serial parser would
+				au_par_free_list(l);
+				continue;
+			}
+			l = best->open;
+			best->open = l->next_spare;
+			if (best->open == NULL)
+				best->open_tail = NULL;
+			l->next_spare = NULL;
+			if (best + 1 == par->streams + par->nstreams)
+				break;
+
+			// Stitch the parts of an event that crossed a file
+			// boundary, wherever the next file queued them
+			next = best + 1;
+			cnt = l->cnt;
+			au_par_join(par, l, next);
+			if (!au_par_can_join(l))
+				break;
+			// Unless the next file timed it out, it runs through
+			// that one and goes on from there
+			if (au_par_find(&next->open, &l->e) == NULL &&
+			    (l->cnt != cnt || !next->done ||
+			     l->e.sec <= next->expired))
+				break;
+			au_par_carry(next, l);
+			continue;
+		}
+		if (!waiting && !pending && best == NULL) {
+			pthread_mutex_unlock(&par->lock);
+			return par->error ? -1 : 0;
+		}
+		// Let the files holding up the best event run past the limit
+		if (!waiting && best && !ready) {
+			struct au_par_stream *s;
+
+			if (open)
+				au_par_need(par, best + 1);
+			else {
+				for (s = par->streams; s < best; s++)
+					if (!s->done &&
+					    s->expired < best->head->e.sec)
+						au_par_need(par, s);
+			}
+			pthread_cond_broadcast(&par->cond);
+		}
+		pthread_cond_wait(&par->cond, &par->lock);
+	}
+	pthread_mutex_unlock(&par->lock);
+
+	par->cur = l;
+	aup_list_first(l);
+	r = aup_list_get_cur(l);
+	free_interpretation_list(au);
+	load_interpretation_list(au, r->interp);
+	aup_list_first_field(l);
+	au->le = l;
+	return 1;
+}
+
+int auparse_set_parallelism(auparse_state_t *au, unsigned int threads)
+{
+	if (au == NULL || (au->source != AUSOURCE_LOGS &&
+			   au->source != AUSOURCE_FILE_ARRAY)) {
+		errno = EINVAL;
+		return -1;
+	}
+	// Only before the first event
+	if (au->par || au->in || au->map || au->list_idx) {
+		errno = EBUSY;
+		return -1;
+	}
+	au->par_threads = threads > 1 ? threads : 0;
+	return 0;
+}
+
+int auparse_set_feed_limit(auparse_state_t *au, size_t bytes)
+{
+	if (au == NULL || au->source != AUSOURCE_FEED ||
+			(bytes && bytes < au->databuf.len)) {
+		errno = EINVAL;
+		return -1;
+	}
+	databuf_set_limit(&au->databuf, bytes);
+	return 0;
 }
-#endif	/* LOL_EVENTS_DEBUG01 */
 
+int auparse_set_projection(auparse_state_t *au, const int *types,
+			   const char **fields)
+{
+	unsigned int ntypes = 0, nfields = 0;
+	aup_proj_t *p = NULL;
 
-/* General functions that affect operation of the library */
+	if (au == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	// Only before the first event, records point at the projection.
+	// A file pointer or descriptor is open from the start, other
+	// sources open their input when the first line is read.
+	if (au->par || au->list_idx || au->line_number || au->le ||
+			((au->in || au->map) &&
+			 au->source != AUSOURCE_FILE_POINTER &&
+			 au->source != AUSOURCE_DESCRIPTOR)) {
+		errno = EBUSY;
+		return -1;
+	}
+	if (types) {
+		while (types[ntypes])
+			ntypes++;
+	}
+	if (fields) {
+		while (fields[nfields]) {
+			if (*fields[nfields] == 0) {
+				errno = EINVAL;
+				return -1;
+			}
+			nfields++;
+		}
+	}
+	if (types || fields) {
+		p = au_proj_new(types, ntypes, (char * const *)fields,
+				nfields);
+		if (p == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+	au_proj_free(au->proj);
+	au->proj = p;
+	return 0;
+}
 
 /*
- * au_setup_userspace_configitems - load userspace configuration items from auditd.conf
+ * au_proj_drop - Leave out a record whose type was not projected
  *
  * Args:
- *  au - pointer to auparseing state structure
- *
+ *  au	- the parser state machine
+ *  e	- the time stamp of the record in au->cur_line
+ *  hash - lol_hash of e
  * Rtns:
- *      void
+ *  1 if the record was left out, 0 if it is to be added
+ *
+ * A record that is left out still ends the event it belongs to.
  */
-static void au_setup_userspace_configitems(auparse_state_t *au)
+static int au_proj_drop(auparse_state_t *au, au_event_t *e,
+			unsigned int hash)
 {
-	struct daemon_conf config;
-
-	/* Load config so we know where logs are */
-	if (secure_getenv("AUPARSE_DEBUG"))
-		set_aumessage_mode(au, MSG_STDERR, DBG_NO);
-	aup_load_config(au, &config, TEST_SEARCH);
+	int type = aup_line_type(au->cur_line, au->cur_line_len);
+	int i;
 
-	eoe_timeout = (time_t)config.end_of_event_timeout;
+	// Anything odd is added and sorted out when it is split
+	if (type <= 0 || bsearch(&type, au->proj->types, au->proj->ntypes,
+				 sizeof(int), au_proj_cmp_type))
+		return 0;
 
-	aup_free_config(&config);
+	i = au_lol_find(au->au_lo, e, hash);
+	free((char *)e->host);
+	au_check_events(au, e->sec);
+	if (i >= 0 && au->au_lo->array[i].status == EBS_BUILDING &&
+			audit_is_last_record(type))
+		au_lol_complete(au, i, 1);
+	return 1;
 }
 
 auparse_state_t *auparse_init(ausource_t source, const void *b)
@@ -466,11 +1623,16 @@ auparse_state_t *auparse_init(ausource_t source, const void *b)
 		return NULL;
 	}
 	au->au_ready = 0;
+	au->eoe_complete = 0;
+	au->timeout_complete = 0;
+	au->eoe_timeout = EOE_TIMEOUT;
+	au->fan_type = 2;
 	au->escape_mode = AUPARSE_ESC_TTY;
 	au->message_mode = MSG_QUIET;
 	au->debug_message = DBG_NO;
 
 	au->in = NULL;
+	au->map = NULL;
 	au->source_list = NULL;
 	databuf_init(&au->databuf, 0, 0);
 	au->callback = NULL;
@@ -550,6 +1712,7 @@ auparse_state_t *auparse_init(ausource_t source, const void *b)
 			break;
 		case AUSOURCE_FEED:
                     if (databuf_init(&au->databuf, 0, 0) < 0) goto bad_exit;
+			databuf_set_limit(&au->databuf, FEED_LIMIT);
 			break;
 		default:
 			errno = EINVAL;
@@ -562,14 +1725,29 @@ auparse_state_t *auparse_init(ausource_t source, const void *b)
 	au->next_buf = NULL;
 	au->off = 0;
 	au->cur_buf = NULL;
+	au->cur_buf_size = 0;
+	au->cur_line = NULL;
+	au->cur_line_len = 0;
 	au->line_pushed = 0;
 	au->parse_state = EVENT_EMPTY;
 	au->expr = NULL;
+	au->prog = NULL;
 	au->find_field = NULL;
+	au->find_field_id = -1;
 	au->search_where = AUSEARCH_STOP_EVENT;
 	au->tmp_translation = NULL;
-	au->uid_cache = NULL;
-	au->gid_cache = NULL;
+	au->interp_cache = NULL;
+	au->interp_cache_max = INTERP_CACHE_ENTRIES;
+	au->interp_hits = 0;
+	au->interp_misses = 0;
+	au->interp_evictions = 0;
+	au->par_threads = 0;
+	au->par = NULL;
+	au->keep_eoe = 0;
+	au->proj = NULL;
+	au->batch_held = 0;
+	au->feed_skip = 0;
+	au->feed_dropped = 0;
 	init_interpretation_list(au);
 	init_normalizer(&au->norm_data);
 
@@ -620,7 +1798,7 @@ static void consume_feed(auparse_state_t *au, int flush)
 
 		//if (debug) printf("terminate all events in flush\n");
 		au_terminate_all_events(au);
-		while ((l = au_get_ready_event(au, 0)) != NULL) {
+		while ((l = au_get_ready_event(au)) != NULL) {
 			rnode *r;
 			au->le = l;  // make this current the event of interest
 			aup_list_first(l);
@@ -650,11 +1828,51 @@ int auparse_new_buffer(auparse_state_t *au, const char *data, size_t data_len)
 	return 0;
 }
 
+/*
+ * Data goes into the buffer no faster than the parser takes lines out of
+ * it, so memory stays under the feed limit. A line that does not fit by
+ * itself is thrown away up to its newline and ENOBUFS is returned once
+ * the rest of the data has been parsed.
+ */
 int auparse_feed(auparse_state_t *au, const char *data, size_t data_len)
 {
-	if (databuf_append(&au->databuf, data, data_len) < 0)
+	int dropped = 0;
+
+	while (data_len) {
+		size_t n;
+
+		if (au->feed_skip) {
+			const char *nl = memchr(data, '\n', data_len);
+
+			if (nl == NULL)
+				break;
+			au->feed_skip = 0;
+			data_len -= nl + 1 - data;
+			data = nl + 1;
+			continue;
+		}
+
+		n = databuf_room(&au->databuf);
+		if (n == 0) {
+			// One line fills the buffer and is still not complete
+			databuf_discard(&au->databuf);
+			au->feed_skip = 1;
+			au->feed_dropped++;
+			dropped = 1;
+			continue;
+		}
+		if (n > data_len)
+			n = data_len;
+		if (databuf_append(&au->databuf, data, n) < 0)
+			return -1;
+		consume_feed(au, 0);
+		data += n;
+		data_len -= n;
+	}
+	if (dropped) {
+		errno = ENOBUFS;
 		return -1;
-	consume_feed(au, 0);
+	}
 	return 0;
 }
 
@@ -671,16 +1889,9 @@ int auparse_feed_has_data(const auparse_state_t *au)
 	if (!au)
 		return 0;
 
-	int i;
-	au_lol *lol = au->au_lo;
-
-	// An improvement would be to track how many events we have stored
-	// to avoid a costly loop
-        for (i=0; i <= lol->maxi; i++) {
-                au_lolnode *cur = &(lol->array[i]);
-		if (cur->status > EBS_EMPTY)
-			return 1;
-	}
+	// Every building or complete event is on the heap
+	if (au->au_lo->nheap)
+		return 1;
 
 	return 0;
 }
@@ -689,7 +1900,7 @@ int auparse_feed_has_data(const auparse_state_t *au)
 // Otherwise return 0 to indicate its empty
 int auparse_feed_has_ready_event(auparse_state_t *au)
 {
-	if (au_get_ready_event(au, 1) != NULL)
+	if (au->au_ready > 0)
 		return 1;
 
 	return 0;
@@ -698,7 +1909,7 @@ int auparse_feed_has_ready_event(auparse_state_t *au)
 void auparse_feed_age_events(auparse_state_t *au)
 {
 	time_t t = time(NULL);
-	au_check_events(au, t);
+	au_age_events(au, t);
 	consume_feed(au, 0);
 }
 
@@ -739,6 +1950,8 @@ int auparse_reset(auparse_state_t *au)
 		return -1;
 	}
 
+	au_par_stop(au);
+
 	/* Create or Free list of events list (au_lo) structure */
 	if (au->au_lo->array == NULL)
 		au_lol_create(au->au_lo);
@@ -748,16 +1961,14 @@ int auparse_reset(auparse_state_t *au)
 	au->parse_state = EVENT_EMPTY;
 	au->au_ready = 0;
 	au->le = NULL;
+	au->batch_held = 0;
 
 	switch (au->source)
 	{
 		case AUSOURCE_LOGS:
 		case AUSOURCE_FILE:
 		case AUSOURCE_FILE_ARRAY:
-			if (au->in) {
-				fclose(au->in);
-				au->in = NULL;
-			}
+			au_close_source(au);
 		/* Fall through */
 		case AUSOURCE_DESCRIPTOR:
 		case AUSOURCE_FILE_POINTER:
@@ -782,28 +1993,62 @@ char *auparse_metrics(const auparse_state_t *au)
 {
 	char *metrics;
 	unsigned int uid, gid;
+	unsigned long id_hits, id_misses;
 
-	aulookup_metrics(au, &uid, &gid);
+	aulookup_metrics(au, &uid, &gid, &id_hits, &id_misses);
 
 	if (asprintf(&metrics,
 		     "max lol available: %lu\n"
 		     "max lol used: %d\n"
 		     "pending lol: %d\n"
 		     "uid cache size: %u\n"
-		     "gid cache size: %u",
+		     "gid cache size: %u\n"
+		     "id cache hits: %lu\n"
+		     "id cache misses: %lu\n"
+		     "events completed by eoe: %lu\n"
+		     "events completed by timeout: %lu\n"
+		     "event lists reused: %lu\n"
+		     "spare event lists: %u\n"
+		     "interpretation cache hits: %lu\n"
+		     "interpretation cache misses: %lu\n"
+		     "interpretation cache evictions: %lu\n"
+		     "feed buffer size: %zu\n"
+		     "feed lines dropped: %lu",
 		     au->au_lo->limit,
 		     au->au_lo->maxi,
-		     au->au_ready, uid, gid) < 0)
+		     au->au_ready, uid, gid, id_hits, id_misses,
+		     au->eoe_complete, au->timeout_complete,
+		     au->au_lo->reused, au->au_lo->nspare,
+		     au->interp_hits, au->interp_misses,
+		     au->interp_evictions, au->databuf.alloc_size,
+		     au->feed_dropped) < 0)
 		metrics = NULL;
 	return metrics;
 }
 
+/*
+ * Report how the feed interface decided that events were complete. Events
+ * are either ended by a record known to be last, such as EOE, or they are
+ * ended by the eoe timeout or a flush.
+ */
+void auparse_get_completions(const auparse_state_t *au, unsigned long *eoe,
+			     unsigned long *timeout)
+{
+	if (eoe)
+		*eoe = au->eoe_complete;
+	if (timeout)
+		*timeout = au->timeout_complete;
+}
+
 /* Add EXPR to AU, using HOW to select the combining operator.
    On success, return 0.
    On error, free EXPR set errno and return -1.
    NOTE: EXPR is freed on error! */
 static int add_expr(auparse_state_t *au, struct expr *expr, ausearch_rule_t how)
 {
+	// The program points into the old tree, it's rebuilt on next search
+	expr_prog_free(au->prog);
+	au->prog = NULL;
 	if (au->expr == NULL)
 		au->expr = expr;
 	else if (how == AUSEARCH_RULE_CLEAR) {
@@ -993,6 +2238,8 @@ int ausearch_set_stop(auparse_state_t *au, austop_t where)
 
 void ausearch_clear(auparse_state_t *au)
 {
+	expr_prog_free(au->prog);
+	au->prog = NULL;
 	if (au->expr != NULL) {
 		expr_free(au->expr);
 		au->expr = NULL;
@@ -1005,6 +2252,8 @@ static void auparse_destroy_common(auparse_state_t *au)
 	if (au == NULL)
 		return;
 
+	au_par_stop(au);
+
 	if (au->source_list) {
 		int n = 0;
 		while (au->source_list[n])
@@ -1016,23 +2265,25 @@ static void auparse_destroy_common(auparse_state_t *au)
 	au->next_buf = NULL;
         free(au->cur_buf);
 	au->cur_buf = NULL;
+	au->cur_buf_size = 0;
+	au->cur_line = NULL;
 	au->le = NULL;
 	au->parse_state = EVENT_EMPTY;
         free(au->find_field);
 	au->find_field = NULL;
+	au->find_field_id = -1;
 	ausearch_clear(au);
 	databuf_free(&au->databuf);
 	if (au->callback_user_data_destroy) {
 		(*au->callback_user_data_destroy)(au->callback_user_data);
 		au->callback_user_data = NULL;
 	}
-	if (au->in) {
-		fclose(au->in);
-		au->in = NULL;
-	}
+	au_close_source(au);
        free_interpretation_list(au);
-	clear_normalizer(&au->norm_data);
+	interp_cache_destroy(au);
+	destroy_normalizer(&au->norm_data);
 	au_lol_clear(au->au_lo, 0);
+	au_proj_free(au->proj);
 	free((void *)au->tmp_translation);
 	free(au->au_lo);
 	free(au);
@@ -1040,9 +2291,6 @@ static void auparse_destroy_common(auparse_state_t *au)
 
 void auparse_destroy(auparse_state_t *au)
 {
-	_aulookup_destroy_uid_list(au);
-	aulookup_destroy_gid_list(au);
-
 	auparse_destroy_common(au);
 }
 
@@ -1055,15 +2303,54 @@ void auparse_destroy_ext(auparse_state_t *au, auparse_destroy_what_t what)
 	return;
 }
 
-/* alloc a new buffer, cur_buf which contains a null terminated line
+/* Point cur_line at the next line in the mapping. The line is not null
+ * terminated, cur_line_len gives its length without the newline. The
+ * next MAP_READAHEAD bytes are requested before the reader gets to them.
+ *
+ * Returns:
+ *     1 if successful (errno == 0)
+ *    -2 if EOF  (errno == 0)
+ */
+static int readline_map(auparse_state_t *au)
+{
+	const char *line, *nl;
+	size_t left;
+
+	errno = 0;
+	if (au->map_off >= au->map_size)
+		return -2;
+
+	if (au->map_off + MAP_READAHEAD / 2 >= au->map_advised &&
+				au->map_advised < au->map_size) {
+		size_t len = au->map_size - au->map_advised;
+
+		if (len > MAP_READAHEAD)
+			len = MAP_READAHEAD;
+		madvise(au->map + au->map_advised, len, MADV_WILLNEED);
+		au->map_advised += len;
+	}
+
+	line = au->map + au->map_off;
+	left = au->map_size - au->map_off;
+	nl = audit_memchr(line, '\n', left);
+	if (nl) {
+		au->cur_line_len = nl - line;
+		au->map_off += au->cur_line_len + 1;
+	} else {
+		// Last line without a newline
+		au->cur_line_len = left;
+		au->map_off = au->map_size;
+	}
+	au->cur_line = line;
+	return 1;
+}
+
+/* Read a line into cur_buf which contains a null terminated line
  * without a newline (note, this implies the line may be empty (strlen == 0)) if
  * successfully read a blank line (e.g. containing only a single newline).
- * cur_buf will have been newly allocated with malloc.
  *
- * Note: cur_buf will be freed the next time this routine is called if
- * cur_buf is not NULL, callers who retain a reference to the cur_buf
- * pointer will need to set cur_buf to NULL to cause the previous cur_buf
- * allocation to persist.
+ * Note: cur_buf is reused for every line, so it is only valid until the
+ * next call. aup_list_append keeps its own copy.
  *
  * Returns:
  *     1 if successful (errno == 0)
@@ -1076,22 +2363,14 @@ static int readline_file(auparse_state_t *au)
 {
 	ssize_t rc;
 	char *p_last_char;
-	size_t n = 0;
 
-	if (au->cur_buf != NULL) {
-		free(au->cur_buf);
-		au->cur_buf = NULL;
-	}
 	if (au->in == NULL) {
 		errno = EBADF;
 		return -1;
 	}
-	if ((rc = getline(&au->cur_buf, &n, au->in)) <= 0) {
-		// Note: getline always malloc's if lineptr==NULL or n==0,
-		// on failure malloc'ed memory is left uninitialized,
-		// caller must free it.
-		free(au->cur_buf);
-		au->cur_buf = NULL;
+	if ((rc = getline(&au->cur_buf, &au->cur_buf_size, au->in)) <= 0) {
+		// Note: getline leaves the buffer allocated, it gets
+		// reused or freed by auparse_destroy.
 
 		// Note: feof() does not set errno
 		if (feof(au->in)) {
@@ -1105,23 +2384,23 @@ static int readline_file(auparse_state_t *au)
 	p_last_char = au->cur_buf + (rc-1);
 	if (*p_last_char == '\n') {	/* nuke newline */
 		*p_last_char = 0;
+		rc--;
 	}
+	au->cur_line = au->cur_buf;
+	au->cur_line_len = rc;
 	// return success
 	errno = 0;
 	return 1;
 }
 
 
-/* malloc & copy a line into cur_buf from the internal buffer,
- * next_buf.  cur_buf will contain a null terminated line without a
- * newline (note, this implies the line may be empty (strlen == 0)) if
- * successfully read a blank line (e.g. containing only a single
- * newline).
+/* Point cur_line at the next line in the internal buffer, next_buf.
+ * The line is null terminated in place and does not contain a trailing
+ * newline. This implies a successful read (result == 1) may result in a
+ * zero length line if a blank line was read.
  *
- * Note: cur_buf will be freed the next time this routine is called if
- * cur_buf is not NULL, callers who retain a reference to the cur_buf
- * pointer will need to set cur_buf to NULL to cause the previous cur_buf
- * allocation to persist.
+ * Note: the line lives in the DataBuf, so it is only valid until the next
+ * call. Records copy it into their event.
  *
  * Returns:
  *     1 if successful (errno == 0)
@@ -1132,13 +2411,8 @@ static int readline_file(auparse_state_t *au)
 
 static int readline_buf(auparse_state_t *au)
 {
-	char *p_newline=NULL;
-	size_t line_len;
-
-	if (au->cur_buf != NULL) {
-		free(au->cur_buf);
-		au->cur_buf = NULL;
-	}
+	char *line;
+	size_t len;
 
 	//if (debug) databuf_print(&au->databuf, 1, "readline_buf");
 	if (au->databuf.len == 0) {
@@ -1147,19 +2421,9 @@ static int readline_buf(auparse_state_t *au)
 		return -2;
 	}
 
-	if ((p_newline = strnchr(databuf_beg(&au->databuf), '\n',
-						au->databuf.len)) != NULL) {
-		line_len = p_newline - databuf_beg(&au->databuf);
-
-		/* dup the line */
-		au->cur_buf = malloc(line_len+1);   // +1 for null terminator
-		if (au->cur_buf == NULL)
-			return -1; // return error condition, errno set
-		strncpy(au->cur_buf, databuf_beg(&au->databuf), line_len);
-		au->cur_buf[line_len] = 0;
-
-		if (databuf_advance(&au->databuf, line_len+1) < 0)
-			return -1;
+	if ((line = databuf_line(&au->databuf, &len)) != NULL) {
+		au->cur_line = line;
+		au->cur_line_len = len;
 		// return success
 		errno = 0;
 		return 1;
@@ -1170,124 +2434,31 @@ static int readline_buf(auparse_state_t *au)
 	}
 }
 
-static int str2event(char *s, au_event_t *e)
-{
-	char *ptr;
-
-	errno = 0;
-	e->sec = strtoul(s, NULL, 10);
-	if (errno || e->sec > (LONG_MAX - eoe_timeout -1))
-		return -1;
-	ptr = strchr(s, '.');
-	if (ptr) {
-		ptr++;
-		e->milli = strtoul(ptr, NULL, 10);
-		if (errno || e->milli > 999)
-			return -1;
-		s = ptr;
-	} else
-		e->milli = 0;
-
-	ptr = strchr(s, ':');
-	if (ptr) {
-		ptr++;
-		e->serial = strtoul(ptr, NULL, 10);
-		if (errno)
-			return -1;
-	} else
-		e->serial = 0;
-	return 0;
-}
-
-#ifndef HAVE_STRNDUPA
-#define strndupa(s, n)								\
-	({												\
-		const char *__old = (s);					\
-		size_t __len = strnlen (__old, (n));		\
-		char *__new = (char *) alloca(__len + 1);	\
-		__new[__len] = '\0';						\
-		(char *) memcpy (__new, __old, __len);		\
-	})
-#endif
-
 /* Returns 0 on success and 1 on error */
-static int extract_timestamp(const char *b, au_event_t *e)
+static int extract_timestamp(const auparse_state_t *au, const char *b,
+			     size_t len, au_event_t *e)
 {
-	char *ptr, *tmp;
-	int rc = 1;
-
-        e->host = NULL;
-	if (*b == 'n')
-		tmp = strndupa(b, 340);
-	else
-		tmp = strndupa(b, 80);
-	ptr = audit_strsplit(tmp);
-	if (ptr) {
-		// Optionally grab the node - may or may not be included
-		if (*ptr == 'n' && strnlen(ptr, 8) > 5) {
-			e->host = strdup(ptr+5);
-			(void)audit_strsplit(NULL);// Bump along to next one
-		}
-		// at this point we have type=
-		ptr = audit_strsplit(NULL);
-		// strlen is for fuzzers that make invalid lines
-		if (ptr && strnlen(ptr, 20) > 18) {
-			if (*(ptr+9) == '(')
-				ptr+=9;
-			else
-				ptr = strchr(ptr, '(');
-			if (ptr) {
-				// now we should be pointed at the timestamp
-				char *eptr;
-				ptr++;
-				eptr = strchr(ptr, ')');
-				if (eptr)
-					*eptr = 0;
-
-				if (str2event(ptr, e) == 0)
-					rc = 0;
-			}
-			// else we have a bad line
-		}
-		// else we have a bad line
-	}
-	if (rc)
-		free((void *)e->host);
-
-	// else we have a bad line
-	return rc;
-}
+	audit_stamp_t st;
 
-static int events_are_equal(const au_event_t *e1, const au_event_t *e2)
-{
-	// Check time & serial first since its most likely way
-	// to spot 2 different events
-	if (!(e1->serial == e2->serial && e1->milli == e2->milli &&
-					e1->sec == e2->sec))
-		return 0;
-	// Hmm...same so far, check if both have a host, only a string
-	// compare can tell if they are the same. Otherwise, if only one
-	// of them have a host, they are definitely not the same. Its
-	// a boundary on daemon config.
-	if (e1->host && e2->host) {
-		if (strcmp(e1->host, e2->host))
-			return 0;
-	} else if (e1->host || e2->host)
-		return 0;
-	return 1;
+	e->host = NULL;
+	if (audit_parse_stamp(b, len, LONG_MAX - au_eoe_timeout(au) - 1, &st))
+		return 1;
+	e->sec = st.sec;
+	e->milli = st.milli;
+	e->serial = st.serial;
+	if (st.node)
+		e->host = strndup(st.node, st.node_len);
+	return 0;
 }
 
 /* This function will figure out how to get the next line of input.
- * storing it cur_buf. cur_buf will be NULL terminated but will not
+ * pointing cur_line at it. cur_line will be NULL terminated but will not
  * contain a trailing newline. This implies a successful read
- * (result == 1) may result in a zero length cur_buf if a blank line
+ * (result == 1) may result in a zero length cur_line if a blank line
  * was read.
  *
- * cur_buf will have been allocated with malloc. The next time this
- * routine is called if cur_buf is non-NULL cur_buf will be freed,
- * thus if the caller wishes to retain a reference to malloc'ed
- * cur_buf data it should copy the cur_buf pointer and set cur_buf to
- * NULL.
+ * cur_line is only valid until the next read, so a caller that wants to
+ * keep the line has to copy it.
  *
  * Returns:
  *     1 if successful (errno == 0)
@@ -1321,36 +2492,31 @@ static int retrieve_next_line(auparse_state_t *au)
 		case AUSOURCE_FILE_ARRAY:
 			// if the first time through, open file
 			if (au->list_idx == 0 && au->in == NULL &&
-						au->source_list != NULL) {
+				au->map == NULL && au->source_list != NULL) {
 				if (au->source_list[au->list_idx] == NULL) {
 					errno = 0;
 					return -2;
 				}
 				au->line_number = 0;
-				au->in = fopen(au->source_list[au->list_idx],
-									"rm");
-				if (au->in == NULL)
+				if (au_open_source(au))
 					return -1;
-				__fsetlocking(au->in, FSETLOCKING_BYCALLER);
 			}
 
 			// loop reading lines from a file
-			while (au->in) {
-				if ((rc = readline_file(au)) == -2) {
+			while (au->in || au->map) {
+				if (au->map)
+					rc = readline_map(au);
+				else
+					rc = readline_file(au);
+				if (rc == -2) {
 					// end of file, open next file,
 					// try readline again
-					fclose(au->in);
-					au->in = NULL;
+					au_close_source(au);
 					au->list_idx++;
 					au->line_number = 0;
 					if (au->source_list[au->list_idx]) {
-						au->in = fopen(
-						  au->source_list[au->list_idx],
-						  "rm");
-						if (au->in == NULL)
+						if (au_open_source(au))
 							return -1;
-						__fsetlocking(au->in,
-							FSETLOCKING_BYCALLER);
 					}
 				} else {
 					if (rc > 0)
@@ -1418,8 +2584,12 @@ static int ausearch_compare(auparse_state_t *au)
 
 	r = aup_list_get_cur(au->le);
 	if (r) {
-		int res = expr_eval(au, r, au->expr);
-		return res;
+		if (au->prog == NULL)
+			au->prog = expr_compile(au->expr);
+		// Without memory for the program the tree still works
+		if (au->prog == NULL)
+			return expr_eval(au, r, au->expr);
+		return expr_prog_eval(au, r, au->prog);
 	}
 
 	return 0;
@@ -1494,7 +2664,8 @@ int ausearch_next_event(auparse_state_t *au)
  */
 static int au_auparse_next_event(auparse_state_t *au)
 {
-	int rc, i, built;
+	int rc, i;
+	unsigned int hash;
 	event_list_t *l;
 	au_event_t e;
 
@@ -1514,31 +2685,24 @@ static int au_auparse_next_event(auparse_state_t *au)
 		au_lol_create(au->au_lo);
 	}
 
+	if (au->par_threads && au->par == NULL && au->list_idx == 0 &&
+	    au->in == NULL && au->map == NULL && au->source_list) {
+		if (au_par_start(au))
+			au->par_threads = 0;
+	}
+	if (au->par)
+		return au_par_next_event(au);
+
 	/*
-	 * First see if we have any empty events but with an allocated event
-	 * list. These would have just been processed, so we can free them
+	 * First free the events that were handed out. These would have
+	 * just been processed, so we are done with them
 	 */
-	for (i = 0; i <= au->au_lo->maxi; i++) {
-		au_lolnode *cur = &au->au_lo->array[i];
-		if (cur->status == EBS_EMPTY && cur->l) {
-#ifdef	LOL_EVENTS_DEBUG01
-			if (debug) {
-				printf("Freeing at start ");
-				print_list_t(cur->l);
-			}
-#endif	/* LOL_EVENTS_DEBUG01 */
-			aup_list_clear(cur->l);
-			free(cur->l);
-			au->le = NULL;	// this should crash any usage
-					// of au->le until reset
-			cur->l = NULL;
-		}
-	}
+	au_lol_release(au);
 	/*
 	 * Now see if we have completed events queued, and if so grab the
 	 * first one and set it to be the 'current' event of interest
 	 */
-	if ((l = au_get_ready_event(au, 0)) != NULL) {
+	if ((l = au_get_ready_event(au)) != NULL) {
 		rnode *r;
 
 		aup_list_first(l);
@@ -1556,24 +2720,10 @@ static int au_auparse_next_event(auparse_state_t *au)
 	 * If no complete events are available, lets ingest
 	 */
 	while (1) {
-		for (i = 0; i <= au->au_lo->maxi; i++) {
-			au_lolnode *cur = &au->au_lo->array[i];
-			if (cur->status == EBS_EMPTY && cur->l) {
-#ifdef	LOL_EVENTS_DEBUG01
-				if (debug) {
-					printf("Freeing at loop");
-					print_list_t(cur->l);
-				}
-#endif	/* LOL_EVENTS_DEBUG01 */
-				aup_list_clear(cur->l);
-				free(cur->l);
-				au->le = NULL;	/* this should crash any usage of au->le until reset */
-				cur->l = NULL;
-			}
-		}
 		rc = retrieve_next_line(au);
 #ifdef	LOL_EVENTS_DEBUG01
-		if (debug) printf("next_line(%d) '%s'\n", rc, au->cur_buf);
+		if (debug) printf("next_line(%d) '%.*s'\n", rc,
+					(int)au->cur_line_len, au->cur_line);
 #endif	/* LOL_EVENTS_DEBUG01 */
 		if (rc == 0) {
 #ifdef	LOL_EVENTS_DEBUG01
@@ -1590,7 +2740,7 @@ static int au_auparse_next_event(auparse_state_t *au)
 			if (debug) printf("EOF\n");
 #endif	/* LOL_EVENTS_DEBUG01 */
 			au_terminate_all_events(au);
-			if ((l = au_get_ready_event(au, 0)) != NULL) {
+			if ((l = au_get_ready_event(au)) != NULL) {
 				rnode *r;
 
 				aup_list_first(l);
@@ -1615,10 +2765,11 @@ static int au_auparse_next_event(auparse_state_t *au)
 			return -1;
 		}
 		/* So we got a successful read ie rc > 0 */
-		if (extract_timestamp(au->cur_buf, &e)) {
+		if (extract_timestamp(au, au->cur_line, au->cur_line_len, &e)) {
 #ifdef	LOL_EVENTS_DEBUG01
 			if (debug)
-				printf("Malformed line:%s\n", au->cur_buf);
+				printf("Malformed line:%.*s\n",
+				(int)au->cur_line_len, au->cur_line);
 #endif	/* LOL_EVENTS_DEBUG01 */
 			continue;
 		}
@@ -1626,75 +2777,75 @@ static int au_auparse_next_event(auparse_state_t *au)
 		/*
 		 * Is this an event we have already been building?
 		 */
-		built = 0;
-		for (i = 0; i <= au->au_lo->maxi; i++) {
-			au_lolnode *cur = &au->au_lo->array[i];
-			if (cur->status == EBS_BUILDING) {
-				if (events_are_equal(&cur->l->e, &e)) {
+		hash = lol_hash(&e);
+		if (au->proj && au->proj->types &&
+				au_proj_drop(au, &e, hash)) {
+			rnode *r;
+
+			if ((l = au_get_ready_event(au)) == NULL)
+				continue;
+			aup_list_first(l);
+			r = aup_list_get_cur(l);
+			free_interpretation_list(au);
+			load_interpretation_list(au, r->interp);
+			aup_list_first_field(l);
+			au->le = l;
+			return 1;
+		}
+		if ((i = au_lol_find(au->au_lo, &e, hash)) >= 0) {
 #ifdef	LOL_EVENTS_DEBUG01
-					if (debug)
-						printf("Adding event to building event\n");
+			if (debug)
+				printf("Adding event to building event\n");
 #endif	/* LOL_EVENTS_DEBUG01 */
-					if (aup_list_append(cur->l, au->cur_buf,
-					    au->list_idx, au->line_number) < 0) {
-						au->cur_buf = NULL;
-						continue;
-					}
-					au->cur_buf = NULL;
-					free((char *)e.host);
-					au_check_events(au,  e.sec);
+			rc = aup_list_append(au->au_lo->array[i].l,
+				au->cur_line, au->cur_line_len, au->list_idx,
+				au->line_number);
+			free((char *)e.host);
+			if (rc < 0)
+				continue;
+			au_check_events(au,  e.sec);
+			au_check_last_record(au, i);
 #ifdef	LOL_EVENTS_DEBUG01
-					if (debug)
-						print_lol("building",au->au_lo);
+			if (debug)
+				print_lol("building",au->au_lo);
 #endif	/* LOL_EVENTS_DEBUG01 */
-					/* we built something, so break out */
-					built++;
-					break;
-				}
-			}
-		}
-		if (built)
+			/* we built something, so go get the next record */
 			continue;
+		}
 
 		/* So create one */
 #ifdef	LOL_EVENTS_DEBUG01
 		if (debug)
 			printf("First record in new event, initialize event\n");
 #endif	/* LOL_EVENTS_DEBUG01 */
-		if ((l=(event_list_t *)malloc(sizeof(event_list_t))) == NULL) {
+		if ((l = au_lol_get_list(au->au_lo)) == NULL) {
 			free((char *)e.host);
 			return -1;
 		}
-		aup_list_create(l);
 		aup_list_set_event(l, &e);
-		if (aup_list_append(l, au->cur_buf, au->list_idx,
-				    au->line_number) < 0) {
-			au->cur_buf = NULL;
-			aup_list_clear(l);
-			free(l);
+		l->proj = au->proj;
+		if (aup_list_append(l, au->cur_line, au->cur_line_len,
+				    au->list_idx, au->line_number) < 0) {
+			au_lol_put_list(au->au_lo, l);
 			continue;
 		}
 		// Eat standalone EOE - main event was already marked complete
-		if (l->head->type == AUDIT_EOE) {
-			au->cur_buf = NULL;
-			aup_list_clear(l);
-			free(l);
+		if (l->head->type == AUDIT_EOE && !au->keep_eoe) {
+			au_lol_put_list(au->au_lo, l);
 			continue;
 		}
-		if (au_lol_append(au->au_lo, l) == NULL) {
+		if ((i = au_lol_append(au, l, hash)) < 0) {
 			free((char *)e.host);
-			au->cur_buf = NULL;
-			aup_list_clear(l);
-			free(l);
+			au_lol_put_list(au->au_lo, l);
 #ifdef	LOL_EVENTS_DEBUG01
 			if (debug) printf("error appending to lol\n");
 #endif	/* LOL_EVENTS_DEBUG01 */
 			return -1;
 		}
-		au->cur_buf = NULL;
 		free((char *)e.host);
 		au_check_events(au,  e.sec);
-		if ((l = au_get_ready_event(au, 0)) != NULL) {
+		au_check_last_record(au, i);
+		if ((l = au_get_ready_event(au)) != NULL) {
 			rnode *r;
 
 			aup_list_first(l);
@@ -1715,6 +2866,7 @@ static int au_auparse_next_event(auparse_state_t *au)
 int auparse_next_event(auparse_state_t *au)
 {
 	clear_normalizer(&au->norm_data);
+	au->batch_held = 0;
 	return au_auparse_next_event(au);
 }
 
@@ -1983,7 +3135,7 @@ int auparse_next_field(const auparse_state_t *au)
 	if (au->le == NULL)
 		return 0;
 
-	rnode *r = aup_list_get_cur(au->le);
+	rnode *r = aup_list_get_cur_fields(au->le);
 	if (r) {
 		if (nvlist_next(&r->nv))
 			return 1;
@@ -1999,7 +3151,7 @@ unsigned int auparse_get_num_fields(const auparse_state_t *au)
 	if (au->le == NULL)
 		return 0;
 
-	rnode *r = aup_list_get_cur(au->le);
+	rnode *r = aup_list_get_cur_fields(au->le);
 	if (r)
 		return nvlist_get_cnt(&r->nv);
 	else
@@ -2031,21 +3183,23 @@ const char *auparse_get_record_interpretations(const auparse_state_t *au)
 }
 
 
-/* scan from current location to end of event */
-const char *auparse_find_field(auparse_state_t *au, const char *name)
+static const char *find_field(auparse_state_t *au, const char *name, int id)
 {
 	if (au->le == NULL)
 		return NULL;
 
-	free(au->find_field);
-	au->find_field = strdup(name);
+	if (au->find_field == NULL || strcmp(au->find_field, name)) {
+		free(au->find_field);
+		au->find_field = strdup(name);
+	}
+	au->find_field_id = id;
 
 	if (au->le->e.sec) {
 		const char *cur_name;
 		rnode *r;
 
 		// look at current record before moving
-		r = aup_list_get_cur(au->le);
+		r = aup_list_get_cur_fields(au->le);
 		if (r == NULL)
 			return NULL;
 		cur_name = nvlist_get_cur_name(&r->nv);
@@ -2057,6 +3211,37 @@ const char *auparse_find_field(auparse_state_t *au, const char *name)
 	return NULL;
 }
 
+/* scan from current location to end of event */
+const char *auparse_find_field(auparse_state_t *au, const char *name)
+{
+	int id;
+
+	if (au->find_field && strcmp(au->find_field, name) == 0)
+		id = au->find_field_id;
+	else
+		id = field_name_to_id(name);
+	return find_field(au, name, id);
+}
+
+/* Field names interned to a small integer so lookups skip the hashing */
+int auparse_field_id(const char *name)
+{
+	if (name == NULL)
+		return -1;
+	return field_name_to_id(name);
+}
+
+const char *auparse_find_field_id(auparse_state_t *au, int id)
+{
+	const char *name = field_id_to_name(id);
+
+	if (name == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return find_field(au, name, id);
+}
+
 /* Increment 1 location and then scan for next field */
 const char *auparse_find_field_next(auparse_state_t *au)
 {
@@ -2070,17 +3255,19 @@ const char *auparse_find_field_next(auparse_state_t *au)
 	if (au->le->e.sec) {
 		int moved = 0;
 
-		rnode *r = aup_list_get_cur(au->le);
+		rnode *r = aup_list_get_cur_fields(au->le);
 		while (r) {	// For each record in the event...
 			if (!moved) {
 				if (nvlist_next(&r->nv) == NULL)
 					return NULL;
 				moved=1;
 			}
-			if (nvlist_find_name(&r->nv, au->find_field))
+			if (nvlist_find_id(&r->nv, au->find_field_id,
+					   au->find_field))
 				return nvlist_get_cur_val(&r->nv);
 			r = aup_list_next(au->le);
 			if (r) {
+				aup_rnode_fields(r);
 				aup_list_first_field(au->le);
 				free_interpretation_list(au);
 				load_interpretation_list(au, r->interp);
@@ -2097,8 +3284,8 @@ unsigned int auparse_get_field_num(const auparse_state_t *au)
 	if (au->le == NULL)
 		return 0;
 
-	rnode *r = aup_list_get_cur(au->le);
-	if (r) {
+	rnode *r = aup_list_get_cur_fields(au->le);
+	if (r && r->nv.cnt) {
 		nvnode *n = nvlist_get_cur(&r->nv);
 		if (n)
 			return n->item;
@@ -2111,7 +3298,7 @@ int auparse_goto_field_num(const auparse_state_t *au, unsigned int num)
 	if (au->le == NULL)
 		return 0;
 
-	rnode *r = aup_list_get_cur(au->le);
+	rnode *r = aup_list_get_cur_fields(au->le);
 	if (r) {
 		if (num >= r->nv.cnt)
 			return 0;
@@ -2128,7 +3315,7 @@ const char *auparse_get_field_name(const auparse_state_t *au)
 		return NULL;
 
 	if (au->le->e.sec) {
-		rnode *r = aup_list_get_cur(au->le);
+		rnode *r = aup_list_get_cur_fields(au->le);
 		if (r)
 			return nvlist_get_cur_name(&r->nv);
 	}
@@ -2142,7 +3329,7 @@ const char *auparse_get_field_str(const auparse_state_t *au)
 		return NULL;
 
 	if (au->le->e.sec) {
-		rnode *r = aup_list_get_cur(au->le);
+		rnode *r = aup_list_get_cur_fields(au->le);
 		if (r)
 			return nvlist_get_cur_val(&r->nv);
 	}
@@ -2155,7 +3342,7 @@ int auparse_get_field_type(const auparse_state_t *au)
 		return AUPARSE_TYPE_UNCLASSIFIED;
 
         if (au->le->e.sec) {
-                rnode *r = aup_list_get_cur(au->le);
+                rnode *r = aup_list_get_cur_fields(au->le);
                 if (r)
                         return nvlist_get_cur_type(r);
         }
@@ -2183,7 +3370,7 @@ const char *auparse_interpret_field(auparse_state_t *au)
 		return NULL;
 
 	if (au->le->e.sec) {
-		rnode *r = aup_list_get_cur(au->le);
+		rnode *r = aup_list_get_cur_fields(au->le);
 		if (r) {
 			r->cwd = NULL;
 			return nvlist_interp_cur_val(au, r);
@@ -2199,7 +3386,7 @@ const char *auparse_interpret_realpath(const auparse_state_t *au)
 		return NULL;
 
         if (au->le->e.sec) {
-                rnode *r = aup_list_get_cur(au->le);
+                rnode *r = aup_list_get_cur_fields(au->le);
                 if (r) {
 			if (nvlist_get_cur_type(r) != AUPARSE_TYPE_ESCAPED_FILE)
 				return NULL;
@@ -2219,7 +3406,7 @@ static const char *auparse_interpret_sock_parts(auparse_state_t *au,
 		return NULL;
 
         if (au->le->e.sec) {
-		rnode *r = aup_list_get_cur(au->le);
+		rnode *r = aup_list_get_cur_fields(au->le);
 		if (r == NULL)
 			return NULL;
 		// This is limited to socket address fields
@@ -2270,6 +3457,153 @@ const char *auparse_interpret_sock_address(auparse_state_t *au)
 	return auparse_interpret_sock_parts(au, "laddr=");
 }
 
+/* Copy a value to the end of the batch heap, returns its offset */
+static size_t batch_put(auparse_batch_t *b, const char *val, int *full)
+{
+	size_t off = b->heap_used, len;
+
+	if (val == NULL)
+		return AUPARSE_BATCH_NONE;
+	len = strlen(val) + 1;
+	if (len > b->heap_size - off) {
+		*full = 1;
+		return AUPARSE_BATCH_NONE;
+	}
+	memcpy(b->heap + off, val, len);
+	b->heap_used += len;
+	return off;
+}
+
+/*
+ * Fill row of the batch from the current event. Each column gets the
+ * first record in the event that has its field. Returns 0 on success
+ * and 1 if the heap ran out of room.
+ */
+static int batch_row(auparse_state_t *au, auparse_batch_t *b,
+	unsigned int nfields, const int *ids, unsigned int row)
+{
+	event_list_t *l = au->le;
+	unsigned int f, left = nfields;
+	int full = 0;
+	rnode *r;
+
+	if (b->sec)
+		b->sec[row] = l->e.sec;
+	if (b->milli)
+		b->milli[row] = l->e.milli;
+	if (b->serial)
+		b->serial[row] = l->e.serial;
+	if (b->type)
+		b->type[row] = l->head ? l->head->type : 0;
+	for (f = 0; f < nfields; f++) {
+		b->value[f * b->size + row] = AUPARSE_BATCH_NONE;
+		if (b->interp)
+			b->interp[f * b->size + row] = AUPARSE_BATCH_NONE;
+	}
+
+	for (r = l->head; r && left && !full; r = r->next) {
+		int loaded = 0;
+
+		aup_rnode_fields(r);
+		for (f = 0; f < nfields && !full; f++) {
+			size_t *val = &b->value[f * b->size + row];
+
+			if (*val != AUPARSE_BATCH_NONE)
+				continue;
+			nvlist_first(&r->nv);
+			if (!nvlist_find_id(&r->nv, ids[f], b->fields[f]))
+				continue;
+			*val = batch_put(b, nvlist_get_cur_val(&r->nv), &full);
+			left--;
+			if (b->interp == NULL || full)
+				continue;
+			if (!loaded) {
+				load_interpretation_list(au, r->interp);
+				loaded = 1;
+			}
+			r->cwd = NULL;
+			b->interp[f * b->size + row] =
+				batch_put(b, nvlist_interp_cur_val(au, r), &full);
+		}
+		if (loaded)
+			free_interpretation_list(au);
+	}
+	return full;
+}
+
+/*
+ * auparse_get_batch - export the next events into caller's columns
+ *
+ * Args
+ *	au	- the parser state machine
+ *	b	- the columns to fill, see auparse_get_batch(3)
+ * Rtns
+ *	> 0	- number of events exported
+ *	0	- no more events
+ *	-1	- error, errno is EINVAL or ENOSPC when the heap cannot
+ *		  hold a single event
+ */
+int auparse_get_batch(auparse_state_t *au, auparse_batch_t *b)
+{
+	unsigned int f, nfields = 0, row = 0;
+	int *ids = NULL, rc = 1;
+
+	if (au == NULL || b == NULL || b->fields == NULL || b->size == 0 ||
+			(b->heap == NULL && b->heap_size)) {
+		errno = EINVAL;
+		return -1;
+	}
+	while (b->fields[nfields])
+		nfields++;
+	if (nfields) {
+		if (b->value == NULL) {
+			errno = EINVAL;
+			return -1;
+		}
+		ids = malloc(nfields * sizeof(int));
+		if (ids == NULL)
+			return -1;
+		for (f = 0; f < nfields; f++)
+			ids[f] = field_name_to_id(b->fields[f]);
+	}
+
+	b->rows = 0;
+	b->heap_used = 0;
+	while (row < b->size) {
+		size_t heap_mark = b->heap_used;
+
+		// An event that did not fit last time goes first
+		if (au->batch_held && au->le)
+			au->batch_held = 0;
+		else if (au->expr)
+			rc = ausearch_next_event(au);
+		else
+			rc = auparse_next_event(au);
+		if (rc <= 0)
+			break;
+
+		if (batch_row(au, b, nfields, ids, row)) {
+			b->heap_used = heap_mark;
+			au->batch_held = 1;
+			break;
+		}
+		row++;
+	}
+	free(ids);
+	b->rows = row;
+
+	// Leave the cursors where auparse_next_event would
+	if (rc > 0)
+		auparse_first_record(au);
+	if (row == 0 && au->batch_held) {
+		errno = ENOSPC;
+		return -1;
+	}
+	if (row == 0 && rc < 0)
+		return -1;
+	return row;
+}
+
 /*
  * auparse_set_eoe_timeout - set the end of event timeout value
  *
@@ -2280,8 +3614,8 @@ const char *auparse_interpret_sock_address(auparse_state_t *au)
  *	1	- failed to set
  */
 int auparse_set_eoe_timeout (time_t new_tmo) {
-	if (new_tmo == 0)
+	if (new_tmo == 0 || new_tmo > INT_MAX || new_tmo < INT_MIN)
 		return 1;
-	eoe_timeout = new_tmo;
+	AUDIT_ATOMIC_STORE(eoe_timeout_override, (int)new_tmo);
 	return 0;
 }
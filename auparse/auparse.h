@@ -1,5 +1,5 @@
 /* auparse.h --
- * Copyright 2006-08,2012-23 Red Hat Inc.
+ * Copyright 2006-08,2012-23,2026 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -53,6 +53,26 @@ typedef void (*user_destroy)(void *user_data);
 typedef void (*auparse_callback_ptr)(auparse_state_t *au,
 			auparse_cb_event_t cb_event_type, void *user_data);
 
+/* Columns that auparse_get_batch fills, one row per event. Field columns
+ * are laid out one after another, so field f of row i is at f*size+i. */
+typedef struct auparse_batch {
+	const char **fields;	// Field names to export, NULL terminated
+	unsigned int size;	// Rows each column has room for
+	unsigned int rows;	// Rows filled by the last call
+	time_t *sec;		// Event time, or NULL to skip
+	unsigned int *milli;	// Event milliseconds, or NULL to skip
+	unsigned long *serial;	// Event serial, or NULL to skip
+	int *type;		// Type of first record, or NULL to skip
+	size_t *value;		// Heap offsets of the field values
+	size_t *interp;		// Heap offsets of interpretations, or NULL
+	char *heap;		// Nul terminated strings the offsets point at
+	size_t heap_size;	// Bytes of room in heap
+	size_t heap_used;	// Bytes filled by the last call
+} auparse_batch_t;
+
+/* Offset given to fields that are not in the event */
+#define AUPARSE_BATCH_NONE ((size_t)-1)
+
 /* General functions that affect operation of the library */
 void auparse_destroy(auparse_state_t *au);
 void auparse_destroy_ext(auparse_state_t *au, auparse_destroy_what_t what);
@@ -69,9 +89,16 @@ int auparse_feed_has_ready_event(auparse_state_t *au);
 void auparse_add_callback(auparse_state_t *au, auparse_callback_ptr callback,
 			void *user_data, user_destroy user_destroy_func);
 void auparse_set_escape_mode(auparse_state_t *au, auparse_esc_t mode);
+int auparse_set_parallelism(auparse_state_t *au, unsigned int threads);
+int auparse_set_interp_cache(auparse_state_t *au, unsigned int entries);
+int auparse_set_projection(auparse_state_t *au, const int *types,
+	const char **fields);
+int auparse_set_feed_limit(auparse_state_t *au, size_t bytes);
 int auparse_reset(auparse_state_t *au);
 char *auparse_metrics(const auparse_state_t *au)
 	__attribute_malloc__ __attr_dealloc_free;
+void auparse_get_completions(const auparse_state_t *au, unsigned long *eoe,
+			     unsigned long *timeout);
 
 /* Functions that are part of the search interface */
 int ausearch_add_expression(auparse_state_t *au, const char *expression,
@@ -90,6 +117,7 @@ void ausearch_clear(auparse_state_t *au);
 
 /* Function dealing with setting user space configuration items */
 int auparse_set_eoe_timeout (time_t new_tmo);
+int auparse_set_id_cache(unsigned int entries, unsigned int ttl, int preload);
 
 /* Functions that are part of the auparse_normalize interface */
 
@@ -143,6 +171,7 @@ const char *auparse_get_node(const auparse_state_t *au) __attr_dealloc_free;
 int auparse_node_compare(const au_event_t *e1, const au_event_t *e2);
 int auparse_timestamp_compare(const au_event_t *e1, const au_event_t *e2);
 unsigned int auparse_get_num_records(const auparse_state_t *au);
+int auparse_get_batch(auparse_state_t *au, auparse_batch_t *b);
 
 /* Functions that traverse records in the same event */
 int auparse_first_record(auparse_state_t *au);
@@ -162,6 +191,8 @@ const char *auparse_get_record_text(const auparse_state_t *au);
 const char *auparse_get_record_interpretations(const auparse_state_t *au);
 const char *auparse_find_field(auparse_state_t *au, const char *name);
 const char *auparse_find_field_next(auparse_state_t *au);
+int auparse_field_id(const char *name);
+const char *auparse_find_field_id(auparse_state_t *au, int id);
 unsigned int auparse_get_field_num(const auparse_state_t *au);
 int auparse_goto_field_num(const auparse_state_t *au, unsigned int num);
 
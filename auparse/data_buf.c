@@ -1,5 +1,5 @@
 /* data_buf.c --
- * Copyright 2007,2011 Red Hat Inc
+ * Copyright 2007,2011,2026 Red Hat Inc
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -35,11 +35,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h> // for memmove()
+#include <string.h>
 #include <assert.h>
 #include <stdarg.h>
 #include <errno.h>
 #include "data_buf.h"
+#include "common.h"
 
 /*****************************************************************************/
 /****************************** Internal Defines *****************************/
@@ -58,7 +59,9 @@
 #ifdef DEBUG
 #define DATABUF_VALIDATE(db)                            \
 {                                                       \
-    if (db->alloc_ptr == NULL || db->alloc_size == 0) { \
+    if (!(db->flags & DATABUF_FLAG_PRESERVE_HEAD)) {    \
+        assert(db->limit == 0 || db->len <= db->limit); \
+    } else if (db->alloc_ptr == NULL || db->alloc_size == 0) { \
         assert(db->alloc_ptr == NULL);                  \
         assert(db->alloc_size == 0);                    \
         assert(db->len == 0);                           \
@@ -84,7 +87,8 @@
 /**********************  Internal Function Declarations  *********************/
 /*****************************************************************************/
 
-static int databuf_shift_data_to_beginning(DataBuf *db);
+static void databuf_restore_line(DataBuf *db);
+static void databuf_trim(DataBuf *db);
 
 /*****************************************************************************/
 /*************************  External Global Variables  ***********************/
@@ -104,27 +108,184 @@ static int debug = 0;
 static inline char *databuf_end(const DataBuf *db)
 {return (db->alloc_ptr == NULL) ? NULL : db->alloc_ptr+db->offset+db->len;}
 
-static inline unsigned databuf_tail_size(const DataBuf *db)
-{return db->alloc_size - (db->offset+db->len);}
-
-static inline unsigned databuf_tail_available(DataBuf *db, size_t append_len)
-{return append_len <= databuf_tail_size(db);}
+static inline int databuf_is_ring(const DataBuf *db)
+{return !(db->flags & DATABUF_FLAG_PRESERVE_HEAD);}
 
 /*****************************************************************************/
 /***************************  Internal Functions  ****************************/
 /*****************************************************************************/
 
-static int databuf_shift_data_to_beginning(DataBuf *db)
+/*
+ * databuf_line terminates the line it hands out by writing over the
+ * newline. Put the newline back so preserved data reads the same after a
+ * reset and nothing else sees the change.
+ */
+static void databuf_restore_line(DataBuf *db)
 {
-    DATABUF_VALIDATE(db);
-    if (db->flags & DATABUF_FLAG_PRESERVE_HEAD) return -1;
-    if (databuf_beg(db) == NULL) return 1;
-    if (db->offset) {
-        memmove(db->alloc_ptr, databuf_beg(db), db->len);
-        db->offset = 0;
-    }
-    DATABUF_VALIDATE(db);
-    return 1;
+	if (db->has_term) {
+		*db->term = '\n';
+		db->has_term = 0;
+	}
+}
+
+/* Take a segment from the spares or the heap */
+static DataBufSeg *databuf_seg_new(DataBuf *db)
+{
+	DataBufSeg *seg = db->spare;
+
+	if (seg) {
+		db->spare = seg->next;
+		db->nspare--;
+	} else {
+		seg = malloc(sizeof(DataBufSeg) + DATABUF_SEG_SIZE);
+		if (seg == NULL)
+			return NULL;
+		db->alloc_size += DATABUF_SEG_SIZE;
+	}
+	seg->next = NULL;
+	seg->beg = 0;
+	seg->end = 0;
+	return seg;
+}
+
+/* Keep read segments for later appends, up to what the limit can use */
+static void databuf_seg_release(DataBuf *db, DataBufSeg *seg)
+{
+	size_t keep = db->limit ?
+		(db->limit + DATABUF_SEG_SIZE - 1) / DATABUF_SEG_SIZE : 1;
+
+	if (db->nspare < keep) {
+		seg->next = db->spare;
+		db->spare = seg;
+		db->nspare++;
+	} else {
+		free(seg);
+		db->alloc_size -= DATABUF_SEG_SIZE;
+	}
+}
+
+/*
+ * Let go of ring segments that have been read. It must not run while a
+ * line handed out by databuf_line is still in use.
+ */
+static void databuf_trim(DataBuf *db)
+{
+	DataBufSeg *seg;
+
+	while ((seg = db->head) && seg->beg == seg->end) {
+		if (seg == db->tail) {
+			// The last one is written again from the start
+			seg->beg = 0;
+			seg->end = 0;
+			break;
+		}
+		db->head = seg->next;
+		databuf_seg_release(db, seg);
+	}
+}
+
+static int databuf_ring_append(DataBuf *db, const char *src, size_t src_size)
+{
+	DataBufSeg *first = NULL, *last = NULL, *seg;
+	size_t room;
+
+	databuf_trim(db);
+	room = db->tail ? DATABUF_SEG_SIZE - db->tail->end : 0;
+
+	// Get every segment needed first so a failure changes nothing
+	while (room < src_size) {
+		seg = databuf_seg_new(db);
+		if (seg == NULL) {
+			while ((seg = first)) {
+				first = seg->next;
+				databuf_seg_release(db, seg);
+			}
+			return -1;
+		}
+		if (last)
+			last->next = seg;
+		else
+			first = seg;
+		last = seg;
+		room += DATABUF_SEG_SIZE;
+	}
+	if (first) {
+		if (db->tail)
+			db->tail->next = first;
+		else
+			db->head = first;
+	}
+
+	seg = db->tail ? db->tail : first;
+	db->len += src_size;
+	while (src_size) {
+		size_t n = DATABUF_SEG_SIZE - seg->end;
+
+		if (n > src_size)
+			n = src_size;
+		memcpy(seg->data + seg->end, src, n);
+		seg->end += n;
+		src += n;
+		src_size -= n;
+		if (seg->end == DATABUF_SEG_SIZE && seg->next)
+			seg = seg->next;
+	}
+	if (last)
+		db->tail = last;
+	return 1;
+}
+
+/*
+ * Hand out a line that starts in the head segment but ends in a later
+ * one. The pieces are copied into db->line and the segments advanced.
+ */
+static char *databuf_ring_join(DataBuf *db, size_t *len)
+{
+	DataBufSeg *seg;
+	const char *nl = NULL;
+	size_t line_len = 0, n;
+
+	for (seg = db->head; seg; seg = seg->next) {
+		nl = audit_memchr(seg->data + seg->beg, '\n',
+				  seg->end - seg->beg);
+		if (nl) {
+			line_len += nl - (seg->data + seg->beg);
+			break;
+		}
+		line_len += seg->end - seg->beg;
+	}
+	if (nl == NULL)
+		return NULL;
+
+	if (line_len + 1 > db->line_size) {
+		char *line = realloc(db->line, line_len + 1);
+
+		if (line == NULL)
+			return NULL;
+		db->line = line;
+		db->line_size = line_len + 1;
+	}
+
+	n = 0;
+	for (seg = db->head; ; seg = seg->next) {
+		size_t piece = seg->end - seg->beg;
+
+		if (n + piece > line_len) {
+			// The segment holding the newline
+			piece = line_len - n;
+			memcpy(db->line + n, seg->data + seg->beg, piece);
+			seg->beg += piece + 1;
+			break;
+		}
+		memcpy(db->line + n, seg->data + seg->beg, piece);
+		seg->beg = seg->end;
+		n += piece;
+	}
+	db->line[line_len] = 0;
+	db->len -= line_len + 1;
+	if (len)
+		*len = line_len;
+	return db->line;
 }
 
 /*****************************************************************************/
@@ -138,15 +299,21 @@ void databuf_print(const DataBuf *db, int print_data, char *fmt, ...)
     if (fmt) {
         vprintf(fmt, ap);
     }
-    printf("%salloc_size=%zu alloc_ptr=%p offset=%zu beg=%p len=%zu max_len=%zu flags=[",
-           fmt?" ":"", db->alloc_size, db->alloc_ptr, db->offset, databuf_beg(db), db->len, db->max_len);
+    printf("%salloc_size=%zu alloc_ptr=%p offset=%zu beg=%p len=%zu max_len=%zu limit=%zu flags=[",
+           fmt?" ":"", db->alloc_size, db->alloc_ptr, db->offset, databuf_beg(db), db->len, db->max_len, db->limit);
 
     if (db->flags & DATABUF_FLAG_PRESERVE_HEAD) printf("PRESERVE_HEAD ");
     printf("]");
     
     if (print_data) {
         printf(" [");
-        fwrite(databuf_beg(db), 1, db->len, stdout);
+        if (databuf_is_ring(db)) {
+            const DataBufSeg *seg;
+
+            for (seg = db->head; seg; seg = seg->next)
+                fwrite(seg->data+seg->beg, 1, seg->end-seg->beg, stdout);
+        } else
+            fwrite(databuf_beg(db), 1, db->len, stdout);
         printf("]");
     }
     printf("\n");
@@ -160,9 +327,18 @@ int databuf_init(DataBuf *db, size_t size, unsigned flags)
     db->offset     = 0;
     db->len        = 0;
     db->max_len    = 0;
+    db->limit      = 0;
+    db->has_term   = 0;
     db->flags      = flags;
-
-    if (size) {
+    db->head       = NULL;
+    db->tail       = NULL;
+    db->spare      = NULL;
+    db->nspare     = 0;
+    db->line       = NULL;
+    db->line_size  = 0;
+
+    // A ring grows a segment at a time, there is nothing to size
+    if (size && !databuf_is_ring(db)) {
         if ((db->alloc_ptr = malloc(size))) {
             db->alloc_size = size;
             return 1;
@@ -176,17 +352,33 @@ int databuf_init(DataBuf *db, size_t size, unsigned flags)
 
 void databuf_free(DataBuf *db)
 {
+    DataBufSeg *seg;
+
     DATABUF_VALIDATE(db);
 
     if (db->alloc_ptr != NULL) {
         free(db->alloc_ptr);
     }
+    while ((seg = db->head)) {
+        db->head = seg->next;
+        free(seg);
+    }
+    while ((seg = db->spare)) {
+        db->spare = seg->next;
+        free(seg);
+    }
+    free(db->line);
+    db->tail       = NULL;
+    db->nspare     = 0;
+    db->line       = NULL;
+    db->line_size  = 0;
 
     db->alloc_ptr  = NULL;
     db->alloc_size = 0;
     db->offset     = 0;
     db->len        = 0;
     db->max_len    = 0;
+    db->has_term   = 0;
 
     DATABUF_VALIDATE(db);
 }
@@ -200,18 +392,26 @@ int databuf_append(DataBuf *db, const char *src, size_t src_size)
 	if (src == NULL || src_size == 0)
 		return 0;
 
-	new_len = db->len + src_size;
+	if (src_size > databuf_room(db)) {
+		errno = ENOBUFS;
+		return -1;
+	}
+	databuf_restore_line(db);
 
 #ifdef DEBUG
 	if (debug)
 		databuf_print(db, 1, "databuf_append() size=%zd", src_size);
 #endif
 
-	/* If we can shift data to the beginning do so before any size checks */
-	if (!(db->flags & DATABUF_FLAG_PRESERVE_HEAD) &&
-				!databuf_tail_available(db, src_size))
-		databuf_shift_data_to_beginning(db);
+	if (databuf_is_ring(db)) {
+		if (databuf_ring_append(db, src, src_size) < 0)
+			return -1;
+		DATABUF_VALIDATE(db);
+		return 1;
+	}
 
+	/* A preserved buffer only grows, the head has to stay put */
+	new_len = db->len + src_size;
 	required_size = db->offset + new_len;
 	if (required_size > db->alloc_size) {
 		void *new_alloc;
@@ -228,12 +428,7 @@ int databuf_append(DataBuf *db, const char *src, size_t src_size)
 		db->alloc_ptr  = new_alloc;
 		db->alloc_size = new_alloc_size;
         }
-#ifdef DEBUG
-	if (debug)
-		databuf_print(db, 1, "databuf_append() about to memmove()");
-#endif
-	/* pointers all set up and room available, move the data and update */
-	memmove(databuf_end(db), src, src_size);
+	memcpy(databuf_end(db), src, src_size);
 	db->len = new_len;
 	db->max_len = MAX(db->max_len, new_len);
 #ifdef DEBUG
@@ -250,6 +445,9 @@ int databuf_replace(DataBuf *db, const char *src, size_t src_size)
 
     if (src == NULL || src_size == 0) return 0;
 
+    if (databuf_is_ring(db))
+        databuf_discard(db);
+    databuf_restore_line(db);
     db->len = 0;
     return databuf_append(db, src, src_size);
 }
@@ -263,8 +461,23 @@ int databuf_advance(DataBuf *db, size_t advance)
     if (debug) databuf_print(db, 1, "databuf_advance() enter, advance=%zd", advance);
 #endif
     actual_advance = MIN(advance, db->len);
-    db->offset += actual_advance;
-    db->len -= actual_advance;
+    if (databuf_is_ring(db)) {
+        DataBufSeg *seg;
+        size_t left = actual_advance;
+
+        databuf_restore_line(db);
+        for (seg = db->head; left; seg = seg->next) {
+            size_t n = MIN(left, seg->end - seg->beg);
+
+            seg->beg += n;
+            left -= n;
+        }
+        db->len -= actual_advance;
+        databuf_trim(db);
+    } else {
+        db->offset += actual_advance;
+        db->len -= actual_advance;
+    }
 
 #ifdef DEBUG
     if (debug) databuf_print(db, 1, "databuf_advance() leave, actual_advance=%zd", actual_advance);
@@ -284,6 +497,7 @@ int databuf_reset(DataBuf *db)
     if (debug) databuf_print(db, 1, "databuf_reset() entry");
 #endif
     if (!(db->flags & DATABUF_FLAG_PRESERVE_HEAD)) return -1;
+    databuf_restore_line(db);
     db->offset = 0;
     db->len = MIN(db->alloc_size, db->max_len);
 #ifdef DEBUG
@@ -292,6 +506,75 @@ int databuf_reset(DataBuf *db)
     return 1;
 }
 
+/*
+ * Set the most unread bytes the buffer holds. databuf_append fails with
+ * ENOBUFS rather than go past it, so the caller can consume some first.
+ */
+void databuf_set_limit(DataBuf *db, size_t limit)
+{
+	db->limit = limit;
+}
+
+/* Throw away everything not yet read */
+void databuf_discard(DataBuf *db)
+{
+	DataBufSeg *seg;
+
+	databuf_restore_line(db);
+	if (databuf_is_ring(db)) {
+		for (seg = db->head; seg; seg = seg->next)
+			seg->beg = seg->end;
+		databuf_trim(db);
+	} else
+		db->offset += db->len;
+	db->len = 0;
+}
+
+/*
+ * Hand out the next complete line without copying it. The newline is
+ * replaced by a null so the line can be used as a string, and the data is
+ * advanced past it. The line stays valid until the next call into the
+ * DataBuf. Returns NULL if there is no complete line yet.
+ */
+char *databuf_line(DataBuf *db, size_t *len)
+{
+	const char *nl;
+	char *line;
+	size_t line_len;
+
+	databuf_restore_line(db);
+	if (db->len == 0)
+		return NULL;
+
+	if (databuf_is_ring(db)) {
+		DataBufSeg *seg;
+
+		databuf_trim(db);
+		seg = db->head;
+		line = seg->data + seg->beg;
+		nl = audit_memchr(line, '\n', seg->end - seg->beg);
+		if (nl == NULL)
+			return databuf_ring_join(db, len);
+		line_len = nl - line;
+		seg->beg += line_len + 1;
+	} else {
+		line = databuf_beg(db);
+		nl = audit_memchr(line, '\n', db->len);
+		if (nl == NULL)
+			return NULL;
+		line_len = nl - line;
+		db->offset += line_len + 1;
+	}
+
+	db->term = line + line_len;
+	db->has_term = 1;
+	line[line_len] = 0;
+	db->len -= line_len + 1;
+	if (len)
+		*len = line_len;
+	return line;
+}
+
 /*****************************************************************************/
 /*******************************  Test Program  ******************************/
 /*****************************************************************************/
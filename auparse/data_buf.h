@@ -1,5 +1,5 @@
 /* data_buf.h --
- * Copyright 2007 Red Hat Inc., Durham, North Carolina.
+ * Copyright 2007,2026 Red Hat Inc., Durham, North Carolina.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -35,18 +35,44 @@
 
 #define DATABUF_FLAG_PRESERVE_HEAD (1 << 0)
 
+/* Bytes in each segment of a ring DataBuf */
+#define DATABUF_SEG_SIZE (64 * 1024)
+
 
 /*****************************************************************************/
 /******************************* Type Definitions ****************************/
 /*****************************************************************************/
 
+/*
+ * A DataBuf with DATABUF_FLAG_PRESERVE_HEAD is one flat allocation that can
+ * be read again from the start. Any other DataBuf is a ring: a queue of
+ * fixed size segments that are written at the tail, read at the head and
+ * recycled once read, so data is never moved to make room. Enough read
+ * segments are kept to hold the limit again, or one if there is none.
+ */
+typedef struct databuf_seg {
+    struct databuf_seg *next;
+    size_t beg;		/* first unread byte */
+    size_t end;		/* one past the last byte written */
+    char data[];
+} DataBufSeg;
+
 typedef struct Databuf {
     unsigned flags;
-    size_t alloc_size;
-    char *alloc_ptr;
-    size_t offset;
-    size_t len;
+    size_t alloc_size;	/* bytes allocated for data */
+    char *alloc_ptr;	/* flat buffer */
+    size_t offset;	/* flat buffer read offset */
+    size_t len;		/* unread bytes */
     size_t max_len;
+    size_t limit;	/* most unread bytes held, 0 is no limit */
+    char *term;		/* newline replaced by databuf_line */
+    int has_term;
+    DataBufSeg *head;	/* ring segment being read */
+    DataBufSeg *tail;	/* ring segment being written */
+    DataBufSeg *spare;	/* read segments kept for reuse */
+    unsigned int nspare;
+    char *line;		/* copy of a line that spans segments */
+    size_t line_size;
 } DataBuf;
 
 /*****************************************************************************/
@@ -57,8 +83,21 @@ typedef struct Databuf {
 /*****************************  Inline Functions  ****************************/
 /*****************************************************************************/
 
+/* The unread data, for a ring only as far as the end of its head segment */
 static inline char *databuf_beg(const DataBuf *db)
-{return (db->alloc_ptr == NULL) ? NULL : db->alloc_ptr+db->offset;}
+{
+    if (db->flags & DATABUF_FLAG_PRESERVE_HEAD)
+        return (db->alloc_ptr == NULL) ? NULL : db->alloc_ptr+db->offset;
+    return (db->head == NULL) ? NULL : db->head->data+db->head->beg;
+}
+
+/* How many more bytes databuf_append will take */
+static inline size_t databuf_room(const DataBuf *db)
+{
+    if (db->limit == 0)
+        return (size_t)-1;
+    return db->len < db->limit ? db->limit - db->len : 0;
+}
 
 /*****************************************************************************/
 /****************************  Exported Functions  ***************************/
@@ -78,6 +117,9 @@ int databuf_append(DataBuf *db, const char *src, size_t src_size);
 int databuf_replace(DataBuf *db, const char *src, size_t src_size);
 int databuf_advance(DataBuf *db, size_t advance);
 int databuf_reset(DataBuf *db);
+void databuf_set_limit(DataBuf *db, size_t limit);
+void databuf_discard(DataBuf *db);
+char *databuf_line(DataBuf *db, size_t *len);
 
 AUDIT_HIDDEN_END
 
@@ -1,6 +1,6 @@
 /*
 * ellist.c - Minimal linked list library
-* Copyright (c) 2006-08,2014,2016-17,2023 Red Hat Inc.
+* Copyright (c) 2006-08,2014,2016-17,2023,2026 Red Hat Inc.
 * All Rights Reserved.
 *
 * This library is free software; you can redistribute it and/or
@@ -29,6 +29,7 @@
 #include "ellist.h"
 #include "interpret.h"
 #include "common.h"
+#include "arena.h"
 
 static const char key_sep[2] = { AUDIT_KEY_SEPARATOR, 0 };
 
@@ -42,6 +43,10 @@ void aup_list_create(event_list_t *l)
 	l->e.serial = 0L;
 	l->e.host = NULL;
 	l->cwd = NULL;
+	arena_init(&l->arena);
+	l->next_spare = NULL;
+	l->joined = NULL;
+	l->proj = NULL;
 }
 
 static void aup_list_last(event_list_t *l)
@@ -64,59 +69,61 @@ rnode *aup_list_next(event_list_t *l)
 	return l->cur;
 }
 
-/*
- *  * This function does encoding of "untrusted" names just like the kernel
- *   */
-static char *_audit_c2x(char *final, const char *buf, unsigned int size)
+static char *escape(arena_t *a, const char *tmp)
 {
-	unsigned int i;
-	char *ptr = final;
-	const char *hex = "0123456789ABCDEF";
-
-	for (i=0; i<size; i++) {
-		*ptr++ = hex[(buf[i] & 0xF0)>>4]; /* Upper nibble */
-		*ptr++ = hex[buf[i] & 0x0F];      /* Lower nibble */
+	char *name;
+	int len = strlen(tmp);
+
+	if (audit_escape_count(tmp, len, AUDIT_ESC_ENCODE)) {
+		name = arena_alloc(a, (2*len)+1);
+		if (name == NULL)
+			return NULL;
+		audit_hex_encode(name, tmp, len);
+		name[2*len] = 0;
+		return name;
+	}
+	name = arena_alloc(a, len + 3);
+	if (name) {
+		name[0] = '"';
+		memcpy(name + 1, tmp, len);
+		name[len + 1] = '"';
+		name[len + 2] = 0;
 	}
-	*ptr = 0;
-	return final;
+	return name;
 }
 
-static char *escape(const char *tmp)
+/* Is name one of the fields the consumer projected the records to? */
+static inline int proj_keep(const aup_proj_t *p, const char *name)
 {
-	char *name;
-	const unsigned char *p = (unsigned char *)tmp;
-	while (*p) {
-		if (*p == '"' || *p < 0x21 || *p > 0x7e) {
-			int len = strlen(tmp);
-			name = malloc((2*len)+1);
-			return _audit_c2x(name, tmp, len);
-		}
-		p++;
+	unsigned int i;
+
+	if (p == NULL || p->fields == NULL)
+		return 1;
+	if (name == NULL)
+		return 0;
+	for (i = 0; i < p->nfields; i++) {
+		if (p->fields[i][0] == name[0] &&
+				strcmp(p->fields[i], name) == 0)
+			return 1;
 	}
-	if (asprintf(&name, "\"%s\"", tmp) < 0)
-		name = NULL;
-	return name;
+	return 0;
 }
 
 /* This function does the heavy duty work of splitting a record into
- * its little tiny pieces */
+ * its little tiny pieces. Fields the projection leaves out are not
+ * stored, but are counted in pos so the header fields are still found. */
 static int parse_up_record(rnode* r)
 {
 	char *ptr, *buf, *saved=NULL;
-	unsigned int offset = 0, len;
+	unsigned int offset = 0, len, dropped = 0, pos;
+	arena_t *a = r->nv.arena;
 
-	// Potentially cut the record in two
-	ptr = strchr(r->record, AUDIT_INTERP_SEPARATOR);
-	if (ptr) {
-		*ptr = 0;
-		ptr++;
-	}
-	r->interp = ptr;
 	// Rather than call strndup, we will do it ourselves to reduce
 	// the number of interactions across the record.
-	// len includes the string terminator.
+	// len includes the string terminator. Everything allocated
+	// here is in the event's arena and goes away with the event.
 	len = strlen(r->record) + 1;
-	r->nv.record = buf = malloc(len);
+	r->nv.record = buf = arena_alloc(a, len);
 	if (r->nv.record == NULL)
 		return -1;
 	memcpy(r->nv.record, r->record, len);
@@ -124,7 +131,6 @@ static int parse_up_record(rnode* r)
 	ptr = audit_strsplit_r(buf, &saved);
 	// If no fields we have fuzzer induced problems, leave
 	if (ptr == NULL) {
-		free(buf);
 		r->nv.record = NULL;
 		return -1;
 	}
@@ -185,40 +191,33 @@ static int parse_up_record(rnode* r)
 				}
 			}
 			// Make virtual keys or just store it
-			if (strcmp(n.name, "key") == 0 && *n.val != '(') {
+			if (!proj_keep(r->proj, n.name)) {
+				dropped++;
+			} else if (strcmp(n.name, "key") == 0 &&
+					*n.val != '(') {
 				if (*n.val == '"') {
 					// This is a normal single key.
-					n.name = strdup("key");
-					char *t = strdup(n.val);
-					n.val = t;
-					if (nvlist_append(&r->nv, &n)) {
-						free(n.name);
-						free(n.val);
+					n.name = arena_strdup(a, "key");
+					n.val = arena_strdup(a, n.val);
+					if (nvlist_append(&r->nv, &n))
 						continue;
-					}
 				} else {
 					// Virtual keys
 					char *key, *ptr2, *saved2;
 
 					key = (char *)au_unescape(n.val);
 					if (key == NULL) {
-						n.name = strdup("key");
+						n.name = arena_strdup(a, "key");
 						n.val = NULL;
 						// Malformed key - save as is
-						if (nvlist_append(&r->nv, &n)) {
-							free(n.name);
-							free(n.val);
-						}
+						nvlist_append(&r->nv, &n);
 						continue;
 					}
 					ptr2 = strtok_r(key, key_sep, &saved2);
 					while (ptr2) {
-						n.name = strdup("key");
-						n.val = escape(ptr2);
-						if (nvlist_append(&r->nv, &n)) {
-							free(n.name);
-							free(n.val);
-						}
+						n.name = arena_strdup(a, "key");
+						n.val = escape(a, ptr2);
+						nvlist_append(&r->nv, &n);
 						ptr2 = strtok_r(NULL,
 							key_sep, &saved2);
 					}
@@ -228,30 +227,27 @@ static int parse_up_record(rnode* r)
 			} else {
 				if (strcmp(n.name, "key") == 0) {
 					// This is a null key
-					n.name = strdup("key");
-					char *t = strdup(n.val);
-					n.val = t;
-					if (nvlist_append(&r->nv, &n)) {
-						free(n.name);
-						free(n.val);
+					n.name = arena_strdup(a, "key");
+					n.val = arena_strdup(a, n.val);
+					if (nvlist_append(&r->nv, &n))
 						continue;
-					}
 				} else	// everything not a key
 					nvlist_append(&r->nv, &n);
 			}
 
 			// Do some info gathering for use later
-			if (r->nv.cnt == 1 && strcmp(n.name, "node") == 0)
+			pos = r->nv.cnt + dropped;
+			if (pos == 1 && strcmp(n.name, "node") == 0)
 				offset = 1; // if node, some positions changes
 				// This has to account for seccomp records
-			else if (r->nv.cnt == (1 + offset) &&
+			else if (pos == (1 + offset) &&
 					strcmp(n.name, "type") == 0) {
 				r->type = audit_name_to_msg_type(n.val);
 				if (r->type == AUDIT_URINGOP)
 					r->machine = MACH_IO_URING;
 				// This has to account for seccomp records
-			} else if ((r->nv.cnt == (2 + offset) ||
-					r->nv.cnt == (11 + offset)) &&
+			} else if ((pos == (2 + offset) ||
+					pos == (11 + offset)) &&
 					strcmp(n.name, "arch")== 0){
 				unsigned int ival;
 				errno = 0;
@@ -260,26 +256,26 @@ static int parse_up_record(rnode* r)
 					r->machine = -2;
 				else
 					r->machine = audit_elf_to_machine(ival);
-			} else if ((r->nv.cnt == (3 + offset) ||
-					r->nv.cnt == (12 + offset)) &&
+			} else if ((pos == (3 + offset) ||
+					pos == (12 + offset)) &&
 					strcmp(n.name, "syscall") == 0){
 				errno = 0;
 				r->syscall = strtoul(n.val, NULL, 10);
 				if (errno)
 					r->syscall = -1;
-			} else if (r->nv.cnt == (2 + offset) &&
+			} else if (pos == (2 + offset) &&
 				   strcmp(n.name, "uring_op") == 0) {
 				errno = 0;
 				r->syscall = strtoul(n.val, NULL, 10);
 				if (errno)
 					r->syscall = -1;
-			} else if (r->nv.cnt == (6 + offset) &&
+			} else if (pos == (6 + offset) &&
 					strcmp(n.name, "a0") == 0){
 				errno = 0;
 				r->a0 = strtoull(n.val, NULL, 16);
 				if (errno)
 					r->a0 = -1LL;
-			} else if (r->nv.cnt == (7 + offset) &&
+			} else if (pos == (7 + offset) &&
 					strcmp(n.name, "a1") == 0){
 				errno = 0;
 				r->a1 = strtoull(n.val, NULL, 16);
@@ -288,18 +284,19 @@ static int parse_up_record(rnode* r)
 			} else if (r->type == AUDIT_CWD) {
 				// most common fuzzing hit: duplicate cwds
 				if (strcmp(n.name, "cwd") == 0 && !r->cwd)
-					r->cwd = strdup(n.val);
+					r->cwd = arena_strdup(a, n.val);
 			}
 		} else if (r->type == AUDIT_AVC || r->type == AUDIT_USER_AVC) {
 			// We special case these 2 fields because selinux
 			// avc messages do not label these fields.
 			n.name = NULL;
-			if (nvlist_get_cnt(&r->nv) == (1 + offset)) {
+			pos = r->nv.cnt + dropped;
+			if (pos == (1 + offset)) {
 				// skip over 'avc:'
 				if (strncmp(ptr, "avc", 3) == 0)
 					continue;
-				n.name = strdup("seresult");
-			} else if (nvlist_get_cnt(&r->nv) == (2 + offset)) {
+				n.name = arena_strdup(a, "seresult");
+			} else if (pos == (2 + offset)) {
 				// skip over open brace
 				if (*ptr == '{') {
 					int total = 0, clen;
@@ -309,12 +306,8 @@ static int parse_up_record(rnode* r)
 					ptr = audit_strsplit_r(NULL, &saved);
 					while (ptr && *ptr != '}') {
 						clen = strlen(ptr);
-						if ((clen+1) >= (256-total)) {
-						   if (nvlist_get_cnt(&r->nv)
-									 == 0)
-								free(buf);
+						if ((clen+1) >= (256-total))
 							return -1;
-						}
 						if (tmpctx[0]) {
 							to = stpcpy(to, ",");
 							total++;
@@ -324,50 +317,115 @@ static int parse_up_record(rnode* r)
 						ptr = audit_strsplit_r(NULL,
 								 &saved);
 					}
-					n.name = strdup("seperms");
-					n.val = strdup(tmpctx);
-					if (nvlist_append(&r->nv, &n)) {
-						free(n.name);
-						free(n.val);
+					if (!proj_keep(r->proj, "seperms")) {
+						dropped++;
+						continue;
 					}
+					n.name = arena_strdup(a, "seperms");
+					n.val = arena_strdup(a, tmpctx);
+					nvlist_append(&r->nv, &n);
 					continue;
 				}
 			} else
 				continue;
 
+			if (!proj_keep(r->proj, n.name)) {
+				dropped++;
+				continue;
+			}
 			n.val = ptr;
 			nvlist_append(&r->nv, &n);
 		}
 	} while((ptr = audit_strsplit_r(NULL, &saved)));
 
-	// If for some reason it was useless, delete buf
-	if (r->nv.cnt == 0) {
-		free(buf);
+	// If for some reason it was useless, forget buf
+	if (r->nv.cnt == 0 && dropped == 0) {
 		r->nv.record = NULL;
 		r->nv.end = NULL;
-		free((void *)r->cwd);
 		r->cwd = NULL;
+		r->nv.cur = 0;
+		return -1;
 	}
 
 	r->nv.cur = 0;	// reset to beginning
 	return 0;
 }
 
-int aup_list_append(event_list_t *l, char *record, int list_idx,
-	unsigned int line_number)
+/*
+ * Pull the record type out of the header of a line without splitting it.
+ * The line is len bytes long and does not have to be null terminated.
+ * This covers the "type=X msg=" and "node=N type=X msg=" forms that
+ * auditd writes. Anything unusual returns -1 and is left to
+ * parse_up_record so that both paths agree on what the type is.
+ */
+int aup_line_type(const char *line, size_t len)
 {
-	int rc;
+	const char *ptr = line, *end = line + len, *sp;
+	char name[64];
+	int type;
+
+	if (len > 5 && memcmp(ptr, "node=", 5) == 0) {
+		sp = memchr(ptr + 5, ' ', end - ptr - 5);
+		if (sp == NULL || sp == ptr + 5 || memchr(ptr, 0, sp - ptr))
+			return -1;
+		ptr = sp;
+		while (ptr < end && *ptr == ' ')
+			ptr++;
+	}
+	if (end - ptr < 5 || memcmp(ptr, "type=", 5))
+		return -1;
+	ptr += 5;
+	sp = memchr(ptr, ' ', end - ptr);
+	len = (sp ? sp : end) - ptr;
+	if (len == 0 || len >= sizeof(name) || memchr(ptr, 0, len) ||
+			strchr(":,')", ptr[len-1]))
+		return -1;
+	memcpy(name, ptr, len);
+	name[len] = 0;
+	type = audit_name_to_msg_type(name);
+
+	// Searches on the type field use the name of r->type for unsplit
+	// records, so it has to be exactly what the record says.
+	ptr = audit_msg_type_to_name(type);
+	if (ptr == NULL || strcmp(ptr, name))
+		return -1;
+	return type;
+}
+
+/*
+ * Split a record that was appended lazily. Returns -1 if the record
+ * turned out to have no usable fields.
+ */
+int aup_rnode_parse(rnode *r)
+{
+	r->parsed = 1;
+	nvlist_create(&r->nv, r->nv.arena);
+	return parse_up_record(r);
+}
+
+/*
+ * Add a copy of record to the event. The record is len bytes long and does
+ * not have to be null terminated, so the caller's memory can go away. The
+ * copy and everything made from it are allocated from the event's arena.
+ */
+int aup_list_append(event_list_t *l, const char *record, size_t len,
+	int list_idx, unsigned int line_number)
+{
+	int rc, type;
 	rnode* r;
+	char *ptr;
 
 	if (record == NULL)
 		return -1;
 
 	// First step is build rnode
-	r = malloc(sizeof(rnode));
+	r = arena_alloc(&l->arena, sizeof(rnode) + len + 1);
 	if (r == NULL)
 		return -1;
 
-	r->record = record;
+	r->record = (char *)(r + 1);
+	memcpy(r->record, record, len);
+	r->record[len] = 0;
 	r->interp = NULL;
 	r->cwd = NULL;
 	r->type = 0;
@@ -378,8 +436,11 @@ int aup_list_append(event_list_t *l, char *record, int list_idx,
 	r->item = l->cnt;
 	r->list_idx = list_idx;
 	r->line_number = line_number;
+	r->proj = l->proj;
 	r->next = NULL;
-	nvlist_create(&r->nv);
+	r->parsed = 0;
+	memset(&r->nv, 0, sizeof(r->nv));
+	r->nv.arena = &l->arena;
 
 	// if we are at top, fix this up
 	if (l->head == NULL)
@@ -393,16 +454,35 @@ int aup_list_append(event_list_t *l, char *record, int list_idx,
 	l->cur = r;
 	l->cnt++;
 
-	// Then parse the record up into nvlist
-	rc = parse_up_record(r);
-	if (r->nv.cnt == 0) // This is fuzzer induced, return an error.
-		rc = -1;
+	// Potentially cut the record in two
+	ptr = strchr(r->record, AUDIT_INTERP_SEPARATOR);
+	if (ptr) {
+		*ptr = 0;
+		len = ptr - r->record;
+		ptr++;
+	}
+	r->interp = ptr;
 
-	if (r->cwd) {
-		// Should never be 2 cwd records unless log is corrupted
-		free((void *)l->cwd);
-		l->cwd = r->cwd;
+	// Most consumers only look at the type or a few fields, so the
+	// record is split into its fields on first use. CWD records are
+	// needed by the whole event. AVCs can fail part way through, so
+	// they and anything odd are checked right away.
+	type = aup_line_type(r->record, len);
+	if (type == AUDIT_URINGOP)
+		r->machine = MACH_IO_URING;
+	if (type > 0 && type != AUDIT_CWD && type != AUDIT_AVC &&
+			type != AUDIT_USER_AVC) {
+		r->type = type;
+		return 0;
 	}
+
+	// Then parse the record up into nvlist. If there are no fields,
+	// this is fuzzer induced, return an error.
+	rc = aup_rnode_parse(r);
+
+	// Should never be 2 cwd records unless log is corrupted
+	if (r->cwd)
+		l->cwd = r->cwd;
 	return rc;
 }
 
@@ -414,14 +494,14 @@ void aup_list_clear(event_list_t* l)
 	if (l == NULL)
 		return;
 
+	// Only the interpretations and lookup maps are on the heap
 	current = l->head;
 	while (current) {
 		nextnode=current->next;
 		nvlist_clear(&current->nv, 1);
-		free(current->record);
-		free(current);
 		current=nextnode;
 	}
+	arena_reset(&l->arena);
 	l->head = NULL;
 	l->cur = NULL;
 	l->cnt = 0;
@@ -430,7 +510,25 @@ void aup_list_clear(event_list_t* l)
 	l->e.serial = 0L;
 	free((char *)l->e.host);
 	l->e.host = NULL;
-	free((void *)l->cwd);
+	l->cwd = NULL;
+	while (l->joined) {
+		event_list_t *j = l->joined;
+
+		l->joined = j->joined;
+		j->joined = NULL;
+		aup_list_destroy(j);
+		free(j);
+	}
+}
+
+/* Clear the list and give its arena back to the heap */
+void aup_list_destroy(event_list_t *l)
+{
+	if (l == NULL)
+		return;
+
+	aup_list_clear(l);
+	arena_free(&l->arena);
 }
 
 /*int aup_list_get_event(event_list_t* l, au_event_t *e)
@@ -448,6 +546,37 @@ void aup_list_clear(event_list_t* l)
 	return 1;
 } */
 
+/*
+ * Move the records of from onto the end of l. The records stay in from's
+ * arena, so l takes custody of from and frees it when l is cleared.
+ */
+void aup_list_join(event_list_t *l, event_list_t *from)
+{
+	event_list_t *last;
+	rnode *r;
+
+	if (from->head) {
+		if (l->head == NULL)
+			l->head = from->head;
+		else {
+			aup_list_last(l);
+			l->cur->next = from->head;
+		}
+		for (r = from->head; r; r = r->next)
+			r->item = l->cnt++;
+		if (l->cwd == NULL)
+			l->cwd = from->cwd;
+		from->head = NULL;
+		from->cur = NULL;
+		from->cnt = 0;
+	}
+	for (last = from; last->joined; last = last->joined)
+		;
+	last->joined = l->joined;
+	l->joined = from;
+	l->cur = l->head;
+}
+
 int aup_list_set_event(event_list_t* l, au_event_t *e)
 {
 	if (l == NULL || e == NULL)
@@ -479,7 +608,9 @@ rnode *aup_list_goto_rec(event_list_t *l, int i)
 int aup_list_first_field(const event_list_t *l)
 {
 	if (l && l->cur) {
-		nvlist_first(&l->cur->nv);
+		// An unsplit record starts at its first field anyway
+		if (l->cur->parsed)
+			nvlist_first(&l->cur->nv);
 		return 1;
 	} else
 		return 0;
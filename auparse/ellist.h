@@ -1,6 +1,6 @@
 /*
 * ellist.h - Header file for ellist.c
-* Copyright (c) 2006-07,2017,2021 Red Hat Inc.
+* Copyright (c) 2006-07,2017,2021,2026 Red Hat Inc.
 * All Rights Reserved.
 *
 * This library is free software; you can redistribute it and/or
@@ -29,10 +29,19 @@
 #include "auparse-defs.h"
 #include <sys/types.h>
 #include "nvlist.h"
+#include "arena.h"
+
+/* What a consumer asked to see, see auparse_set_projection */
+typedef struct aup_proj {
+	int *types;		// Sorted record types to keep, NULL for all
+	unsigned int ntypes;	// How many types
+	char **fields;		// Field names to keep, NULL for all
+	unsigned int nfields;	// How many fields
+} aup_proj_t;
 
 /* This is the record linked list head. Only data elements that are 1 per
  * event goes here. */
-typedef struct {
+typedef struct event_list {
 	rnode *head;		// List head
 	rnode *cur;		// Pointer to current node
 	unsigned int cnt;	// How many items in this list
@@ -40,6 +49,10 @@ typedef struct {
 	// Data we add as 1 per event
 	au_event_t e;		// event - time & serial number
 	const char *cwd;	// cwd used for realpath conversion
+	arena_t arena;		// Holds the records and their fields
+	const aup_proj_t *proj;	// Given to the records as they are added
+	struct event_list *next_spare; // Link while on the spare list
+	struct event_list *joined; // Lists whose records were joined on
 } event_list_t;
 
 static inline unsigned int aup_list_get_cnt(const event_list_t *l)
@@ -50,13 +63,35 @@ static inline rnode *aup_list_get_cur(const event_list_t *l)
 
 AUDIT_HIDDEN_START
 
+int aup_rnode_parse(rnode *r);
+int aup_line_type(const char *line, size_t len);
+
+/* Records are split into fields the first time a field is needed */
+static inline void aup_rnode_fields(rnode *r)
+{
+	if (!r->parsed)
+		aup_rnode_parse(r);
+}
+
+/* The current record, split into fields */
+static inline rnode *aup_list_get_cur_fields(const event_list_t *l)
+{
+	rnode *r = aup_list_get_cur(l);
+
+	if (r)
+		aup_rnode_fields(r);
+	return r;
+}
+
 void aup_list_create(event_list_t *l);
 void aup_list_clear(event_list_t* l);
+void aup_list_destroy(event_list_t *l);
 rnode *aup_list_next(event_list_t *l);
-int aup_list_append(event_list_t *l, char *record, int list_idx,
-	unsigned int line_number);
+int aup_list_append(event_list_t *l, const char *record, size_t len,
+	int list_idx, unsigned int line_number);
 //int aup_list_get_event(event_list_t* l, au_event_t *e);
 int aup_list_set_event(event_list_t* l, au_event_t *e);
+void aup_list_join(event_list_t *l, event_list_t *from);
 
 /* Seek to a specific record number */
 rnode *aup_list_goto_rec(event_list_t *l, int i);
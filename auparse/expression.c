@@ -1,6 +1,6 @@
 /*
 * expression.c - Expression parsing and handling
-* Copyright (C) 2008,2014,2016 Red Hat Inc.
+* Copyright (C) 2008,2014,2016,2026 Red Hat Inc.
 * All Rights Reserved.
 *
 * This library is free software; you can redistribute it and/or
@@ -982,6 +982,14 @@ static char *
 eval_raw_value(rnode *record, const struct expr *expr, int *free_it)
 {
 	if (expr->virtual_field == 0) {
+		// The type of an unsplit record is already known. Without
+		// a node it is also field 0, where splitting leaves the cursor.
+		if (!record->parsed && strncmp(record->record, "type=", 5) == 0
+				&& strcmp(expr->v.p.field.name, "type") == 0) {
+			*free_it = 0;
+			return (char *)audit_msg_type_to_name(record->type);
+		}
+		aup_rnode_fields(record);
 		nvlist_first(&record->nv);
 		if (nvlist_find_name(&record->nv, expr->v.p.field.name) == 0)
 			return NULL;
@@ -1006,6 +1014,7 @@ eval_unsigned_value(rnode *record, const struct expr *expr, int *valid)
 {
 	*valid = 0;
 	if (expr->virtual_field == 0) {
+		aup_rnode_fields(record);
 		nvlist_first(&record->nv);
 		if (nvlist_find_name(&record->nv, expr->v.p.field.name) == 0)
 			return 0;
@@ -1030,6 +1039,7 @@ eval_interpreted_value(const auparse_state_t *au, rnode *record,
 	if (expr->virtual_field == 0) {
 		const char *res;
 
+		aup_rnode_fields(record);
 		nvlist_first(&record->nv);
 		if (nvlist_find_name(&record->nv, expr->v.p.field.name) == 0)
 			return NULL;
@@ -1220,6 +1230,7 @@ expr_eval(auparse_state_t *au, rnode *record, const struct expr *expr)
 
 	case EO_FIELD_EXISTS:
 		assert(expr->virtual_field == 0);
+		aup_rnode_fields(record);
 		nvlist_first(&record->nv);
 		res = nvlist_find_name(&record->nv, expr->v.p.field.name) != 0;
 		break;
@@ -1233,3 +1244,781 @@ expr_eval(auparse_state_t *au, rnode *record, const struct expr *expr)
 	}
 	return res;
 }
+
+/* Compiled expressions */
+
+/*
+ * ausearch evaluates the same expression on every record, so the tree is
+ * flattened once into a program. Field names are interned, type names are
+ * turned into numbers, and AND/OR become jumps over the rest of their
+ * operand. Every instruction leaves its result in one register. The set of
+ * record types that can possibly match is worked out up front so that most
+ * records are rejected before their fields are split.
+ */
+
+enum {
+	PI_LEAF,	/* Anything not below, evaluated by expr_eval */
+	PI_NOT,
+	PI_JUMP_FALSE, PI_JUMP_TRUE,	/* Use jump */
+	PI_TYPE,	/* Compares record->type with val.type */
+	PI_RAW, PI_INTERPRETED, PI_UNSIGNED, PI_EXISTS,	/* Use field_id */
+	PI_REGEXP,
+};
+
+#define PROG_MAX_TYPES 16
+
+struct expr_insn {
+	unsigned char code;	/* PI_* */
+	unsigned char op;	/* EO_* of the comparison */
+	int field_id;		/* Interned field name or -1 */
+	unsigned int jump;	/* Next instruction if the jump is taken */
+	union {
+		int type;
+		uint32_t unsigned_val;
+	} val;
+	const struct expr *e;	/* The leaf this came from */
+};
+
+struct type_set {
+	int cnt;		/* -1 means any type */
+	int type[PROG_MAX_TYPES];
+};
+
+struct expr_prog {
+	unsigned int cnt, size;
+	struct expr_insn *insn;
+	struct type_set types;	/* Records of other types never match */
+	struct rule_index *index; /* Instead of insn for many ORed rules */
+};
+
+static struct rule_index *index_create(const struct expr *expr);
+static void index_free(struct rule_index *idx);
+static int index_eval(auparse_state_t *au, rnode *record,
+		      const struct rule_index *idx);
+
+/* Return the record type a raw "type" comparison names, or -1 */
+static int
+raw_type_value(const struct expr *expr)
+{
+	int type;
+
+	if (expr->virtual_field || strcmp(expr->v.p.field.name, "type"))
+		return -1;
+	type = audit_name_to_msg_type(expr->v.p.value.string);
+	// Only names that print back the same way compare equal as strings
+	if (type <= 0 || audit_msg_type_to_name(type) == NULL ||
+	    strcmp(audit_msg_type_to_name(type), expr->v.p.value.string))
+		return -1;
+	return type;
+}
+
+static int
+type_set_has(const struct type_set *s, int type)
+{
+	int i;
+
+	for (i = 0; i < s->cnt; i++)
+		if (s->type[i] == type)
+			return 1;
+	return 0;
+}
+
+/* Fill S with the record types EXPR can be true for */
+static void
+expr_types(const struct expr *expr, struct type_set *s)
+{
+	struct type_set a, b;
+	int i;
+
+	s->cnt = -1;
+	switch (expr->op) {
+	case EO_AND:
+		expr_types(expr->v.sub[0], &a);
+		expr_types(expr->v.sub[1], &b);
+		if (a.cnt < 0 || b.cnt < 0) {
+			*s = a.cnt < 0 ? b : a;
+			break;
+		}
+		s->cnt = 0;
+		for (i = 0; i < a.cnt; i++)
+			if (type_set_has(&b, a.type[i]))
+				s->type[s->cnt++] = a.type[i];
+		break;
+
+	case EO_OR:
+		expr_types(expr->v.sub[0], &a);
+		expr_types(expr->v.sub[1], &b);
+		if (a.cnt < 0 || b.cnt < 0)
+			break;
+		*s = a;
+		for (i = 0; i < b.cnt; i++) {
+			if (type_set_has(s, b.type[i]))
+				continue;
+			if (s->cnt == PROG_MAX_TYPES) {
+				s->cnt = -1;
+				break;
+			}
+			s->type[s->cnt++] = b.type[i];
+		}
+		break;
+
+	case EO_RAW_EQ:
+		if ((s->type[0] = raw_type_value(expr)) > 0)
+			s->cnt = 1;
+		break;
+
+	case EO_VALUE_EQ:
+		if (expr->virtual_field &&
+				expr->v.p.field.id == EF_RECORD_TYPE) {
+			s->type[0] = expr->v.p.value.int_value;
+			s->cnt = 1;
+		}
+		break;
+
+	default:
+		// NOT of an invalid term is true, so nothing can be excluded
+		break;
+	}
+}
+
+static struct expr_insn *
+prog_emit(struct expr_prog *prog, unsigned char code, const struct expr *expr)
+{
+	struct expr_insn *in;
+
+	if (prog->cnt == prog->size) {
+		unsigned int size = prog->size ? prog->size * 2 : 16;
+
+		in = realloc(prog->insn, size * sizeof(*in));
+		if (in == NULL)
+			return NULL;
+		prog->insn = in;
+		prog->size = size;
+	}
+	in = &prog->insn[prog->cnt++];
+	memset(in, 0, sizeof(*in));
+	in->code = code;
+	in->op = expr->op;
+	in->field_id = -1;
+	in->e = expr;
+	return in;
+}
+
+/* Append the code for EXPR to PROG. Return 0 on success, -1 on error. */
+static int
+prog_compile(struct expr_prog *prog, const struct expr *expr)
+{
+	struct expr_insn *in;
+	unsigned int jump;
+
+	switch (expr->op) {
+	case EO_NOT:
+		if (prog_compile(prog, expr->v.sub[0]))
+			return -1;
+		return prog_emit(prog, PI_NOT, expr) ? 0 : -1;
+
+	case EO_AND: case EO_OR:
+		if (prog_compile(prog, expr->v.sub[0]))
+			return -1;
+		jump = prog->cnt;
+		if (prog_emit(prog, expr->op == EO_AND ? PI_JUMP_FALSE :
+					PI_JUMP_TRUE, expr) == NULL)
+			return -1;
+		if (prog_compile(prog, expr->v.sub[1]))
+			return -1;
+		// The result of the first operand is the result of the whole
+		prog->insn[jump].jump = prog->cnt;
+		return 0;
+
+	case EO_RAW_EQ: case EO_RAW_NE: {
+		int type = raw_type_value(expr);
+
+		if (type > 0) {
+			in = prog_emit(prog, PI_TYPE, expr);
+			if (in == NULL)
+				return -1;
+			in->op = expr->op == EO_RAW_EQ ? EO_VALUE_EQ :
+							EO_VALUE_NE;
+			in->field_id = field_name_to_id(expr->v.p.field.name);
+			in->val.type = type;
+			return 0;
+		}
+		// The unsplit record shortcut lives in eval_raw_value
+		if (strcmp(expr->v.p.field.name, "type") == 0)
+			break;
+		in = prog_emit(prog, PI_RAW, expr);
+		if (in == NULL)
+			return -1;
+		in->field_id = field_name_to_id(expr->v.p.field.name);
+		return 0;
+	}
+
+	case EO_INTERPRETED_EQ: case EO_INTERPRETED_NE:
+		in = prog_emit(prog, PI_INTERPRETED, expr);
+		if (in == NULL)
+			return -1;
+		in->field_id = field_name_to_id(expr->v.p.field.name);
+		return 0;
+
+	case EO_VALUE_EQ: case EO_VALUE_NE: case EO_VALUE_LT: case EO_VALUE_LE:
+	case EO_VALUE_GT: case EO_VALUE_GE:
+		if (expr->virtual_field == 0) {
+			in = prog_emit(prog, PI_UNSIGNED, expr);
+			if (in == NULL)
+				return -1;
+			in->field_id = field_name_to_id(expr->v.p.field.name);
+			in->val.unsigned_val = expr->v.p.unsigned_val;
+			return 0;
+		}
+		if (expr->v.p.field.id == EF_RECORD_TYPE) {
+			in = prog_emit(prog, PI_TYPE, expr);
+			if (in == NULL)
+				return -1;
+			in->val.type = expr->v.p.value.int_value;
+			return 0;
+		}
+		break;
+
+	case EO_FIELD_EXISTS:
+		in = prog_emit(prog, PI_EXISTS, expr);
+		if (in == NULL)
+			return -1;
+		in->field_id = field_name_to_id(expr->v.p.field.name);
+		return 0;
+
+	case EO_REGEXP_MATCHES:
+		return prog_emit(prog, PI_REGEXP, expr) ? 0 : -1;
+
+	default:
+		break;
+	}
+	return prog_emit(prog, PI_LEAF, expr) ? 0 : -1;
+}
+
+/* Compile EXPR into a program for expr_prog_eval.
+   On success, return the program. It refers to EXPR, which must outlive it.
+   On error, set errno and return NULL. */
+struct expr_prog *
+expr_compile(const struct expr *expr)
+{
+	struct expr_prog *prog;
+
+	prog = calloc(1, sizeof(*prog));
+	if (prog == NULL)
+		return NULL;
+	prog->types.cnt = -1;
+	if (expr->op == EO_OR) {
+		prog->index = index_create(expr);
+		if (prog->index)
+			return prog;
+		if (errno == ENOMEM) {
+			expr_prog_free(prog);
+			return NULL;
+		}
+	}
+	if (prog_compile(prog, expr)) {
+		expr_prog_free(prog);
+		return NULL;
+	}
+	expr_types(expr, &prog->types);
+	return prog;
+}
+
+/* Free PROG. */
+void
+expr_prog_free(struct expr_prog *prog)
+{
+	if (prog == NULL)
+		return;
+	index_free(prog->index);
+	free(prog->insn);
+	free(prog);
+}
+
+/* Position RECORD's field cursor on the field IN compares. Return 1 if the
+   record has it, 0 otherwise. */
+static int
+prog_field(rnode *record, const struct expr_insn *in)
+{
+	aup_rnode_fields(record);
+	nvlist_first(&record->nv);
+	return nvlist_find_id(&record->nv, in->field_id,
+			      in->e->v.p.field.name);
+}
+
+static int
+cmp_result(unsigned op, int cmp)
+{
+	switch (op) {
+	case EO_VALUE_EQ:
+		return cmp == 0;
+	case EO_VALUE_NE:
+		return cmp != 0;
+	case EO_VALUE_LT:
+		return cmp < 0;
+	case EO_VALUE_LE:
+		return cmp <= 0;
+	case EO_VALUE_GT:
+		return cmp > 0;
+	case EO_VALUE_GE:
+		return cmp >= 0;
+	default:
+		abort();
+	}
+}
+
+/* Evaluate PROG on RECORD in AU->le.
+   Return the same result expr_eval gives for the expression PROG was
+   compiled from. */
+int
+expr_prog_eval(auparse_state_t *au, rnode *record,
+	       const struct expr_prog *prog)
+{
+	unsigned int pc = 0;
+	int res = 0;
+
+	if (prog->index)
+		return index_eval(au, record, prog->index);
+	if (prog->types.cnt >= 0 && !type_set_has(&prog->types, record->type))
+		return 0;
+
+	while (pc < prog->cnt) {
+		const struct expr_insn *in = &prog->insn[pc++];
+		const char *val;
+
+		switch (in->code) {
+		case PI_LEAF:
+			res = expr_eval(au, record, in->e);
+			break;
+
+		case PI_NOT:
+			res = !res;
+			break;
+
+		case PI_JUMP_FALSE:
+			if (res == 0)
+				pc = in->jump;
+			break;
+
+		case PI_JUMP_TRUE:
+			if (res)
+				pc = in->jump;
+			break;
+
+		case PI_TYPE:
+			// A match on the type field leaves the cursor on it.
+			// As in eval_raw_value, a record that starts with
+			// type= is not split for it; with a node it is not
+			// field 0.
+			if (in->e->virtual_field == 0 && (record->parsed ||
+			    strncmp(record->record, "type=", 5)) &&
+			    prog_field(record, in) == 0) {
+				res = 0;
+				break;
+			}
+			res = cmp_result(in->op,
+				compare_unsigned_values(record->type,
+							in->val.type));
+			break;
+
+		case PI_RAW:
+			val = prog_field(record, in) ?
+				nvlist_get_cur_val(&record->nv) : NULL;
+			if (val == NULL)
+				res = 0;
+			else
+				res = (strcmp(in->e->v.p.value.string, val)
+					== 0) == (in->op == EO_RAW_EQ);
+			break;
+
+		case PI_INTERPRETED:
+			if (prog_field(record, in) == 0) {
+				res = 0;
+				break;
+			}
+			val = nvlist_interp_cur_val(au, record);
+			if (val == NULL)
+				val = nvlist_get_cur_val(&record->nv);
+			if (val == NULL)
+				res = 0;
+			else
+				res = (strcmp(in->e->v.p.value.string, val)
+				    == 0) == (in->op == EO_INTERPRETED_EQ);
+			break;
+
+		case PI_UNSIGNED:
+			val = prog_field(record, in) ?
+				nvlist_get_cur_val(&record->nv) : NULL;
+			if (val == NULL)
+				res = 0;
+			else
+				res = cmp_result(in->op,
+					compare_unsigned_values(
+						strtoul(val, NULL, 10),
+						in->val.unsigned_val));
+			break;
+
+		case PI_EXISTS:
+			res = prog_field(record, in);
+			break;
+
+		case PI_REGEXP:
+			res = regexec(in->e->v.regexp, record->record, 0,
+				      NULL, 0) == 0;
+			break;
+
+		default:
+			abort();
+		}
+	}
+	return res;
+}
+
+/* Rule indexing */
+
+/*
+ * audisp-filter and friends OR together one expression per rule. Walking
+ * hundreds of them for every record costs more than everything else, so a
+ * long enough chain of ORs is split back into rules. Each rule is filed in
+ * one bucket: under the value of an equality test on a field that tells
+ * events apart, under the record types it can match, or failing both on
+ * a list that is always tried. A record then only runs the rules in the
+ * buckets its own type and field values select. Candidates are tried in
+ * rule order, so the first rule that matches is the same one the plain OR
+ * would have stopped at.
+ */
+
+#define INDEX_MIN_RULES 8
+
+static const char *const index_field_names[] = {
+	"key", "exe", "syscall", "auid",
+};
+#define INDEX_NAMES (sizeof(index_field_names)/sizeof(index_field_names[0]))
+
+enum { IK_RAW, IK_INTERPRETED, IK_UNSIGNED, IK_TYPE };
+
+/* A field value the record is looked up by */
+struct index_field {
+	int field_id;
+	const char *name;
+	unsigned char kind;	/* IK_* except IK_TYPE */
+};
+
+struct index_bucket {
+	unsigned char kind;
+	unsigned char field;	/* Slot in fields, unused for IK_TYPE */
+	uint32_t hash;
+	const char *str;	/* IK_RAW and IK_INTERPRETED */
+	uint32_t num;		/* IK_UNSIGNED and IK_TYPE */
+	unsigned int *rules;	/* Ascending rule numbers */
+	unsigned int cnt, size;
+};
+
+struct rule_index {
+	unsigned int nrules;
+	struct expr_prog **rules;
+	unsigned int nfields;
+	struct index_field fields[INDEX_NAMES * IK_TYPE];
+	struct index_bucket *buckets;	/* Open addressing, kind 0xff free */
+	unsigned int nbuckets, used;
+	struct index_bucket always;
+};
+
+static uint32_t
+index_hash(unsigned kind, unsigned field, const char *str, uint32_t num)
+{
+	uint32_t h = 2166136261U ^ (kind << 8 | field);
+
+	h *= 16777619U;
+	if (str) {
+		while (*str) {
+			h ^= (unsigned char)*str++;
+			h *= 16777619U;
+		}
+	} else {
+		h ^= num;
+		h *= 16777619U;
+		h ^= h >> 15;
+	}
+	return h;
+}
+
+static struct index_bucket *
+index_lookup(const struct rule_index *idx, unsigned kind, unsigned field,
+	     const char *str, uint32_t num, uint32_t hash)
+{
+	unsigned int mask = idx->nbuckets - 1, i = hash & mask;
+
+	while (idx->buckets[i].kind != 0xff) {
+		struct index_bucket *b = &idx->buckets[i];
+
+		if (b->hash == hash && b->kind == kind && b->field == field &&
+		    (str ? strcmp(b->str, str) == 0 : b->num == num))
+			return b;
+		i = (i + 1) & mask;
+	}
+	return &idx->buckets[i];
+}
+
+static int
+bucket_add(struct index_bucket *b, unsigned int rule)
+{
+	if (b->cnt == b->size) {
+		unsigned int size = b->size ? b->size * 2 : 4;
+		unsigned int *r = realloc(b->rules, size * sizeof(*r));
+
+		if (r == NULL)
+			return -1;
+		b->rules = r;
+		b->size = size;
+	}
+	b->rules[b->cnt++] = rule;
+	return 0;
+}
+
+/* File RULE under the given key. Return 0 on success, -1 on error. */
+static int
+index_add(struct rule_index *idx, unsigned kind, unsigned field,
+	  const char *str, uint32_t num, unsigned int rule)
+{
+	uint32_t hash = index_hash(kind, field, str, num);
+	struct index_bucket *b;
+
+	if ((idx->used + 1) * 2 > idx->nbuckets) {
+		struct index_bucket *old = idx->buckets;
+		unsigned int i, n = idx->nbuckets;
+
+		idx->nbuckets = n ? n * 2 : 64;
+		idx->buckets = malloc(idx->nbuckets * sizeof(*b));
+		if (idx->buckets == NULL) {
+			idx->buckets = old;
+			idx->nbuckets = n;
+			return -1;
+		}
+		for (i = 0; i < idx->nbuckets; i++)
+			idx->buckets[i].kind = 0xff;
+		for (i = 0; i < n; i++) {
+			if (old[i].kind == 0xff)
+				continue;
+			*index_lookup(idx, old[i].kind, old[i].field,
+				old[i].str, old[i].num, old[i].hash) = old[i];
+		}
+		free(old);
+	}
+	b = index_lookup(idx, kind, field, str, num, hash);
+	if (b->kind == 0xff) {
+		memset(b, 0, sizeof(*b));
+		b->kind = kind;
+		b->field = field;
+		b->hash = hash;
+		b->str = str;
+		b->num = num;
+		idx->used++;
+	}
+	return bucket_add(b, rule);
+}
+
+/* Return the slot in IDX->fields for NAME looked up as KIND, or -1 */
+static int
+index_field_slot(struct rule_index *idx, const char *name, unsigned kind)
+{
+	unsigned int i;
+
+	for (i = 0; i < INDEX_NAMES; i++)
+		if (strcmp(index_field_names[i], name) == 0)
+			break;
+	if (i == INDEX_NAMES)
+		return -1;
+	for (i = 0; i < idx->nfields; i++)
+		if (idx->fields[i].kind == kind &&
+		    strcmp(idx->fields[i].name, name) == 0)
+			return i;
+	idx->fields[i].field_id = field_name_to_id(name);
+	idx->fields[i].name = name;
+	idx->fields[i].kind = kind;
+	idx->nfields++;
+	return i;
+}
+
+/* Find an equality test on an indexed field that EXPR can't be true
+   without. Return the leaf or NULL. */
+static const struct expr *
+index_term(const struct expr *expr)
+{
+	const struct expr *e;
+
+	switch (expr->op) {
+	case EO_AND:
+		if ((e = index_term(expr->v.sub[0])))
+			return e;
+		return index_term(expr->v.sub[1]);
+
+	case EO_RAW_EQ: case EO_INTERPRETED_EQ: case EO_VALUE_EQ:
+		if (expr->virtual_field)
+			return NULL;
+		for (unsigned int i = 0; i < INDEX_NAMES; i++)
+			if (strcmp(index_field_names[i],
+				   expr->v.p.field.name) == 0)
+				return expr;
+		return NULL;
+
+	default:
+		return NULL;
+	}
+}
+
+static unsigned int
+count_rules(const struct expr *expr)
+{
+	if (expr->op != EO_OR)
+		return 1;
+	return count_rules(expr->v.sub[0]) + count_rules(expr->v.sub[1]);
+}
+
+/* Compile each rule ORed together in EXPR and file it in IDX */
+static int
+index_rules(struct rule_index *idx, const struct expr *expr)
+{
+	unsigned int rule = idx->nrules, kind;
+	struct expr_prog *prog;
+	const struct expr *term;
+	int i, slot;
+
+	if (expr->op == EO_OR) {
+		if (index_rules(idx, expr->v.sub[0]))
+			return -1;
+		return index_rules(idx, expr->v.sub[1]);
+	}
+	prog = expr_compile(expr);
+	if (prog == NULL)
+		return -1;
+	idx->rules[idx->nrules++] = prog;
+
+	term = index_term(expr);
+	if (term) {
+		kind = term->op == EO_RAW_EQ ? IK_RAW :
+			term->op == EO_INTERPRETED_EQ ? IK_INTERPRETED :
+			IK_UNSIGNED;
+		slot = index_field_slot(idx, term->v.p.field.name, kind);
+		if (kind == IK_UNSIGNED)
+			return index_add(idx, kind, slot, NULL,
+					 term->v.p.unsigned_val, rule);
+		return index_add(idx, kind, slot, term->v.p.value.string,
+				 0, rule);
+	}
+	// A rule that can't match any type never needs to run
+	for (i = 0; i < prog->types.cnt; i++)
+		if (index_add(idx, IK_TYPE, 0, NULL, prog->types.type[i],
+			      rule))
+			return -1;
+	if (prog->types.cnt < 0)
+		return bucket_add(&idx->always, rule);
+	return 0;
+}
+
+/* Build an index for the rules ORed together in EXPR.
+   Return NULL with errno set to ENOMEM on error, or to 0 if there are too
+   few rules to be worth it. */
+static struct rule_index *
+index_create(const struct expr *expr)
+{
+	unsigned int n = count_rules(expr);
+	struct rule_index *idx;
+
+	errno = 0;
+	if (n < INDEX_MIN_RULES)
+		return NULL;
+	idx = calloc(1, sizeof(*idx));
+	if (idx == NULL)
+		goto err;
+	idx->rules = calloc(n, sizeof(*idx->rules));
+	if (idx->rules == NULL || index_rules(idx, expr))
+		goto err;
+	return idx;
+err:
+	index_free(idx);
+	errno = ENOMEM;
+	return NULL;
+}
+
+static void
+index_free(struct rule_index *idx)
+{
+	unsigned int i;
+
+	if (idx == NULL)
+		return;
+	for (i = 0; i < idx->nrules; i++)
+		expr_prog_free(idx->rules[i]);
+	for (i = 0; i < idx->nbuckets; i++)
+		if (idx->buckets[i].kind != 0xff)
+			free(idx->buckets[i].rules);
+	free(idx->buckets);
+	free(idx->always.rules);
+	free(idx->rules);
+	free(idx);
+}
+
+/* Evaluate the rules IDX was built from on RECORD in AU->le. */
+static int
+index_eval(auparse_state_t *au, rnode *record, const struct rule_index *idx)
+{
+	const struct index_bucket *lists[INDEX_NAMES * IK_TYPE + 2];
+	unsigned int pos[INDEX_NAMES * IK_TYPE + 2];
+	unsigned int i, n = 0;
+	const struct index_bucket *b;
+
+	if (idx->always.cnt)
+		lists[n++] = &idx->always;
+	if (idx->nbuckets == 0)
+		goto merge;
+	b = index_lookup(idx, IK_TYPE, 0, NULL, record->type,
+			 index_hash(IK_TYPE, 0, NULL, record->type));
+	if (b->kind != 0xff)
+		lists[n++] = b;
+	for (i = 0; i < idx->nfields; i++) {
+		const struct index_field *f = &idx->fields[i];
+		const char *val;
+		uint32_t num = 0;
+
+		aup_rnode_fields(record);
+		nvlist_first(&record->nv);
+		if (nvlist_find_id(&record->nv, f->field_id, f->name) == 0)
+			continue;
+		if (f->kind == IK_INTERPRETED) {
+			val = nvlist_interp_cur_val(au, record);
+			if (val == NULL)
+				val = nvlist_get_cur_val(&record->nv);
+		} else
+			val = nvlist_get_cur_val(&record->nv);
+		if (val == NULL)
+			continue;
+		if (f->kind == IK_UNSIGNED) {
+			num = strtoul(val, NULL, 10);
+			val = NULL;
+		}
+		b = index_lookup(idx, f->kind, i, val, num,
+				 index_hash(f->kind, i, val, num));
+		if (b->kind != 0xff)
+			lists[n++] = b;
+	}
+
+	// Each rule is in one bucket, so merging the lists tries it once
+merge:
+	memset(pos, 0, sizeof(pos));
+	for (;;) {
+		unsigned int best = 0, rule = UINT_MAX;
+
+		for (i = 0; i < n; i++)
+			if (pos[i] < lists[i]->cnt &&
+			    lists[i]->rules[pos[i]] < rule) {
+				rule = lists[i]->rules[pos[i]];
+				best = i;
+			}
+		if (rule == UINT_MAX)
+			return 0;
+		pos[best]++;
+		if (expr_prog_eval(au, record, idx->rules[rule]))
+			return 1;
+	}
+}
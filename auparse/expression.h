@@ -1,6 +1,6 @@
 /*
 * expression.h - Expression parsing and handling
-* Copyright (C) 2008,2014 Red Hat Inc., Durham, North Carolina.
+* Copyright (C) 2008,2014,2026 Red Hat Inc., Durham, North Carolina.
 * All Rights Reserved.
 *
 * This library is free software; you can redistribute it and/or
@@ -134,6 +134,20 @@ struct expr *expr_create_binary(unsigned op, struct expr *e1, struct expr *e2);
    be false; e.g. !invalid is true.) */
 int expr_eval(auparse_state_t *au, rnode *record, const struct expr *expr);
 
+/* Compile EXPR into a program for expr_prog_eval.
+   On success, return the program. It refers to EXPR, which must outlive it.
+   On error, set errno and return NULL. */
+struct expr_prog *expr_compile(const struct expr *expr);
+
+/* Free PROG. */
+void expr_prog_free(struct expr_prog *prog);
+
+/* Evaluate PROG on RECORD in AU->le.
+   Return the same result expr_eval gives for the expression PROG was
+   compiled from. */
+int expr_prog_eval(auparse_state_t *au, rnode *record,
+		   const struct expr_prog *prog);
+
 AUDIT_HIDDEN_END
 
 #endif
@@ -0,0 +1,55 @@
+/* fieldid.h -- hash used to intern field names
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *      Steve Grubb <sgrubb@redhat.com>
+ */
+
+#ifndef FIELDID_HEADER
+#define FIELDID_HEADER
+
+#include <stdint.h>
+
+/*
+ * gen_fieldids builds a perfect hash over the known field names with
+ * these two functions and the library looks names up with the same
+ * ones. A name is hashed once. The per bucket displacement that
+ * gen_fieldids picked is then mixed in to find the slot.
+ */
+static inline uint64_t field_name_hash(const char *s)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	while (*s) {
+		h ^= (unsigned char)*s++;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static inline unsigned int field_hash_slot(uint64_t h, uint32_t disp,
+		unsigned int slots)
+{
+	h ^= disp * 0x9e3779b97f4a7c15ULL;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return (unsigned int)(h % slots);
+}
+
+#endif
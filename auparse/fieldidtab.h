@@ -0,0 +1,88 @@
+/* fieldidtab.h --
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *      Steve Grubb <sgrubb@redhat.com>
+ */
+
+/*
+ * Field names that show up in records but are neither rule fields in
+ * lib/fieldtab.h nor interpreted fields in typetab.h. Together they make
+ * up the set of names that auparse interns to field ids. The value is
+ * unused.
+ */
+_S(0,	"type"			)
+_S(0,	"node"			)
+_S(0,	"msg"			)
+_S(0,	"op"			)
+_S(0,	"items"			)
+_S(0,	"item"			)
+_S(0,	"nametype"		)
+_S(0,	"dev"			)
+_S(0,	"rdev"			)
+_S(0,	"tty"			)
+_S(0,	"hostname"		)
+_S(0,	"terminal"		)
+_S(0,	"argc"			)
+_S(0,	"cap_fe"		)
+_S(0,	"cap_fver"		)
+_S(0,	"cap_frootid"		)
+_S(0,	"old-ses"		)
+_S(0,	"unit"			)
+_S(0,	"grantors"		)
+_S(0,	"table"			)
+_S(0,	"entries"		)
+_S(0,	"laddr"			)
+_S(0,	"lport"			)
+_S(0,	"rport"			)
+_S(0,	"fd"			)
+_S(0,	"kind"			)
+_S(0,	"ip"			)
+_S(0,	"compat"		)
+_S(0,	"ver"			)
+_S(0,	"format"		)
+_S(0,	"kernel"		)
+_S(0,	"audit_enabled"		)
+_S(0,	"audit_pid"		)
+_S(0,	"audit_backlog_limit"	)
+_S(0,	"audit_failure"		)
+_S(0,	"old"			)
+_S(0,	"nargs"			)
+_S(0,	"seresult"		)
+_S(0,	"seperms"		)
+_S(0,	"tclass"		)
+_S(0,	"permissive"		)
+_S(0,	"bool"			)
+_S(0,	"enforcing"		)
+_S(0,	"old_enforcing"		)
+_S(0,	"new-level"		)
+_S(0,	"selected-context"	)
+_S(0,	"sw_type"		)
+_S(0,	"reason"		)
+_S(0,	"direction"		)
+_S(0,	"fe"			)
+_S(0,	"fver"			)
+_S(0,	"frootid"		)
+_S(0,	"printer"		)
+_S(0,	"resrc"			)
+_S(0,	"module"		)
+_S(0,	"name_len"		)
+_S(0,	"lsm"			)
+_S(0,	"prog-id"		)
+_S(0,	"opid"			)
+_S(0,	"oses"			)
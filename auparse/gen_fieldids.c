@@ -0,0 +1,188 @@
+/* gen_fieldids.c -- Generator of the field name perfect hash.
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *      Steve Grubb <sgrubb@redhat.com>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fieldid.h"
+
+/*
+ * The known field names are the rule fields from libaudit, the fields
+ * that have an interpretation, and a short list of other common ones.
+ * Each unique name gets an id in sorted order. The names are spread over
+ * buckets, then each bucket (biggest first) gets the smallest
+ * displacement that moves all of its names to free slots. The library
+ * then finds a name with one hash, two table reads and one strcmp.
+ */
+
+#define MAX_DISP (1U << 20)
+
+static const char *names[] = {
+#define _S(VAL, S) S,
+#include "fieldtab.h"
+#include "typetab.h"
+#include "fieldidtab.h"
+#undef _S
+};
+
+#define NUM_NAMES (sizeof(names) / sizeof(*names))
+
+struct bucket {
+	unsigned int idx;
+	unsigned int cnt;
+	unsigned int first;	/* first name in the bucket sorted order */
+};
+
+static uint64_t hashes[NUM_NAMES];
+static unsigned int order[NUM_NAMES];
+static unsigned int num_buckets;
+
+static int cmp_names(const void *a, const void *b)
+{
+	return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+static int cmp_by_bucket(const void *a, const void *b)
+{
+	unsigned int x = hashes[*(const unsigned int *)a] % num_buckets;
+	unsigned int y = hashes[*(const unsigned int *)b] % num_buckets;
+
+	return x < y ? -1 : x > y;
+}
+
+static int cmp_buckets(const void *a, const void *b)
+{
+	const struct bucket *x = a, *y = b;
+
+	if (x->cnt != y->cnt)
+		return x->cnt < y->cnt ? 1 : -1;
+	return x->idx < y->idx ? -1 : x->idx > y->idx;
+}
+
+int main(void)
+{
+	unsigned int n = 0, i, j, slots, offset;
+	struct bucket *buckets;
+	uint32_t *disp;
+	short *slot;
+
+	qsort(names, NUM_NAMES, sizeof(*names), cmp_names);
+	for (i = 0; i < NUM_NAMES; i++)
+		if (n == 0 || strcmp(names[n - 1], names[i]))
+			names[n++] = names[i];
+
+	num_buckets = n / 4 + 1;
+	slots = n + n / 4 + 1;
+	buckets = calloc(num_buckets, sizeof(*buckets));
+	disp = calloc(num_buckets, sizeof(*disp));
+	slot = malloc(slots * sizeof(*slot));
+	if (buckets == NULL || disp == NULL || slot == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	for (i = 0; i < slots; i++)
+		slot[i] = -1;
+
+	for (i = 0; i < n; i++) {
+		hashes[i] = field_name_hash(names[i]);
+		order[i] = i;
+	}
+	qsort(order, n, sizeof(*order), cmp_by_bucket);
+	for (i = 0; i < num_buckets; i++)
+		buckets[i].idx = i;
+	for (i = 0; i < n; i++) {
+		struct bucket *b = &buckets[hashes[order[i]] % num_buckets];
+
+		if (b->cnt++ == 0)
+			b->first = i;
+	}
+	qsort(buckets, num_buckets, sizeof(*buckets), cmp_buckets);
+
+	for (i = 0; i < num_buckets && buckets[i].cnt; i++) {
+		struct bucket *b = &buckets[i];
+		uint32_t d;
+
+		for (d = 0; d < MAX_DISP; d++) {
+			for (j = 0; j < b->cnt; j++) {
+				unsigned int id = order[b->first + j];
+				unsigned int s = field_hash_slot(hashes[id], d,
+								 slots);
+				unsigned int k;
+
+				if (slot[s] >= 0)
+					break;
+				for (k = 0; k < j; k++)
+					if (field_hash_slot(hashes[order[b->first
+						+ k]], d, slots) == s)
+						break;
+				if (k < j)
+					break;
+			}
+			if (j == b->cnt)
+				break;
+		}
+		if (d == MAX_DISP) {
+			fprintf(stderr, "No displacement for bucket %u\n",
+				b->idx);
+			return 1;
+		}
+		disp[b->idx] = d;
+		for (j = 0; j < b->cnt; j++) {
+			unsigned int id = order[b->first + j];
+
+			slot[field_hash_slot(hashes[id], d, slots)] = id;
+		}
+	}
+
+	printf("/* This is a generated file, see gen_fieldids.c */\n"
+	       "#define FIELD_ID_COUNT %u\n"
+	       "#define FIELD_HASH_BUCKETS %u\n"
+	       "#define FIELD_HASH_SLOTS %u\n", n, num_buckets, slots);
+
+	printf("static const char field_id_strings[] = \"");
+	for (i = 0; i < n; i++)
+		printf("%s\\0", names[i]);
+	printf("\";\n");
+
+	printf("static const unsigned short field_id_offsets[] = {");
+	for (i = 0, offset = 0; i < n; i++) {
+		printf("%s%u,", i % 10 ? "" : "\n\t", offset);
+		offset += strlen(names[i]) + 1;
+	}
+	printf("\n};\n");
+
+	printf("static const unsigned int field_hash_disp[] = {");
+	for (i = 0; i < num_buckets; i++)
+		printf("%s%u,", i % 10 ? "" : "\n\t", disp[i]);
+	printf("\n};\n");
+
+	printf("static const short field_hash_ids[] = {");
+	for (i = 0; i < slots; i++)
+		printf("%s%d,", i % 10 ? "" : "\n\t", slot[i]);
+	printf("\n};\n");
+
+	free(buckets);
+	free(disp);
+	free(slot);
+	return 0;
+}
@@ -0,0 +1,557 @@
+/*
+ * idcache.c - process wide cache of user and group names
+ * Copyright (c) 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <grp.h>
+#include <limits.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "auparse.h"
+#include "idcache.h"
+
+/*
+ * Every uid and gid in a record is turned into a name through NSS, which
+ * can mean a round trip to sssd or LDAP. All parsers in the process share
+ * one cache of the answers, including the ids that have no name. Entries
+ * are found by id or by name, grow up to a limit and are then replaced
+ * by a CLOCK hand. Answers are trusted for a while so that account
+ * changes are eventually seen. The lock is never held across an NSS call.
+ */
+
+#define IDCACHE_ENTRIES	8192
+#define IDCACHE_TTL	600	// Seconds a name is trusted
+#define IDCACHE_NEG_TTL	60	// Seconds a missing account is trusted
+#define IDC_NONE	UINT_MAX
+
+struct id_entry {
+	char *name;		// NULL if the id has no account
+	unsigned int id;
+	unsigned char kind;	// IDC_UID or IDC_GID
+	unsigned char has_id;	// 0 if the name has no account
+	unsigned char ref;	// Used since the clock hand last passed
+	unsigned char dead;	// Released, waiting on the free list
+	time_t added;
+	unsigned int id_next;	// Next entry in the id bucket
+	unsigned int name_next;	// Next entry in the name bucket
+};
+
+static pthread_mutex_t id_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct id_entry *entries;
+static unsigned int *id_buckets, *name_buckets;
+static unsigned int used, cap, mask, hand;
+static unsigned int free_slots = IDC_NONE;	// Released, chained by id_next
+static unsigned int max_entries = IDCACHE_ENTRIES;
+static unsigned int ttl = IDCACHE_TTL;
+static unsigned int counts[2];
+static unsigned long hits, misses;
+
+static time_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec;
+}
+
+static unsigned int id_hash(int kind, unsigned int id)
+{
+	return ((id * 0x9e3779b1U) >> 7 ^ kind) & mask;
+}
+
+static unsigned int name_hash(int kind, const char *name)
+{
+	uint32_t h = 2166136261U ^ kind;
+
+	while (*name)
+		h = (h ^ (unsigned char)*name++) * 16777619U;
+	return h & mask;
+}
+
+/* Return 1 if E is too old to be believed */
+static int stale(const struct id_entry *e, time_t t)
+{
+	unsigned int life = ttl;
+
+	if (life == 0)
+		return 0;
+	if ((e->name == NULL || e->has_id == 0) && life > IDCACHE_NEG_TTL)
+		life = IDCACHE_NEG_TTL;
+	return t - e->added >= (time_t)life;
+}
+
+static struct id_entry *find_id(int kind, unsigned int id)
+{
+	unsigned int i;
+
+	if (cap == 0)
+		return NULL;
+	for (i = id_buckets[id_hash(kind, id)]; i != IDC_NONE;
+						i = entries[i].id_next) {
+		struct id_entry *e = &entries[i];
+
+		if (e->id == id && e->kind == kind)
+			return e;
+	}
+	return NULL;
+}
+
+static struct id_entry *find_name(int kind, const char *name)
+{
+	unsigned int i;
+
+	if (cap == 0)
+		return NULL;
+	for (i = name_buckets[name_hash(kind, name)]; i != IDC_NONE;
+						i = entries[i].name_next) {
+		struct id_entry *e = &entries[i];
+
+		if (e->kind == kind && strcmp(e->name, name) == 0)
+			return e;
+	}
+	return NULL;
+}
+
+static void link_entry(unsigned int slot)
+{
+	struct id_entry *e = &entries[slot];
+	unsigned int b;
+
+	e->id_next = e->name_next = IDC_NONE;
+	if (e->has_id) {
+		b = id_hash(e->kind, e->id);
+		e->id_next = id_buckets[b];
+		id_buckets[b] = slot;
+	}
+	if (e->name) {
+		b = name_hash(e->kind, e->name);
+		e->name_next = name_buckets[b];
+		name_buckets[b] = slot;
+	}
+}
+
+static void unlink_entry(unsigned int slot)
+{
+	struct id_entry *e = &entries[slot];
+	unsigned int *p;
+
+	if (e->has_id) {
+		p = &id_buckets[id_hash(e->kind, e->id)];
+		while (*p != slot)
+			p = &entries[*p].id_next;
+		*p = e->id_next;
+	}
+	if (e->name) {
+		p = &name_buckets[name_hash(e->kind, e->name)];
+		while (*p != slot)
+			p = &entries[*p].name_next;
+		*p = e->name_next;
+	}
+	free(e->name);
+	counts[e->kind]--;
+}
+
+/* Make room for CAP * 2 entries, rebuilding the buckets */
+static int grow(void)
+{
+	unsigned int i, n = cap ? cap * 2 : 64, buckets = 16;
+	struct id_entry *e;
+	unsigned int *ib, *nb;
+
+	if (n > max_entries)
+		n = max_entries;
+	while (buckets < n * 2)
+		buckets *= 2;
+	e = realloc(entries, n * sizeof(*e));
+	if (e == NULL)
+		return -1;
+	entries = e;
+	ib = malloc(buckets * sizeof(*ib));
+	nb = malloc(buckets * sizeof(*nb));
+	if (ib == NULL || nb == NULL) {
+		free(ib);
+		free(nb);
+		return -1;
+	}
+	free(id_buckets);
+	free(name_buckets);
+	id_buckets = ib;
+	name_buckets = nb;
+	for (i = 0; i < buckets; i++)
+		id_buckets[i] = name_buckets[i] = IDC_NONE;
+	mask = buckets - 1;
+	cap = n;
+	for (i = 0; i < used; i++)
+		if (!entries[i].dead)
+			link_entry(i);
+	return 0;
+}
+
+/* Drop the entry in SLOT and keep the slot for the next answer */
+static void release(unsigned int slot)
+{
+	struct id_entry *e = &entries[slot];
+
+	unlink_entry(slot);
+	e->name = NULL;
+	e->dead = 1;
+	e->id_next = free_slots;
+	free_slots = slot;
+}
+
+/* Remember what NSS said. NAME is taken over, even on failure. Must be
+ * called with id_lock held. */
+static void store(int kind, unsigned int id, int has_id, char *name)
+{
+	struct id_entry *e;
+	unsigned int slot;
+
+	// Older answers about the same id or name are replaced
+	if (has_id && (e = find_id(kind, id)))
+		release(e - entries);
+	if (name && (e = find_name(kind, name)))
+		release(e - entries);
+
+	if (free_slots != IDC_NONE) {
+		slot = free_slots;
+		free_slots = entries[slot].id_next;
+	} else {
+		if (used == cap && cap < max_entries)
+			grow();
+		if (used < cap)
+			slot = used++;
+		else if (cap) {
+			while (entries[hand].ref) {
+				entries[hand].ref = 0;
+				hand = (hand + 1) % cap;
+			}
+			slot = hand;
+			hand = (hand + 1) % cap;
+			unlink_entry(slot);
+		} else {
+			free(name);
+			return;
+		}
+	}
+
+	e = &entries[slot];
+	e->name = name;
+	e->id = id;
+	e->kind = kind;
+	e->has_id = has_id;
+	e->ref = 0;
+	e->dead = 0;
+	e->added = now();
+	link_entry(slot);
+	counts[kind]++;
+}
+
+static void clear(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < used; i++)
+		free(entries[i].name);
+	free(entries);
+	free(id_buckets);
+	free(name_buckets);
+	entries = NULL;
+	id_buckets = name_buckets = NULL;
+	used = cap = mask = hand = 0;
+	free_slots = IDC_NONE;
+	counts[IDC_UID] = counts[IDC_GID] = 0;
+}
+
+static size_t nss_buf_size(void)
+{
+	long len = sysconf(_SC_GETPW_R_SIZE_MAX);
+	long glen = sysconf(_SC_GETGR_R_SIZE_MAX);
+
+	if (glen > len)
+		len = glen;
+	return len > 0 ? (size_t)len : 16384;
+}
+
+/* Not finding an account is reported in a few ways */
+static int nss_missing(int rc)
+{
+	return rc == 0 || rc == ENOENT || rc == ESRCH || rc == EBADF ||
+		rc == EPERM;
+}
+
+/* Ask NSS for the name of KIND ID. Returns 1 and sets *NAME if found,
+ * 0 if there is no such account, -1 if NSS failed. */
+static int nss_name(int kind, unsigned int id, char **name)
+{
+	size_t size = nss_buf_size();
+	char *buf = NULL;
+	int rc;
+
+	*name = NULL;
+	for (;;) {
+		char *tmp = realloc(buf, size);
+
+		if (tmp == NULL) {
+			free(buf);
+			return -1;
+		}
+		buf = tmp;
+		if (kind == IDC_UID) {
+			struct passwd pw, *res = NULL;
+
+			rc = getpwuid_r(id, &pw, buf, size, &res);
+			if (rc == 0 && res)
+				*name = strdup(res->pw_name);
+		} else {
+			struct group gr, *res = NULL;
+
+			rc = getgrgid_r(id, &gr, buf, size, &res);
+			if (rc == 0 && res)
+				*name = strdup(res->gr_name);
+		}
+		if (rc != ERANGE)
+			break;
+		size *= 2;
+	}
+	free(buf);
+	if (*name)
+		return 1;
+	return nss_missing(rc) ? 0 : -1;
+}
+
+/* Ask NSS for the id of KIND NAME. Returns 1 and sets *ID if found, 0 if
+ * there is no such account, -1 if NSS failed. */
+static int nss_id(int kind, const char *name, unsigned int *id)
+{
+	size_t size = nss_buf_size();
+	char *buf = NULL;
+	int rc, found = 0;
+
+	for (;;) {
+		char *tmp = realloc(buf, size);
+
+		if (tmp == NULL) {
+			free(buf);
+			return -1;
+		}
+		buf = tmp;
+		if (kind == IDC_UID) {
+			struct passwd pw, *res = NULL;
+
+			rc = getpwnam_r(name, &pw, buf, size, &res);
+			if (rc == 0 && res) {
+				*id = res->pw_uid;
+				found = 1;
+			}
+		} else {
+			struct group gr, *res = NULL;
+
+			rc = getgrnam_r(name, &gr, buf, size, &res);
+			if (rc == 0 && res) {
+				*id = res->gr_gid;
+				found = 1;
+			}
+		}
+		if (rc != ERANGE)
+			break;
+		size *= 2;
+	}
+	free(buf);
+	if (found)
+		return 1;
+	return nss_missing(rc) ? 0 : -1;
+}
+
+int idcache_name(int kind, unsigned int id, char *buf, size_t size)
+{
+	struct id_entry *e;
+	char *name;
+	int rc;
+
+	pthread_mutex_lock(&id_lock);
+	e = find_id(kind, id);
+	if (e && !stale(e, now())) {
+		hits++;
+		e->ref = 1;
+		rc = e->name != NULL;
+		if (rc)
+			snprintf(buf, size, "%s", e->name);
+		pthread_mutex_unlock(&id_lock);
+		return rc;
+	}
+	misses++;
+	pthread_mutex_unlock(&id_lock);
+
+	rc = nss_name(kind, id, &name);
+	if (rc < 0)
+		return 0;
+	if (name)
+		snprintf(buf, size, "%s", name);
+	pthread_mutex_lock(&id_lock);
+	if (max_entries)
+		store(kind, id, 1, name);
+	else
+		free(name);
+	pthread_mutex_unlock(&id_lock);
+	return rc;
+}
+
+int idcache_id(int kind, const char *name, unsigned int *id)
+{
+	struct id_entry *e;
+	char *copy;
+	int rc;
+
+	pthread_mutex_lock(&id_lock);
+	e = find_name(kind, name);
+	if (e && !stale(e, now())) {
+		hits++;
+		e->ref = 1;
+		rc = e->has_id;
+		if (rc)
+			*id = e->id;
+		pthread_mutex_unlock(&id_lock);
+		return rc;
+	}
+	misses++;
+	pthread_mutex_unlock(&id_lock);
+
+	rc = nss_id(kind, name, id);
+	if (rc < 0)
+		return 0;
+	copy = strdup(name);
+	pthread_mutex_lock(&id_lock);
+	if (max_entries && copy)
+		store(kind, rc ? *id : 0, rc, copy);
+	else
+		free(copy);
+	pthread_mutex_unlock(&id_lock);
+	return rc;
+}
+
+void idcache_flush(void)
+{
+	pthread_mutex_lock(&id_lock);
+	clear();
+	pthread_mutex_unlock(&id_lock);
+}
+
+void idcache_metrics(unsigned int *uids, unsigned int *gids,
+		     unsigned long *h, unsigned long *m)
+{
+	pthread_mutex_lock(&id_lock);
+	*uids = counts[IDC_UID];
+	*gids = counts[IDC_GID];
+	*h = hits;
+	*m = misses;
+	pthread_mutex_unlock(&id_lock);
+}
+
+struct preload_entry {
+	char *name;
+	unsigned int id;
+	int kind;
+};
+
+/* Append one account to LIST, growing it as needed. NAME is taken over. */
+static void preload_add(struct preload_entry **list, unsigned int *cnt,
+			unsigned int *size, int kind, unsigned int id,
+			char *name)
+{
+	if (name == NULL)
+		return;
+	if (*cnt == *size) {
+		unsigned int n = *size ? *size * 2 : 64;
+		struct preload_entry *tmp = realloc(*list, n * sizeof(**list));
+
+		if (tmp == NULL) {
+			free(name);
+			return;
+		}
+		*list = tmp;
+		*size = n;
+	}
+	(*list)[*cnt].name = name;
+	(*list)[*cnt].id = id;
+	(*list)[*cnt].kind = kind;
+	(*cnt)++;
+}
+
+/* Fill the cache with up to LIMIT accounts that getpwent and getgrent
+ * hand out. The accounts are gathered first so that id_lock is only
+ * taken once NSS is done. */
+static void preload(unsigned int limit)
+{
+	struct preload_entry *list = NULL;
+	unsigned int i, cnt = 0, size = 0;
+	struct passwd *pw;
+	struct group *gr;
+
+	setpwent();
+	while (cnt < limit && (pw = getpwent()))
+		preload_add(&list, &cnt, &size, IDC_UID, pw->pw_uid,
+			    strdup(pw->pw_name));
+	endpwent();
+	setgrent();
+	while (cnt < limit && (gr = getgrent()))
+		preload_add(&list, &cnt, &size, IDC_GID, gr->gr_gid,
+			    strdup(gr->gr_name));
+	endgrent();
+
+	pthread_mutex_lock(&id_lock);
+	for (i = 0; i < cnt; i++) {
+		if (max_entries)
+			store(list[i].kind, list[i].id, 1, list[i].name);
+		else
+			free(list[i].name);
+	}
+	pthread_mutex_unlock(&id_lock);
+	free(list);
+}
+
+/*
+ * Set how many ids the process wide cache holds and for how many seconds
+ * an answer is trusted. 0 entries turns caching off, a ttl of 0 trusts
+ * answers until they are replaced. If preload is non-zero, every account
+ * enumerable through NSS is loaded now. Anything cached before is dropped.
+ * Returns 0.
+ */
+int auparse_set_id_cache(unsigned int entries_max, unsigned int ttl_secs,
+			 int do_preload)
+{
+	pthread_mutex_lock(&id_lock);
+	clear();
+	max_entries = entries_max;
+	ttl = ttl_secs;
+	pthread_mutex_unlock(&id_lock);
+	if (do_preload && entries_max)
+		preload(entries_max);
+	return 0;
+}
+
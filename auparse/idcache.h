@@ -0,0 +1,49 @@
+/*
+ * idcache.h - Header file for idcache.c
+ * Copyright (c) 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#ifndef IDCACHE_HEADER
+#define IDCACHE_HEADER
+
+#include "config.h"
+#include "dso.h"
+#include <sys/types.h>
+
+/* What kind of id is cached */
+enum { IDC_UID, IDC_GID };
+
+/* Make these hidden to prevent conflicts */
+AUDIT_HIDDEN_START
+
+/* Put the name of KIND ID in BUF. Returns 1 if it has one, 0 if the
+ * account database doesn't know it. */
+int idcache_name(int kind, unsigned int id, char *buf, size_t size);
+/* Store the id of KIND NAME in ID. Returns 1 if found, 0 if not. */
+int idcache_id(int kind, const char *name, unsigned int *id);
+void idcache_flush(void);
+void idcache_metrics(unsigned int *uids, unsigned int *gids,
+		     unsigned long *hits, unsigned long *misses);
+
+AUDIT_HIDDEN_END
+
+#endif
+
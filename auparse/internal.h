@@ -1,5 +1,5 @@
 /* internal.h --
- * Copyright 2006-07,2013-17,2025 Red Hat Inc.
+ * Copyright 2006-07,2013-17,2025-26 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -29,7 +29,6 @@
 #include "normalize-llist.h"
 #include "dso.h"
 #include "nvlist.h"
-#include "lru.h"
 #include <stdio.h>
 
 /* This is what state the parser is in */
@@ -83,8 +82,22 @@ typedef enum { EBS_EMPTY, EBS_BUILDING, EBS_COMPLETE } au_lol_t;
 typedef struct _au_lolnode {
 	event_list_t  *l;	/* the list of this event's records */
 	au_lol_t      status;	/* this event's build state */
+	int           next;	/* hash chain, or free or retired list */
+	int           heap;	/* index in the timestamp heap or -1 */
+	int           wprev;	/* timer wheel neighbours */
+	int           wnext;
+	unsigned int  wslot;	/* timer wheel slot holding this event */
+	unsigned int  hash;	/* hash of the event's time, serial and node */
 } au_lolnode;
 
+/*
+ * Building events are timed out on a wheel of LOL_WHEEL_SLOTS one second
+ * slots. The extra slot at the end holds events that arrived with a time
+ * the wheel has already passed.
+ */
+#define LOL_WHEEL_SLOTS	64
+#define LOL_WHEEL_LATE	LOL_WHEEL_SLOTS
+
 /*
  * List of events being processed at any one time
  */
@@ -92,6 +105,19 @@ typedef struct {
 	au_lolnode *array;	/* array of events */
 	int         maxi;	/* largest index in array used */
 	size_t      limit;	/* number of events in array */
+	event_list_t *spare;	/* consumed events kept for reuse */
+	unsigned int nspare;	/* number of events on spare */
+	unsigned long reused;	/* events that came from spare */
+	int         free_slot;	/* unused array entries */
+	int         retired;	/* handed out events waiting to be freed */
+	int        *buckets;	/* hash of building events */
+	unsigned int nbuckets;	/* size of buckets, a power of 2 */
+	unsigned int building;	/* number of building events */
+	int        *heap;	/* in flight events, oldest first */
+	unsigned int nheap;	/* number of events in heap */
+	int         wheel[LOL_WHEEL_SLOTS + 1];	/* building events by time */
+	time_t      wheel_time;	/* events up to this time have timed out */
+	int         wheel_set;	/* wheel_time is valid */
 } au_lol;
 
 /*
@@ -102,6 +128,14 @@ typedef struct {
 
 #define ARRAY_LIMIT     80
 
+/* Interpretations a parser remembers unless auparse_set_interp_cache
+ * says otherwise */
+#define INTERP_CACHE_ENTRIES 1024
+
+/* Unread bytes auparse_feed holds unless auparse_set_feed_limit says
+ * otherwise */
+#define FEED_LIMIT (1024 * 1024)
+
 /* This is the name/value pair used by search tables */
 struct nv_pair {
 	int        value;
@@ -138,6 +172,12 @@ typedef struct data
 	const char *how;
 	normalize_option_t opt;
 	value_t key;
+	int syscall_success;	// -1 unknown, else if the syscall worked
+	struct norm_slot *slots; // Where each field of the event is
+	unsigned int nslots;	// Slots in use
+	unsigned int slots_size; // Slots allocated
+	unsigned int *heads;	// Field to its last slot + 1
+	int slots_ok;		// The slots describe the current event
 } normalize_data;
 
 struct opaque
@@ -147,17 +187,29 @@ struct opaque
 					//	 file names
 	int list_idx;			// The index into the source list
 	FILE *in;			// If source is file, this is the fd
+	char *map;			// If source is a regular file, it
+					//	is read from this mapping
+	size_t map_size;		// Length of map
+	size_t map_off;			// Offset of the next line in map
+	size_t map_advised;		// map is read ahead up to here
 	unsigned int line_number;	// line number of current file, zero
 					//	 if invalid
 	char *next_buf;			// The current buffer being broken down
 	unsigned int off;		// The current offset into next_buf
 	char *cur_buf;			// The current buffer being parsed
+	size_t cur_buf_size;		// Allocated size of cur_buf
+	const char *cur_line;		// The current line, in cur_buf,
+					//	the databuf or map
+	size_t cur_line_len;		// Length of cur_line, which is not
+					//	null terminated in map
 	int line_pushed;		// True if retrieve_next_line()
 					//	returns same input
 	event_list_t *le;		// Linked list of record in same event
 	struct expr *expr;		// Search expression or NULL
+	struct expr_prog *prog;		// expr compiled, NULL until searched
 	char *find_field;		// Used to store field name when
 					//	 searching
+	int find_field_id;		// find_field interned, -1 if unknown
 	austop_t search_where;		// Where to put the cursors on a match
 	auparser_state_t parse_state;	// parsing state
 	DataBuf databuf;		// input data
@@ -175,14 +227,30 @@ struct opaque
 	int au_ready;		// For speed, we note how many EBS_COMPLETE
 				// events we hold at any point in time. Thus
 				// we don't have to scan the list
+	unsigned long eoe_complete;	// Events ended by their last record
+	unsigned long timeout_complete;	// Events ended by timeout or flush
+	time_t eoe_timeout;		// end_of_event_timeout from auditd.conf
 	auparse_esc_t escape_mode;
 	message_t message_mode;		// Where to send error messages
 	debug_message_t debug_message;	// Whether or not messages are debug or not
 	const char *tmp_translation;	// Pointer to manage mem for field translation
 	normalize_data norm_data;
 	nvlist interpretations;		// Per-parser interpretations list
-	Queue *uid_cache;               // per-parser UID cache
-	Queue *gid_cache;               // per-parser GID cache
+	int fan_type;			// Last fan_type, fan_info depends on it
+	struct interp_cache *interp_cache; // Remembered interpretations
+	unsigned int interp_cache_max;	// Entries it may hold, 0 is off
+	unsigned long interp_hits;	// Interpretations found in the cache
+	unsigned long interp_misses;	// Cacheable ones that were not
+	unsigned long interp_evictions;	// Entries replaced when full
+	unsigned int par_threads;	// Threads to parse files with
+	struct au_par *par;		// Parallel file parsing, or NULL
+	int keep_eoe;			// Hand out standalone EOE records,
+					//	the end of an event in another file
+	aup_proj_t *proj;		// Records and fields to keep, or NULL
+	int batch_held;			// Current event did not fit the last
+					//	batch and goes in the next one
+	int feed_skip;			// Dropping fed data up to a newline
+	unsigned long feed_dropped;	// Fed lines longer than the limit
 };
 
 AUDIT_HIDDEN_START
@@ -198,6 +266,7 @@ uid_t lookup_uid_from_name(auparse_state_t *au, const char *name);
 // normalize.c
 void init_normalizer(normalize_data *d);
 void clear_normalizer(normalize_data *d);
+void destroy_normalizer(normalize_data *d);
 
 AUDIT_HIDDEN_END
 
@@ -1,6 +1,6 @@
 /*
 * interpret.c - Lookup values to something more readable
-* Copyright (c) 2007-09,2011-16,2018-21,2023 Red Hat Inc.
+* Copyright (c) 2007-09,2011-16,2018-21,2023,2026 Red Hat Inc.
 * All Rights Reserved.
 *
 * This library is free software; you can redistribute it and/or
@@ -22,7 +22,7 @@
 */
 
 #include "config.h"
-#include "lru.h"
+#include "idcache.h"
 #include "libaudit.h"
 #include "internal.h"
 #include "interpret.h"
@@ -138,38 +138,6 @@ typedef enum { S_UNSET=-1, S_FAILED, S_SUCCESS } success_t;
 static char *print_escaped(const char *val);
 static const char *print_signals(const char *val, unsigned int base);
 
-/*
- * This function will take a pointer to a 2 byte Ascii character buffer and
- * return the actual hex value.
- */
-static unsigned char x2c(const unsigned char *buf)
-{
-	static const char AsciiArray[17] = "0123456789ABCDEF";
-	char *ptr;
-	unsigned char total=0;
-
-	ptr = strchr(AsciiArray, (char)toupper(buf[0]));
-	if (ptr)
-		total = (unsigned char)(((ptr-AsciiArray) & 0x0F)<<4);
-	ptr = strchr(AsciiArray, (char)toupper(buf[1]));
-	if (ptr)
-		total += (unsigned char)((ptr-AsciiArray) & 0x0F);
-
-	return total;
-}
-
-// Check if any characters need tty escaping. Returns how many found.
-static unsigned int need_tty_escape(const unsigned char *s, unsigned int len)
-{
-	unsigned int i = 0, cnt = 0;
-	while (i < len) {
-		if (s[i] < 32)
-			cnt++;
-		i++;
-	}
-	return cnt;
-}
-
 // TTY escaping s string into dest.
 static void tty_escape(const char *s, char *dest, unsigned int len)
 {
@@ -188,19 +156,6 @@ static void tty_escape(const char *s, char *dest, unsigned int len)
 }
 
 static const char sh_set[] = "\"'`$\\!()| ";
-static unsigned int need_shell_escape(const char *s, unsigned int len)
-{
-	unsigned int i = 0, cnt = 0;
-	while (i < len) {
-		if (s[i] < 32)
-			cnt++;
-		else if (strchr(sh_set, s[i]))
-			cnt++;
-		i++;
-	}
-	return cnt;
-}
-
 static void shell_escape(const char *s, char *dest, unsigned int len)
 {
 	unsigned int i = 0, j = 0;
@@ -221,20 +176,6 @@ static void shell_escape(const char *s, char *dest, unsigned int len)
 }
 
 static const char quote_set[] = "\"'`$\\!()| ;#&*?[]<>{}";
-static unsigned int need_shell_quote_escape(const unsigned char *s,
-					    unsigned int len)
-{
-	unsigned int i = 0, cnt = 0;
-	while (i < len) {
-		if (s[i] < 32)
-			cnt++;
-		else if (strchr(quote_set, s[i]))
-			cnt++;
-		i++;
-	}
-	return cnt;
-}
-
 static void shell_quote_escape(const char *s, char *dest, unsigned int len)
 {
 	unsigned int i = 0, j = 0;
@@ -263,11 +204,12 @@ static unsigned int need_escaping(const char *s, unsigned int len,
 		case AUPARSE_ESC_RAW:
 			break;
 		case AUPARSE_ESC_TTY:
-			return need_tty_escape(s, len);
+			return audit_escape_count(s, len, AUDIT_ESC_CTRL);
 		case AUPARSE_ESC_SHELL:
-			return need_shell_escape(s, len);
+			return audit_escape_count(s, len, AUDIT_ESC_SHELL);
 		case AUPARSE_ESC_SHELL_QUOTE:
-			return need_shell_quote_escape(s, len);
+			return audit_escape_count(s, len,
+						  AUDIT_ESC_SHELL_QUOTE);
 	}
 	return 0;
 }
@@ -338,7 +280,7 @@ static int is_hex_string(const char *str)
 /* returns a freshly malloc'ed and converted buffer */
 char *au_unescape(char *buf)
 {
-	int olen, len, i;
+	int olen, len;
 	char saved, *str, *ptr = buf;
 
 	/* Find the end of the name */
@@ -379,11 +321,7 @@ char *au_unescape(char *buf)
 		free(str);
 		return NULL;
 	}
-	ptr = str;
-	for (i=0; i<len; i+=2) {
-		*ptr = x2c((unsigned char *)&str[i]);
-		ptr++;
-	}
+	ptr = str + audit_hex_decode(str, str, len);
 	*ptr = 0;
 	len = ptr - str - 1;
 	olen /= 2;
@@ -398,7 +336,7 @@ void init_interpretation_list(auparse_state_t *au)
 {
 	if (au == NULL)
 		return;
-	nvlist_create(&au->interpretations);
+	nvlist_create(&au->interpretations, NULL);
 	au->interpretations.cnt = NEVER_LOADED;
 }
 
@@ -553,39 +491,19 @@ static const char *aulookup_success(int s)
 }
 
 /*
- * hash_name - djb2 string hash
- * @name: string to hash
- *
- * We use djb2 for its small code and reasonable distribution on
- * typical account names, which keeps the cache hash tables balanced
- * without a performance penalty.
- */
-static unsigned int hash_name(const char *name)
-{
-	unsigned int h = 5381;
-	unsigned char c;
-	while ((c = *(const unsigned char *)name++))
-		h = ((h << 5) + h) + c;
-	return h;
-}
-
-/*
- * aulookup_uid - map a uid to a name using the cache
- * @au:   parser state containing the cache
+ * aulookup_uid - map a uid to a name using the id cache
+ * @au:   parser state
  * @uid:  user id to resolve
  * @buf:  caller-provided buffer
  * @size: size of @buf
  *
- * Returns @buf containing the best-effort name. On a cache hit the
- * entry is promoted to the head of the queue; on a miss the system
- * password database is consulted and the result cached.
+ * Returns @buf containing the best-effort name. Misses consult the
+ * system password database and the answer, found or not, is cached
+ * for every parser in the process.
  */
 static const char *aulookup_uid(auparse_state_t *au, uid_t uid,
 				 char *buf, size_t size)
 {
-	char *name = NULL;
-	QNode *q_node;
-
 	if (uid == (uid_t)-1) {
 		snprintf(buf, size, "unset");
 		return buf;
@@ -594,85 +512,35 @@ static const char *aulookup_uid(auparse_state_t *au, uid_t uid,
 		return buf;
 	}
 
-	if (au->uid_cache == NULL)
-		au->uid_cache = init_lru(19, NULL, "uid");
-
-	q_node = check_lru_uid(au->uid_cache, uid);
-	if (q_node) {
-		if (q_node->uid == uid && q_node->name)
-			name = q_node->name;
-		else {
-			struct passwd *pw;
-			pw = getpwuid(uid);
-			if (pw) {
-				free(q_node->name);
-				q_node->name = strdup(pw->pw_name);
-				if (q_node->name) {
-					unsigned int key = hash_name(q_node->name) % au->uid_cache->total;
-					au->uid_cache->name_hash->array[key] = q_node;
-					q_node->uid = uid;
-					name = q_node->name;
-				}
-			}
-		}
-	}
-	if (name != NULL)
-		snprintf(buf, size, "%s", name);
-	else
+	if (idcache_name(IDC_UID, uid, buf, size) == 0)
 		snprintf(buf, size, "unknown(%d)", uid);
 	return buf;
 }
 
-
-void _aulookup_destroy_uid_list(auparse_state_t *au)
-{
-	destroy_lru(au->uid_cache);
-	au->uid_cache = NULL;
-}
 /*
- * lookup_uid_from_name - resolve a name to a uid using the cache
- * @au:   parser state containing the cache
+ * lookup_uid_from_name - resolve a name to a uid using the id cache
+ * @au:   parser state
  * @name: account name to resolve
  *
- * Returns the uid on success or (uid_t)-1 on failure. Cache hits are
- * promoted and misses consult the system password database with the
- * result stored for future lookups.
+ * Returns the uid on success or (uid_t)-1 on failure. Misses consult the
+ * system password database with the result stored for future lookups.
  */
 uid_t lookup_uid_from_name(auparse_state_t *au, const char *name)
 {
-	QNode *q_node;
-	uid_t uid = (uid_t)-1;
+	unsigned int uid;
 
 	if (name == NULL)
 		return (uid_t)-1;
 
-	if (au->uid_cache == NULL)
-		au->uid_cache = init_lru(19, NULL, "uid");
-
-	q_node = check_lru_name(au->uid_cache, name);
-	if (q_node) {
-		if (q_node->uid != (uid_t)-1)
-			uid = q_node->uid;
-		else {
-			struct passwd *pw = getpwnam(name);
-			if (pw) {
-				q_node->uid = pw->pw_uid;
-				unsigned int key = q_node->uid % au->uid_cache->total;
-				au->uid_cache->uid_hash->array[key] = q_node;
-				uid = q_node->uid;
-			}
-		}
-	}
-	return uid;
+	if (idcache_id(IDC_UID, name, &uid))
+		return uid;
+	return (uid_t)-1;
 }
 
 
 static const char *aulookup_gid(auparse_state_t *au, gid_t gid,
 			       char *buf, size_t size)
 {
-	char *name = NULL;
-	QNode *q_node;
-
 	if (gid == (gid_t)-1) {
 		snprintf(buf, size, "unset");
 		return buf;
@@ -681,55 +549,22 @@ static const char *aulookup_gid(auparse_state_t *au, gid_t gid,
 		return buf;
 	}
 
-	if (au->gid_cache == NULL)
-		au->gid_cache = init_lru(19, NULL, "gid");
-
-	q_node = check_lru_uid(au->gid_cache, gid);
-	if (q_node) {
-		if (q_node->uid == gid && q_node->name)
-			name = q_node->name;
-		else {
-			struct group *gr;
-			gr = getgrgid(gid);
-			if (gr) {
-				free(q_node->name);
-				q_node->name = strdup(gr->gr_name);
-				if (q_node->name) {
-					unsigned int key = hash_name(q_node->name) % au->gid_cache->total;
-					au->gid_cache->name_hash->array[key] = q_node;
-					q_node->uid = gid;
-					name = q_node->name;
-				}
-			}
-		}
-	}
-	if (name != NULL)
-		snprintf(buf, size, "%s", name);
-	else
+	if (idcache_name(IDC_GID, gid, buf, size) == 0)
 		snprintf(buf, size, "unknown(%d)", gid);
 	return buf;
 }
 
-
-void aulookup_destroy_gid_list(auparse_state_t *au)
-{
-	destroy_lru(au->gid_cache);
-	au->gid_cache = NULL;
-}
-
 void _auparse_flush_caches(auparse_state_t *au)
 {
-	destroy_lru(au->uid_cache);
-	au->uid_cache = NULL;
-	destroy_lru(au->gid_cache);
-	au->gid_cache = NULL;
+	interp_cache_destroy(au);
+	idcache_flush();
 }
 
 void aulookup_metrics(const auparse_state_t *au,
-			unsigned int *uid, unsigned int *gid)
+			unsigned int *uid, unsigned int *gid,
+			unsigned long *hits, unsigned long *misses)
 {
-	*uid = au->uid_cache ? au->uid_cache->count : 0;
-	*gid = au->gid_cache ? au->gid_cache->count : 0;
+	idcache_metrics(uid, gid, hits, misses);
 }
 static const char *print_uid(auparse_state_t *au,
 				const char *val, unsigned int base)
@@ -2512,29 +2347,28 @@ static const char *print_trust(const char *val)
 }
 
 // fan_type always precedes fan_info
-static int last_type = 2;
-static const char *print_fan_type(const char *val)
+static const char *print_fan_type(auparse_state_t *au, const char *val)
 {
 	const char *out;
 
 	if (strcmp(val, "0") == 0) {
 		out = strdup("none");
-		last_type = 0;
+		au->fan_type = 0;
 	} else if (strcmp(val, "1") == 0) {
 		out = strdup("rule_info");
-		last_type = 1;
+		au->fan_type = 1;
 	} else {
 		out = strdup("unknown");
-		last_type = 2;
+		au->fan_type = 2;
 	}
 
 	return out;
 }
 
-static const char *print_fan_info(const char *val)
+static const char *print_fan_info(auparse_state_t *au, const char *val)
 {
 	char *out;
-	if (last_type == 1) {
+	if (au->fan_type == 1) {
 		errno = 0;
 		unsigned long info = strtoul(val, NULL, 16);
 		if (errno) {
@@ -3407,6 +3241,207 @@ int auparse_interp_adjust_type(int rtype, const char *name, const char *val)
 	return type;
 }
 
+/*
+ * The same few syscall numbers, modes, flags, addresses and proctitles
+ * show up in record after record. Interpretations that only depend on the
+ * field's value, the machine and the escape mode are remembered in a
+ * bounded table. When it's full, a CLOCK hand picks the entry to replace
+ * among those that haven't been hit since it last went by.
+ */
+#define INTERP_CACHE_MAX_VAL 512
+
+struct interp_entry {
+	char *val;
+	char *out;
+	uint32_t hash;
+	int type;
+	int machine;
+	int escape_mode;
+	unsigned int next;	// Next entry in the bucket or INTERP_NONE
+	unsigned char ref;	// Hit since the clock hand last passed
+};
+#define INTERP_NONE UINT_MAX
+
+struct interp_cache {
+	unsigned int size, used, hand;
+	unsigned int mask;	// Buckets - 1
+	unsigned int *buckets;
+	struct interp_entry *entries;
+};
+
+/* Return 1 if the interpretation of TYPE depends only on the value */
+static int interp_cacheable(int type, const idata *id)
+{
+	switch (type) {
+	case AUPARSE_TYPE_ESCAPED:
+	case AUPARSE_TYPE_ESCAPED_FILE:
+		// Relative paths are glued to the cwd
+		return id->cwd == NULL;
+	case AUPARSE_TYPE_SYSCALL:
+	case AUPARSE_TYPE_ARCH:
+	case AUPARSE_TYPE_EXIT:
+	case AUPARSE_TYPE_ESCAPED_KEY:
+	case AUPARSE_TYPE_PERM:
+	case AUPARSE_TYPE_MODE:
+	case AUPARSE_TYPE_MODE_SHORT:
+	case AUPARSE_TYPE_SOCKADDR:
+	case AUPARSE_TYPE_PROMISC:
+	case AUPARSE_TYPE_CAPABILITY:
+	case AUPARSE_TYPE_SUCCESS:
+	case AUPARSE_TYPE_SIGNAL:
+	case AUPARSE_TYPE_LIST:
+	case AUPARSE_TYPE_CAP_BITMAP:
+	case AUPARSE_TYPE_NFPROTO:
+	case AUPARSE_TYPE_ICMPTYPE:
+	case AUPARSE_TYPE_PROTOCOL:
+	case AUPARSE_TYPE_ADDR:
+	case AUPARSE_TYPE_PERSONALITY:
+	case AUPARSE_TYPE_SECCOMP:
+	case AUPARSE_TYPE_OFLAG:
+	case AUPARSE_TYPE_MMAP:
+	case AUPARSE_TYPE_PROCTITLE:
+	case AUPARSE_TYPE_NETACTION:
+	case AUPARSE_TYPE_MACPROTO:
+	case AUPARSE_TYPE_IOCTL_REQ:
+	case AUPARSE_TYPE_FANOTIFY:
+	case AUPARSE_TYPE_NLMCGRP:
+	case AUPARSE_TYPE_RESOLVE:
+	case AUPARSE_TYPE_ERRNO:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static uint32_t interp_hash(int type, int machine, int escape_mode,
+			    const char *val)
+{
+	uint32_t h = 2166136261U;
+
+	h = (h ^ (uint32_t)type) * 16777619U;
+	h = (h ^ (uint32_t)machine) * 16777619U;
+	h = (h ^ (uint32_t)escape_mode) * 16777619U;
+	while (*val)
+		h = (h ^ (unsigned char)*val++) * 16777619U;
+	return h;
+}
+
+static struct interp_entry *interp_cache_find(struct interp_cache *c,
+		uint32_t hash, int type, int machine, int escape_mode,
+		const char *val)
+{
+	unsigned int i = c->buckets[hash & c->mask];
+
+	while (i != INTERP_NONE) {
+		struct interp_entry *e = &c->entries[i];
+
+		if (e->hash == hash && e->type == type &&
+		    e->machine == machine && e->escape_mode == escape_mode &&
+		    strcmp(e->val, val) == 0)
+			return e;
+		i = e->next;
+	}
+	return NULL;
+}
+
+static void interp_cache_add(auparse_state_t *au, uint32_t hash, int type,
+		int machine, int escape_mode, const char *val, const char *out)
+{
+	struct interp_cache *c = au->interp_cache;
+	struct interp_entry *e;
+	unsigned int slot, *p;
+	char *v, *o;
+
+	if (c == NULL) {
+		unsigned int i, n = 16;
+
+		while (n < au->interp_cache_max * 2)
+			n *= 2;
+		c = calloc(1, sizeof(*c));
+		if (c == NULL)
+			return;
+		c->size = au->interp_cache_max;
+		c->mask = n - 1;
+		c->buckets = malloc(n * sizeof(*c->buckets));
+		c->entries = malloc(c->size * sizeof(*c->entries));
+		if (c->buckets == NULL || c->entries == NULL) {
+			free(c->buckets);
+			free(c->entries);
+			free(c);
+			return;
+		}
+		for (i = 0; i < n; i++)
+			c->buckets[i] = INTERP_NONE;
+		au->interp_cache = c;
+	}
+
+	v = strdup(val);
+	o = strdup(out);
+	if (v == NULL || o == NULL) {
+		free(v);
+		free(o);
+		return;
+	}
+	if (c->used < c->size)
+		slot = c->used++;
+	else {
+		while (c->entries[c->hand].ref) {
+			c->entries[c->hand].ref = 0;
+			c->hand = (c->hand + 1) % c->size;
+		}
+		slot = c->hand;
+		c->hand = (c->hand + 1) % c->size;
+
+		e = &c->entries[slot];
+		p = &c->buckets[e->hash & c->mask];
+		while (*p != slot)
+			p = &c->entries[*p].next;
+		*p = e->next;
+		free(e->val);
+		free(e->out);
+		au->interp_evictions++;
+	}
+
+	e = &c->entries[slot];
+	e->val = v;
+	e->out = o;
+	e->hash = hash;
+	e->type = type;
+	e->machine = machine;
+	e->escape_mode = escape_mode;
+	e->ref = 0;
+	e->next = c->buckets[hash & c->mask];
+	c->buckets[hash & c->mask] = slot;
+}
+
+void interp_cache_destroy(auparse_state_t *au)
+{
+	struct interp_cache *c = au->interp_cache;
+	unsigned int i;
+
+	if (c == NULL)
+		return;
+	for (i = 0; i < c->used; i++) {
+		free(c->entries[i].val);
+		free(c->entries[i].out);
+	}
+	free(c->buckets);
+	free(c->entries);
+	free(c);
+	au->interp_cache = NULL;
+}
+
+/*
+ * Set how many interpretations a parser remembers. 0 turns the cache off
+ * and frees it. Returns 0.
+ */
+int auparse_set_interp_cache(auparse_state_t *au, unsigned int entries)
+{
+	interp_cache_destroy(au);
+	au->interp_cache_max = entries;
+	return 0;
+}
+
 /*
  * This can be called by either interpret() or from ausearch-report or
  * auditctl-listing.c. Returns a malloc'ed buffer that the caller must free.
@@ -3415,6 +3450,8 @@ char *auparse_do_interpretation(auparse_state_t *au, int type, const idata *id,
 				auparse_esc_t escape_mode)
 {
 	const char *out;
+	uint32_t hash = 0;
+	int cache = 0;
 
 	nvlist *il = &au->interpretations;
 
@@ -3441,6 +3478,23 @@ char *auparse_do_interpretation(auparse_state_t *au, int type, const idata *id,
 	}
 unknown:
 
+	if (au->interp_cache_max && id->val && interp_cacheable(type, id) &&
+	    strlen(id->val) <= INTERP_CACHE_MAX_VAL) {
+		struct interp_entry *e = NULL;
+
+		hash = interp_hash(type, id->machine, escape_mode, id->val);
+		if (au->interp_cache)
+			e = interp_cache_find(au->interp_cache, hash, type,
+					id->machine, escape_mode, id->val);
+		if (e) {
+			au->interp_hits++;
+			e->ref = 1;
+			return strdup(e->out);
+		}
+		au->interp_misses++;
+		cache = 1;
+	}
+
 	switch(type) {
 		case AUPARSE_TYPE_UID:
 			out = print_uid(au, id->val, 10);
@@ -3564,10 +3618,10 @@ unknown:
 			out = print_trust(id->val);
 			break;
 		case AUPARSE_TYPE_FAN_TYPE:
-			out = print_fan_type(id->val);
+			out = print_fan_type(au, id->val);
 			break;
 		case AUPARSE_TYPE_FAN_INFO:
-			out = print_fan_info(id->val);
+			out = print_fan_info(au, id->val);
 			break;
 		case AUPARSE_TYPE_ERRNO:
 			out = print_errno(id->val);
@@ -3648,6 +3702,10 @@ unknown:
 			}
 		}
 	}
+	// socketcall and ipc are named after a0, which isn't in the key
+	if (cache && out && !(type == AUPARSE_TYPE_SYSCALL && strchr(out, '(')))
+		interp_cache_add(au, hash, type, id->machine, escape_mode,
+				 id->val, out);
 	return (char *)out;
 }
 
@@ -40,10 +40,10 @@ void free_interpretation_list(auparse_state_t *au);
 unsigned int interpretation_list_cnt(const auparse_state_t *au);
 int lookup_type(const char *name);
 const char *do_interpret(auparse_state_t *au, rnode *r);
-void _aulookup_destroy_uid_list(auparse_state_t *au);
-void aulookup_destroy_gid_list(auparse_state_t *au);
 void aulookup_metrics(const auparse_state_t *au, unsigned int *uid,
-			unsigned int *gid);
+			unsigned int *gid, unsigned long *hits,
+			unsigned long *misses);
+void interp_cache_destroy(auparse_state_t *au);
 char *au_unescape(char *buf)  __attribute_malloc__ __attr_dealloc_free;
 
 AUDIT_HIDDEN_END
@@ -1,5 +1,5 @@
 /* normalize.c --
- * Copyright 2016-18,2021 Red Hat Inc.
+ * Copyright 2016-18,2021,2026 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -26,9 +26,11 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include <pwd.h>
+#include <pthread.h>
 #include "libaudit.h"
 #include "auparse.h"
 #include "internal.h"
+#include "interpret.h"
 #include "normalize-llist.h"
 #include "normalize-internal.h"
 #include "gen_tables.h"
@@ -52,9 +54,184 @@
 #define is_unset(y) (get_record(y) == UNSET)
 #define D au->norm_data
 
-static int syscall_success;
+/* The fields the normalizer looks for */
+enum {
+#define _S(A, B) A,
+#include "normalize_fieldtab.h"
+#undef _S
+	NF_COUNT
+};
+
+static const char *const norm_field_names[NF_COUNT] = {
+#define _S(A, B) B,
+#include "normalize_fieldtab.h"
+#undef _S
+};
+
+/*
+ * The field slot table. auparse_normalize makes one pass over the event
+ * and notes where every field it could want is. Fields with the same name
+ * are chained back to front, so a lookup picks the first one at or after
+ * the cursor without scanning the records in between.
+ */
+struct norm_slot {
+	unsigned int rec;	// Record number
+	unsigned int field;	// Field number in the record
+	unsigned int prev;	// Earlier slot with the same name + 1, or 0
+	unsigned int nf;	// Which of the normalizer's fields
+};
+
+/* Names to NF index + 1 by open addressing, most names miss in one probe */
+#define NORM_HASH_SIZE 256
+static unsigned char norm_hash[NORM_HASH_SIZE];
+static pthread_once_t norm_hash_once = PTHREAD_ONCE_INIT;
+
+static inline unsigned int norm_name_hash(const char *name, size_t len)
+{
+	return (len * 37 + (unsigned char)name[0] * 5 +
+		(unsigned char)name[len / 2] * 3 +
+		(unsigned char)name[len - 1]) & (NORM_HASH_SIZE - 1);
+}
+
+static void norm_hash_init(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < NF_COUNT; i++) {
+		const char *name = norm_field_names[i];
+		unsigned int h = norm_name_hash(name, strlen(name));
+
+		while (norm_hash[h])
+			h = (h + 1) & (NORM_HASH_SIZE - 1);
+		norm_hash[h] = i + 1;
+	}
+}
+
+/* Returns the NF index of name or -1 if the normalizer never wants it */
+static int norm_name_lookup(const char *name)
+{
+	size_t len = strlen(name);
+	unsigned int h;
+
+	if (len == 0)
+		return -1;
+	for (h = norm_name_hash(name, len); norm_hash[h];
+			h = (h + 1) & (NORM_HASH_SIZE - 1)) {
+		unsigned int nf = norm_hash[h] - 1;
+
+		if (strcmp(norm_field_names[nf], name) == 0)
+			return nf;
+	}
+	return -1;
+}
+
 static value_t find_simple_object(auparse_state_t *au, int type);
 
+/* Returns 0 on success and 1 if the table could not be made */
+static int norm_fill_slots(auparse_state_t *au)
+{
+	unsigned int i;
+	rnode *r;
+
+	pthread_once(&norm_hash_once, norm_hash_init);
+	D.nslots = 0;
+	D.slots_ok = 0;
+	if (D.heads == NULL) {
+		D.heads = malloc(NF_COUNT * sizeof(*D.heads));
+		if (D.heads == NULL)
+			return 1;
+	}
+	memset(D.heads, 0, NF_COUNT * sizeof(*D.heads));
+	if (au->le == NULL)
+		return 1;
+
+	for (r = au->le->head; r; r = r->next) {
+		nvlist *l = &r->nv;
+
+		aup_rnode_fields(r);
+		for (i = 0; i < l->cnt; i++) {
+			const nvnode *n = &l->array[i];
+			struct norm_slot *s;
+			int nf;
+
+			nf = n->name ? norm_name_lookup(n->name) : -1;
+			if (nf < 0)
+				continue;
+			if (D.nslots == D.slots_size) {
+				unsigned int size = D.slots_size ?
+						D.slots_size * 2 : 64;
+				s = realloc(D.slots, size * sizeof(*s));
+				if (s == NULL)
+					return 1;
+				D.slots = s;
+				D.slots_size = size;
+			}
+			s = &D.slots[D.nslots++];
+			s->rec = r->item;
+			s->field = i;
+			s->nf = nf;
+			s->prev = D.heads[nf];
+			D.heads[nf] = D.nslots;
+		}
+	}
+	D.slots_ok = 1;
+	return 0;
+}
+
+/*
+ * This works like auparse_find_field, including where it leaves the
+ * cursor, but takes the field from the slot table.
+ */
+static const char *norm_find(auparse_state_t *au, unsigned int nf)
+{
+	const struct norm_slot *s = NULL;
+	unsigned int i, cur;
+	rnode *r, *n;
+
+	if (!D.slots_ok)
+		return auparse_find_field(au, norm_field_names[nf]);
+	if (au->le == NULL || au->le->e.sec == 0)
+		return NULL;
+	r = aup_list_get_cur_fields(au->le);
+	if (r == NULL)
+		return NULL;
+	cur = r->nv.cur;
+
+	// The first one at or after the cursor
+	for (i = D.heads[nf]; i; i = D.slots[i - 1].prev) {
+		const struct norm_slot *t = &D.slots[i - 1];
+
+		if (t->rec < r->item || (t->rec == r->item && t->field < cur))
+			break;
+		s = t;
+	}
+	if (s && s->rec == r->item && s->field == cur)
+		return r->nv.array[cur].val;
+
+	// The search stops at the last field of the record it starts in
+	if (r->nv.cnt == 0 || cur >= r->nv.cnt - 1)
+		return NULL;
+	r->nv.cur = cur + 1;
+
+	if (s == NULL) {
+		// A failed search walks off the end of the event
+		for (n = r->next; n; n = n->next)
+			nvlist_first(&n->nv);
+		au->le->cur = NULL;
+		return NULL;
+	}
+	if (s->rec != r->item) {
+		for (n = r->next; n->item != s->rec; n = n->next)
+			nvlist_first(&n->nv);
+		au->le->cur = n;
+		free_interpretation_list(au);
+		load_interpretation_list(au, n->interp);
+		r = n;
+	}
+	r->nv.cur = s->field;
+	return r->nv.array[s->field].val;
+}
+
 void init_normalizer(normalize_data *d)
 {
 	d->evkind = NULL;
@@ -73,7 +250,12 @@ void init_normalizer(normalize_data *d)
 	d->how = NULL;
 	d->opt = NORM_OPT_ALL;
 	d->key = set_record(0, UNSET);
-	syscall_success = -1;
+	d->syscall_success = -1;
+	d->slots = NULL;
+	d->nslots = 0;
+	d->slots_size = 0;
+	d->heads = NULL;
+	d->slots_ok = 0;
 }
 
 void clear_normalizer(normalize_data *d)
@@ -97,7 +279,19 @@ void clear_normalizer(normalize_data *d)
 	d->how = NULL;
 	d->opt = NORM_OPT_ALL;
 	d->key = set_record(0, UNSET);
-	syscall_success = -1;
+	d->syscall_success = -1;
+	d->slots_ok = 0;
+}
+
+void destroy_normalizer(normalize_data *d)
+{
+	clear_normalizer(d);
+	free(d->slots);
+	d->slots = NULL;
+	d->nslots = 0;
+	d->slots_size = 0;
+	free(d->heads);
+	d->heads = NULL;
 }
 
 static void set_system_subject_what(auparse_state_t *au)
@@ -146,10 +340,10 @@ check:
 	return 0;
 }
 
-static unsigned int set_prime_subject(auparse_state_t *au, const char *str,
+static unsigned int set_prime_subject(auparse_state_t *au, unsigned int nf,
 	unsigned int rnum)
 {
-	if (auparse_find_field(au, str)) {
+	if (norm_find(au, nf)) {
 		D.actor.primary = set_record(0, rnum);
 		D.actor.primary = set_field(D.actor.primary,
 				auparse_get_field_num(au));
@@ -158,10 +352,10 @@ static unsigned int set_prime_subject(auparse_state_t *au, const char *str,
 	return 1;
 }
 
-static unsigned int set_secondary_subject(auparse_state_t *au, const char *str,
+static unsigned int set_secondary_subject(auparse_state_t *au, unsigned int nf,
 	unsigned int rnum)
 {
-	if (auparse_find_field(au, str)) {
+	if (norm_find(au, nf)) {
 		D.actor.secondary = set_record(0, rnum);
 		D.actor.secondary = set_field(D.actor.secondary,
 				auparse_get_field_num(au));
@@ -170,12 +364,12 @@ static unsigned int set_secondary_subject(auparse_state_t *au, const char *str,
 	return 1;
 }
 
-static unsigned int add_subj_attr(auparse_state_t *au, const char *str,
+static unsigned int add_subj_attr(auparse_state_t *au, unsigned int nf,
 	unsigned int rnum)
 {
 	value_t attr;
 
-	if ((auparse_find_field(au, str))) {
+	if ((norm_find(au, nf))) {
 		attr = set_record(0, rnum);
 		attr = set_field(attr, auparse_get_field_num(au));
 		if (cllist_append(&D.actor.attr, attr, NULL))
@@ -187,10 +381,10 @@ static unsigned int add_subj_attr(auparse_state_t *au, const char *str,
 	return 1;
 }
 
-static unsigned int set_prime_object(auparse_state_t *au, const char *str,
+static unsigned int set_prime_object(auparse_state_t *au, unsigned int nf,
 	unsigned int rnum)
 {
-	if (auparse_find_field(au, str)) {
+	if (norm_find(au, nf)) {
 		D.thing.primary = set_record(0, rnum);
 		D.thing.primary = set_field(D.thing.primary,
 			auparse_get_field_num(au));
@@ -199,7 +393,7 @@ static unsigned int set_prime_object(auparse_state_t *au, const char *str,
 	return 1;
 }
 
-static unsigned int set_prime_object2(auparse_state_t *au, const char *str,
+static unsigned int set_prime_object2(auparse_state_t *au, unsigned int nf,
 	unsigned int adjust)
 {
 	unsigned int rnum = 2 + adjust;
@@ -207,7 +401,7 @@ static unsigned int set_prime_object2(auparse_state_t *au, const char *str,
 	auparse_goto_record_num(au, rnum);
 	auparse_first_field(au);
 
-	if (auparse_find_field(au, str)) {
+	if (norm_find(au, nf)) {
 		D.thing.two = set_record(0, rnum);
 		D.thing.two = set_field(D.thing.two,
 			auparse_get_field_num(au));
@@ -216,12 +410,12 @@ static unsigned int set_prime_object2(auparse_state_t *au, const char *str,
 	return 1;
 }
 
-static unsigned int add_obj_attr(auparse_state_t *au, const char *str,
+static unsigned int add_obj_attr(auparse_state_t *au, unsigned int nf,
 	unsigned int rnum)
 {
 	value_t attr;
 
-	if ((auparse_find_field(au, str))) {
+	if ((norm_find(au, nf))) {
 		attr = set_record(0, rnum);
 		attr = set_field(attr, auparse_get_field_num(au));
 		if (cllist_append(&D.thing.attr, attr, NULL))
@@ -234,7 +428,7 @@ static unsigned int add_obj_attr(auparse_state_t *au, const char *str,
 
 static unsigned int add_session(auparse_state_t *au, unsigned int rnum)
 {
-	if (auparse_find_field(au, "ses")) {
+	if (norm_find(au, NF_SES)) {
 		D.session = set_record(0, rnum);
 		D.session = set_field(D.session,
 				auparse_get_field_num(au));
@@ -246,7 +440,7 @@ static unsigned int add_session(auparse_state_t *au, unsigned int rnum)
 
 static unsigned int set_results(auparse_state_t *au, unsigned int rnum)
 {
-	if (auparse_find_field(au, "res")) {
+	if (norm_find(au, NF_RES)) {
 		D.results = set_record(0, rnum);
 		D.results = set_field(D.results, auparse_get_field_num(au));
 		return 0;
@@ -267,18 +461,18 @@ static void syscall_subj_attr(auparse_state_t *au)
 				return;
 			}
 
-			add_subj_attr(au, "ppid", rnum);
-			add_subj_attr(au, "pid", rnum);
-			add_subj_attr(au, "gid", rnum);
-			add_subj_attr(au, "euid", rnum);
-			add_subj_attr(au, "suid", rnum);
-			add_subj_attr(au, "fsuid", rnum);
-			add_subj_attr(au, "egid", rnum);
-			add_subj_attr(au, "sgid", rnum);
-			add_subj_attr(au, "fsgid", rnum);
-			add_subj_attr(au, "tty", rnum);
+			add_subj_attr(au, NF_PPID, rnum);
+			add_subj_attr(au, NF_PID, rnum);
+			add_subj_attr(au, NF_GID, rnum);
+			add_subj_attr(au, NF_EUID, rnum);
+			add_subj_attr(au, NF_SUID, rnum);
+			add_subj_attr(au, NF_FSUID, rnum);
+			add_subj_attr(au, NF_EGID, rnum);
+			add_subj_attr(au, NF_SGID, rnum);
+			add_subj_attr(au, NF_FSGID, rnum);
+			add_subj_attr(au, NF_TTY, rnum);
 			add_session(au, rnum);
-			add_subj_attr(au, "subj", rnum);
+			add_subj_attr(au, NF_SUBJ, rnum);
 			return;
 		}
 	} while (auparse_next_record(au) == 1);
@@ -286,15 +480,15 @@ static void syscall_subj_attr(auparse_state_t *au)
 
 static void collect_perm_obj2(auparse_state_t *au, const char *syscall)
 {
-	const char *val;
+	unsigned int nf;
 
 	if (strcmp(syscall, "fchmodat") == 0)
-		val = "a2";
+		nf = NF_A2;
 	else
-		val = "a1";
+		nf = NF_A1;
 
 	auparse_first_record(au);
-	if (auparse_find_field(au, val)) {
+	if (norm_find(au, nf)) {
 		D.thing.two = set_record(0, 0);
 		D.thing.two = set_field(D.thing.two,
 			auparse_get_field_num(au));
@@ -303,15 +497,15 @@ static void collect_perm_obj2(auparse_state_t *au, const char *syscall)
 
 static void collect_own_obj2(auparse_state_t *au, const char *syscall)
 {
-	const char *val;
+	unsigned int nf;
 
 	if (strcmp(syscall, "fchownat") == 0)
-		val = "a2";
+		nf = NF_A2;
 	else
-		val = "a1";
+		nf = NF_A1;
 
 	auparse_first_record(au);
-	if (auparse_find_field(au, val)) {
+	if (norm_find(au, nf)) {
 		// if uid is -1, its not being changed, user group
 		if (auparse_get_field_int(au) == -1 && errno == 0)
 			auparse_next_field(au);
@@ -341,7 +535,7 @@ static void collect_id_obj2(auparse_state_t *au, const char *syscall)
 		return; // Shouldn't happen
 
 	auparse_first_record(au);
-	if (auparse_find_field(au, "a0")) {
+	if (norm_find(au, NF_A0)) {
 		while (cnt <= limit) {
 			const char *str = auparse_interpret_field(au);
 			if ((strcmp(str, "unset") == 0) && errno == 0) {
@@ -367,7 +561,7 @@ static int collect_path_attrs(auparse_state_t *au)
 	unsigned int rnum = auparse_get_record_num(au);
 
 	auparse_first_field(au);
-	if (add_obj_attr(au, "mode", rnum))
+	if (add_obj_attr(au, NF_MODE, rnum))
 		return 1;	// Failed opens don't have anything else
 
 	// All the rest of the fields matter
@@ -383,13 +577,13 @@ static int collect_path_attrs(auparse_state_t *au)
 static void collect_cwd_attrs(auparse_state_t *au)
 {
 	unsigned int rnum = auparse_get_record_num(au);
-	add_obj_attr(au, "cwd", rnum);
+	add_obj_attr(au, NF_CWD, rnum);
 }
 
 static void collect_sockaddr_attrs(auparse_state_t *au)
 {
 	unsigned int rnum = auparse_get_record_num(au);
-	add_obj_attr(au, "saddr", rnum);
+	add_obj_attr(au, NF_SADDR, rnum);
 }
 
 static void simple_file_attr(auparse_state_t *au)
@@ -406,7 +600,7 @@ static void simple_file_attr(auparse_state_t *au)
 		switch (type)
 		{
 			case AUDIT_PATH:
-				f = auparse_find_field(au, "nametype");
+				f = norm_find(au, NF_NAMETYPE);
 				if (f && strcmp(f, "PARENT") == 0) {
 					if (parent == 0)
 					    parent = auparse_get_record_num(au);
@@ -443,7 +637,7 @@ static void set_file_object(auparse_state_t *au, int adjust)
 
 	// Now double check that we picked the right one.
 	do {
-		f = auparse_find_field(au, "nametype");
+		f = norm_find(au, NF_NAMETYPE);
 		if (f) {
 			if (strcmp(f, "PARENT"))
 				break;
@@ -467,15 +661,15 @@ static void set_file_object(auparse_state_t *au, int adjust)
 		auparse_first_field(au);
 
 		// Object
-		set_prime_object(au, "name", rnum);
+		set_prime_object(au, NF_NAME, rnum);
 
-		f = auparse_find_field(au, "inode");
+		f = norm_find(au, NF_INODE);
 		if (f) {
 			D.thing.secondary = set_record(0, rnum);
 			D.thing.secondary = set_field(D.thing.secondary,
 						auparse_get_field_num(au));
 		}
-		f = auparse_find_field(au, "mode");
+		f = norm_find(au, NF_MODE);
 		if (f) {
 			unsigned int mode;
 			errno = 0;
@@ -504,7 +698,7 @@ static void set_socket_object(auparse_state_t *au)
 {
 	auparse_goto_record_num(au, 1);
 	auparse_first_field(au);
-	set_prime_object(au, "saddr", 1);
+	set_prime_object(au, NF_SADDR, 1);
 }
 
 /* This is only called processing syscall records */
@@ -514,27 +708,27 @@ static int set_program_obj(auparse_state_t *au)
 	int type = auparse_get_type(au);
 
 	if (type == AUDIT_BPF) {
-		if (auparse_find_field(au, "prog-id")) {
+		if (norm_find(au, NF_PROG_ID)) {
 			D.thing.primary = set_record(0,
 					auparse_get_record_num(au));
 			D.thing.primary = set_field(D.thing.primary,
 					auparse_get_field_num(au));
 		}
 	} else if (type == AUDIT_EVENT_LISTENER) {
-		if (auparse_find_field(au, "nl-mcgrp")) {
+		if (norm_find(au, NF_NL_MCGRP)) {
 			D.thing.primary = set_record(0,
 					auparse_get_record_num(au));
 			D.thing.primary = set_field(D.thing.primary,
 					auparse_get_field_num(au));
 		}
 	} else if (type == AUDIT_MAC_POLICY_LOAD) {
-		if (auparse_find_field(au, "lsm")) {
+		if (norm_find(au, NF_LSM)) {
 			D.thing.primary = set_record(0,
 					auparse_get_record_num(au));
 			D.thing.primary = set_field(D.thing.primary,
 					auparse_get_field_num(au));
 		}
-	} else if (auparse_find_field(au, "exe")) {
+	} else if (norm_find(au, NF_EXE)) {
 		const char *exe = auparse_interpret_field(au);
 		if ((strncmp(exe, "/usr/bin/python", 15) == 0) ||
 		    (strncmp(exe, "/usr/bin/sh", 11) == 0) ||
@@ -546,7 +740,7 @@ static int set_program_obj(auparse_state_t *au)
 				auparse_goto_field_num(au, fnum - 1);
 			else
 				auparse_first_record(au);
-			auparse_find_field(au, "comm");
+			norm_find(au, NF_COMM);
 		}
 
 		D.thing.primary = set_record(0,
@@ -664,7 +858,7 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 			act = "loaded-kernel-module";
 			D.thing.what = NORM_WHAT_FILE;
 			auparse_goto_record_num(au, 1);
-			set_prime_object(au, "name", 1);
+			set_prime_object(au, NF_NAME, 1);
 			break;
 		case NORM_FILE_UNLDMOD:
 			act = "unloaded-kernel-module";
@@ -682,10 +876,10 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 			act = "mounted";
 			// this gets overridden
 			D.thing.what = NORM_WHAT_FILESYSTEM;
-			if (syscall_success == 1)
-				set_prime_object2(au, "name", 0);
+			if (D.syscall_success == 1)
+				set_prime_object2(au, NF_NAME, 0);
 			//The device is 1 after on success 0 on fail
-			set_file_object(au, syscall_success);
+			set_file_object(au, D.syscall_success);
 			// We call this directly to make sure the right
 			// PATH record is used. (There can be 4.)
 			collect_path_attrs(au);
@@ -706,7 +900,7 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 			 */
 
 			// The 3rd record will always contain the name of the new file
-			set_prime_object2(au, "name", 3);
+			set_prime_object2(au, NF_NAME, 3);
 			set_file_object(au, 2); // Thing renamed is 2 after
 			simple_file_attr(au);
 			break;
@@ -725,7 +919,7 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 		case NORM_FILE_LNK:
 			act = "symlinked";
 			D.thing.what = NORM_WHAT_FILE; // this gets overridden
-			set_prime_object2(au, "name", 0);
+			set_prime_object2(au, NF_NAME, 0);
 			set_file_object(au, 2);
 			simple_file_attr(au);
 			break;
@@ -792,7 +986,7 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 				if (auparse_get_type(au) != AUDIT_OBJ_PID)
 					continue;
 				auparse_first_field(au);
-				if (auparse_find_field(au, "opid")) {
+				if (norm_find(au, NF_OPID)) {
 					attr = set_record(0,
 						auparse_get_record_num(au));
 					attr = set_field(attr,
@@ -815,7 +1009,7 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 			break;
 		case NORM_MAC_CONFIG:
 			act = normalize_record_map_i2s(ttype);
-			f = auparse_find_field(au, "bool");
+			f = norm_find(au, NF_BOOL);
 			if (f) {
 				D.thing.primary = set_record(0,
 					auparse_get_record_num(au));
@@ -826,7 +1020,7 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 			break;
 		case NORM_MAC_ENFORCE:
 			act = normalize_record_map_i2s(ttype);
-			f = auparse_find_field(au, "enforcing");
+			f = norm_find(au, NF_ENFORCING);
 			if (f) {
 				D.thing.primary = set_record(0,
 					auparse_get_record_num(au));
@@ -844,7 +1038,7 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 		case NORM_IPTABLES:
 			act = "loaded-firewall-rule-to";
 			auparse_first_record(au);
-			f = auparse_find_field(au, "table");
+			f = norm_find(au, NF_TABLE);
 			if (f) {
 				D.thing.primary = set_record(0,
 					auparse_get_record_num(au));
@@ -855,14 +1049,14 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 			break;
 		case NORM_PROMISCUOUS:
 			auparse_first_record(au);
-			f = auparse_find_field(au, "dev");
+			f = norm_find(au, NF_DEV);
 			if (f) {
 				D.thing.primary = set_record(0,
 					auparse_get_record_num(au));
 				D.thing.primary = set_field(D.thing.primary,
 					auparse_get_field_num(au));
 			}
-			f = auparse_find_field(au, "prom");
+			f = norm_find(au, NF_PROM);
 			if (f) {
 				int i = auparse_get_field_int(au);
 				if (i == 0)
@@ -905,11 +1099,11 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 			break;
 		case NORM_SYSTEM_MEMORY:
 			act = "allocated-memory";
-			if (syscall_success == 1) {
+			if (D.syscall_success == 1) {
 				// If its not a mmap avc, we can use comm
 				act = "allocated-memory-in";
 				auparse_first_record(au);
-				f = auparse_find_field(au, "comm");
+				f = norm_find(au, NF_COMM);
 				if (f) {
 					D.thing.primary = set_record(0,
 						auparse_get_record_num(au));
@@ -931,7 +1125,7 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 			break;
 		case NORM_BPF:
 			auparse_first_record(au);
-			f = auparse_find_field(au, "op");
+			f = norm_find(au, NF_OP);
 			if (f) {
 				const char *str = auparse_get_field_str(au);
 				if (strcmp(str, "LOAD") == 0)
@@ -945,7 +1139,7 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 			break;
 		case NORM_EV_LISTEN:
 			auparse_first_record(au);
-			f = auparse_find_field(au, "op");
+			f = norm_find(au, NF_OP);
 			if (f) {
 				const char *str = auparse_get_field_str(au);
 				if (strcmp(str, "connect") == 0)
@@ -979,7 +1173,7 @@ static int normalize_syscall(auparse_state_t *au, const char *syscall)
 			{
 				const char *k;
 				rc = auparse_first_record(au);
-				k = auparse_find_field(au, "key");
+				k = norm_find(au, NF_KEY);
 				if (k && strcmp(k, "(null)")) {
 					act = "triggered-audit-rule";
 					D.thing.primary = set_record(0,
@@ -1117,7 +1311,7 @@ static const char *find_config_change_object(auparse_state_t *au)
 
 	// Check if its an audit rule
 	auparse_first_record(au);
-	f = auparse_find_field(au, "key");
+	f = norm_find(au, NF_KEY);
 	if (f) {
 		const char *str = auparse_get_field_str(au);
 		if (str && strcmp(str, "(null)"))
@@ -1126,27 +1320,27 @@ static const char *find_config_change_object(auparse_state_t *au)
 
 	// Next lets find the individual objects being set
 	auparse_first_record(au);
-	f = auparse_find_field(au, "audit_enabled");
+	f = norm_find(au, NF_AUDIT_ENABLED);
 	if (f)
 		return f;
 	auparse_first_record(au);
-	f = auparse_find_field(au, "audit_pid");
+	f = norm_find(au, NF_AUDIT_PID);
 	if (f)
 		return f;
 	auparse_first_record(au);
-	f = auparse_find_field(au, "audit_backlog_limit");
+	f = norm_find(au, NF_AUDIT_BACKLOG_LIMIT);
 	if (f)
 		return f;
 	auparse_first_record(au);
-	f = auparse_find_field(au, "audit_failure");
+	f = norm_find(au, NF_AUDIT_FAILURE);
 	if (f)
 		return f;
 	auparse_first_record(au);
-	f = auparse_find_field(au, "actions"); // seccomp-logging
+	f = norm_find(au, NF_ACTIONS); // seccomp-logging
 	if (f)
 		return f;
 	auparse_first_record(au);
-	f = auparse_find_field(au, "list");	// If nothing else, the list
+	f = norm_find(au, NF_LIST);	// If nothing else, the list
 	if (f)
 		return f;
 
@@ -1182,7 +1376,7 @@ static int normalize_compound(auparse_state_t *au)
 
 	if (type == AUDIT_SYSCALL) {
 		recno = auparse_get_record_num(au);
-		f = auparse_find_field(au, "syscall");
+		f = norm_find(au, NF_SYSCALL);
 		if (f) {
 			f = auparse_interpret_field(au);
 			if (f)
@@ -1190,13 +1384,13 @@ static int normalize_compound(auparse_state_t *au)
 		}
 
 		// Results
-		f = auparse_find_field(au, "success");
+		f = norm_find(au, NF_SUCCESS);
 		if (f) {
 			const char *str = auparse_get_field_str(au);
 			if (strcmp(str, "no") == 0)
-				syscall_success = 0;
+				D.syscall_success = 0;
 			else
-				syscall_success = 1;
+				D.syscall_success = 1;
 
 			D.results = set_record(0, recno);
 			D.results = set_field(D.results,
@@ -1211,7 +1405,7 @@ static int normalize_compound(auparse_state_t *au)
 		}
 
 		// Subject - primary
-		if (set_prime_subject(au, "auid", recno)) {
+		if (set_prime_subject(au, NF_AUID, recno)) {
 			rc = auparse_goto_record_num(au, recno);
 			if (rc != 1) {
 				free((void *)syscall);
@@ -1221,7 +1415,7 @@ static int normalize_compound(auparse_state_t *au)
 		}
 
 		// Subject - alias, uid comes before auid
-		if (set_secondary_subject(au, "uid", recno)) {
+		if (set_secondary_subject(au, NF_UID, recno)) {
 			rc = auparse_goto_record_num(au, recno);
 			if (rc != 1) {
 				free((void *)syscall);
@@ -1235,7 +1429,7 @@ static int normalize_compound(auparse_state_t *au)
 
 		// how
 		auparse_first_field(au);
-		f = auparse_find_field(au, "exe");
+		f = norm_find(au, NF_EXE);
 		if (f) {
 			const char *exe = auparse_interpret_field(au);
 			D.how = strdup(exe);
@@ -1255,7 +1449,7 @@ static int normalize_compound(auparse_state_t *au)
 					rc = auparse_goto_field_num(au,fnum-1);
 				if (rc == 0)
 					auparse_first_record(au);
-				f = auparse_find_field(au, "comm");
+				f = norm_find(au, NF_COMM);
 				if (f) {
 					free((void *)D.how);
 					exe = auparse_interpret_field(au);
@@ -1271,7 +1465,7 @@ static int normalize_compound(auparse_state_t *au)
 			auparse_first_field(au);
 		}
 
-		f = auparse_find_field(au, "key");
+		f = norm_find(au, NF_KEY);
 		if (f) {
 			const char *k = auparse_get_field_str(au);
 			if (strcmp(k, "(null)")) {
@@ -1295,16 +1489,16 @@ static int normalize_compound(auparse_state_t *au)
 					auparse_goto_record_num(au, r);
 					if (auparse_get_type(au) == AUDIT_PATH) {
 						auparse_first_field(au);
-						set_prime_object(au, "name", r);
+						set_prime_object(au, NF_NAME, r);
 						D.thing.what = NORM_WHAT_LINK;
 						break;
 					}
 				}
 				if (is_unset(D.thing.primary)) {
 					auparse_first_record(au);
-					f = auparse_find_field(au, "path");
+					f = norm_find(au, NF_PATH);
 					if (f == NULL)
-					f = auparse_find_field(au, "cwd");
+					f = norm_find(au, NF_CWD);
 					if (f) {
 						D.thing.primary = set_record(0,
 						    auparse_get_record_num(au));
@@ -1317,7 +1511,7 @@ static int normalize_compound(auparse_state_t *au)
 			}
 		} else if (otype == AUDIT_CONFIG_CHANGE) {
 			auparse_first_record(au);
-			f = auparse_find_field(au, "op");
+			f = norm_find(au, NF_OP);
 			if (f) {
 				value_t o;
 
@@ -1349,15 +1543,15 @@ static value_t find_simple_object(auparse_state_t *au, int type)
 	{
 		case AUDIT_SERVICE_START:
 		case AUDIT_SERVICE_STOP:
-			f = auparse_find_field(au, "unit");
+			f = norm_find(au, NF_UNIT);
 			D.thing.what = NORM_WHAT_SERVICE;
 			break;
 		case AUDIT_SYSTEM_RUNLEVEL:
-			f = auparse_find_field(au, "new-level");
+			f = norm_find(au, NF_NEW_LEVEL);
 			D.thing.what = NORM_WHAT_SYSTEM;
 			break;
 		case AUDIT_USER_ROLE_CHANGE:
-			f = auparse_find_field(au, "selected-context");
+			f = norm_find(au, NF_SELECTED_CONTEXT);
 			D.thing.what = NORM_WHAT_USER_SESSION;
 			break;
 		case AUDIT_ROLE_ASSIGN:
@@ -1370,10 +1564,10 @@ static value_t find_simple_object(auparse_state_t *au, int type)
 		case AUDIT_ADD_GROUP:
 		case AUDIT_DEL_GROUP:
 		case AUDIT_GRP_MGMT:
-			f = auparse_find_field(au, "id");
+			f = norm_find(au, NF_ID);
 			if (f == NULL) {
 				auparse_first_record(au);
-				f = auparse_find_field(au, "acct");
+				f = norm_find(au, NF_ACCT);
 			}
 			D.thing.what = NORM_WHAT_ACCT;
 			break;
@@ -1382,7 +1576,7 @@ static value_t find_simple_object(auparse_state_t *au, int type)
 		case AUDIT_USER_ERR:
 		case AUDIT_USER_LOGIN:
 		case AUDIT_USER_LOGOUT:
-			f = auparse_find_field(au, "terminal");
+			f = norm_find(au, NF_TERMINAL);
 			D.thing.what = NORM_WHAT_USER_SESSION;
 			break;
 		case AUDIT_USER_AUTH:
@@ -1396,44 +1590,44 @@ static value_t find_simple_object(auparse_state_t *au, int type)
 		case AUDIT_ANOM_LOGIN_TIME:
 		case AUDIT_ANOM_LOGIN_SESSIONS:
 		case AUDIT_ANOM_LOGIN_LOCATION:
-			f = auparse_find_field(au, "acct");
+			f = norm_find(au, NF_ACCT);
 			D.thing.what = NORM_WHAT_USER_SESSION;
 			break;
 		case AUDIT_ANOM_EXEC:
 		case AUDIT_USER_CMD:
-			f = auparse_find_field(au, "cmd");
+			f = norm_find(au, NF_CMD);
 			D.thing.what = NORM_WHAT_PROCESS;
 			break;
 		case AUDIT_USER_TTY:
 		case AUDIT_TTY:
 			auparse_first_record(au);
-			f = auparse_find_field(au, "data");
+			f = norm_find(au, NF_DATA);
 			D.thing.what = NORM_WHAT_KEYSTROKES;
 			break;
 		case AUDIT_USER_DEVICE:
 			auparse_first_record(au);
-			f = auparse_find_field(au, "device");
+			f = norm_find(au, NF_DEVICE);
 			D.thing.what = NORM_WHAT_KEYSTROKES;
 			break;
 		case AUDIT_SOFTWARE_UPDATE:
 			auparse_first_record(au);
-			f = auparse_find_field(au, "sw");
+			f = norm_find(au, NF_SW);
 			D.thing.what = NORM_WHAT_SOFTWARE;
 			break;
 		case AUDIT_VIRT_MACHINE_ID:
-			f = auparse_find_field(au, "vm");
+			f = norm_find(au, NF_VM);
 			D.thing.what = NORM_WHAT_VM;
 			break;
 		case AUDIT_VIRT_RESOURCE:
-			f = auparse_find_field(au, "resrc");
+			f = norm_find(au, NF_RESRC);
 			D.thing.what = NORM_WHAT_VM;
 			break;
 		case AUDIT_VIRT_CONTROL:
-			f = auparse_find_field(au, "op");
+			f = norm_find(au, NF_OP);
 			D.thing.what = NORM_WHAT_VM;
 			break;
 		case AUDIT_LABEL_LEVEL_CHANGE:
-			f = auparse_find_field(au, "printer");
+			f = norm_find(au, NF_PRINTER);
 			D.thing.what = NORM_WHAT_PRINTER;
 			break;
 		case AUDIT_CONFIG_CHANGE:
@@ -1441,11 +1635,11 @@ static value_t find_simple_object(auparse_state_t *au, int type)
 			D.thing.what = NORM_WHAT_AUDIT_CONFIG;
 			break;
 		case AUDIT_MAC_CONFIG_CHANGE:
-			f = auparse_find_field(au, "bool");
+			f = norm_find(au, NF_BOOL);
 			D.thing.what = NORM_WHAT_SECURITY_POLICY;
 			break;
 		case AUDIT_MAC_STATUS:
-			f = auparse_find_field(au, "enforcing");
+			f = norm_find(au, NF_ENFORCING);
 			D.thing.what = NORM_WHAT_SECURITY_POLICY;
 			break;
 		// These deal with policy, not sure about object yet
@@ -1455,11 +1649,11 @@ static value_t find_simple_object(auparse_state_t *au, int type)
 			D.thing.what = NORM_WHAT_SECURITY_POLICY;
 			break;
 		case AUDIT_USER:
-			f = auparse_find_field(au, "addr");
+			f = norm_find(au, NF_ADDR);
 			// D.thing.what = NORM_WHAT_?
 			break;
 		case AUDIT_USYS_CONFIG:
-			f = auparse_find_field(au, "op");
+			f = norm_find(au, NF_OP);
 			if (f) {
 				free((void *)D.action);
 				D.action = strdup(auparse_interpret_field(au));
@@ -1468,15 +1662,15 @@ static value_t find_simple_object(auparse_state_t *au, int type)
 			D.thing.what = NORM_WHAT_SYSTEM;
 			break;
 		case AUDIT_CRYPTO_KEY_USER:
-			f = auparse_find_field(au, "fp");
+			f = norm_find(au, NF_FP);
 			D.thing.what = NORM_WHAT_USER_SESSION;
 			break;
 		case AUDIT_CRYPTO_SESSION:
-			f = auparse_find_field(au, "addr");
+			f = norm_find(au, NF_ADDR);
 			D.thing.what = NORM_WHAT_USER_SESSION;
 			break;
 		case AUDIT_ANOM_RBAC_INTEGRITY_FAIL:
-			f = auparse_find_field(au, "hostname");
+			f = norm_find(au, NF_HOSTNAME);
 			D.thing.what = NORM_WHAT_FILESYSTEM;
 			break;
 		default:
@@ -1498,10 +1692,10 @@ static value_t find_simple_obj_secondary(auparse_state_t *au, int type)
 	switch (type)
 	{
 		case AUDIT_CRYPTO_SESSION:
-			f = auparse_find_field(au, "rport");
+			f = norm_find(au, NF_RPORT);
 			break;
 		case AUDIT_SOFTWARE_UPDATE:
-			f = auparse_find_field(au, "sw_type");
+			f = norm_find(au, NF_SW_TYPE);
 			break;
 		default:
 			break;
@@ -1522,13 +1716,13 @@ static value_t find_simple_obj_primary2(auparse_state_t *au, int type)
 	switch (type)
 	{
 		case AUDIT_VIRT_CONTROL:
-			f = auparse_find_field(au, "vm");
+			f = norm_find(au, NF_VM);
 			break;
 		case AUDIT_VIRT_RESOURCE:
-			f = auparse_find_field(au, "vm");
+			f = norm_find(au, NF_VM);
 			break;
 		case AUDIT_SOFTWARE_UPDATE:
-			f = auparse_find_field(au, "root_dir");
+			f = norm_find(au, NF_ROOT_DIR);
 			break;
 		default:
 			break;
@@ -1546,8 +1740,8 @@ static void collect_simple_subj_attr(auparse_state_t *au)
 		return;
 
 	auparse_first_record(au);
-	add_subj_attr(au, "pid", 0); // Just pass 0 since simple is 1 record
-	add_subj_attr(au, "subj", 0);
+	add_subj_attr(au, NF_PID, 0); // Just pass 0 since simple is 1 record
+	add_subj_attr(au, NF_SUBJ, 0);
 }
 
 static void collect_userspace_subj_attr(auparse_state_t *au, int type)
@@ -1556,13 +1750,13 @@ static void collect_userspace_subj_attr(auparse_state_t *au, int type)
 		return;
 
 	// Just pass 0 since simple is 1 record
-	add_subj_attr(au, "hostname", 0);
-	add_subj_attr(au, "addr", 0);
+	add_subj_attr(au, NF_HOSTNAME, 0);
+	add_subj_attr(au, NF_ADDR, 0);
 
 	// Some events have the terminal as the object - skip for them
 	if (type != AUDIT_USER_START && type != AUDIT_USER_END &&
 				type != AUDIT_USER_ERR)
-		add_subj_attr(au, "terminal", 0);
+		add_subj_attr(au, NF_TERMINAL, 0);
 }
 
 static int normalize_simple(auparse_state_t *au)
@@ -1583,7 +1777,7 @@ static int normalize_simple(auparse_state_t *au)
 			type == AUDIT_SECCOMP || type == AUDIT_ANOM_ABEND ||
 			type == AUDIT_ANOM_PROMISCUOUS) {
 		// Subject - primary
-		set_prime_subject(au, "auid", 0);
+		set_prime_subject(au, NF_AUID, 0);
 
 		// Session
 		add_session(au, 0);
@@ -1594,7 +1788,7 @@ static int normalize_simple(auparse_state_t *au)
 		// action
 		if (type == AUDIT_CONFIG_CHANGE) {
 			auparse_first_field(au);
-			f = auparse_find_field(au, "op");
+			f = norm_find(au, NF_OP);
 			if (f) {
 				const char *str = auparse_interpret_field(au);
 				if (*str == '"')
@@ -1626,41 +1820,41 @@ map:
 		if (type == AUDIT_FEATURE_CHANGE) {
 			// Subject - secondary
 			auparse_first_field(au);
-			if (set_secondary_subject(au, "uid", 0))
+			if (set_secondary_subject(au, NF_UID, 0))
 				auparse_first_record(au);
 
 			// how
-			f = auparse_find_field(au, "exe");
+			f = norm_find(au, NF_EXE);
 			if (f) {
 				const char *sig = auparse_interpret_field(au);
 				D.how = strdup(sig);
 			}
 
 			// object
-			set_prime_object(au, "feature", 0);
+			set_prime_object(au, NF_FEATURE, 0);
 			D.thing.what = NORM_WHAT_SYSTEM;
 		}
 
 		if (type == AUDIT_SECCOMP) {
 			// Subject - secondary
 			auparse_first_field(au);
-			if (set_secondary_subject(au, "uid", 0))
+			if (set_secondary_subject(au, NF_UID, 0))
 				auparse_first_record(au);
 
 			// how
-			f = auparse_find_field(au, "exe");
+			f = norm_find(au, NF_EXE);
 			if (f) {
 				const char *sig = auparse_interpret_field(au);
 				D.how = strdup(sig);
 			}
 
 			// Object
-			if (set_prime_object(au, "syscall", 0))
+			if (set_prime_object(au, NF_SYSCALL, 0))
 				auparse_first_record(au);
 			D.thing.what = NORM_WHAT_PROCESS;
 
 			// Results
-			f = auparse_find_field(au, "code");
+			f = norm_find(au, NF_CODE);
 			if (f) {
 				D.results = set_record(0, 0);
 				D.results = set_field(D.results,
@@ -1672,16 +1866,16 @@ map:
 		if (type == AUDIT_ANOM_ABEND) {
 			// Subject - secondary
 			auparse_first_field(au);
-			if (set_secondary_subject(au, "uid", 0))
+			if (set_secondary_subject(au, NF_UID, 0))
 				auparse_first_record(au);
 
 			//object
-			if (set_prime_object(au, "exe", 0))
+			if (set_prime_object(au, NF_EXE, 0))
 				auparse_first_record(au);
 			D.thing.what = NORM_WHAT_PROCESS;
 
 			// how
-			f = auparse_find_field(au, "sig");
+			f = norm_find(au, NF_SIG);
 			if (f) {
 				const char *sig = auparse_interpret_field(au);
 				D.how = strdup(sig);
@@ -1689,8 +1883,8 @@ map:
 		}
 		if (type == AUDIT_ANOM_PROMISCUOUS) {
 			auparse_first_field(au);
-			set_prime_object(au, "dev", 0);
-			set_secondary_subject(au, "uid", 0);
+			set_prime_object(au, NF_DEV, 0);
+			set_secondary_subject(au, NF_UID, 0);
 
 			D.thing.what = NORM_WHAT_SOCKET;
 		}
@@ -1704,18 +1898,18 @@ map:
 	// This one is atypical and originates from the kernel
 	if (type == AUDIT_LOGIN) {
 		// Secondary
-		if (set_secondary_subject(au, "uid", 0))
+		if (set_secondary_subject(au, NF_UID, 0))
 			auparse_first_record(au);
 
 		// Subject attrs
 		collect_simple_subj_attr(au);
 
 		// Subject
-		if (set_prime_subject(au, "old-auid", 0))
+		if (set_prime_subject(au, NF_OLD_AUID, 0))
 			auparse_first_record(au);
 
 		// Object
-		if (set_prime_object(au, "auid", 0))
+		if (set_prime_object(au, NF_AUID, 0))
 			auparse_first_record(au);
 		D.thing.what = NORM_WHAT_USER_SESSION;
 
@@ -1740,14 +1934,14 @@ map:
 		// Subject attrs
 		collect_simple_subj_attr(au);
 		// how
-		f = auparse_find_field(au, "comm");
+		f = norm_find(au, NF_COMM);
 		if (f) {
 			const char *sig = auparse_interpret_field(au);
 			D.how = strdup(sig);
 		}
 		D.action = strdup("loaded-firewall-rule-to");
 		auparse_first_record(au);
-		f = auparse_find_field(au, "table");
+		f = norm_find(au, NF_TABLE);
 		if (f) {
 			D.thing.primary = set_record(0,
 				auparse_get_record_num(au));
@@ -1761,7 +1955,7 @@ map:
 	/* This one is also atypical and comes from the kernel */
 	if (type == AUDIT_AVC) {
 		// how
-		f = auparse_find_field(au, "comm");
+		f = norm_find(au, NF_COMM);
 		if (f) {
 			const char *sig = auparse_interpret_field(au);
 			D.how = strdup(sig);
@@ -1769,7 +1963,7 @@ map:
 			auparse_first_record(au);
 
 		// Subject
-		set_prime_subject(au, "scontext", 0);
+		set_prime_subject(au, NF_SCONTEXT, 0);
 		set_unknown_subject_what(au);
 		auparse_first_record(au);
 
@@ -1777,7 +1971,7 @@ map:
 		if (D.opt == NORM_OPT_ALL) {
 			// We will only collect this when everything is asked
 			// for because it messes up text format otherwise
-			set_prime_object(au, "tcontext", 0);
+			set_prime_object(au, NF_TCONTEXT, 0);
 			auparse_first_record(au);
 		}
 
@@ -1791,7 +1985,7 @@ map:
 
 		// find the denial
 		auparse_first_record(au);
-		f = auparse_find_field(au, "seresult");
+		f = norm_find(au, NF_SERESULT);
 		if (f) {
 			D.results = set_record(0, 0);
 			D.results = set_field(D.results,
@@ -1806,10 +2000,10 @@ map:
 	if (type >= AUDIT_FIRST_DAEMON &&
 		type < AUDIT_LAST_DAEMON) {
 		// Subject - primary
-		set_prime_subject(au, "auid", 0);
+		set_prime_subject(au, NF_AUID, 0);
 
 		// Secondary - optional
-		if (set_secondary_subject(au, "uid", 0))
+		if (set_secondary_subject(au, NF_UID, 0))
 			auparse_first_record(au);
 
 		// Session - optional
@@ -1844,7 +2038,7 @@ map:
 	if (type == AUDIT_BPF) {
 		set_system_subject_what(au);
 		auparse_first_record(au);
-		f = auparse_find_field(au, "op");
+		f = norm_find(au, NF_OP);
 		if (f) {
 			const char *str = auparse_get_field_str(au);
 			if (strcmp(str, "LOAD") == 0)
@@ -1863,11 +2057,11 @@ map:
 	// LISTENER events are atypical
 	if (type == AUDIT_EVENT_LISTENER) {
 		// Subject - primary
-		set_prime_subject(au, "auid", 0);
+		set_prime_subject(au, NF_AUID, 0);
 
 		// Secondary - optional
 		auparse_first_record(au);
-		set_secondary_subject(au, "uid", 0);
+		set_secondary_subject(au, NF_UID, 0);
 
 		// Session
 		auparse_first_record(au);
@@ -1877,7 +2071,7 @@ map:
 		collect_simple_subj_attr(au);
 
 		auparse_first_record(au);
-		f = auparse_find_field(au, "op");
+		f = norm_find(au, NF_OP);
 		if (f) {
 			const char *str = auparse_get_field_str(au);
 			if (strcmp(str, "connect") == 0)
@@ -1893,7 +2087,7 @@ map:
 
 		// How
 		auparse_first_record(au);
-		f = auparse_find_field(au, "exe");
+		f = norm_find(au, NF_EXE);
 		if (f) {
 			const char *exe = auparse_interpret_field(au);
 			D.how = strdup(exe);
@@ -1909,7 +2103,7 @@ map:
 	// Labeled networking events are atypical
 	if (type >= AUDIT_MAC_UNLBL_ALLOW && type <= AUDIT_LAST_SELINUX) {
 		// Subject - primary
-		set_prime_subject(au, "auid", 0);
+		set_prime_subject(au, NF_AUID, 0);
 
 		// We don't have a secondary subject, so set it to auid
 		set_subject_what(au);
@@ -1918,11 +2112,11 @@ map:
 		add_session(au, 0);
 
 		// Subject attrs
-		add_subj_attr(au, "subj", 0);
+		add_subj_attr(au, NF_SUBJ, 0);
 
 		// action
 		if (type == AUDIT_MAC_UNLBL_ALLOW) {
-			f = auparse_find_field(au, "unlbl_accept");
+			f = norm_find(au, NF_UNLBL_ACCEPT);
 			if (f) {
 			    if (auparse_get_field_int(au) == 1)
 			      act = "is-allowing-unlabeled-network-traffic";
@@ -1937,7 +2131,7 @@ map:
 			D.action = strdup(act);
 
 		if (type == AUDIT_MAC_MAP_ADD || type == AUDIT_MAC_MAP_DEL) {
-			if (set_prime_object(au, "nlbl_domain", 0))
+			if (set_prime_object(au, NF_NLBL_DOMAIN, 0))
 				auparse_first_record(au);
 		}
 
@@ -1956,20 +2150,20 @@ map:
 	// fail login, they are not quite in the system to have an auid.
 	if (type == AUDIT_USER_LOGIN) {
 		// Subject - primary
-		if (set_prime_subject(au, "id", 0)) {
+		if (set_prime_subject(au, NF_ID, 0)) {
 			auparse_first_record(au);
-			if (set_prime_subject(au, "acct", 0) == 0)
+			if (set_prime_subject(au, NF_ACCT, 0) == 0)
 				set_subject_what(au);
 		} else // If id found, set the subjkind
 			set_subject_what(au);
 		auparse_first_record(au);
 	} else {
 		// Subject - alias, uid comes before auid
-		if (set_secondary_subject(au, "uid", 0))
+		if (set_secondary_subject(au, NF_UID, 0))
 			auparse_first_record(au);
 
 		// Subject - primary
-		set_prime_subject(au, "auid", 0);
+		set_prime_subject(au, NF_AUID, 0);
 	}
 	// Session
 	add_session(au, 0);
@@ -1986,7 +2180,7 @@ map:
 	else {
 		// find the denial
 		auparse_first_record(au);
-		f = auparse_find_field(au, "seresult");
+		f = norm_find(au, NF_SERESULT);
 		if (f) {
 			D.results = set_record(0, 0);
 			D.results = set_field(D.results,
@@ -1995,21 +2189,21 @@ map:
 
 		// Subject
 		auparse_first_record(au);
-		set_prime_subject(au, "scontext", 0);
+		set_prime_subject(au, NF_SCONTEXT, 0);
 
 		// Object
 		if (D.opt == NORM_OPT_ALL) {
 			// We will only collect this when everything is asked
 			// for because it messes up text format otherwise
 			auparse_first_record(au);
-			set_prime_object(au, "tcontext", 0);
+			set_prime_object(au, NF_TCONTEXT, 0);
 		}
 	}
 
 	// action
 	if (type == AUDIT_USER_DEVICE) {
 		auparse_first_record(au);
-		f = auparse_find_field(au, "op");
+		f = norm_find(au, NF_OP);
 		if (f)
 			act = f;
 	}
@@ -2028,11 +2222,11 @@ map:
 		// object attrs - rare on simple events
 		if (D.opt == NORM_OPT_ALL) {
 			if (type == AUDIT_USER_DEVICE) {
-				add_obj_attr(au, "uuid", 0);
+				add_obj_attr(au, NF_UUID, 0);
 			} else if (type == AUDIT_SOFTWARE_UPDATE) {
 				auparse_first_record(au);
-				add_obj_attr(au, "key_enforce", 0);
-				add_obj_attr(au, "gpg_res", 0);
+				add_obj_attr(au, NF_KEY_ENFORCE, 0);
+				add_obj_attr(au, NF_GPG_RES, 0);
 			}
 		}
 	}
@@ -2040,7 +2234,7 @@ map:
 	// how
 	if (type == AUDIT_SYSTEM_BOOT) {
 		D.thing.what = NORM_WHAT_SYSTEM;
-		f = auparse_find_field(au, "exe");
+		f = norm_find(au, NF_EXE);
 		if (f) {
 			const char *exe = auparse_interpret_field(au);
 			D.how = strdup(exe);
@@ -2048,7 +2242,7 @@ map:
 		return 0;
 	} else if (type == AUDIT_SYSTEM_SHUTDOWN) {
 		D.thing.what = NORM_WHAT_SERVICE;
-		f = auparse_find_field(au, "exe");
+		f = norm_find(au, NF_EXE);
 		if (f) {
 			const char *exe = auparse_interpret_field(au);
 			D.how = strdup(exe);
@@ -2057,7 +2251,7 @@ map:
 	}
 	auparse_first_record(au);
 	if (type == AUDIT_ANOM_EXEC) {
-		f = auparse_find_field(au, "terminal");
+		f = norm_find(au, NF_TERMINAL);
 		if (f) {
 			const char *term = auparse_interpret_field(au);
 			D.how = strdup(term);
@@ -2065,14 +2259,14 @@ map:
 		return 0;
 	}
 	if (type == AUDIT_TTY) {
-		f = auparse_find_field(au, "comm");
+		f = norm_find(au, NF_COMM);
 		if (f) {
 			const char *comm = auparse_interpret_field(au);
 			D.how = strdup(comm);
 		}
 		return 0;
 	}
-	f = auparse_find_field(au, "exe");
+	f = norm_find(au, NF_EXE);
 	if (f) {
 		const char *exe = auparse_interpret_field(au);
 		D.how = strdup(exe);
@@ -2090,7 +2284,7 @@ map:
 				auparse_goto_field_num(au, fnum - 1);
 			else
 				auparse_first_record(au);
-			f = auparse_find_field(au, "comm");
+			f = norm_find(au, NF_COMM);
 			if (f) {
 				free((void *)D.how);
 				exe = auparse_interpret_field(au);
@@ -2119,6 +2313,11 @@ int auparse_normalize(auparse_state_t *au, normalize_option_t opt)
 	clear_normalizer(&D);
 	D.opt = opt;
 
+	// Attributes make enough lookups that one pass to find the fields
+	// pays for itself. Without them, or if it fails, the lookups scan.
+	if (D.opt != NORM_OPT_NO_ATTRS)
+		norm_fill_slots(au);
+
 	// If we have more than one record in the event its a syscall based
 	// event. Otherwise its a simple event with all pieces in the same
 	// record.
@@ -0,0 +1,100 @@
+/*
+ * normalize_fieldtab.h - the fields auparse_normalize looks at
+ * Copyright (c) 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+_S(NF_A0,			"a0")
+_S(NF_A1,			"a1")
+_S(NF_A2,			"a2")
+_S(NF_ACCT,			"acct")
+_S(NF_ACTIONS,			"actions")
+_S(NF_ADDR,			"addr")
+_S(NF_AUDIT_BACKLOG_LIMIT,	"audit_backlog_limit")
+_S(NF_AUDIT_ENABLED,		"audit_enabled")
+_S(NF_AUDIT_FAILURE,		"audit_failure")
+_S(NF_AUDIT_PID,		"audit_pid")
+_S(NF_AUID,			"auid")
+_S(NF_BOOL,			"bool")
+_S(NF_CMD,			"cmd")
+_S(NF_CODE,			"code")
+_S(NF_COMM,			"comm")
+_S(NF_CWD,			"cwd")
+_S(NF_DATA,			"data")
+_S(NF_DEV,			"dev")
+_S(NF_DEVICE,			"device")
+_S(NF_EGID,			"egid")
+_S(NF_ENFORCING,		"enforcing")
+_S(NF_EUID,			"euid")
+_S(NF_EXE,			"exe")
+_S(NF_FEATURE,			"feature")
+_S(NF_FP,			"fp")
+_S(NF_FSGID,			"fsgid")
+_S(NF_FSUID,			"fsuid")
+_S(NF_GID,			"gid")
+_S(NF_GPG_RES,			"gpg_res")
+_S(NF_HOSTNAME,			"hostname")
+_S(NF_ID,			"id")
+_S(NF_INODE,			"inode")
+_S(NF_KEY,			"key")
+_S(NF_KEY_ENFORCE,		"key_enforce")
+_S(NF_LIST,			"list")
+_S(NF_LSM,			"lsm")
+_S(NF_MODE,			"mode")
+_S(NF_NAME,			"name")
+_S(NF_NAMETYPE,			"nametype")
+_S(NF_NEW_LEVEL,		"new-level")
+_S(NF_NL_MCGRP,			"nl-mcgrp")
+_S(NF_NLBL_DOMAIN,		"nlbl_domain")
+_S(NF_OLD_AUID,			"old-auid")
+_S(NF_OP,			"op")
+_S(NF_OPID,			"opid")
+_S(NF_PATH,			"path")
+_S(NF_PID,			"pid")
+_S(NF_PPID,			"ppid")
+_S(NF_PRINTER,			"printer")
+_S(NF_PROG_ID,			"prog-id")
+_S(NF_PROM,			"prom")
+_S(NF_RES,			"res")
+_S(NF_RESRC,			"resrc")
+_S(NF_ROOT_DIR,			"root_dir")
+_S(NF_RPORT,			"rport")
+_S(NF_SADDR,			"saddr")
+_S(NF_SCONTEXT,			"scontext")
+_S(NF_SELECTED_CONTEXT,		"selected-context")
+_S(NF_SERESULT,			"seresult")
+_S(NF_SES,			"ses")
+_S(NF_SGID,			"sgid")
+_S(NF_SIG,			"sig")
+_S(NF_SUBJ,			"subj")
+_S(NF_SUCCESS,			"success")
+_S(NF_SUID,			"suid")
+_S(NF_SW,			"sw")
+_S(NF_SW_TYPE,			"sw_type")
+_S(NF_SYSCALL,			"syscall")
+_S(NF_TABLE,			"table")
+_S(NF_TCONTEXT,			"tcontext")
+_S(NF_TERMINAL,			"terminal")
+_S(NF_TTY,			"tty")
+_S(NF_UID,			"uid")
+_S(NF_UNIT,			"unit")
+_S(NF_UNLBL_ACCEPT,		"unlbl_accept")
+_S(NF_UUID,			"uuid")
+_S(NF_VM,			"vm")
@@ -1,6 +1,6 @@
 /*
 * nvlist.c - Minimal linked list library for name-value pairs
-* Copyright (c) 2006-07,2016,2021 Red Hat Inc.
+* Copyright (c) 2006-07,2016,2021,2026 Red Hat Inc.
 * All Rights Reserved.
 *
 * This library is free software; you can redistribute it and/or
@@ -27,21 +27,41 @@
 #include "nvlist.h"
 #include "interpret.h"
 #include "auparse-idata.h"
+#include "fieldid.h"
+#include "fieldidtabs.h"
+#include "arena.h"
+
+/*
+ * Building a map hashes every name in the record, which costs about as
+ * much as a few linear scans. Only records that are big and searched
+ * often get one.
+ */
+#define NV_MAP_MIN 8
+#define NV_MAP_FINDS 4
+#define NV_NO_NEXT 0xFFFF
 
 static inline void alloc_array(nvlist *l)
 {
+	if (l->arena)
+		l->array = arena_alloc(l->arena, NFIELDS * sizeof(nvnode));
+	else
 		l->array = calloc(NFIELDS, sizeof(nvnode));
-		l->size = NFIELDS;
+	l->size = l->array ? NFIELDS : 0;
 }
 
-void nvlist_create(nvlist *l)
+void nvlist_create(nvlist *l, struct arena *a)
 {
 	if (l) {
+		l->arena = a;
 		alloc_array(l);
 		l->cur = 0;
 		l->cnt = 0;
 		l->record = NULL;
 		l->end = NULL;
+		l->map = NULL;
+		l->map_size = 0;
+		l->mapped = 0;
+		l->finds = 0;
 	}
 }
 
@@ -62,12 +82,23 @@ int nvlist_append(nvlist *l, const nvnode *node)
 		(node->val == NULL))
 		return 1;
 
-	if (l->array == NULL)
+	if (l->array == NULL) {
 		alloc_array(l);
+		if (l->array == NULL)
+			return 1;
+	}
 
 	if (l->cnt == l->size) {
 		nvnode* tmp;
-		tmp = realloc(l->array, l->size * sizeof(nvnode) * 2);
+
+		if (l->arena) {
+			// The old array stays in the arena until the event ends
+			tmp = arena_alloc(l->arena,
+					  l->size * sizeof(nvnode) * 2);
+			if (tmp)
+				memcpy(tmp, l->array, l->size * sizeof(nvnode));
+		} else
+			tmp = realloc(l->array, l->size * sizeof(nvnode) * 2);
 		if (tmp != NULL) {
 			l->array = tmp;
 			memset(l->array + l->size, 0, sizeof(nvnode) * l->size);
@@ -108,10 +139,88 @@ nvnode *nvlist_goto_rec(nvlist *l, unsigned int i)
 	return NULL;
 }
 
+int field_name_to_id(const char *name)
+{
+	uint64_t h = field_name_hash(name);
+	unsigned int d = field_hash_disp[h % FIELD_HASH_BUCKETS];
+	int id = field_hash_ids[field_hash_slot(h, d, FIELD_HASH_SLOTS)];
+
+	if (id < 0 || strcmp(field_id_strings + field_id_offsets[id], name))
+		return -1;
+	return id;
+}
+
+const char *field_id_to_name(int id)
+{
+	if (id < 0 || id >= FIELD_ID_COUNT)
+		return NULL;
+	return field_id_strings + field_id_offsets[id];
+}
+
+/* Returns the map slot that holds id or the empty slot where it goes */
+static inline unsigned int map_probe(const nvlist *l, int id)
+{
+	unsigned int mask = l->map_size - 1;
+	unsigned int s = ((unsigned int)id * 0x9e3779b1U >> 16) & mask;
+
+	while (l->map[s] && l->array[l->map[s] - 1].id != id)
+		s = (s + 1) & mask;
+	return s;
+}
+
+/*
+ * Intern every field name and index them by id. Fields with the same name
+ * are chained in record order through next so a search that starts in the
+ * middle of the record still finds the next one.
+ */
+static int build_map(nvlist *l)
+{
+	unsigned int size = 16, i;
+
+	while (size < l->cnt * 2)
+		size <<= 1;
+	if (size != l->map_size) {
+		free(l->map);
+		l->map = malloc(size * sizeof(*l->map));
+		if (l->map == NULL) {
+			l->map_size = 0;
+			return 1;
+		}
+		l->map_size = size;
+	}
+	memset(l->map, 0, size * sizeof(*l->map));
+
+	i = l->cnt;
+	while (i--) {
+		nvnode *node = &l->array[i];
+		unsigned int s;
+
+		node->next = NV_NO_NEXT;
+		node->id = node->name ? field_name_to_id(node->name) : -1;
+		if (node->id < 0)
+			continue;
+		s = map_probe(l, node->id);
+		if (l->map[s])
+			node->next = l->map[s] - 1;
+		l->map[s] = i + 1;
+	}
+	l->mapped = l->cnt;
+	return 0;
+}
+
 /*
  * This function will start at current index and scan for a name
  */
 int nvlist_find_name(nvlist *l, const char *name)
+{
+	return nvlist_find_id(l, field_name_to_id(name), name);
+}
+
+/*
+ * A record that is searched more than once gets a map from field id to
+ * index. Names without an id and small records use a linear scan.
+ */
+int nvlist_find_id(nvlist *l, int id, const char *name)
 {
 	unsigned int i = l->cur;
 	register nvnode *node;
@@ -119,6 +228,25 @@ int nvlist_find_name(nvlist *l, const char *name)
 	if (l->cnt == 0)
 		return 0;
 
+	if (id >= 0 && l->mapped != l->cnt && l->cnt >= NV_MAP_MIN &&
+			l->cnt < NV_NO_NEXT && ++l->finds > NV_MAP_FINDS)
+		build_map(l);
+
+	if (id >= 0 && l->mapped == l->cnt) {
+		unsigned int s = map_probe(l, id);
+
+		if (l->map[s] == 0)
+			return 0;
+		i = l->map[s] - 1;
+		while (i < l->cur) {
+			i = l->array[i].next;
+			if (i == NV_NO_NEXT)
+				return 0;
+		}
+		l->cur = i;
+		return 1;
+	}
+
 	do {
 		node = &l->array[i];
 		if (node->name && strcmp(node->name, name) == 0) {
@@ -134,6 +262,8 @@ extern int interp_adjust_type(int rtype, const char *name, const char *val);
 int nvlist_get_cur_type(rnode *r)
 {
 	nvlist *l = &r->nv;
+	if (l->cnt == 0)
+		return AUPARSE_TYPE_UNCLASSIFIED;
 	nvnode *node = &l->array[l->cur];
 	return auparse_interp_adjust_type(r->type, node->name, node->val);
 }
@@ -171,7 +301,8 @@ void nvlist_clear(nvlist *l, int free_interp)
 			free(current->interp_val);
 			// A couple items are not in parsed up list.
 			// These all come from the aup_list_append path.
-			if (not_in_rec_buf(l, current->name)) {
+			if (l->arena == NULL &&
+					not_in_rec_buf(l, current->name)) {
 				// seperms & key values are strdup'ed
 				if (not_in_rec_buf(l, current->val))
 					free(current->val);
@@ -181,12 +312,20 @@ void nvlist_clear(nvlist *l, int free_interp)
 		i++;
 	}
 
-	free((void *)l->record);
-
-	free(l->array);
+	// Arena memory goes back all at once when the event is done
+	if (l->arena == NULL) {
+		free((void *)l->record);
+		free(l->array);
+	}
 	l->array = NULL;
 	l->size = 0;
 
+	free(l->map);
+	l->map = NULL;
+	l->map_size = 0;
+	l->mapped = 0;
+	l->finds = 0;
+
 	l->record = NULL;
 	l->end = NULL;
 	l->cur = 0;
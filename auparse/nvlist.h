@@ -1,6 +1,6 @@
 /*
 * nvlist.h - Header file for nvlist.c
-* Copyright (c) 2006-07,2016,2021 Red Hat Inc.
+* Copyright (c) 2006-07,2016,2021,2026 Red Hat Inc.
 * All Rights Reserved.
 *
 * This library is free software; you can redistribute it and/or
@@ -44,7 +44,7 @@ static inline const char *nvlist_get_cur_val_interp(const nvlist *l)
 
 AUDIT_HIDDEN_START
 
-void nvlist_create(nvlist *l);
+void nvlist_create(nvlist *l, struct arena *a);
 void nvlist_clear(nvlist *l, int free_interp);
 nvnode *nvlist_next(nvlist *l);
 int nvlist_get_cur_type(rnode *r);
@@ -56,6 +56,12 @@ void nvlist_interp_fixup(const nvlist *l);
 nvnode *nvlist_goto_rec(nvlist *l, unsigned int i);
 /* Given a name, find that record */
 int nvlist_find_name(nvlist *l, const char *name);
+/* Same, with the name already interned by field_name_to_id */
+int nvlist_find_id(nvlist *l, int id, const char *name);
+
+/* Intern a field name. Returns -1 for names that have no id. */
+int field_name_to_id(const char *name);
+const char *field_id_to_name(int id);
 
 AUDIT_HIDDEN_END
 
@@ -1,5 +1,5 @@
 /* rnode.h --
- * Copyright 2007,2016-17,21 Red Hat Inc.
+ * Copyright 2007,2016-17,21,26 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -32,6 +32,8 @@ typedef struct _nvnode{
   char *val;            // The value field
   char *interp_val;     // The value field interpreted
   unsigned int item;    // Which item of the same event
+  short id;             // Interned field name id, -1 if unknown
+  unsigned short next;  // Next field with the same id
 } nvnode;
 
 /* This is the field list head. */
@@ -42,6 +44,11 @@ typedef struct {
   unsigned int size;    // Number of allocated items
   char *record;		// Holds the parsed up record
   char *end;		// End of the parsed up record
+  unsigned short *map;  // Field id to index + 1, open addressing
+  unsigned int map_size; // Number of slots in map
+  unsigned int mapped;  // Fields in map, 0 if not built
+  unsigned int finds;   // Name lookups since the list was filled
+  struct arena *arena;  // Owner of array, record and names, NULL if heap
 } nvlist;
 
 
@@ -57,9 +64,11 @@ typedef struct _rnode{
 	unsigned long long a0;  // arg 0 to the syscall
 	unsigned long long a1;  // arg 1 to the syscall
 	nvlist nv;              // name-value linked list of parsed elements
+	int parsed;		// nv has been filled in
 	unsigned int item;      // Which item of the same event
 	int list_idx;		// The index into the source list, points to where record was found
 	unsigned int line_number; // The line number where record was found
+	const struct aup_proj *proj; // Fields to keep, NULL for all
 	struct _rnode* next;    // Next record node pointer
 } rnode;
 
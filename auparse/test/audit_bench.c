@@ -0,0 +1,375 @@
+/* audit_bench.c -- measure auparse and the search tools on whole logs
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "libaudit.h"
+#include "auparse.h"
+
+/*
+ * Usage: audit_bench [-t tooldir] log...
+ *
+ * Every benchmark runs in its own child so that the peak RSS the parent
+ * collects with wait4 belongs to that benchmark alone. The library ones
+ * read the log themselves the way a consumer would:
+ *   next_event - auparse_next_event over a file, touching every record
+ *   feed       - read() 4k at a time into auparse_feed like a plugin
+ *   interp     - interpret every field of every record
+ *   norm       - normalize and read the subject and object
+ *   expr       - check an audisp-filter style expression on each event
+ * With -t, ausearch and aureport from tooldir are run on the log too.
+ * Each result is one line of name=value pairs. Allocations are counted
+ * by wrapping malloc, so they are na for the tools and when the build
+ * already wraps it for a sanitizer.
+ */
+
+#if defined(__SANITIZE_ADDRESS__)
+# define HAVE_SANITIZER 1
+#elif defined(__has_feature)
+# if __has_feature(address_sanitizer)
+#  define HAVE_SANITIZER 1
+# endif
+#endif
+
+#if defined(__GLIBC__) && !defined(HAVE_SANITIZER)
+#define COUNT_ALLOCS 1
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static unsigned long allocs;
+
+void *malloc(size_t size)
+{
+	allocs++;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	allocs++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	allocs++;
+	return __libc_realloc(ptr, size);
+}
+#endif
+
+struct result {
+	unsigned long events;
+	unsigned long allocs;
+	double secs;
+	int counted;
+};
+
+static unsigned long sink;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long bench_next_event(auparse_state_t *au)
+{
+	unsigned long events = 0;
+
+	while (auparse_next_event(au) > 0) {
+		do {
+			sink += auparse_get_type(au) +
+				auparse_get_num_fields(au);
+		} while (auparse_next_record(au) > 0);
+		events++;
+	}
+	return events;
+}
+
+static unsigned long fed;
+static void feed_cb(auparse_state_t *au, auparse_cb_event_t cb_event_type,
+		    void *user_data)
+{
+	if (cb_event_type != AUPARSE_CB_EVENT_READY)
+		return;
+	do {
+		sink += auparse_get_type(au);
+	} while (auparse_next_record(au) > 0);
+	fed++;
+}
+
+static unsigned long bench_feed(const char *log)
+{
+	auparse_state_t *au;
+	char buf[4096];
+	ssize_t len;
+	int fd = open(log, O_RDONLY);
+
+	if (fd < 0)
+		return 0;
+	au = auparse_init(AUSOURCE_FEED, NULL);
+	if (au == NULL) {
+		close(fd);
+		return 0;
+	}
+	auparse_add_callback(au, feed_cb, NULL, NULL);
+	while ((len = read(fd, buf, sizeof(buf))) > 0)
+		auparse_feed(au, buf, len);
+	auparse_flush_feed(au);
+	auparse_destroy(au);
+	close(fd);
+	return fed;
+}
+
+static unsigned long bench_interp(auparse_state_t *au)
+{
+	unsigned long events = 0;
+
+	while (auparse_next_event(au) > 0) {
+		do {
+			do {
+				const char *v = auparse_interpret_field(au);
+
+				sink += v ? strlen(v) : 0;
+			} while (auparse_next_field(au) > 0);
+		} while (auparse_next_record(au) > 0);
+		events++;
+	}
+	return events;
+}
+
+static unsigned long bench_norm(auparse_state_t *au)
+{
+	unsigned long events = 0;
+
+	while (auparse_next_event(au) > 0) {
+		if (auparse_normalize(au, NORM_OPT_NO_ATTRS) == 0) {
+			if (auparse_normalize_subject_primary(au) == 1)
+				sink += strlen(auparse_get_field_str(au));
+			if (auparse_normalize_object_primary(au) == 1)
+				sink += strlen(auparse_get_field_str(au));
+		}
+		events++;
+	}
+	return events;
+}
+
+static unsigned long bench_expr(auparse_state_t *au)
+{
+	unsigned long events = 0;
+	char *err = NULL;
+
+	if (ausearch_add_expression(au, "(type r= USER_LOGIN || "
+			"type r= USER_AUTH || exe r= \"/usr/bin/sudo\") && "
+			"auid >= 1001 && res r= success", &err,
+			AUSEARCH_RULE_CLEAR)) {
+		fprintf(stderr, "%s\n", err);
+		free(err);
+		return 0;
+	}
+	while (auparse_next_event(au) > 0) {
+		sink += ausearch_cur_event(au) == 1;
+		events++;
+	}
+	return events;
+}
+
+/* Runs in the child, everything it measures goes back through res */
+static void run_library(const char *name, const char *log,
+			struct result *res)
+{
+	auparse_state_t *au = NULL;
+	double start;
+
+	if (strcmp(name, "feed")) {
+		au = auparse_init(AUSOURCE_FILE, log);
+		if (au == NULL)
+			return;
+	}
+#ifdef COUNT_ALLOCS
+	allocs = 0;
+	res->counted = 1;
+#endif
+	start = now();
+	if (strcmp(name, "next_event") == 0)
+		res->events = bench_next_event(au);
+	else if (strcmp(name, "feed") == 0)
+		res->events = bench_feed(log);
+	else if (strcmp(name, "interp") == 0)
+		res->events = bench_interp(au);
+	else if (strcmp(name, "norm") == 0)
+		res->events = bench_norm(au);
+	else if (strcmp(name, "expr") == 0)
+		res->events = bench_expr(au);
+	res->secs = now() - start;
+#ifdef COUNT_ALLOCS
+	res->allocs = allocs;
+#endif
+	if (au)
+		auparse_destroy(au);
+}
+
+static void report(const char *name, const char *log, const struct result *r,
+		   const struct rusage *ru)
+{
+	printf("bench=%s log=%s events=%lu secs=%.3f events_per_sec=%.0f ",
+	       name, log, r->events, r->secs,
+	       r->secs > 0 ? r->events / r->secs : 0.0);
+	if (r->counted && r->events)
+		printf("allocs_per_event=%.2f ",
+		       (double)r->allocs / r->events);
+	else
+		printf("allocs_per_event=na ");
+	printf("peak_rss_kb=%ld\n", ru->ru_maxrss);
+	fflush(stdout);
+}
+
+static int bench_library(const char *name, const char *log,
+			 unsigned long *events)
+{
+	struct result r;
+	struct rusage ru;
+	int fds[2], status;
+	pid_t pid;
+
+	if (pipe(fds))
+		return 1;
+	fflush(stdout);
+	pid = fork();
+	if (pid < 0)
+		return 1;
+	if (pid == 0) {
+		memset(&r, 0, sizeof(r));
+		close(fds[0]);
+		run_library(name, log, &r);
+		_exit(write(fds[1], &r, sizeof(r)) != sizeof(r));
+	}
+	close(fds[1]);
+	if (read(fds[0], &r, sizeof(r)) != sizeof(r))
+		memset(&r, 0, sizeof(r));
+	close(fds[0]);
+	if (wait4(pid, &status, 0, &ru) < 0 || !WIFEXITED(status) ||
+			WEXITSTATUS(status) || r.events == 0) {
+		fprintf(stderr, "%s failed on %s\n", name, log);
+		return 1;
+	}
+	if (events && *events == 0)
+		*events = r.events;
+	report(name, log, &r, &ru);
+	return 0;
+}
+
+/* Time a tool over the whole log, its output is thrown away */
+static int bench_tool(const char *dir, const char *tool, char *const argv[],
+		      const char *log, unsigned long events)
+{
+	struct result r = { events, 0, 0.0, 0 };
+	struct rusage ru;
+	char path[4096];
+	int status;
+	double start;
+	pid_t pid;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, argv[0]);
+	if (access(path, X_OK))
+		return 0;
+	fflush(stdout);
+	start = now();
+	pid = fork();
+	if (pid < 0)
+		return 1;
+	if (pid == 0) {
+		int fd = open("/dev/null", O_WRONLY);
+
+		if (fd >= 0) {
+			dup2(fd, STDOUT_FILENO);
+			dup2(fd, STDERR_FILENO);
+		}
+		execv(path, argv);
+		_exit(127);
+	}
+	if (wait4(pid, &status, 0, &ru) < 0 || !WIFEXITED(status) ||
+			WEXITSTATUS(status) == 127) {
+		fprintf(stderr, "%s failed on %s\n", tool, log);
+		return 1;
+	}
+	r.secs = now() - start;
+	report(tool, log, &r, &ru);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *library[] = { "next_event", "feed", "interp",
+					 "norm", "expr" };
+	const char *tooldir = NULL;
+	int c, rc = 0;
+	unsigned int i;
+
+	while ((c = getopt(argc, argv, "t:")) != -1) {
+		if (c != 't') {
+			fprintf(stderr, "Usage: %s [-t tooldir] log...\n",
+				argv[0]);
+			return 1;
+		}
+		tooldir = optarg;
+	}
+	if (optind == argc) {
+		fprintf(stderr, "Usage: %s [-t tooldir] log...\n", argv[0]);
+		return 1;
+	}
+
+	for (; optind < argc; optind++) {
+		char *log = argv[optind];
+		unsigned long events = 0;
+
+		for (i = 0; i < sizeof(library)/sizeof(library[0]); i++)
+			rc |= bench_library(library[i], log, &events);
+		if (tooldir) {
+			char *search[] = { "ausearch", "--input", log,
+					   "--raw", NULL };
+			char *search_i[] = { "ausearch", "--input", log,
+					     "--interpret", NULL };
+			char *summary[] = { "aureport", "--input", log,
+					    "--summary", NULL };
+
+			rc |= bench_tool(tooldir, "ausearch", search, log,
+					 events);
+			rc |= bench_tool(tooldir, "ausearch_interp", search_i,
+					 log, events);
+			rc |= bench_tool(tooldir, "aureport", summary, log,
+					 events);
+		}
+	}
+	return rc;
+}
@@ -1,11 +1,17 @@
 #include "config.h"
 #include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "libaudit.h"
 #include "auparse.h"
 #include "auparse-idata.h"
+#include "common.h"
 
 static void test_new_buffer(void)
 {
@@ -137,6 +143,1199 @@ static void test_path_norm(void)
 	auparse_destroy(au);
 }
 
+/* Interned lookups must match the string scan, duplicates included. */
+static void test_field_id(void)
+{
+	const char buf[] = "type=SYSCALL msg=audit(1143146623.787:142): "
+		"arch=c000003e syscall=2 success=yes exit=3 a0=1 a1=2 a2=3 "
+		"a3=4 items=1 pid=10 auid=1000 uid=0 odd_one=7 uid=5 tty=pts0\n"
+		"type=CWD msg=audit(1143146623.787:142): cwd=\"/root\"\n"
+		"type=PATH msg=audit(1143146623.787:142): item=0 "
+		"name=\"/etc\" inode=1 dev=fd:00 mode=040755 ouid=0 ogid=0 "
+		"rdev=00:00 nametype=NORMAL uid=9\n";
+	auparse_state_t *au = auparse_init(AUSOURCE_BUFFER, buf);
+	int uid = auparse_field_id("uid");
+	const char *f;
+	int i;
+
+	assert(au != NULL);
+	assert(uid >= 0);
+	assert(auparse_field_id("odd_one") == -1);
+	assert(auparse_field_id("") == -1);
+	assert(auparse_find_field_id(au, -1) == NULL);
+	assert(auparse_next_event(au) > 0);
+
+	/* Search the same event often enough that the map gets built */
+	for (i = 0; i < 3; i++) {
+		assert(auparse_first_record(au) > 0);
+		f = auparse_find_field_id(au, uid);
+		assert(f && strcmp(f, "0") == 0);
+		f = auparse_find_field_next(au);
+		assert(f && strcmp(f, "5") == 0);
+		f = auparse_find_field_next(au);
+		assert(f && strcmp(f, "9") == 0);
+		assert(auparse_get_type(au) == AUDIT_PATH);
+		assert(auparse_find_field_next(au) == NULL);
+
+		assert(auparse_first_record(au) > 0);
+		f = auparse_find_field(au, "odd_one");
+		assert(f && strcmp(f, "7") == 0);
+		f = auparse_find_field(au, "uid");
+		assert(f && strcmp(f, "5") == 0);
+		f = auparse_find_field(au, "nametype");
+		assert(f && strcmp(f, "NORMAL") == 0);
+		assert(auparse_find_field(au, "auid") == NULL);
+	}
+	auparse_destroy(au);
+}
+
+/* Consumed events are recycled rather than freed. */
+static void test_event_reuse(void)
+{
+	auparse_state_t *au = auparse_init(AUSOURCE_FILE, "./test.log");
+	unsigned long reused = 0;
+	char *m, *p;
+	int events = 0;
+
+	assert(au != NULL);
+	while (auparse_next_event(au) > 0) {
+		assert(auparse_first_record(au) > 0);
+		do {
+			assert(auparse_get_record_text(au) != NULL);
+		} while (auparse_next_record(au) > 0);
+		events++;
+	}
+	m = auparse_metrics(au);
+	assert(m != NULL);
+	p = strstr(m, "event lists reused: ");
+	assert(p != NULL);
+	reused = strtoul(p + 20, NULL, 10);
+	assert(events > 2 && reused > 0);
+	free(m);
+	auparse_destroy(au);
+}
+
+/* Interpret every field of test.log twice into OUT */
+static void interpret_all(auparse_state_t *au, char *out, size_t size)
+{
+	size_t used = 0;
+	int pass;
+
+	for (pass = 0; pass < 2; pass++) {
+		assert(auparse_reset(au) == 0);
+		while (auparse_next_event(au) > 0) {
+			do {
+				do {
+					const char *v;
+
+					v = auparse_interpret_field(au);
+					used += snprintf(out + used,
+						size - used, "%s,", v ? v : "");
+					assert(used < size);
+				} while (auparse_next_field(au) > 0);
+			} while (auparse_next_record(au) > 0);
+		}
+	}
+}
+
+static unsigned long metric(auparse_state_t *au, const char *name)
+{
+	char *m = auparse_metrics(au), *p;
+	unsigned long val;
+
+	assert(m != NULL);
+	p = strstr(m, name);
+	assert(p != NULL);
+	val = strtoul(p + strlen(name), NULL, 10);
+	free(m);
+	return val;
+}
+
+/* Cached interpretations read the same as computed ones */
+static void test_interp_cache(void)
+{
+	static char plain[32768], cached[32768], small[32768];
+	auparse_state_t *au = auparse_init(AUSOURCE_FILE, "./test.log");
+
+	assert(au != NULL);
+	assert(auparse_set_interp_cache(au, 0) == 0);
+	interpret_all(au, plain, sizeof(plain));
+	assert(metric(au, "interpretation cache hits: ") == 0);
+	assert(metric(au, "interpretation cache misses: ") == 0);
+
+	assert(auparse_set_interp_cache(au, 1024) == 0);
+	interpret_all(au, cached, sizeof(cached));
+	assert(strcmp(plain, cached) == 0);
+	assert(metric(au, "interpretation cache hits: ") > 0);
+	assert(metric(au, "interpretation cache evictions: ") == 0);
+
+	// A tiny cache keeps replacing entries
+	assert(auparse_set_interp_cache(au, 2) == 0);
+	interpret_all(au, small, sizeof(small));
+	assert(strcmp(plain, small) == 0);
+	assert(metric(au, "interpretation cache evictions: ") > 0);
+	auparse_destroy(au);
+}
+
+/* fan_info reads by the fan_type before it, so neither may be cached */
+static void test_interp_cache_fanotify(void)
+{
+	static const char *buf =
+		"type=FANOTIFY msg=audit(1700000000.001:1): resp=2 fan_type=1 "
+			"fan_info=1F subj_trust=2 obj_trust=2\n"
+		"type=FANOTIFY msg=audit(1700000000.002:2): resp=2 fan_type=0 "
+			"fan_info=1F subj_trust=2 obj_trust=2\n"
+		"type=FANOTIFY msg=audit(1700000000.003:3): resp=2 fan_type=1 "
+			"fan_info=1F subj_trust=2 obj_trust=2\n";
+	auparse_state_t *au = auparse_init(AUSOURCE_BUFFER, buf);
+	char out[64];
+	size_t used = 0;
+
+	assert(au != NULL);
+	assert(auparse_set_interp_cache(au, 1024) == 0);
+	while (auparse_next_event(au) > 0) {
+		assert(auparse_find_field(au, "fan_type"));
+		assert(auparse_interpret_field(au));
+		assert(auparse_find_field(au, "fan_info"));
+		used += snprintf(out + used, sizeof(out) - used, "%s,",
+				 auparse_interpret_field(au));
+		assert(used < sizeof(out));
+	}
+	auparse_destroy(au);
+	assert(strcmp(out, "31,1F,31,") == 0);
+}
+
+/*
+ * Keep a few hundred events in flight, finish them out of order, and make
+ * sure they still come out oldest first with all their records.
+ */
+#define INFLIGHT 300
+
+static void test_interleaved(void)
+{
+	size_t size = INFLIGHT * 3 * 128, used = 0;
+	char *buf = malloc(size);
+	const au_event_t *e;
+	auparse_state_t *au;
+	unsigned long last = 0;
+	int i, events = 0;
+
+	assert(buf != NULL);
+	for (i = 1; i <= INFLIGHT; i++)
+		used += snprintf(buf + used, size - used,
+			"type=SYSCALL msg=audit(1700000000.%03d:%d): pid=%d\n",
+			i % 1000, i, i);
+	for (i = INFLIGHT; i >= 1; i--)
+		used += snprintf(buf + used, size - used,
+			"type=CWD msg=audit(1700000000.%03d:%d): cwd=\"/\"\n",
+			i % 1000, i);
+	for (i = 0; i < INFLIGHT; i++) {
+		int n = (i * 7) % INFLIGHT + 1;
+		used += snprintf(buf + used, size - used,
+			"type=EOE msg=audit(1700000000.%03d:%d): \n",
+			n % 1000, n);
+	}
+
+	au = auparse_init(AUSOURCE_BUFFER, buf);
+	assert(au != NULL);
+	while (auparse_next_event(au) > 0) {
+		e = auparse_get_timestamp(au);
+		assert(e != NULL && e->serial > last);
+		last = e->serial;
+		assert(auparse_get_num_records(au) == 3);
+		events++;
+	}
+	assert(events == INFLIGHT);
+	auparse_destroy(au);
+	free(buf);
+}
+
+/* An event without an EOE is ended by the timeout once time moves on */
+static void test_event_timeout(void)
+{
+	const char buf1[] =
+		"type=SYSCALL msg=audit(1700000000.001:1): pid=1\n";
+	const char buf2[] =
+		"type=SYSCALL msg=audit(1700000100.001:2): pid=2\n"
+		"type=EOE msg=audit(1700000100.001:2): \n";
+	auparse_state_t *au = auparse_init(AUSOURCE_FEED, NULL);
+	unsigned long eoe, timeout;
+
+	assert(au != NULL);
+	cb_count = 0;
+	auparse_add_callback(au, ready_cb, NULL, NULL);
+	assert(auparse_feed(au, buf1, strlen(buf1)) == 0);
+	assert(cb_count == 0);
+	assert(auparse_feed(au, buf2, strlen(buf2)) == 0);
+	assert(cb_count == 1);
+	auparse_get_completions(au, &eoe, &timeout);
+	assert(timeout == 1 && eoe == 1);
+	auparse_flush_feed(au);
+	assert(cb_count == 2);
+	assert(auparse_feed_has_data(au) == 0);
+	auparse_destroy(au);
+}
+
+/*
+ * A feed parser holds no more than its limit no matter how much is fed at
+ * once, and a line that cannot fit is dropped without losing its
+ * neighbours.
+ */
+static void test_feed_limit(void)
+{
+	const char rec[] = "type=LOGIN msg=audit(1143146623.787:%d): pid=%d\n";
+	size_t size = 1024 * 1024, used = 0, n;
+	char *buf = malloc(size);
+	auparse_state_t *au;
+	int i;
+
+	assert(buf != NULL);
+	for (i = 1; i <= 2000; i++)
+		used += snprintf(buf + used, size - used, rec, i, i);
+
+	au = auparse_init(AUSOURCE_FEED, NULL);
+	assert(au != NULL);
+	assert(auparse_set_feed_limit(au, 4096) == 0);
+	cb_count = 0;
+	auparse_add_callback(au, ready_cb, NULL, NULL);
+	assert(auparse_feed(au, buf, used) == 0);
+	auparse_flush_feed(au);
+	assert(cb_count == 2000);
+	// One segment in use and one spare at most
+	assert(metric(au, "feed buffer size: ") <= 2 * 64 * 1024);
+	assert(metric(au, "feed lines dropped: ") == 0);
+	auparse_destroy(au);
+
+	// A 10k line between two records, fed in pieces that split it
+	used = snprintf(buf, size, rec, 1, 1);
+	memset(buf + used, 'x', 10000);
+	used += 10000;
+	buf[used++] = '\n';
+	used += snprintf(buf + used, size - used, rec, 2, 2);
+	au = auparse_init(AUSOURCE_FEED, NULL);
+	assert(au != NULL);
+	assert(auparse_set_feed_limit(au, 4096) == 0);
+	cb_count = 0;
+	auparse_add_callback(au, ready_cb, NULL, NULL);
+	for (i = 0, n = 0; n < used; n += 3000) {
+		errno = 0;
+		if (auparse_feed(au, buf + n, used - n < 3000 ? used - n :
+				 3000) < 0) {
+			assert(errno == ENOBUFS);
+			i++;
+		}
+	}
+	auparse_flush_feed(au);
+	assert(i == 1);
+	assert(cb_count == 2);
+	assert(metric(au, "feed lines dropped: ") == 1);
+	assert(auparse_set_feed_limit(au, 0) == 0);
+	auparse_destroy(au);
+
+	au = auparse_init(AUSOURCE_BUFFER, buf);
+	assert(au != NULL);
+	errno = 0;
+	assert(auparse_set_feed_limit(au, 4096) == -1 && errno == EINVAL);
+	auparse_destroy(au);
+	free(buf);
+}
+
+/*
+ * Files are read from a mapping. Make the file exactly one page without
+ * a trailing newline so the last line ends at the end of the mapping.
+ */
+static void test_file_source(void)
+{
+	char path[] = "/tmp/auparse_mapXXXXXX";
+	const char rec[] = "type=LOGIN msg=audit(1143146623.787:142): pid=1\n";
+	const char *files[3];
+	const char *text = NULL;
+	char buf[4096];
+	auparse_state_t *au;
+	mode_t mode;
+	int fd, events = 0;
+
+	memset(buf, 'x', sizeof(buf));
+	memcpy(buf, rec, sizeof(rec) - 1);
+	memcpy(buf + sizeof(rec) - 1,
+	       "type=LOGIN msg=audit(1143146624.787:143): pid=2 msg='", 53);
+	buf[sizeof(buf) - 1] = '\'';
+	fd = mkstemp(path);
+	assert(fd >= 0);
+	assert(write(fd, buf, sizeof(buf)) == sizeof(buf));
+	close(fd);
+
+	/* Read only files are mapped, writable ones go through stdio */
+	for (mode = 0400; mode <= 0600; mode += 0200) {
+		assert(chmod(path, mode) == 0);
+		au = auparse_init(AUSOURCE_FILE, path);
+		assert(au != NULL);
+		events = 0;
+		while (auparse_next_event(au) > 0) {
+			text = auparse_get_record_text(au);
+			events++;
+		}
+		assert(events == 2);
+		assert(text && strlen(text) == sizeof(buf) - (sizeof(rec) - 1));
+		assert(text[strlen(text) - 1] == '\'');
+		auparse_destroy(au);
+	}
+
+	files[0] = path;
+	files[1] = path;
+	files[2] = NULL;
+	au = auparse_init(AUSOURCE_FILE_ARRAY, files);
+	assert(au != NULL);
+	/* The same events twice are merged, so count the records */
+	events = 0;
+	while (auparse_next_event(au) > 0)
+		events += auparse_get_num_records(au);
+	assert(events == 4);
+	auparse_destroy(au);
+
+	/* A live log truncated while it is read just ends early. Events
+	 * three seconds apart are handed out without reading ahead. */
+	fd = open(path, O_WRONLY | O_TRUNC);
+	assert(fd >= 0);
+	for (events = 1; events <= 20000; events++) {
+		int len = snprintf(buf, sizeof(buf),
+			"type=LOGIN msg=audit(%d.787:%d): pid=1\n",
+			1143146623 + events * 3, events);
+
+		assert(write(fd, buf, len) == len);
+	}
+	au = auparse_init(AUSOURCE_FILE, path);
+	assert(au != NULL);
+	assert(auparse_next_event(au) > 0);
+	assert(ftruncate(fd, 0) == 0);
+	close(fd);
+	events = 1;
+	while (auparse_next_event(au) > 0)
+		events++;
+	assert(events < 20000);
+	auparse_destroy(au);
+	unlink(path);
+}
+
+/*
+ * Read three files serially and on two threads. The merged events have to
+ * match, including the one whose records are split between two files.
+ */
+static int read_events(const char **files, unsigned int threads, char *out,
+		       size_t size)
+{
+	auparse_state_t *au = auparse_init(AUSOURCE_FILE_ARRAY, files);
+	size_t used = 0;
+	int events = 0;
+
+	assert(au != NULL);
+	assert(auparse_set_parallelism(au, threads) == 0);
+	while (auparse_next_event(au) > 0) {
+		const au_event_t *e = auparse_get_timestamp(au);
+
+		used += snprintf(out + used, size - used, "%lu:%u:",
+				 e->serial, auparse_get_num_records(au));
+		do {
+			used += snprintf(out + used, size - used, "%s|",
+				 auparse_get_filename(au));
+		} while (auparse_next_record(au) > 0);
+		events++;
+	}
+	assert(auparse_set_parallelism(au, threads) != 0);
+	auparse_destroy(au);
+	return events;
+}
+
+static void test_parallel(void)
+{
+	char paths[3][32];
+	const char *files[4];
+	static char serial[65536], parallel[65536];
+	int i, n, serial_events;
+
+	for (i = 0; i < 3; i++) {
+		FILE *f;
+		int fd;
+
+		strcpy(paths[i], "/tmp/auparse_parXXXXXX");
+		fd = mkstemp(paths[i]);
+		assert(fd >= 0);
+		f = fdopen(fd, "w");
+		assert(f != NULL);
+		if (i)	// The rest of the event the last file started
+			fprintf(f, "type=CWD msg=audit(1700000%03d.000:%d): "
+				"cwd=\"/\"\ntype=EOE msg=audit(1700000%03d.000:%d): "
+				"\n", i * 100, i * 100, i * 100, i * 100);
+		for (n = i * 100 + 1; n < i * 100 + 100; n++)
+			fprintf(f, "type=SYSCALL msg=audit(1700000%03d.000:%d): "
+				"pid=%d\ntype=EOE msg=audit(1700000%03d.000:%d): "
+				"\n", n, n, n, n, n);
+		if (i < 2)
+			fprintf(f, "type=SYSCALL msg=audit(1700000%03d.000:%d): "
+				"pid=1\n", n, n);
+		fclose(f);
+		files[i] = paths[i];
+	}
+	files[3] = NULL;
+
+	serial_events = read_events(files, 0, serial, sizeof(serial));
+	assert(serial_events == 299);
+	assert(read_events(files, 2, parallel, sizeof(parallel)) ==
+								serial_events);
+	assert(strcmp(serial, parallel) == 0);
+	assert(strstr(parallel, "|100:3:"));
+
+	for (i = 0; i < 3; i++)
+		unlink(paths[i]);
+}
+
+/* Records of events still in flight at both file boundaries */
+static const struct {
+	int file;
+	const char *type;
+	int serial;
+} interleaved[] = {
+	{ 0, "SYSCALL", 51 }, { 0, "SYSCALL", 52 }, { 0, "SYSCALL", 53 },
+	{ 0, "CWD", 52 }, { 0, "SYSCALL", 54 }, { 0, "EOE", 54 },
+	{ 0, "SYSCALL", 59 },
+	// A whole event is queued ahead of the rest of the ones in flight
+	{ 1, "SYSCALL", 55 }, { 1, "EOE", 55 }, { 1, "PATH", 52 },
+	{ 1, "CWD", 51 }, { 1, "CWD", 53 }, { 1, "EOE", 52 },
+	{ 1, "SYSCALL", 56 }, { 1, "EOE", 56 }, { 1, "EOE", 51 },
+	{ 1, "SYSCALL", 57 }, { 1, "PATH", 53 },
+	// 53 runs through the middle file and 59 skips it, the last file
+	// only has their EOE
+	{ 2, "EOE", 53 }, { 2, "CWD", 57 }, { 2, "EOE", 57 },
+	{ 2, "SYSCALL", 58 }, { 2, "EOE", 58 }, { 2, "EOE", 59 },
+};
+
+static void test_parallel_interleaved(void)
+{
+	char paths[3][32];
+	const char *files[4];
+	static char serial[65536], parallel[65536];
+	FILE *f[3];
+	unsigned int i, threads;
+
+	for (i = 0; i < 3; i++) {
+		int fd;
+
+		strcpy(paths[i], "/tmp/auparse_parXXXXXX");
+		fd = mkstemp(paths[i]);
+		assert(fd >= 0);
+		f[i] = fdopen(fd, "w");
+		assert(f[i] != NULL);
+		files[i] = paths[i];
+	}
+	files[3] = NULL;
+	for (i = 1; i <= 50; i++)
+		fprintf(f[0], "type=SYSCALL msg=audit(1700001000.%03u:%u): "
+			"pid=%u\ntype=EOE msg=audit(1700001000.%03u:%u): \n",
+			i, i, i, i, i);
+	for (i = 0; i < sizeof(interleaved)/sizeof(interleaved[0]); i++)
+		fprintf(f[interleaved[i].file],
+			"type=%s msg=audit(1700001000.%03d:%d): %s\n",
+			interleaved[i].type, interleaved[i].serial,
+			interleaved[i].serial,
+			strcmp(interleaved[i].type, "EOE") ? "pid=1" : "");
+	for (i = 0; i < 3; i++)
+		fclose(f[i]);
+
+	assert(read_events(files, 0, serial, sizeof(serial)) == 59);
+	for (threads = 2; threads <= 3; threads++) {
+		assert(read_events(files, threads, parallel,
+				   sizeof(parallel)) == 59);
+		assert(strcmp(serial, parallel) == 0);
+	}
+	assert(strstr(parallel, "|51:3:"));
+	assert(strstr(parallel, "|53:4:"));
+	assert(strstr(parallel, "|57:3:"));
+	assert(strstr(parallel, "|59:2:"));
+
+	for (i = 0; i < 3; i++)
+		unlink(paths[i]);
+}
+
+/* The rest of an event comes after more events than a queue holds */
+static void test_parallel_far(void)
+{
+	char paths[3][32];
+	const char *files[4];
+	static char serial[262144], parallel[262144];
+	FILE *f[3];
+	unsigned int i, threads;
+
+	for (i = 0; i < 3; i++) {
+		int fd;
+
+		strcpy(paths[i], "/tmp/auparse_parXXXXXX");
+		fd = mkstemp(paths[i]);
+		assert(fd >= 0);
+		f[i] = fdopen(fd, "w");
+		assert(f[i] != NULL);
+		files[i] = paths[i];
+	}
+	files[3] = NULL;
+	fprintf(f[0], "type=SYSCALL msg=audit(1700002000.000:1): pid=1\n");
+	for (i = 2; i < 3002; i++)
+		fprintf(f[1], "type=SYSCALL msg=audit(1700002000.%03u:%u): "
+			"pid=%u\ntype=EOE msg=audit(1700002000.%03u:%u): \n",
+			i / 4, i, i, i / 4, i);
+	fprintf(f[1], "type=CWD msg=audit(1700002000.000:1): cwd=\"/\"\n"
+		"type=EOE msg=audit(1700002000.000:1): \n");
+	for (i = 3002; i < 3010; i++)
+		fprintf(f[2], "type=SYSCALL msg=audit(1700002001.000:%u): "
+			"pid=%u\ntype=EOE msg=audit(1700002001.000:%u): \n",
+			i, i, i);
+	for (i = 0; i < 3; i++)
+		fclose(f[i]);
+
+	assert(read_events(files, 0, serial, sizeof(serial)) == 3009);
+	assert(strstr(serial, "1:3:"));
+	for (threads = 2; threads <= 3; threads++) {
+		assert(read_events(files, threads, parallel,
+				   sizeof(parallel)) == 3009);
+		assert(strcmp(serial, parallel) == 0);
+	}
+
+	for (i = 0; i < 3; i++)
+		unlink(paths[i]);
+}
+
+/* Raw value of NAME in the current record or NULL */
+static const char *record_field(auparse_state_t *au, const char *name)
+{
+	auparse_first_field(au);
+	do {
+		if (strcmp(auparse_get_field_name(au), name) == 0)
+			return auparse_get_field_str(au);
+	} while (auparse_next_field(au) > 0);
+	return NULL;
+}
+
+static int match_syscall(auparse_state_t *au)
+{
+	return auparse_get_type(au) == AUDIT_SYSCALL;
+}
+
+static int match_path_cwd(auparse_state_t *au)
+{
+	return auparse_get_type(au) == AUDIT_PATH ||
+		auparse_get_type(au) == AUDIT_CWD;
+}
+
+static int match_auid(auparse_state_t *au)
+{
+	const char *auid = record_field(au, "auid");
+
+	return auid && strtoul(auid, NULL, 10) >= 42 &&
+		auparse_get_type(au) != AUDIT_SYSCALL;
+}
+
+static int match_login_root(auparse_state_t *au)
+{
+	const char *uid = record_field(au, "uid");
+
+	if (auparse_get_type(au) == AUDIT_USER_LOGIN)
+		return 1;
+	return uid && strcmp(auparse_interpret_field(au), "root") == 0;
+}
+
+static int match_none(auparse_state_t *au)
+{
+	(void)au;
+	return 0;
+}
+
+/* Compiled searches find the same events as walking every record */
+static void test_compiled_search(void)
+{
+	static const struct {
+		const char *expr;
+		int (*match)(auparse_state_t *au);
+	} cases[] = {
+		{ "type r= SYSCALL", match_syscall },
+		{ "type r= PATH || type r= CWD", match_path_cwd },
+		{ "auid >= 42 && !(type r= SYSCALL)", match_auid },
+		{ "\\record_type == 1112 || uid i= root", match_login_root },
+		{ "type r= SYSCALL && type r= PATH", match_none },
+	};
+	auparse_state_t *au;
+	unsigned int i;
+	int found;
+	char *err = NULL;
+
+	for (i = 0; i < sizeof(cases)/sizeof(cases[0]); i++) {
+		int expected = 0;
+
+		au = auparse_init(AUSOURCE_FILE, "./test.log");
+		found = 0;
+
+		assert(au != NULL);
+		while (auparse_next_event(au) > 0) {
+			do {
+				if (cases[i].match(au)) {
+					expected++;
+					break;
+				}
+			} while (auparse_next_record(au) > 0);
+		}
+		auparse_destroy(au);
+
+		au = auparse_init(AUSOURCE_FILE, "./test.log");
+		assert(au != NULL);
+		assert(ausearch_add_expression(au, cases[i].expr, &err,
+					       AUSEARCH_RULE_CLEAR) == 0);
+		ausearch_set_stop(au, AUSEARCH_STOP_RECORD);
+		while (ausearch_next_event(au) > 0) {
+			assert(cases[i].match(au));
+			found++;
+		}
+		auparse_destroy(au);
+		printf("%s: %d events\n", cases[i].expr, found);
+		assert(found == expected);
+	}
+
+	// With a node, the type is not the record's first field
+	au = auparse_init(AUSOURCE_FILE, "./test3.log");
+	assert(au != NULL);
+	assert(ausearch_add_expression(au, "type r= SYSCALL", &err,
+				       AUSEARCH_RULE_CLEAR) == 0);
+	ausearch_set_stop(au, AUSEARCH_STOP_FIELD);
+	found = 0;
+	while (ausearch_next_event(au) > 0) {
+		assert(auparse_get_type(au) == AUDIT_SYSCALL);
+		assert(strcmp(auparse_get_field_name(au), "type") == 0);
+		assert(strcmp(auparse_get_field_str(au), "SYSCALL") == 0);
+		found++;
+	}
+	auparse_destroy(au);
+	printf("type r= SYSCALL with a node: %d events\n", found);
+	assert(found > 0);
+}
+
+/* Return a mask of the serials EXPR matches in test.log */
+static unsigned int search_serials(const char *expr, ausearch_rule_t how)
+{
+	auparse_state_t *au = auparse_init(AUSOURCE_FILE, "./test.log");
+	unsigned int serials = 0;
+	char *err = NULL;
+
+	assert(au != NULL);
+	assert(ausearch_add_expression(au, expr, &err, how) == 0);
+	ausearch_set_stop(au, AUSEARCH_STOP_EVENT);
+	while (ausearch_next_event(au) > 0)
+		serials |= 1U << (auparse_get_timestamp(au)->serial - 290);
+	auparse_destroy(au);
+	return serials;
+}
+
+/* Many ORed rules go through the index and match what each rule does */
+static void test_rule_index(void)
+{
+	static const char *rules[] = {
+		"exe i= \"/usr/sbin/crond\" && type r= CRED_DISP",
+		"syscall i= write",
+		"auid == 42",
+		"\\record_type == 1400",
+		"type r= USER_END || type r= USER_START",
+		"key r= nothing",
+		"exe r= \"\\\"/bin/none\\\"\"",
+		"auid == 7",
+		"uid i= nobody && pid r= 1",
+	};
+	auparse_state_t *au = auparse_init(AUSOURCE_FILE, "./test.log");
+	unsigned int i, expected = 0, found = 0;
+	char *err = NULL;
+
+	for (i = 0; i < sizeof(rules)/sizeof(rules[0]); i++)
+		expected |= search_serials(rules[i], AUSEARCH_RULE_CLEAR);
+	assert(expected == (1U << 3 | 1U << 6 | 1U << 7 | 1U << 8 | 1U << 9));
+
+	assert(au != NULL);
+	for (i = 0; i < sizeof(rules)/sizeof(rules[0]); i++)
+		assert(ausearch_add_expression(au, rules[i], &err,
+					       AUSEARCH_RULE_OR) == 0);
+	ausearch_set_stop(au, AUSEARCH_STOP_EVENT);
+	while (ausearch_next_event(au) > 0)
+		found |= 1U << (auparse_get_timestamp(au)->serial - 290);
+	auparse_destroy(au);
+	assert(found == expected);
+}
+
+/* Types and fields the projection tests keep */
+static const int proj_types[] = { AUDIT_SYSCALL, AUDIT_PATH, AUDIT_USER_AUTH,
+				  AUDIT_CRED_DISP, 0 };
+static const char *proj_fields[] = { "syscall", "auid", "name", "res",
+				     "exe", NULL };
+
+static int projected_type(int type)
+{
+	unsigned int i;
+
+	for (i = 0; proj_types[i]; i++)
+		if (proj_types[i] == type)
+			return 1;
+	return 0;
+}
+
+/*
+ * Write out the projected records of each event in FILE. The unprojected
+ * parser is filtered here, the projected one has to come out the same.
+ * If STREAM is non-zero, FILE is handed over as an open FILE pointer,
+ * which the parser closes.
+ */
+static void render_projected(const char *file, int project, int stream,
+			     char *out, size_t size)
+{
+	FILE *f = NULL;
+	auparse_state_t *au;
+	size_t used = 0;
+
+	if (stream) {
+		f = fopen(file, "r");
+		assert(f != NULL);
+		au = auparse_init(AUSOURCE_FILE_POINTER, f);
+	} else
+		au = auparse_init(AUSOURCE_FILE, file);
+	assert(au != NULL);
+	if (project)
+		assert(auparse_set_projection(au, proj_types,
+					      proj_fields) == 0);
+	*out = 0;
+	while (auparse_next_event(au) > 0) {
+		size_t start = used;
+		int records = 0;
+
+		used += snprintf(out + used, size - used, "%lu:",
+				 auparse_get_serial(au));
+		do {
+			if (!projected_type(auparse_get_type(au)))
+				continue;
+			records++;
+			used += snprintf(out + used, size - used, "%d %s|",
+					 auparse_get_type(au),
+					 auparse_get_record_text(au));
+			if (auparse_first_field(au) == 0)
+				continue;
+			do {
+				const char *name = auparse_get_field_name(au);
+				unsigned int i;
+
+				for (i = 0; proj_fields[i]; i++)
+					if (strcmp(proj_fields[i], name) == 0)
+						break;
+				if (proj_fields[i] == NULL)
+					continue;
+				used += snprintf(out + used, size - used,
+					"%s=%s|", name,
+					auparse_interpret_field(au));
+			} while (auparse_next_field(au) > 0);
+		} while (auparse_next_record(au) > 0);
+		if (records == 0) {
+			assert(!project);
+			used = start;
+			out[used] = 0;
+		} else
+			used += snprintf(out + used, size - used, "\n");
+		assert(used < size);
+	}
+	if (project)
+		assert(auparse_set_projection(au, NULL, NULL) != 0 &&
+		       errno == EBUSY);
+	auparse_destroy(au);
+}
+
+static void test_projection(void)
+{
+	static const char *logs[] = { "./test.log", "./test2.log",
+				      "./test3.log", "./test4.log" };
+	static char full[65536], projected[65536];
+	static const char feed[] =
+	"type=SYSCALL msg=audit(1700000000.001:10): arch=c000003e "
+		"syscall=2 success=yes exit=3 pid=7 auid=1000 uid=0\n"
+	"type=EOE msg=audit(1700000000.001:10): \n"
+	"type=SYSCALL msg=audit(1700000000.001:11): arch=c000003e "
+		"syscall=2 success=yes exit=3 pid=7 auid=1000 uid=0\n";
+	static const int syscall_only[] = { AUDIT_SYSCALL, 0 };
+	auparse_state_t *au;
+	unsigned int i;
+
+	for (i = 0; i < sizeof(logs)/sizeof(logs[0]); i++) {
+		render_projected(logs[i], 0, 0, full, sizeof(full));
+		render_projected(logs[i], 1, 0, projected, sizeof(projected));
+		assert(strcmp(full, projected) == 0);
+		// aulast --stdin projects a source that is open from the start
+		render_projected(logs[i], 1, 1, projected, sizeof(projected));
+		assert(strcmp(full, projected) == 0);
+	}
+	// The syscall is named without the arch field being kept
+	assert(strstr(projected, "syscall=execve|"));
+
+	// A record that is left out still ends its event
+	au = auparse_init(AUSOURCE_FEED, NULL);
+	assert(au != NULL);
+	assert(auparse_set_projection(au, syscall_only, NULL) == 0);
+	cb_count = 0;
+	auparse_add_callback(au, ready_cb, NULL, NULL);
+	assert(auparse_feed(au, feed, sizeof(feed) - 1) == 0);
+	assert(cb_count == 1);
+	auparse_flush_feed(au);
+	assert(cb_count == 2);
+	auparse_destroy(au);
+}
+
+static const char *batch_fields[] = { "auid", "uid", "syscall", "name", "res",
+				      "no_such_field", NULL };
+
+/* What the field at a time accessors say about each event */
+static void render_fields(const char *file, char *out, size_t size)
+{
+	auparse_state_t *au = auparse_init(AUSOURCE_FILE, file);
+	size_t len = 0;
+
+	assert(au != NULL);
+	out[0] = 0;
+	while (auparse_next_event(au) > 0) {
+		unsigned int f;
+
+		auparse_first_record(au);
+		len += snprintf(out + len, size - len, "%lu.%u:%lu %d",
+				(unsigned long)auparse_get_time(au),
+				auparse_get_milli(au), auparse_get_serial(au),
+				auparse_get_type(au));
+		for (f = 0; batch_fields[f]; f++) {
+			const char *val, *interp = NULL;
+
+			auparse_first_record(au);
+			val = auparse_find_field(au, batch_fields[f]);
+			if (val)
+				interp = auparse_interpret_field(au);
+			len += snprintf(out + len, size - len, " %s/%s",
+					val ? val : "-", interp ? interp : "-");
+		}
+		len += snprintf(out + len, size - len, "\n");
+		assert(len < size);
+	}
+	auparse_destroy(au);
+}
+
+/* The same from batches that are small enough to fill up */
+static void render_batches(const char *file, char *out, size_t size)
+{
+	enum { ROWS = 3, NF = 6 };
+	static char heap[160];
+	time_t sec[ROWS];
+	unsigned int milli[ROWS];
+	unsigned long serial[ROWS];
+	int type[ROWS];
+	size_t value[NF * ROWS], interp[NF * ROWS];
+	auparse_batch_t b = {
+		.fields = batch_fields, .size = ROWS, .sec = sec,
+		.milli = milli, .serial = serial, .type = type,
+		.value = value, .interp = interp, .heap = heap,
+		.heap_size = sizeof(heap)
+	};
+	auparse_state_t *au = auparse_init(AUSOURCE_FILE, file);
+	size_t len = 0;
+	int rc;
+
+	assert(au != NULL);
+	out[0] = 0;
+	while ((rc = auparse_get_batch(au, &b)) > 0) {
+		unsigned int i, f;
+
+		assert(b.rows == (unsigned int)rc);
+		assert(b.heap_used <= sizeof(heap));
+		for (i = 0; i < b.rows; i++) {
+			len += snprintf(out + len, size - len, "%lu.%u:%lu %d",
+					(unsigned long)sec[i], milli[i],
+					serial[i], type[i]);
+			for (f = 0; f < NF; f++) {
+				size_t v = value[f * ROWS + i];
+				size_t t = interp[f * ROWS + i];
+
+				len += snprintf(out + len, size - len, " %s/%s",
+					v == AUPARSE_BATCH_NONE ? "-" : heap + v,
+					t == AUPARSE_BATCH_NONE ? "-" : heap + t);
+			}
+			len += snprintf(out + len, size - len, "\n");
+			assert(len < size);
+		}
+	}
+	assert(rc == 0);
+	auparse_destroy(au);
+}
+
+static void test_batch(void)
+{
+	static const char *logs[] = { "./test.log", "./test2.log",
+				      "./test3.log", "./test4.log" };
+	static char one[131072], batched[131072];
+	static char heap[4];
+	const char *no_fields[] = { NULL };
+	unsigned long serial[2];
+	auparse_batch_t b = {
+		.fields = no_fields, .size = 2, .serial = serial
+	};
+	unsigned long first;
+	auparse_state_t *au;
+	unsigned int i;
+
+	for (i = 0; i < sizeof(logs)/sizeof(logs[0]); i++) {
+		render_fields(logs[i], one, sizeof(one));
+		render_batches(logs[i], batched, sizeof(batched));
+		assert(one[0]);
+		assert(strcmp(one, batched) == 0);
+	}
+
+	// Only the event columns, without a heap
+	au = auparse_init(AUSOURCE_FILE, "./test.log");
+	assert(au != NULL);
+	assert(auparse_get_batch(au, &b) == 2);
+	assert(serial[0] != serial[1]);
+	assert(auparse_get_serial(au) == serial[1]);
+	first = serial[0];
+	auparse_destroy(au);
+
+	// An event too big for the heap is kept for a roomier call
+	au = auparse_init(AUSOURCE_FILE, "./test.log");
+	assert(au != NULL);
+	b.fields = batch_fields;
+	b.value = (size_t [12]){ 0 };
+	b.heap = heap;
+	b.heap_size = sizeof(heap);
+	errno = 0;
+	assert(auparse_get_batch(au, &b) == -1 && errno == ENOSPC);
+	assert(b.rows == 0);
+	b.heap = one;
+	b.heap_size = sizeof(one);
+	assert(auparse_get_batch(au, &b) == 2);
+	assert(serial[0] == first);
+	auparse_destroy(au);
+}
+
+/* The strndupa and strtoul version audit_parse_stamp replaced */
+static int ref_stamp(const char *b, size_t len, long max_sec, audit_stamp_t *e,
+		     char *host, char *type)
+{
+	char *ptr, *tmp, *saved = NULL, *s;
+
+	*host = *type = 0;
+	tmp = strndupa(b, len && *b == 'n' ? (len < 340 ? len : 340) :
+			(len < 80 ? len : 80));
+	ptr = audit_strsplit_r(tmp, &saved);
+	if (ptr == NULL)
+		return 1;
+	if (*ptr == 'n' && strnlen(ptr, 8) > 5) {
+		strcpy(host, ptr+5);
+		ptr = audit_strsplit_r(NULL, &saved);
+		if (ptr == NULL)
+			return 1;
+	}
+	if (strlen(ptr) >= 5)
+		strcpy(type, ptr+5);
+	ptr = audit_strsplit_r(NULL, &saved);
+	if (ptr == NULL || strnlen(ptr, 20) <= 18)
+		return 1;
+	if (*(ptr+9) == '(')
+		ptr += 9;
+	else
+		ptr = strchr(ptr, '(');
+	if (ptr == NULL)
+		return 1;
+	s = ++ptr;
+	ptr = strchr(s, ')');
+	if (ptr)
+		*ptr = 0;
+
+	errno = 0;
+	e->sec = strtoul(s, NULL, 10);
+	if (errno || e->sec > max_sec)
+		return -1;
+	ptr = strchr(s, '.');
+	if (ptr) {
+		ptr++;
+		e->milli = strtoul(ptr, NULL, 10);
+		if (errno || e->milli > 999)
+			return -1;
+		s = ptr;
+	} else
+		e->milli = 0;
+	ptr = strchr(s, ':');
+	if (ptr) {
+		e->serial = strtoul(ptr+1, NULL, 10);
+		if (errno)
+			return -1;
+	} else
+		e->serial = 0;
+	return 0;
+}
+
+static void test_stamp_fuzz(void)
+{
+	static const char *lines[] = {
+		"type=SYSCALL msg=audit(1700000000.123:4567): arch=c000003e "
+			"syscall=59 success=yes exit=0",
+		"node=host.example.com type=PATH msg=audit(1143146623.787:142): "
+			"item=0 name=\"/bin/ls\"",
+		"type=LOGIN msg=audit(1143146623.787:142): pid=1",
+		"type=DAEMON_START msg=audit(1700000000.5): op=start",
+		"type=EOE msg=audit(18446744073709551616.1:2):",
+		"n type=USER msg=audit(-5.+7:\t9):",
+		"  node=a  type=USER_AUTH   msg=audit(1.999:18446744073709551615):",
+	};
+	static const char chars[] = " ().:+-\t\n0123456789naudit=x";
+	char line[400], longline[400], host[400], type[400];
+	long limits[] = { LONG_MAX - 2 - 1, 1500000000 };
+	unsigned int seed = 7, round;
+
+	// One node name long enough to run into the 340 byte limit
+	memset(longline, 'h', 330);
+	memcpy(longline, "node=", 5);
+	strcpy(longline + 330, " type=X msg=audit(1.2:3):");
+
+	for (round = 0; round < 200000; round++) {
+		unsigned int i, edits;
+		long max_sec = limits[round % 2];
+		size_t len;
+		audit_stamp_t got, want;
+		int rc;
+
+		if (round % 8 == 7)
+			strcpy(line, longline);
+		else
+			strcpy(line, lines[round % (sizeof(lines) /
+						    sizeof(lines[0]))]);
+		len = strlen(line);
+		seed = seed * 1103515245 + 12345;
+		edits = (seed >> 16) % 5;
+		for (i = 0; i < edits && len; i++) {
+			size_t at;
+
+			seed = seed * 1103515245 + 12345;
+			at = (seed >> 8) % len;
+			switch ((seed >> 4) % 4) {
+			case 0: // delete
+				memmove(line + at, line + at + 1, len - at);
+				len--;
+				break;
+			case 1: // insert
+				if (len + 1 >= sizeof(line))
+					break;
+				memmove(line + at + 1, line + at, len - at + 1);
+				len++;
+				/* fallthrough */
+			default: // replace, sometimes with a nul
+				line[at] = (seed >> 20) % 64 ? chars[(seed >> 12)
+					% (sizeof(chars) - 1)] : 0;
+				break;
+			}
+		}
+		// Sometimes hand over less than the whole line
+		if (round % 3 == 0)
+			len = (seed >> 10) % (len + 1);
+
+		rc = audit_parse_stamp(line, len, max_sec, &got);
+		assert(rc == ref_stamp(line, len, max_sec, &want, host, type));
+		if (got.node)
+			assert(strlen(host) == got.node_len &&
+			       memcmp(got.node, host, got.node_len) == 0);
+		else
+			assert(*host == 0);
+		if (got.type)
+			assert(strlen(type) == got.type_len &&
+			       memcmp(got.type, type, got.type_len) == 0);
+		else
+			assert(*type == 0);
+		if (rc == 0)
+			assert(got.sec == want.sec && got.milli == want.milli &&
+			       got.serial == want.serial);
+	}
+}
+
+/* The byte at a time versions the vector kernels replaced */
+static size_t ref_escape_count(const unsigned char *s, size_t n,
+			       audit_esc_class_t cls)
+{
+	static const char sh[] = "\"'`$\\!()| ";
+	static const char quote[] = "\"'`$\\!()| ;#&*?[]<>{}";
+	size_t i, cnt = 0;
+
+	for (i = 0; i < n; i++) {
+		unsigned char c = s[i];
+
+		if (cls == AUDIT_ESC_ENCODE)
+			cnt += c == '"' || c < 0x21 || c > 0x7e;
+		else if (c < 32)
+			cnt++;
+		else if (cls == AUDIT_ESC_SHELL)
+			cnt += strchr(sh, c) != NULL;
+		else if (cls == AUDIT_ESC_SHELL_QUOTE)
+			cnt += strchr(quote, c) != NULL;
+	}
+	return cnt;
+}
+
+static unsigned char ref_x2c(const unsigned char *buf)
+{
+	static const char AsciiArray[17] = "0123456789ABCDEF";
+	unsigned char total = 0;
+	char *ptr;
+
+	ptr = strchr(AsciiArray, (char)toupper(buf[0]));
+	if (ptr)
+		total = (unsigned char)(((ptr-AsciiArray) & 0x0F)<<4);
+	ptr = strchr(AsciiArray, (char)toupper(buf[1]));
+	if (ptr)
+		total += (unsigned char)((ptr-AsciiArray) & 0x0F);
+	return total;
+}
+
+static void test_hex_kernels(void)
+{
+	static const char chars[] = "0123456789abcdefABCDEFgG\"' $(;{\x01\x7f\xff";
+	unsigned char in[300], ref[300];
+	char enc[601], dec[301], inplace[301];
+	unsigned int seed = 1, round;
+
+	for (round = 0; round < 2000; round++) {
+		size_t n = round % 257, i, got;
+		audit_esc_class_t cls;
+
+		for (i = 0; i < n; i++) {
+			seed = seed * 1103515245 + 12345;
+			// Mostly hex digits, sometimes anything at all
+			in[i] = (seed >> 16) % 8 ? chars[(seed >> 8) %
+				(sizeof(chars) - 1)] : (seed >> 20) & 0xFF;
+		}
+		in[n] = 0;
+
+		for (cls = AUDIT_ESC_CTRL; cls <= AUDIT_ESC_ENCODE; cls++)
+			assert(audit_escape_count((char *)in, n, cls) ==
+			       ref_escape_count(in, n, cls));
+
+		// Odd lengths decode the last digit against the terminator
+		for (i = 0; i < n; i += 2)
+			ref[i / 2] = ref_x2c(&in[i]);
+		got = audit_hex_decode(dec, (char *)in, n);
+		assert(got == (n + 1) / 2);
+		assert(memcmp(dec, ref, got) == 0);
+		memcpy(inplace, in, n);
+		assert(audit_hex_decode(inplace, inplace, n) == got);
+		assert(memcmp(inplace, ref, got) == 0);
+
+		audit_encode_value(enc, (char *)in, n);
+		assert(strlen(enc) == 2 * n);
+		for (i = 0; i < n; i++) {
+			assert(strchr("0123456789ABCDEF", enc[2 * i]));
+			assert(ref_x2c((unsigned char *)&enc[2 * i]) == in[i]);
+		}
+		assert(audit_value_needs_encoding((char *)in, n) ==
+		       (ref_escape_count(in, n, AUDIT_ESC_ENCODE) != 0));
+	}
+}
+
 int main(void)
 {
 	test_new_buffer();
@@ -144,7 +1343,24 @@ int main(void)
 	test_normalize();
 	test_compare();
 	test_timestamp_milli();
+	test_compiled_search();
+	test_rule_index();
 	test_path_norm();
+	test_field_id();
+	test_event_reuse();
+	test_interp_cache();
+	test_interp_cache_fanotify();
+	test_interleaved();
+	test_event_timeout();
+	test_feed_limit();
+	test_file_source();
+	test_parallel();
+	test_parallel_interleaved();
+	test_parallel_far();
+	test_projection();
+	test_batch();
+	test_hex_kernels();
+	test_stamp_fuzz();
 	printf("extra auparse tests: all passed\n");
 	return 0;
 }
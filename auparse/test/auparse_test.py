@@ -275,6 +275,35 @@ if walked_fields != FIELDS_EXPECTED:
           (FIELDS_EXPECTED, walked_fields))
 print("Test 11 Done\n")
 
+print("Starting Test 12, bulk iteration over a file...")
+fields = ["auid", "uid", "syscall", "name", "nonexistent"]
+au = auparse.AuParser(auparse.AUSOURCE_FILE, srcdir + "/test.log");
+rows = list(au.events(fields, interpret=True, batch=3))
+au = auparse.AuParser(auparse.AUSOURCE_FILE, srcdir + "/test.log");
+expected = []
+while au.parse_next_event():
+    ts = au.get_timestamp()
+    au.first_record()
+    row = [ts.sec, ts.milli, ts.serial, au.get_type()]
+    for name in fields:
+        au.first_record()
+        value = au.find_field(name)
+        row.append(value if value is None else au.interpret_field())
+    expected.append(tuple(row))
+if rows != expected:
+    print("Error: events() differs from walking the fields")
+au = auparse.AuParser(auparse.AUSOURCE_FILE, srcdir + "/test.log");
+cols = au.get_batch(fields, size=len(rows) + 1, interpret=True)
+columns = [cols[k] for k in ["sec", "milli", "serial", "type"] + fields]
+if list(zip(*columns)) != rows:
+    print("Error: get_batch() differs from events()")
+if au.get_batch(fields) is not None:
+    print("Error: get_batch() did not end")
+au = auparse.AuParser(auparse.AUSOURCE_FILE, srcdir + "/test.log");
+for row in au.events(fields, as_dict=True):
+    print("    " + " ".join(map(str, row.values())))
+print("Test 12 Done\n")
+
 print("Finished non-admin tests\n")
 
 au = None
@@ -1417,5 +1417,15 @@ event 2 has 6 records
 
 Test 11 Done
 
+Starting Test 12, bulk iteration over a file...
+    1170021493 977 293 1400 4294967295 890 2 "maildrop" None
+    1170021601 340 294 1101 4294967295 0 None None None
+    1170021601 342 295 1103 4294967295 0 None None None
+    1170021601 343 296 1006 42 0 1 None None
+    1170021601 344 297 1105 0 0 None None None
+    1170021601 364 298 1104 0 0 None None None
+    1170021601 366 299 1106 0 0 None None None
+Test 12 Done
+
 Finished non-admin tests
 
@@ -1,9 +1,20 @@
 #include "config.h"
 #include <assert.h>
+#include <errno.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 #include "data_buf.h"
 
+#ifndef MIN
+#define MIN(a,b) (((a)<=(b))?(a):(b))
+#endif
+
+#ifndef MAX
+#define MAX(a,b) (((a)>=(b))?(a):(b))
+#endif
+
 static void test_basic(void)
 {
 	DataBuf db;
@@ -13,21 +24,25 @@ static void test_basic(void)
 
 	assert(databuf_init(&db, 0, 0) == 1);
 	assert(databuf_append(&db, data1, sizeof(data1) - 1) == 1);
-	assert(db.len == 4 && db.offset == 0);
+	assert(db.len == 4);
 	assert(memcmp(databuf_beg(&db), "abcd", 4) == 0);
 
 	assert(databuf_append(&db, data2, sizeof(data2) - 1) == 1);
-	assert(db.len == 6 && db.offset == 0);
+	assert(db.len == 6);
 	assert(memcmp(databuf_beg(&db), "abcdef", 6) == 0);
 
 	assert(databuf_advance(&db, 3) == 1);
-	assert(db.offset == 3 && db.len == 3);
+	assert(db.len == 3);
 	assert(memcmp(databuf_beg(&db), "def", 3) == 0);
 
+	/* A ring appends after what is left rather than moving it */
 	assert(databuf_append(&db, data3, sizeof(data3) - 1) == 1);
-	assert(db.offset == 0 && db.len == 7);
+	assert(db.len == 7);
 	assert(memcmp(databuf_beg(&db), "defghij", 7) == 0);
 
+	assert(databuf_advance(&db, 8) == -1 && errno == ESPIPE);
+	assert(db.len == 0);
+
 	databuf_free(&db);
 }
 
@@ -60,11 +75,194 @@ static void test_preserve(void)
 	databuf_free(&db);
 }
 
-int main(void)
+static void test_line(void)
+{
+	DataBuf db;
+	size_t len;
+	char *line;
+
+	assert(databuf_init(&db, 0, 0) == 1);
+	assert(databuf_append(&db, "ab\ncd\nef", 8) == 1);
+	line = databuf_line(&db, &len);
+	assert(line && len == 2 && strcmp(line, "ab") == 0);
+	line = databuf_line(&db, &len);
+	assert(line && len == 2 && strcmp(line, "cd") == 0);
+	assert(databuf_line(&db, &len) == NULL);
+	assert(db.len == 2);
+
+	/* The rest of a line can arrive later */
+	assert(databuf_append(&db, "g\n\n", 3) == 1);
+	line = databuf_line(&db, &len);
+	assert(line && len == 3 && strcmp(line, "efg") == 0);
+	line = databuf_line(&db, &len);
+	assert(line && len == 0);
+	assert(databuf_line(&db, &len) == NULL);
+	databuf_free(&db);
+
+	/* Preserved data reads the same after a reset */
+	assert(databuf_init(&db, 0, DATABUF_FLAG_PRESERVE_HEAD) == 1);
+	assert(databuf_append(&db, "ab\ncd\n", 6) == 1);
+	assert(databuf_line(&db, NULL) != NULL);
+	assert(databuf_reset(&db) == 1);
+	assert(memcmp(databuf_beg(&db), "ab\ncd\n", 6) == 0);
+	line = databuf_line(&db, &len);
+	assert(line && strcmp(line, "ab") == 0);
+	databuf_free(&db);
+}
+
+/* Lines that cross from one ring segment into the next */
+static void test_span(void)
+{
+	size_t fill = DATABUF_SEG_SIZE - 4, len;
+	char *big = malloc(3 * DATABUF_SEG_SIZE);
+	DataBuf db;
+	char *line;
+	int i;
+
+	assert(big != NULL);
+	memset(big, 'a', fill);
+	big[fill] = '\n';
+	assert(databuf_init(&db, 0, 0) == 1);
+	assert(databuf_append(&db, big, fill + 1) == 1);
+	assert(databuf_append(&db, "bcdefg\nh", 8) == 1);
+	assert(db.alloc_size == 2 * DATABUF_SEG_SIZE);
+
+	line = databuf_line(&db, &len);
+	assert(line && len == fill && line[0] == 'a' && line[len] == 0);
+	line = databuf_line(&db, &len);
+	assert(line && len == 6 && strcmp(line, "bcdefg") == 0);
+	assert(databuf_line(&db, &len) == NULL);
+	assert(db.len == 1);
+
+	/* A line longer than two segments comes back in one piece */
+	memset(big, 'z', 3 * DATABUF_SEG_SIZE);
+	big[3 * DATABUF_SEG_SIZE - 1] = '\n';
+	assert(databuf_append(&db, big, 3 * DATABUF_SEG_SIZE) == 1);
+	line = databuf_line(&db, &len);
+	assert(line && len == 3 * DATABUF_SEG_SIZE && line[0] == 'h');
+	for (i = 1; i < (int)len; i++)
+		assert(line[i] == 'z');
+	assert(db.len == 0);
+
+	/* Read segments are kept for the next append, one spare at most */
+	for (i = 0; i < 100; i++) {
+		assert(databuf_append(&db, big, DATABUF_SEG_SIZE) == 1);
+		assert(databuf_advance(&db, DATABUF_SEG_SIZE) == 1);
+	}
+	assert(db.alloc_size <= 2 * DATABUF_SEG_SIZE);
+
+	databuf_discard(&db);
+	assert(db.len == 0 && databuf_line(&db, &len) == NULL);
+	databuf_free(&db);
+	free(big);
+}
+
+static void test_limit(void)
+{
+	DataBuf db;
+	size_t len;
+	char *line;
+
+	assert(databuf_init(&db, 0, 0) == 1);
+	databuf_set_limit(&db, 8);
+	assert(databuf_room(&db) == 8);
+	assert(databuf_append(&db, "abc\ndef", 7) == 1);
+	assert(databuf_room(&db) == 1);
+
+	/* Appends that do not fit change nothing */
+	errno = 0;
+	assert(databuf_append(&db, "gh", 2) == -1 && errno == ENOBUFS);
+	assert(db.len == 7);
+
+	line = databuf_line(&db, &len);
+	assert(line && strcmp(line, "abc") == 0);
+	assert(databuf_append(&db, "gh\n", 3) == 1);
+	line = databuf_line(&db, &len);
+	assert(line && strcmp(line, "defgh") == 0);
+	assert(databuf_room(&db) == 8);
+
+	databuf_set_limit(&db, 0);
+	assert(databuf_room(&db) == (size_t)-1);
+	databuf_free(&db);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Pass "bench" to time the ring. A burst is a 16M backlog handed over at
+ * once and drained under a 1M limit the way auparse_feed does it, steady
+ * state reads each 4k block as it arrives.
+ */
+static void bench(void)
+{
+	const size_t total = 256 * 1024 * 1024, block = 4096;
+	const size_t burst = 16 * 1024 * 1024;
+	unsigned long lines = 0;
+	size_t peak = 0;
+	char *data = malloc(burst);
+	double start, secs;
+	size_t done, i;
+	DataBuf db;
+
+	assert(data != NULL);
+	// 128 byte lines, about the size of a short audit record
+	for (i = 0; i < burst; i++)
+		data[i] = (i % 128) == 127 ? '\n' : 'a' + i % 26;
+
+	assert(databuf_init(&db, 0, 0) == 1);
+	databuf_set_limit(&db, 1024 * 1024);
+	start = now();
+	for (done = 0; done < total; done += burst) {
+		for (i = 0; i < burst; ) {
+			size_t n = MIN(databuf_room(&db), burst - i);
+
+			assert(databuf_append(&db, data + i, n) == 1);
+			peak = MAX(peak, db.alloc_size);
+			while (databuf_line(&db, NULL))
+				lines++;
+			i += n;
+		}
+	}
+	secs = now() - start;
+	printf("burst  %8.0f MB/s %12.0f lines/s peak %zu kB\n",
+	       total / secs / 1e6, lines / secs, peak / 1024);
+	databuf_free(&db);
+
+	lines = 0;
+	peak = 0;
+	assert(databuf_init(&db, 0, 0) == 1);
+	start = now();
+	for (done = 0; done < total; done += block) {
+		// A block that is not a multiple of the line size splits some
+		assert(databuf_append(&db, data + done % (burst - block),
+				      block) == 1);
+		peak = MAX(peak, db.alloc_size);
+		while (databuf_line(&db, NULL))
+			lines++;
+	}
+	secs = now() - start;
+	printf("steady %8.0f MB/s %12.0f lines/s peak %zu kB\n",
+	       total / secs / 1e6, lines / secs, peak / 1024);
+	databuf_free(&db);
+	free(data);
+}
+
+int main(int argc, char *argv[])
 {
 	test_basic();
 	test_preserve();
+	test_line();
+	test_span();
+	test_limit();
 	printf("databuf tests: all passed\n");
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		bench();
 	return 0;
 }
 
@@ -0,0 +1,262 @@
+/* gen_audit_log.c -- write a synthetic audit log for benchmarks
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * The log is a function of the options alone, so two runs with the same
+ * options give the same bytes. About 70% of events are syscalls made of
+ * SYSCALL, an EXECVE for execs, CWD, one or two PATHs, PROCTITLE and EOE.
+ * The rest are the single record USER_* and CRED_* events of a login.
+ *
+ *   -e N  events to write (default 100000)
+ *   -s N  seed (default 1)
+ *   -n N  prefix records with one of N node= names (default none)
+ *   -E    enriched format, interpretations after a 0x1D separator
+ *   -i N  keep N events in flight and interleave their records
+ */
+
+#define EVENT_MAX 4096
+
+static unsigned int seed = 1;
+
+static unsigned int rnd(unsigned int n)
+{
+	seed = seed * 1103515245 + 12345;
+	return ((seed >> 8) & 0xFFFFFF) % n;
+}
+
+static const char *users[] = { "root", "alice", "bob", "carol", "dave" };
+static const char *programs[][3] = {
+	{ "/usr/bin/cat", "cat", "/etc/passwd" },
+	{ "/usr/bin/ls", "ls", "/var/log" },
+	{ "/usr/bin/vi", "vi", "/etc/ssh/sshd_config" },
+	{ "/usr/sbin/sshd", "sshd", "/etc/shadow" },
+	{ "/usr/bin/python3", "python3", "/home/alice/job.py" },
+	{ "/usr/bin/sudo", "sudo", "/etc/sudoers" },
+};
+static const char *user_types[][2] = {
+	{ "USER_AUTH", "PAM:authentication" },
+	{ "USER_ACCT", "PAM:accounting" },
+	{ "CRED_ACQ", "PAM:setcred" },
+	{ "USER_START", "PAM:session_open" },
+	{ "USER_LOGIN", "login" },
+	{ "USER_END", "PAM:session_close" },
+	{ "CRED_DISP", "PAM:setcred" },
+};
+
+struct gen {
+	unsigned int nodes;
+	int enriched;
+	unsigned long serial;
+};
+
+/* Append one record of the event in buf, returning the new length */
+static size_t record(char *buf, size_t len, const struct gen *g,
+		     unsigned int node, const char *type, const char *stamp,
+		     const char *body, const char *interp)
+{
+	if (g->nodes)
+		len += snprintf(buf + len, EVENT_MAX - len, "node=host%02u ",
+				node);
+	len += snprintf(buf + len, EVENT_MAX - len,
+			"type=%s msg=audit(%s): %s", type, stamp, body);
+	if (g->enriched && interp)
+		len += snprintf(buf + len, EVENT_MAX - len, "%c%s", 0x1D,
+				interp);
+	if (len < EVENT_MAX - 1)
+		buf[len++] = '\n';
+	return len;
+}
+
+static void hex(char *dst, const char *src)
+{
+	static const char digits[] = "0123456789ABCDEF";
+
+	while (*src) {
+		*dst++ = digits[(*src >> 4) & 0x0F];
+		*dst++ = digits[*src++ & 0x0F];
+	}
+	*dst = 0;
+}
+
+/* Write event i into buf and return its length */
+static size_t make_event(char *buf, struct gen *g, unsigned long i)
+{
+	char stamp[64], body[1024], interp[256];
+	unsigned int node = g->nodes ? rnd(g->nodes) : 0;
+	unsigned int u = rnd(sizeof(users)/sizeof(users[0]));
+	unsigned int auid = u ? 1000 + u : 0;
+	size_t len = 0;
+
+	// A thousand events a second, so the in flight ones never time out
+	snprintf(stamp, sizeof(stamp), "%lu.%03lu:%lu", 1700000000 + i / 1000,
+		 i % 1000, ++g->serial);
+
+	if (rnd(10) < 7) {
+		const char **p = programs[rnd(sizeof(programs) /
+					      sizeof(programs[0]))];
+		int exec = rnd(5) == 0, paths = 1 + rnd(2), n;
+
+		snprintf(body, sizeof(body), "arch=c000003e syscall=%d "
+			 "success=%s exit=%d a0=ffffff9c a1=7ffd1c2e a2=0 a3=0 "
+			 "items=%d ppid=1 pid=%lu auid=%u uid=0 gid=0 euid=0 "
+			 "suid=0 fsuid=0 egid=0 sgid=0 fsgid=0 tty=(none) "
+			 "ses=%u comm=\"%s\" exe=\"%s\" "
+			 "subj=unconfined_u:unconfined_r:unconfined_t:s0 "
+			 "key=\"%s\"", exec ? 59 : 257, rnd(8) ? "yes" : "no",
+			 exec ? 0 : 3, paths, 1000 + i % 30000, auid, u + 1,
+			 p[1], p[0], exec ? "exec" : "access");
+		snprintf(interp, sizeof(interp), "ARCH=x86_64 SYSCALL=%s "
+			 "AUID=\"%s\" UID=\"root\" GID=\"root\" EUID=\"root\" "
+			 "SUID=\"root\" FSUID=\"root\" EGID=\"root\" "
+			 "SGID=\"root\" FSGID=\"root\"",
+			 exec ? "execve" : "openat", auid ? users[u] :
+			 "unset");
+		len = record(buf, len, g, node, "SYSCALL", stamp, body,
+			     interp);
+		if (exec) {
+			snprintf(body, sizeof(body),
+				 "argc=2 a0=\"%s\" a1=\"%s\"", p[1], p[2]);
+			len = record(buf, len, g, node, "EXECVE", stamp, body,
+				     NULL);
+		}
+		len = record(buf, len, g, node, "CWD", stamp,
+			     u ? "cwd=\"/home/user\"" : "cwd=\"/root\"", NULL);
+		for (n = 0; n < paths; n++) {
+			snprintf(body, sizeof(body), "item=%d name=\"%s\" "
+				 "inode=%lu dev=fd:00 mode=0100644 ouid=0 "
+				 "ogid=0 rdev=00:00 nametype=NORMAL cap_fp=0 "
+				 "cap_fi=0 cap_fe=0 cap_fver=0", n,
+				 n ? "/lib64/ld-linux-x86-64.so.2" : p[2],
+				 10000 + i % 5000);
+			len = record(buf, len, g, node, "PATH", stamp, body,
+				     "OUID=\"root\" OGID=\"root\"");
+		}
+		// Titles with more than one argument are hex encoded
+		if (rnd(3)) {
+			char t1[64], t2[64];
+
+			hex(t1, p[1]);
+			hex(t2, p[2]);
+			snprintf(body, sizeof(body), "proctitle=%s00%s", t1,
+				 t2);
+		} else
+			snprintf(body, sizeof(body), "proctitle=\"%s\"", p[1]);
+		len = record(buf, len, g, node, "PROCTITLE", stamp, body,
+			     NULL);
+		len = record(buf, len, g, node, "EOE", stamp, "", NULL);
+	} else {
+		const char **t = user_types[rnd(sizeof(user_types) /
+						sizeof(user_types[0]))];
+		unsigned int host = i % 250;
+
+		snprintf(body, sizeof(body), "pid=%lu uid=0 auid=%u ses=%u "
+			 "subj=system_u:system_r:sshd_t:s0-s0:c0.c1023 "
+			 "msg='op=%s grantors=pam_unix acct=\"%s\" "
+			 "exe=\"/usr/sbin/sshd\" hostname=10.0.%u.%u "
+			 "addr=10.0.%u.%u terminal=ssh res=%s'",
+			 1000 + i % 30000, auid, u + 1, t[1], users[u], u, host,
+			 u, host, rnd(10) ? "success" : "failed");
+		snprintf(interp, sizeof(interp), "UID=\"root\" AUID=\"%s\"",
+			 auid ? users[u] : "unset");
+		len = record(buf, len, g, node, t[0], stamp, body, interp);
+	}
+	return len;
+}
+
+int main(int argc, char *argv[])
+{
+	struct gen g = { 0, 0, 0 };
+	unsigned long events = 100000, made = 0;
+	unsigned int inflight = 1, live = 0, i;
+	char *slots;
+	size_t *pos, *len;
+	int c;
+
+	while ((c = getopt(argc, argv, "e:s:n:Ei:")) != -1) {
+		switch (c) {
+		case 'e':
+			events = strtoul(optarg, NULL, 10);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 10);
+			break;
+		case 'n':
+			g.nodes = strtoul(optarg, NULL, 10);
+			break;
+		case 'E':
+			g.enriched = 1;
+			break;
+		case 'i':
+			inflight = strtoul(optarg, NULL, 10);
+			if (inflight == 0)
+				inflight = 1;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-e events] [-s seed] "
+				"[-n nodes] [-E] [-i inflight]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	slots = malloc((size_t)inflight * EVENT_MAX);
+	pos = calloc(inflight, sizeof(size_t));
+	len = calloc(inflight, sizeof(size_t));
+	if (slots == NULL || pos == NULL || len == NULL)
+		return 1;
+
+	// Each slot holds one event, a random slot gives up its next record
+	for (i = 0; i < inflight && made < events; i++, live++)
+		len[i] = make_event(slots + i * EVENT_MAX, &g, made++);
+	while (live) {
+		char *ev, *nl;
+
+		i = rnd(live);
+		ev = slots + (size_t)i * EVENT_MAX;
+		nl = memchr(ev + pos[i], '\n', len[i] - pos[i]);
+		fwrite(ev + pos[i], 1, nl + 1 - (ev + pos[i]), stdout);
+		pos[i] = nl + 1 - ev;
+		if (pos[i] < len[i])
+			continue;
+		if (made < events) {
+			len[i] = make_event(ev, &g, made++);
+			pos[i] = 0;
+		} else {
+			// Keep the live slots packed at the front
+			if (i != --live) {
+				memcpy(ev, slots + (size_t)live * EVENT_MAX,
+				       len[live]);
+				pos[i] = pos[live];
+				len[i] = len[live];
+			}
+		}
+	}
+	free(slots);
+	free(pos);
+	free(len);
+	return fflush(stdout) != 0;
+}
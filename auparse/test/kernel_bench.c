@@ -0,0 +1,188 @@
+/* kernel_bench.c -- measure the hex and escape kernels
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "common.h"
+
+/*
+ * Each kernel runs over a value the size of a long proctitle and one the
+ * size of a typical path, next to the byte at a time code it replaced.
+ * Results are in MB/s of input.
+ */
+
+static unsigned long sink;
+
+static unsigned char old_x2c(const unsigned char *buf)
+{
+	static const char AsciiArray[17] = "0123456789ABCDEF";
+	char *ptr;
+	unsigned char total=0;
+
+	ptr = strchr(AsciiArray, (char)toupper(buf[0]));
+	if (ptr)
+		total = (unsigned char)(((ptr-AsciiArray) & 0x0F)<<4);
+	ptr = strchr(AsciiArray, (char)toupper(buf[1]));
+	if (ptr)
+		total += (unsigned char)((ptr-AsciiArray) & 0x0F);
+	return total;
+}
+
+static size_t old_decode(char *dst, const char *src, size_t n)
+{
+	size_t i, j = 0;
+
+	for (i = 0; i < n; i += 2)
+		dst[j++] = old_x2c((const unsigned char *)&src[i]);
+	return j;
+}
+
+static size_t new_decode(char *dst, const char *src, size_t n)
+{
+	return audit_hex_decode(dst, src, n);
+}
+
+static size_t old_encode(char *dst, const char *src, size_t n)
+{
+	const char *hex = "0123456789ABCDEF";
+	char *ptr = dst;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		*ptr++ = hex[(src[i] & 0xF0)>>4];
+		*ptr++ = hex[src[i] & 0x0F];
+	}
+	return ptr - dst;
+}
+
+static size_t new_encode(char *dst, const char *src, size_t n)
+{
+	audit_hex_encode(dst, src, n);
+	return 2 * n;
+}
+
+static const char sh_set[] = "\"'`$\\!()| ";
+static size_t old_shell(char *dst, const char *s, size_t n)
+{
+	size_t i, cnt = 0;
+
+	(void)dst;
+	for (i = 0; i < n; i++) {
+		if (s[i] < 32)
+			cnt++;
+		else if (strchr(sh_set, s[i]))
+			cnt++;
+	}
+	return cnt;
+}
+
+static size_t new_shell(char *dst, const char *s, size_t n)
+{
+	(void)dst;
+	return audit_escape_count(s, n, AUDIT_ESC_SHELL);
+}
+
+static size_t old_tty(char *dst, const char *s, size_t n)
+{
+	size_t i, cnt = 0;
+
+	(void)dst;
+	for (i = 0; i < n; i++)
+		if ((unsigned char)s[i] < 32)
+			cnt++;
+	return cnt;
+}
+
+static size_t new_tty(char *dst, const char *s, size_t n)
+{
+	(void)dst;
+	return audit_escape_count(s, n, AUDIT_ESC_CTRL);
+}
+
+struct kernel {
+	const char *name;
+	size_t (*old)(char *dst, const char *src, size_t n);
+	size_t (*new)(char *dst, const char *src, size_t n);
+	int hex_input;
+};
+
+static double mbps(size_t (*fn)(char *, const char *, size_t), char *dst,
+		   const char *src, size_t n, unsigned long total)
+{
+	struct timespec start, end;
+	unsigned long i, reps = total / n;
+	double secs;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < reps; i++)
+		sink += fn(dst, src, n);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	return reps * n / secs / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct kernel kernels[] = {
+		{ "decode", old_decode, new_decode, 1 },
+		{ "encode", old_encode, new_encode, 0 },
+		{ "shell",  old_shell,  new_shell,  0 },
+		{ "tty",    old_tty,    new_tty,    0 },
+	};
+	static const size_t sizes[] = { 4096, 48 };
+	unsigned long total = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+	char *hex, *text, *dst;
+	unsigned int i, k;
+
+	total *= 1000000;
+	hex = malloc(sizes[0] + 1);
+	text = malloc(sizes[0] + 1);
+	dst = malloc(sizes[0] * 2 + 1);
+	if (hex == NULL || text == NULL || dst == NULL)
+		return 1;
+	for (i = 0; i < sizes[0]; i++) {
+		hex[i] = "0123456789ABCDEF"[(i * 7) & 15];
+		text[i] = "/usr/bin/python3 -m http.server"[i % 31];
+	}
+
+	for (k = 0; k < sizeof(kernels)/sizeof(kernels[0]); k++) {
+		for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+			const char *src = kernels[k].hex_input ? hex : text;
+			double o = mbps(kernels[k].old, dst, src, sizes[i],
+					total);
+			double n = mbps(kernels[k].new, dst, src, sizes[i],
+					total);
+
+			printf("%-7s %5zu bytes %9.0f MB/s old %9.0f MB/s "
+			       "new %5.1fx\n", kernels[k].name, sizes[i], o, n,
+			       n / o);
+		}
+	}
+	free(hex);
+	free(text);
+	free(dst);
+	return sink == 0;
+}
@@ -0,0 +1,323 @@
+/* parse_bench.c -- measure auparse for common consumer patterns
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "libaudit.h"
+#include "auparse.h"
+
+/*
+ * Every tenth event is a login, the rest are file syscalls. The modes
+ * mirror what the in tree consumers do with each event:
+ *   type   - count record types like audisp-statsd
+ *   field  - look up one field per event
+ *   search - aulastlog's type and res search, then read auid
+ *   expr   - a compound ausearch expression like audisp-filter rules
+ *   rulesN - N audisp-filter style rules ORed together, checked per event
+ *   all    - walk every field of every record
+ *   interp - interpret every field, nocache does it without the cache
+ *   norm   - normalize the event and read subject and object
+ *   normall - normalize with attributes and walk them too
+ *   columns - copy four fields per event out one call at a time
+ *   batch  - copy the same four fields with auparse_get_batch
+ * The inflight mode counts types on a log where INFLIGHT events have their
+ * records interleaved, like a busy aggregator sees.
+ */
+
+#define INFLIGHT 256
+#define BATCH_ROWS 256
+
+static const char *columns[] = { "auid", "uid", "name", "exe", NULL };
+
+static char *make_log(unsigned int events)
+{
+	size_t size = (size_t)events * 1024, used = 0;
+	char *buf = malloc(size);
+	unsigned int i;
+
+	if (buf == NULL)
+		return NULL;
+	for (i = 1; i <= events; i++) {
+		unsigned int sec = 1700000000 + i / 1000, milli = i % 1000;
+
+		if (i % 10 == 0) {
+			used += snprintf(buf + used, size - used,
+			"type=USER_LOGIN msg=audit(%u.%03u:%u): pid=%u uid=0 "
+			"auid=%u ses=%u subj=unconfined msg='op=login id=%u "
+			"exe=\"/usr/sbin/sshd\" hostname=10.0.0.%u "
+			"addr=10.0.0.%u terminal=ssh res=success'\n",
+			sec, milli, i, i, 1000 + i % 50, i, 1000 + i % 50,
+			i % 250, i % 250);
+			continue;
+		}
+		used += snprintf(buf + used, size - used,
+		"type=SYSCALL msg=audit(%u.%03u:%u): arch=c000003e syscall=257 "
+		"success=yes exit=3 a0=ffffff9c a1=7ffd1c2e a2=0 a3=0 items=1 "
+		"ppid=1 pid=%u auid=%u uid=0 gid=0 euid=0 suid=0 fsuid=0 "
+		"egid=0 sgid=0 fsgid=0 tty=(none) ses=%u comm=\"cat\" "
+		"exe=\"/usr/bin/cat\" subj=unconfined key=\"access\"\n"
+		"type=CWD msg=audit(%u.%03u:%u): cwd=\"/root\"\n"
+		"type=PATH msg=audit(%u.%03u:%u): item=0 name=\"/etc/passwd\" "
+		"inode=1234 dev=fd:00 mode=0100644 ouid=0 ogid=0 rdev=00:00 "
+		"nametype=NORMAL cap_fp=0 cap_fi=0 cap_fe=0 cap_fver=0\n"
+		"type=PROCTITLE msg=audit(%u.%03u:%u): "
+		"proctitle=636174002F6574632F706173737764\n",
+		sec, milli, i, i, 1000 + i % 50, i,
+		sec, milli, i, sec, milli, i, sec, milli, i);
+	}
+	return buf;
+}
+
+static char *make_inflight_log(unsigned int events)
+{
+	size_t size = (size_t)events * 512, used = 0;
+	char *buf = malloc(size);
+	unsigned int base, i;
+
+	if (buf == NULL)
+		return NULL;
+	for (base = 1; base + INFLIGHT <= events + 1; base += INFLIGHT) {
+		for (i = base; i < base + INFLIGHT; i++)
+			used += snprintf(buf + used, size - used,
+			"type=SYSCALL msg=audit(%u.%03u:%u): arch=c000003e "
+			"syscall=257 success=yes exit=3 pid=%u auid=%u uid=0 "
+			"comm=\"cat\" exe=\"/usr/bin/cat\" key=\"access\"\n",
+			1700000000 + i / 1000, i % 1000, i, i, 1000 + i % 50);
+		for (i = base + INFLIGHT - 1; i >= base; i--)
+			used += snprintf(buf + used, size - used,
+			"type=CWD msg=audit(%u.%03u:%u): cwd=\"/root\"\n",
+			1700000000 + i / 1000, i % 1000, i);
+		for (i = base; i < base + INFLIGHT; i++)
+			used += snprintf(buf + used, size - used,
+			"type=EOE msg=audit(%u.%03u:%u): \n",
+			1700000000 + i / 1000, i % 1000, i);
+	}
+	return buf;
+}
+
+static unsigned long sink;
+
+/* Rules on exe, auid and record type like a filter.conf would have */
+static int add_rules(auparse_state_t *au, unsigned int rules)
+{
+	unsigned int i;
+
+	for (i = 0; i < rules; i++) {
+		char expr[128], *err = NULL;
+
+		if (i % 3 == 0)
+			snprintf(expr, sizeof(expr),
+				 "exe i= \"/usr/bin/prog%u\" && uid == 0", i);
+		else if (i % 3 == 1)
+			snprintf(expr, sizeof(expr), "auid == %u && "
+				 "type r= USER_LOGIN", 1000 + i);
+		else
+			snprintf(expr, sizeof(expr), "\\record_type == %u && "
+				 "hostname r= \"10.1.%u.1\"", 1100 + i % 100, i);
+		if (ausearch_add_expression(au, expr, &err,
+					    AUSEARCH_RULE_OR)) {
+			free(err);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static unsigned long count_attrs(auparse_state_t *au)
+{
+	unsigned long n = 0;
+
+	if (auparse_normalize_subject_first_attribute(au) == 1)
+		do {
+			n++;
+		} while (auparse_normalize_subject_next_attribute(au) == 1);
+	if (auparse_normalize_object_first_attribute(au) == 1)
+		do {
+			n++;
+		} while (auparse_normalize_object_next_attribute(au) == 1);
+	return n;
+}
+
+static unsigned long run_batch(auparse_state_t *au)
+{
+	static size_t value[4 * BATCH_ROWS];
+	static char heap[BATCH_ROWS * 256];
+	auparse_batch_t b = {
+		.fields = columns, .size = BATCH_ROWS, .value = value,
+		.heap = heap, .heap_size = sizeof(heap)
+	};
+	unsigned long events = 0, sum = 0;
+	int rc;
+
+	while ((rc = auparse_get_batch(au, &b)) > 0) {
+		unsigned int i;
+
+		for (i = 0; i < 4 * BATCH_ROWS; i++)
+			if ((i % BATCH_ROWS) < b.rows &&
+			    value[i] != AUPARSE_BATCH_NONE)
+				sum += strlen(heap + value[i]);
+		events += rc;
+	}
+	sink += sum;
+	return events;
+}
+
+static unsigned long run(const char *mode, const char *log)
+{
+	auparse_state_t *au = auparse_init(AUSOURCE_BUFFER, log);
+	unsigned long events = 0, sum = 0;
+
+	if (au == NULL)
+		return 0;
+	if (strncmp(mode, "rules", 5) == 0) {
+		if (add_rules(au, strtoul(mode + 5, NULL, 10)) == 0)
+			while (auparse_next_event(au) > 0)
+				if (ausearch_cur_event(au) == 0)
+					events++;
+		auparse_destroy(au);
+		return events;
+	}
+	if (strcmp(mode, "batch") == 0) {
+		events = run_batch(au);
+		auparse_destroy(au);
+		return events;
+	}
+	if (strcmp(mode, "search") == 0 || strcmp(mode, "expr") == 0) {
+		char *err = NULL;
+
+		if (mode[0] == 's') {
+			ausearch_add_item(au, "type", "=", "USER_LOGIN",
+					  AUSEARCH_RULE_CLEAR);
+			ausearch_add_item(au, "res", "=", "success",
+					  AUSEARCH_RULE_AND);
+		} else if (ausearch_add_expression(au,
+			"(type r= USER_LOGIN || type r= USER_AUTH) && "
+			"auid >= 1025 && res r= success", &err,
+			AUSEARCH_RULE_CLEAR)) {
+			free(err);
+			auparse_destroy(au);
+			return 0;
+		}
+		ausearch_set_stop(au, AUSEARCH_STOP_RECORD);
+		while (ausearch_next_event(au) > 0) {
+			if (auparse_find_field(au, "auid"))
+				sum += auparse_get_field_int(au);
+			events++;
+			if (auparse_next_event(au) < 0)
+				break;
+		}
+		auparse_destroy(au);
+		sink += sum;
+		return events;
+	}
+
+	while (auparse_next_event(au) > 0) {
+		events++;
+		if (strcmp(mode, "type") == 0 ||
+		    strcmp(mode, "inflight") == 0) {
+			do {
+				sum += auparse_get_type(au);
+			} while (auparse_next_record(au) > 0);
+		} else if (strncmp(mode, "norm", 4) == 0) {
+			int attrs = strcmp(mode, "normall") == 0;
+
+			if (auparse_normalize(au, attrs ? NORM_OPT_ALL :
+						NORM_OPT_NO_ATTRS) == 0) {
+				if (auparse_normalize_subject_primary(au) == 1)
+					sum += strlen(auparse_get_field_str(au));
+				if (auparse_normalize_object_primary(au) == 1)
+					sum += strlen(auparse_get_field_str(au));
+				if (attrs)
+					sum += count_attrs(au);
+			}
+		} else if (strcmp(mode, "interp") == 0 ||
+			   strcmp(mode, "nocache") == 0) {
+			if (events == 1 && mode[0] == 'n')
+				auparse_set_interp_cache(au, 0);
+			do {
+				do {
+					const char *v =
+						auparse_interpret_field(au);
+					sum += v ? strlen(v) : 0;
+				} while (auparse_next_field(au) > 0);
+			} while (auparse_next_record(au) > 0);
+		} else if (strcmp(mode, "columns") == 0) {
+			unsigned int i;
+
+			for (i = 0; columns[i]; i++) {
+				const char *v;
+
+				auparse_first_record(au);
+				v = auparse_find_field(au, columns[i]);
+				sum += v ? strlen(v) : 0;
+			}
+		} else if (strcmp(mode, "field") == 0) {
+			if (auparse_find_field(au, "auid"))
+				sum += auparse_get_field_int(au);
+		} else {
+			do {
+				do {
+					sum += strlen(auparse_get_field_str(au));
+				} while (auparse_next_field(au) > 0);
+			} while (auparse_next_record(au) > 0);
+		}
+	}
+	auparse_destroy(au);
+	sink += sum;
+	return events;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *modes[] = { "type", "field", "search", "expr",
+					"all", "interp", "nocache", "norm",
+					"normall", "columns", "batch",
+					"inflight", "rules10",
+					"rules100", "rules1000" };
+	unsigned int events = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+	unsigned int i;
+	char *log = make_log(events);
+	char *inflight = make_inflight_log(events);
+
+	if (log == NULL || inflight == NULL)
+		return 1;
+	for (i = 0; i < sizeof(modes)/sizeof(modes[0]); i++) {
+		struct timespec start, end;
+		unsigned long n;
+		double secs;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		n = run(modes[i], strcmp(modes[i], "inflight") ? log :
+								inflight);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		secs = (end.tv_sec - start.tv_sec) +
+			(end.tv_nsec - start.tv_nsec) / 1e9;
+		printf("%-8s %8lu events %10.0f events/s\n", modes[i], n,
+		       n / secs);
+	}
+	free(log);
+	free(inflight);
+	return 0;
+}
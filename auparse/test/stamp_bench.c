@@ -0,0 +1,158 @@
+/* stamp_bench.c -- measure how fast record time stamps are found
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "common.h"
+
+/*
+ * Runs audit_parse_stamp over local and remote records next to the
+ * strndupa, audit_strsplit_r, and strtoul code it replaced. Both sides
+ * copy the node name like their callers do. Results are in lines/s.
+ */
+
+static unsigned long sink;
+
+static int old_stamp(const char *b, size_t len, long max_sec)
+{
+	char *ptr, *tmp, *saved = NULL, *s, *host = NULL;
+	time_t sec;
+	unsigned int milli = 0;
+	unsigned long serial = 0;
+
+	tmp = strndupa(b, len && *b == 'n' ? (len < 340 ? len : 340) :
+			(len < 80 ? len : 80));
+	ptr = audit_strsplit_r(tmp, &saved);
+	if (ptr == NULL)
+		return 1;
+	if (*ptr == 'n' && strnlen(ptr, 8) > 5) {
+		host = strdup(ptr+5);
+		(void)audit_strsplit_r(NULL, &saved);
+	}
+	ptr = audit_strsplit_r(NULL, &saved);
+	if (ptr == NULL || strnlen(ptr, 20) <= 18 ||
+			(ptr = strchr(ptr, '(')) == NULL) {
+		free(host);
+		return 1;
+	}
+	s = ++ptr;
+	ptr = strchr(s, ')');
+	if (ptr)
+		*ptr = 0;
+	errno = 0;
+	sec = strtoul(s, NULL, 10);
+	ptr = strchr(s, '.');
+	if (ptr) {
+		milli = strtoul(++ptr, NULL, 10);
+		s = ptr;
+	}
+	ptr = strchr(s, ':');
+	if (ptr)
+		serial = strtoul(ptr+1, NULL, 10);
+	sink += sec + milli + serial + (host != NULL);
+	free(host);
+	return errno || sec > max_sec;
+}
+
+static int new_stamp(const char *b, size_t len, long max_sec)
+{
+	audit_stamp_t st;
+	char *host = NULL;
+	int rc = audit_parse_stamp(b, len, max_sec, &st);
+
+	if (rc == 0) {
+		if (st.node)
+			host = strndup(st.node, st.node_len);
+		sink += st.sec + st.milli + st.serial + (host != NULL);
+		free(host);
+	}
+	return rc;
+}
+
+static double lps(int (*fn)(const char *, size_t, long), const char **lines,
+		  const size_t *lens, unsigned int n, unsigned long total)
+{
+	struct timespec start, end;
+	unsigned long i;
+	double secs;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < total; i++)
+		sink += fn(lines[i % n], lens[i % n], LONG_MAX - 3);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	return total / secs;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *local[] = {
+		"type=SYSCALL msg=audit(1700000000.123:4567): arch=c000003e "
+		"syscall=59 success=yes exit=0 a0=55d3 a1=55d4 a2=55d5 a3=0 "
+		"items=2 ppid=1 pid=1234 auid=1000 uid=0",
+		"type=EXECVE msg=audit(1700000000.123:4567): argc=2 a0=\"ls\" "
+		"a1=\"-l\"",
+		"type=CWD msg=audit(1700000000.123:4567): cwd=\"/root\"",
+		"type=PATH msg=audit(1700000000.123:4567): item=0 "
+		"name=\"/usr/bin/ls\" inode=1234 dev=fd:00 mode=0100755",
+		"type=PROCTITLE msg=audit(1700000000.123:4567): "
+		"proctitle=6C73002D6C",
+		"type=EOE msg=audit(1700000000.123:4567): ",
+	};
+	static const char *remote[] = {
+		"node=web01.example.com type=SYSCALL "
+		"msg=audit(1700000000.123:4567): arch=c000003e syscall=59",
+		"node=web01.example.com type=CWD "
+		"msg=audit(1700000000.123:4567): cwd=\"/root\"",
+		"node=web01.example.com type=EOE "
+		"msg=audit(1700000000.123:4567): ",
+	};
+	static const struct {
+		const char *name;
+		const char **lines;
+		unsigned int n;
+	} sets[] = {
+		{ "local",  local,  sizeof(local)/sizeof(local[0]) },
+		{ "remote", remote, sizeof(remote)/sizeof(remote[0]) },
+	};
+	unsigned long total = argc > 1 ? strtoul(argv[1], NULL, 10) : 5;
+	size_t lens[8];
+	unsigned int s, i;
+
+	total *= 1000000;
+	for (s = 0; s < sizeof(sets)/sizeof(sets[0]); s++) {
+		double o, n;
+
+		for (i = 0; i < sets[s].n; i++)
+			lens[i] = strlen(sets[s].lines[i]);
+		o = lps(old_stamp, sets[s].lines, lens, sets[s].n, total);
+		n = lps(new_stamp, sets[s].lines, lens, sets[s].n, total);
+		printf("%-7s %12.0f lines/s old %12.0f lines/s new %5.1fx\n",
+		       sets[s].name, o, n, n / o);
+	}
+	return sink == 0;
+}
@@ -0,0 +1,195 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "libaudit.h"
+#include "auparse.h"
+
+/*
+ * Run several parsers at once and check each produces what a lone parser
+ * does. Configure with CFLAGS=-fsanitize=thread to have ThreadSanitizer
+ * watch the library while this runs.
+ */
+
+#define THREADS 4
+#define ROUNDS 25
+
+static const char *logs[] = { "./test.log", "./test2.log", "./test3.log",
+			      "./test4.log" };
+
+/* fan_info is only decoded after fan_type=1, and mount objects depend on
+ * whether the syscall worked, so both leak between parsers if shared */
+static const char feed_log[] =
+"type=FANOTIFY msg=audit(1700000000.001:10): resp=2 fan_type=1 "
+	"fan_info=0000002A subj_trust=2 obj_trust=2\n"
+"type=SYSCALL msg=audit(1700000000.001:10): arch=c000003e syscall=257 "
+	"success=no exit=-1 a0=ffffff9c a1=7ffd1c2e a2=0 a3=0 items=1 ppid=1 "
+	"pid=77 auid=1000 uid=1000 gid=1000 euid=1000 suid=1000 fsuid=1000 "
+	"egid=1000 sgid=1000 fsgid=1000 tty=pts0 ses=3 comm=\"cat\" "
+	"exe=\"/usr/bin/cat\" key=(null)\n"
+"type=EOE msg=audit(1700000000.001:10): \n"
+"type=FANOTIFY msg=audit(1700000000.002:11): resp=1 fan_type=0 "
+	"fan_info=2A subj_trust=2 obj_trust=2\n"
+"type=EOE msg=audit(1700000000.002:11): \n"
+"type=SYSCALL msg=audit(1700000000.003:12): arch=c000003e syscall=165 "
+	"success=yes exit=0 a0=55d1 a1=55d2 a2=55d3 a3=0 items=2 ppid=1 "
+	"pid=78 auid=0 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0 sgid=0 "
+	"fsgid=0 tty=(none) ses=1 comm=\"mount\" exe=\"/usr/bin/mount\" "
+	"key=\"mounts\"\n"
+"type=PATH msg=audit(1700000000.003:12): item=0 name=\"/dev/sdb1\" "
+	"inode=500 dev=00:06 mode=060660 ouid=0 ogid=6 rdev=08:11 "
+	"nametype=UNKNOWN\n"
+"type=PATH msg=audit(1700000000.003:12): item=1 name=\"/mnt\" "
+	"inode=2 dev=fd:00 mode=040755 ouid=0 ogid=0 rdev=00:00 "
+	"nametype=UNKNOWN\n"
+"type=EOE msg=audit(1700000000.003:12): \n"
+"type=SYSCALL msg=audit(1700000000.004:13): arch=c000003e syscall=165 "
+	"success=no exit=-2 a0=55d1 a1=55d2 a2=55d3 a3=0 items=1 ppid=1 "
+	"pid=79 auid=0 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0 sgid=0 "
+	"fsgid=0 tty=(none) ses=1 comm=\"mount\" exe=\"/usr/bin/mount\" "
+	"key=\"mounts\"\n"
+"type=PATH msg=audit(1700000000.004:13): item=0 name=\"/mnt\" "
+	"inode=2 dev=fd:00 mode=040755 ouid=0 ogid=0 rdev=00:00 "
+	"nametype=UNKNOWN\n"
+"type=EOE msg=audit(1700000000.004:13): \n";
+
+struct out {
+	char *buf;
+	size_t len, size;
+};
+
+static void put(struct out *o, const char *s)
+{
+	size_t n = strlen(s ? s : "(null)");
+
+	if (o->len + n + 2 > o->size) {
+		o->size = (o->len + n + 2) * 2;
+		o->buf = realloc(o->buf, o->size);
+		if (o->buf == NULL)
+			abort();
+	}
+	memcpy(o->buf + o->len, s ? s : "(null)", n);
+	o->len += n;
+	o->buf[o->len++] = ' ';
+	o->buf[o->len] = 0;
+}
+
+/* Everything a consumer could ask of the current event */
+static void render_event(auparse_state_t *au, struct out *o)
+{
+	char num[32];
+
+	snprintf(num, sizeof(num), "%lu", auparse_get_serial(au));
+	put(o, num);
+	if (auparse_normalize(au, NORM_OPT_ALL) == 0) {
+		put(o, auparse_normalize_get_event_kind(au));
+		if (auparse_normalize_subject_primary(au) == 1)
+			put(o, auparse_interpret_field(au));
+		if (auparse_normalize_object_primary(au) == 1)
+			put(o, auparse_interpret_field(au));
+		if (auparse_normalize_object_primary2(au) == 1)
+			put(o, auparse_interpret_field(au));
+		put(o, auparse_normalize_get_action(au));
+	}
+	auparse_first_record(au);
+	do {
+		auparse_first_field(au);
+		do {
+			put(o, auparse_get_field_name(au));
+			put(o, auparse_interpret_field(au));
+		} while (auparse_next_field(au) > 0);
+	} while (auparse_next_record(au) > 0);
+	o->buf[o->len - 1] = '\n';
+}
+
+static void feed_cb(auparse_state_t *au, auparse_cb_event_t type, void *data)
+{
+	if (type == AUPARSE_CB_EVENT_READY)
+		render_event(au, data);
+}
+
+/* Parse every log, then feed the extra events in CHUNK sized pieces */
+static char *render(size_t chunk)
+{
+	struct out o = { NULL, 0, 0 };
+	auparse_state_t *au;
+	unsigned int i;
+	size_t off;
+
+	put(&o, "");
+	for (i = 0; i < sizeof(logs)/sizeof(logs[0]); i++) {
+		au = auparse_init(AUSOURCE_FILE, logs[i]);
+		if (au == NULL)
+			return NULL;
+		while (auparse_next_event(au) > 0)
+			render_event(au, &o);
+		auparse_destroy(au);
+	}
+
+	au = auparse_init(AUSOURCE_FEED, NULL);
+	if (au == NULL)
+		return NULL;
+	auparse_add_callback(au, feed_cb, &o, NULL);
+	for (off = 0; off < sizeof(feed_log) - 1; off += chunk) {
+		size_t n = sizeof(feed_log) - 1 - off;
+
+		auparse_feed(au, feed_log + off, n < chunk ? n : chunk);
+	}
+	auparse_flush_feed(au);
+	auparse_destroy(au);
+	return o.buf;
+}
+
+static const char *expect;
+
+static void *worker(void *arg)
+{
+	unsigned long id = (unsigned long)arg;
+	unsigned int i;
+
+	for (i = 0; i < ROUNDS; i++) {
+		char *got = render(7 + id * 13 + i);
+
+		if (got == NULL || strcmp(got, expect)) {
+			free(got);
+			return (void *)1;
+		}
+		free(got);
+	}
+	return NULL;
+}
+
+int main(void)
+{
+	pthread_t threads[THREADS];
+	char *serial;
+	unsigned long i;
+	int rc = 0;
+
+	serial = render(sizeof(feed_log));
+	if (serial == NULL) {
+		fprintf(stderr, "cannot parse the test logs\n");
+		return 1;
+	}
+	if (strstr(serial, "fan_info 42 ") == NULL ||
+	    strstr(serial, "fan_info 2A ") == NULL) {
+		fprintf(stderr, "fan_info decoded wrongly\n");
+		return 1;
+	}
+	expect = serial;
+
+	for (i = 0; i < THREADS; i++)
+		pthread_create(&threads[i], NULL, worker, (void *)i);
+	for (i = 0; i < THREADS; i++) {
+		void *res;
+
+		pthread_join(threads[i], &res);
+		if (res) {
+			fprintf(stderr, "thread %lu parsed differently\n", i);
+			rc = 1;
+		}
+	}
+	free(serial);
+	return rc;
+}
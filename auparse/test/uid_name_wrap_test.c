@@ -1,11 +1,34 @@
 #include "config.h"
 #include "internal.h"
+#include "idcache.h"
 #include <assert.h>
+#include <pthread.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 /* Verify name->uid->name round trip through the cache */
 
+#define MISSING_UID 3999999999U
+
+static void *lookups(void *arg)
+{
+	char buf[64];
+	int i;
+
+	(void)arg;
+	for (i = 0; i < 2000; i++) {
+		unsigned int id;
+
+		assert(idcache_name(IDC_UID, 0, buf, sizeof(buf)) == 1);
+		assert(strcmp(buf, "root") == 0);
+		assert(idcache_name(IDC_UID, MISSING_UID + i % 50, buf,
+				    sizeof(buf)) == 0);
+		assert(idcache_id(IDC_GID, "root", &id) == 1 && id == 0);
+	}
+	return NULL;
+}
+
 /*
  * main - ensure cache lookups are symmetric
  *
@@ -14,14 +37,66 @@
 int main(void)
 {
 	auparse_state_t au;
+	unsigned int uids, gids;
+	unsigned long hits, misses, hits2, misses2;
+	pthread_t threads[4];
+	char buf[64];
+	int i;
+
 	memset(&au, 0, sizeof(au));
 
 	uid_t uid = lookup_uid_from_name(&au, "root");
 	assert(uid == 0);
 
-	QNode *n = check_lru_uid(au.uid_cache, uid);
-	assert(n && n->name && strcmp(n->name, "root") == 0);
+	/* The answer for the name also serves the uid */
+	assert(idcache_name(IDC_UID, uid, buf, sizeof(buf)) == 1);
+	assert(strcmp(buf, "root") == 0);
+	idcache_metrics(&uids, &gids, &hits, &misses);
+	assert(uids == 1 && hits == 1 && misses == 1);
+
+	/* Accounts that don't exist are remembered too */
+	assert(idcache_name(IDC_UID, MISSING_UID, buf, sizeof(buf)) == 0);
+	assert(idcache_name(IDC_UID, MISSING_UID, buf, sizeof(buf)) == 0);
+	idcache_metrics(&uids, &gids, &hits2, &misses2);
+	assert(hits2 == hits + 1 && misses2 == misses + 1);
+
+	/* A small cache keeps working once it has to replace entries */
+	assert(auparse_set_id_cache(8, 600, 0) == 0);
+	for (i = 0; i < 100; i++)
+		assert(idcache_name(IDC_UID, MISSING_UID - i, buf,
+				    sizeof(buf)) == 0);
+	idcache_metrics(&uids, &gids, &hits, &misses);
+	assert(uids <= 8);
+
+	/* A refreshed answer takes the place of the old one */
+	assert(auparse_set_id_cache(8, 1, 0) == 0);
+	idcache_metrics(&uids, &gids, &hits, &misses);
+	assert(idcache_name(IDC_UID, 0, buf, sizeof(buf)) == 1);
+	sleep(1);
+	assert(idcache_name(IDC_UID, 0, buf, sizeof(buf)) == 1);
+	assert(idcache_name(IDC_UID, MISSING_UID, buf, sizeof(buf)) == 0);
+	sleep(1);
+	assert(idcache_name(IDC_UID, MISSING_UID, buf, sizeof(buf)) == 0);
+	idcache_metrics(&uids, &gids, &hits2, &misses2);
+	assert(uids == 2 && misses2 == misses + 4);
+
+	/* Preloading finds root without a miss */
+	assert(auparse_set_id_cache(1024, 600, 1) == 0);
+	idcache_metrics(&uids, &gids, &hits, &misses);
+	assert(uids > 0);
+	assert(idcache_name(IDC_UID, 0, buf, sizeof(buf)) == 1);
+	idcache_metrics(&uids, &gids, &hits2, &misses2);
+	assert(misses2 == misses);
+
+	for (i = 0; i < 4; i++)
+		pthread_create(&threads[i], NULL, lookups, NULL);
+	for (i = 0; i < 4; i++)
+		pthread_join(threads[i], NULL);
 
-	destroy_lru(au.uid_cache);
+	/* Turned off, lookups still work */
+	assert(auparse_set_id_cache(0, 0, 0) == 0);
+	assert(lookup_uid_from_name(&au, "root") == 0);
+	idcache_metrics(&uids, &gids, &hits, &misses);
+	assert(uids == 0 && gids == 0);
 	return 0;
 }
@@ -1,5 +1,5 @@
 /* audit-fgets.c -- a replacement for glibc's fgets
- * Copyright 2018,2022,2025 Red Hat Inc.
+ * Copyright 2018,2022,2025-26 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <sys/mman.h>
 #include "libaudit.h"
+#include "common.h"
 #include "auplugin.h"
 
 /*
@@ -130,31 +131,32 @@ void auplugin_fgets_clear_r(struct auplugin_fgets_state *st)
 int auplugin_fgets_more_r(struct auplugin_fgets_state *st, size_t blen)
 {
 	size_t avail;
-	char *nl;
+	const char *nl;
 
 	assert(blen != 0);
 	avail = st->current - st->buffer;
 
 	/* only scan the valid region */
-	nl = memchr(st->buffer, '\n', avail);
+	nl = audit_memchr(st->buffer, '\n', avail);
 	return (nl || avail >= blen - 1);
 }
 
-/* Function to read the next chunk of data from the given fd. If we have
- * data to return, we Read up to blen-1 chars (or through the next newline),
- * copy into buf, NUL-terminate, and return the number of chars.
- * It also returns 0 for no data. And -1 if there was an error reading
- * the fd. */
-int auplugin_fgets_r(struct auplugin_fgets_state *st, char *buf, size_t blen, int fd)
+/*
+ * Locate the next line in the buffer, reading more from fd if needed.
+ * A line ends at a newline, at max chars, or at whatever is left when the
+ * buffer is full or at EOF. On success the line is consumed, *line points
+ * at it inside the buffer and its length is returned. It returns 0 for no
+ * data and -1 if there was an error reading the fd.
+ */
+static int next_line(struct auplugin_fgets_state *st, size_t max, int fd,
+		     char **line)
 {
 	size_t avail = st->current - st->buffer, line_len;
-	char  *line_end;
+	const char *line_end;
 	ssize_t nread;
 
-	assert(blen != 0);
-
 	/* 1) Is there already a '\n' in the buffered data? */
-	line_end = memchr(st->buffer, '\n', avail);
+	line_end = audit_memchr(st->buffer, '\n', avail);
 
 	/* 2) If not, and we still can read more, pull in more data */
 	if (line_end == NULL && !st->eof) {
@@ -164,7 +166,6 @@ int auplugin_fgets_r(struct auplugin_fgets_state *st, char *buf, size_t blen, in
 			memmove(st->orig, st->buffer, used);
 			st->buffer = st->orig;
 			st->current = st->buffer + used;
-			avail = used;
 			*st->current = '\0';
 		}
 
@@ -182,57 +183,90 @@ int auplugin_fgets_r(struct auplugin_fgets_state *st, char *buf, size_t blen, in
 				size_t got = (size_t)nread;
 				st->current[got] = '\0';
 				st->current += got;
-				avail += got;
 			}
 
-			/* see if a newline arrived in that chunk */
-			line_end = memchr(st->buffer, '\n', avail);
+			/* see if a newline arrived in that chunk. Only the
+			 * new bytes need to be searched. */
+			line_end = audit_memchr(st->buffer + avail, '\n',
+					(st->current - st->buffer) - avail);
+			avail = st->current - st->buffer;
 		}
 	}
 
 	/* 3) Do we now have enough to return? */
 	if (line_end == NULL) {
 		/* not a full line—only return early if we still expect more */
-		if (!st->eof && avail < blen - 1 && st->current != st->eptr)
+		if (!st->eof && avail < max && st->current != st->eptr)
 			return 0;
 
 		/* else we’ll return whatever we have (either at EOF,
-		 * buffer‑full, or enough for blen) */
+		 * buffer‑full, or enough for max) */
 	}
 
 	/* 4) Compute how many chars to hand back */
 	if (line_end) {
-		/* include the '\n', but never exceed blen-1 */
+		/* include the '\n', but never exceed max */
 		line_len = (line_end - st->buffer) + 1;
-		if (line_len > blen - 1)
-			line_len = blen - 1;
+		if (line_len > max)
+			line_len = max;
 
 	} else
-		/* no newline: return up to blen-1 or whatever’s left
+		/* no newline: return up to max or whatever’s left
 		 * at EOF/full */
-		line_len = (avail < blen - 1) ? avail : (blen - 1);
+		line_len = (avail < max) ? avail : max;
 
-	/* 5) Copy out, slide the remainder down, reset pointers */
-	memcpy(buf, st->buffer, line_len);
-	buf[line_len] = '\0';
+	/* 5) Advance past the line. For MEM_MMAP_FILE we advance over the
+	 * returned data permanently. For other modes we defer compaction
+	 * until there is no write room left for the next read. */
+	*line = st->buffer;
+	st->buffer += line_len;
+	if (st->mem_type == MEM_MMAP_FILE && st->buffer >= st->eptr)
+		st->eof = 1;
 
-	size_t remainder = avail - line_len;
-	/* For MEM_MMAP_FILE we advance over the returned data permanently.
-	 * For other modes we defer compaction until there is no write room
-	 * left for the next read. */
-	if (st->mem_type == MEM_MMAP_FILE) {
-		st->buffer += line_len;
-		if (st->buffer >= st->eptr)
-			st->eof = 1;
-	} else {
-		st->buffer += line_len;
-	}
+	return (int)line_len;
+}
+
+/* Function to read the next chunk of data from the given fd. If we have
+ * data to return, we Read up to blen-1 chars (or through the next newline),
+ * copy into buf, NUL-terminate, and return the number of chars.
+ * It also returns 0 for no data. And -1 if there was an error reading
+ * the fd. */
+int auplugin_fgets_r(struct auplugin_fgets_state *st, char *buf, size_t blen, int fd)
+{
+	char *line;
+	int len;
 
-	st->current = st->buffer + remainder;
-	if (st->mem_type != MEM_MMAP_FILE)
-		*st->current = '\0';
+	assert(blen != 0);
 
-	return (int)line_len;
+	len = next_line(st, blen - 1, fd, &line);
+	if (len <= 0)
+		return len;
+
+	memcpy(buf, line, len);
+	buf[len] = '\0';
+
+	return len;
+}
+
+/* Function like auplugin_fgets_r except that nothing is copied. On success
+ * *line points at the next line inside the internal buffer and *len holds
+ * its length including the '\n'. The line is not NUL terminated and is only
+ * valid until the next call. Lines longer than the buffer are returned in
+ * pieces. It returns 1 when a line is returned, 0 for no data, and -1 if
+ * there was an error reading the fd. */
+int auplugin_fgets_view_r(struct auplugin_fgets_state *st, const char **line,
+			  size_t *len, int fd)
+{
+	char *ptr;
+	int rc;
+
+	rc = next_line(st, st->buff_size, fd, &ptr);
+	if (rc <= 0)
+		return rc;
+
+	*line = ptr;
+	*len = (size_t)rc;
+	return 1;
 }
 
 static inline void auplugin_fgets_ensure_global(void)
@@ -267,6 +301,12 @@ int auplugin_fgets(char *buf, size_t blen, int fd)
 	return auplugin_fgets_r(&global_state, buf, blen, fd);
 }
 
+int auplugin_fgets_view(const char **line, size_t *len, int fd)
+{
+	auplugin_fgets_ensure_global();
+	return auplugin_fgets_view_r(&global_state, line, len, fd);
+}
+
 int auplugin_setvbuf_r(struct auplugin_fgets_state *st, void *buf,
 			size_t buff_size, enum auplugin_mem how)
 {
@@ -1,5 +1,5 @@
 /* auplugin.c -- The main interface for writin auditd plugins
- * Copyright 2025 Red Hat Inc.
+ * Copyright 2025-26 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -25,10 +25,13 @@
 #include <signal.h>
 #include <fcntl.h>
 #include <sys/select.h>
+#include <sys/stat.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <syslog.h>
 #include <string.h>
+#include <time.h>
 #include "common.h"	// For ATOMICs & VISIBILITY
 #include "libdisp.h"	// For event_t
 AUDIT_HIDDEN_START
@@ -57,10 +60,121 @@ static daemon_conf_t q_config;
 static unsigned int timer_interval;
 static auplugin_timer_callback_ptr timer_cb;
 static auplugin_stats_callback_ptr stats_cb;
+static unsigned int batch_max;
+static unsigned int batch_latency;
+
+/*
+ * Counters behind auplugin_get_metrics. They are bumped from the inbound,
+ * outbound, and worker threads, so every update is a relaxed atomic add.
+ * The rates are computed over the time since the previous snapshot.
+ */
+#define METRIC_ADD(var, val) __atomic_fetch_add(&(var), (val), __ATOMIC_RELAXED)
+#define METRIC_LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+
+static struct {
+	unsigned long long records;
+	unsigned long long bytes;
+	unsigned long long events;
+	unsigned long long eoe;
+	unsigned long long timeout;
+	unsigned long long input_wait_usec;
+	unsigned long long callbacks;
+	unsigned long long callback_usec;
+	unsigned long long callback_hist[AUPLUGIN_CB_HIST_BUCKETS];
+} counters;
+
+static struct {
+	unsigned long long usec;
+	unsigned long long records;
+	unsigned long long events;
+} last_snapshot;
+
+/* What a parser had completed the last time we looked at it */
+struct completions {
+	unsigned long eoe;
+	unsigned long timeout;
+};
+
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+static auplugin_metrics_callback_ptr metrics_cb;
+static const char *metrics_path;
+static volatile sig_atomic_t metrics_dump;
+
+/*
+ * Completed events collected by auplugin_event_feed_batch. Record text is
+ * copied into heap since auparse releases the event after its callback.
+ * Positions are kept as offsets while heap can still move and turned into
+ * pointers just before the batch is handed to the plugin.
+ */
+struct batch_fixup {
+	unsigned int first;		/* index of the first record */
+	size_t host;			/* heap offset of node + 1, 0 if none */
+};
+
+struct event_batch {
+	auplugin_event_t *events;
+	struct batch_fixup *fixups;
+	unsigned int cnt;
+	auplugin_record_t *records;
+	unsigned int nrecords;
+	unsigned int max_records;
+	char *heap;
+	size_t used;
+	size_t size;
+	auplugin_event_batch_callback_ptr callback;
+	auparse_state_t *au;
+	struct completions seen;
+};
+
+/*
+ * The worker pool used by auplugin_event_feed when auplugin_set_workers
+ * asked for more than one worker. The outbound thread hands each record to
+ * the worker that owns its event. Every worker runs its own auparse so an
+ * event is always assembled in one place. Each item carries a ticket in
+ * arrival order which is what ordered completion uses to hold back a
+ * callback until every other worker has caught up with it.
+ */
+struct work_item {
+	struct work_item *next;
+	unsigned long long ticket;
+	event_t *e;			/* NULL means age events */
+};
+
+struct worker {
+	pthread_t thread;
+	auparse_state_t *au;
+	struct work_item *head, *tail;
+	unsigned int depth;
+	int busy;			/* item with ticket is being fed */
+	unsigned long long ticket;
+	pthread_cond_t nonempty;
+	struct completions seen;
+};
+
+static struct worker *workers;
+static unsigned int num_workers;
+static int worker_flags;
+static unsigned int worker_max_depth;
+static int workers_stop;
+static int workers_flushing;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_order = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_room = PTHREAD_COND_INITIALIZER;
+static auparse_callback_ptr feed_cb;
 
 /* Local function prototypes */
+static unsigned long long now_usec(void);
+static void metrics_dump_check(void);
 static void *outbound_thread_loop(void *arg);
 static void *outbound_thread_feed(void *arg);
+static void *outbound_thread_loop_batch(void *arg);
+static void *outbound_thread_feed_batch(void *arg);
+static void *outbound_thread_dispatch(void *arg);
+static void feed_event(auparse_state_t *au, auparse_cb_event_t cb_event_type,
+		       void *user_data);
+static int pool_start(auparse_callback_ptr callback);
+static void batch_collect(auparse_state_t *au, auparse_cb_event_t cb_event_type,
+			  void *user_data);
 
 /*
  * This function is intended to initialize the plugin infrastructure
@@ -74,6 +188,7 @@ int auplugin_init(int inbound_fd, unsigned queue_size, int q_flags,
 	q_config.overflow_action = O_IGNORE;
 	q_config.max_restarts = 0;
 	q_config.plugin_dir = NULL;
+	last_snapshot.usec = now_usec();
 
 	// Set inbound descriptor to non-blocking mode
 	if (fcntl(fd, F_SETFL, O_NONBLOCK) == -1) {
@@ -92,6 +207,55 @@ void auplugin_stop(void)
 	AUDIT_ATOMIC_STORE(stop, 1);
 }
 
+static unsigned long long now_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* Account for one plugin callback that was started at start */
+static void callback_done(unsigned long long start)
+{
+	unsigned long long usec = now_usec() - start;
+	unsigned int bucket = usec ? 64 - __builtin_clzll(usec) : 0;
+
+	if (bucket >= AUPLUGIN_CB_HIST_BUCKETS)
+		bucket = AUPLUGIN_CB_HIST_BUCKETS - 1;
+	METRIC_ADD(counters.callbacks, 1);
+	METRIC_ADD(counters.callback_usec, usec);
+	METRIC_ADD(counters.callback_hist[bucket], 1);
+}
+
+/* Pick up how many events a parser completed since we last looked */
+static void count_completions(auparse_state_t *au, struct completions *seen)
+{
+	unsigned long eoe, timeout;
+
+	auparse_get_completions(au, &eoe, &timeout);
+	if (eoe != seen->eoe) {
+		METRIC_ADD(counters.eoe, eoe - seen->eoe);
+		seen->eoe = eoe;
+	}
+	if (timeout != seen->timeout) {
+		METRIC_ADD(counters.timeout, timeout - seen->timeout);
+		seen->timeout = timeout;
+	}
+}
+
+/* auparse callback that times the plugin's callback */
+static void feed_event(auparse_state_t *au, auparse_cb_event_t cb_event_type,
+		       void *user_data)
+{
+	unsigned long long start = now_usec();
+
+	feed_cb(au, cb_event_type, user_data);
+	callback_done(start);
+	if (cb_event_type == AUPARSE_CB_EVENT_READY)
+		METRIC_ADD(counters.events, 1);
+}
+
 /*
  * This function defines a comment set of tasks that the inbound event
  * handler must perform. Namely waiting for an event and then enqueuing
@@ -99,7 +263,6 @@ void auplugin_stop(void)
  * SIGTERM signal is detected. It leaves cleaning up the queue to the
  * outbound thread since it doesn't know if it's still access it.
  */
-static char rx_buf[MAX_AUDIT_EVENT_FRAME_SIZE+1];
 static void common_inbound(void)
 {
 	fd_set read_mask;
@@ -110,10 +273,14 @@ static void common_inbound(void)
 		FD_SET(fd, &read_mask);
 
 		// Wait for next event
+		unsigned long long start = now_usec();
 		do {
 			 ret_val = select(fd+1, &read_mask, NULL, NULL, NULL);
+			 if (ret_val == -1 && errno == EINTR)
+				metrics_dump_check();
 		} while (ret_val == -1 && errno == EINTR &&
 			 !AUDIT_ATOMIC_LOAD(stop));
+		METRIC_ADD(counters.input_wait_usec, now_usec() - start);
 
 		// If a real error (shouldn't happen) log it and exit
 		if (ret_val < 0 && errno != EINTR) {
@@ -124,21 +291,27 @@ static void common_inbound(void)
 		// Inbound is readable
 		if (ret_val > 0) {
 		    do {
-			int len;
-			if ((len = auplugin_fgets(rx_buf,
-				    MAX_AUDIT_EVENT_FRAME_SIZE + 1, fd)) > 0) {
+			const char *line;
+			size_t len;
+			int rc;
+
+			// Copy straight from the read buffer into the event
+			if ((rc = auplugin_fgets_view(&line, &len, fd)) > 0) {
 				// Got one - enqueue it
-				event_t *e = (event_t *)calloc(1,
-					 sizeof(event_t));
+				event_t *e = (event_t *)malloc(sizeof(event_t));
 				if (e) {
-					strncpy(e->data, rx_buf,
-						MAX_AUDIT_MESSAGE_LENGTH);
-					e->data[MAX_AUDIT_MESSAGE_LENGTH-1] = 0;
+					if (len > MAX_AUDIT_MESSAGE_LENGTH - 1)
+						len = MAX_AUDIT_MESSAGE_LENGTH - 1;
+					memset(&e->hdr, 0, sizeof(e->hdr));
+					memcpy(e->data, line, len);
+					e->data[len] = 0;
 					e->hdr.size = len;
 					e->hdr.ver = AUDISP_PROTOCOL_VER2;
 					enqueue(e, &q_config);
+					METRIC_ADD(counters.records, 1);
+					METRIC_ADD(counters.bytes, len);
 				}
-			} else if (len < 0) {
+			} else if (rc < 0) {
 				AUDIT_ATOMIC_STORE(stop, 1);
 				syslog(LOG_ERR, "auplugin_fgets failed: %m");
 			} else if (auplugin_fgets_eof()) {
@@ -147,6 +320,7 @@ static void common_inbound(void)
 			}
 		    } while (auplugin_fgets_more(MAX_AUDIT_EVENT_FRAME_SIZE));
 		}
+		metrics_dump_check();
 	} while (!AUDIT_ATOMIC_LOAD(stop));
 }
 
@@ -176,6 +350,29 @@ void auplugin_event_loop(auplugin_callback_ptr callback)
 	common_inbound();
 }
 
+/*
+ * This function lets auplugin_event_feed spread event assembly over a pool
+ * of count threads. Each record is routed by its timestamp, serial, and node
+ * to the worker that owns the event, so every event is built by one auparse
+ * instance and the callback runs on that worker's thread. Since the
+ * callback can then run concurrently, the caller must say so by passing
+ * AUPLUGIN_CB_THREAD_SAFE. Adding AUPLUGIN_CB_ORDERED makes callbacks run
+ * one at a time in the order the records that completed them arrived. A
+ * count of 0 or 1 goes back to the single threaded mode. This must be
+ * called before auplugin_event_feed. It returns 0 on success and -1 if the
+ * arguments are invalid.
+ */
+int auplugin_set_workers(unsigned int count, int flags)
+{
+	if (count > 1 && (flags & AUPLUGIN_CB_THREAD_SAFE) == 0)
+		return -1;
+	if (count > AUPLUGIN_MAX_WORKERS)
+		return -1;
+	num_workers = count;
+	worker_flags = flags;
+	return 0;
+}
+
 /*
  * This function is the entrypoint for event processing when you want to
  * get the event records as a callback function to auparse. It takes care
@@ -183,8 +380,9 @@ void auplugin_event_loop(auplugin_callback_ptr callback)
  * callback function will have a pointer to the auparse_state_t variable
  * that can be used to iterate across the event. The called function should
  * only use function related to iterating across a record. Calling any other
- * auparse function can have unknown consequences. This function does not
- * return until SIGTERM has been signalled via auplugin_stop(). It will
+ * auparse function can have unknown consequences. If auplugin_set_workers
+ * was called, the callback runs on the worker threads. This function does
+ * not return until SIGTERM has been signalled via auplugin_stop(). It will
  * return 0 for success and -1 if something went wrong setting up auparse.
  */
 int auplugin_event_feed(auparse_callback_ptr callback, unsigned int t_interval,
@@ -194,15 +392,32 @@ int auplugin_event_feed(auparse_callback_ptr callback, unsigned int t_interval,
 	if (callback == NULL)
 		return -1;
 
+	timer_interval = t_interval;
+	timer_cb = t_cb;
+	if (num_workers > 1) {
+		if (pool_start(callback))
+			return -1;
+		rc = pthread_create(&outbound_thread, NULL,
+				    outbound_thread_dispatch, NULL);
+		if (rc) {
+			syslog(LOG_ERR, "pthread_create failed: %m");
+			destroy_queue();
+			return -1;
+		}
+		pthread_detach(outbound_thread);
+
+		common_inbound();
+		return 0;
+	}
+
 	auparse_state_t *au = auparse_init(AUSOURCE_FEED, 0);
         if (au == NULL) {
                 printf("plugin is exiting due to auparse init errors");
                 return -1;
         }
         auparse_set_eoe_timeout(2);
-        auparse_add_callback(au, callback, NULL, NULL);
-	timer_interval = t_interval;
-	timer_cb = t_cb;
+        auparse_add_callback(au, feed_event, NULL, NULL);
+	feed_cb = callback;
 
 	/* Create outbound thread */
 	rc = pthread_create(&outbound_thread, NULL, outbound_thread_feed, au);
@@ -219,6 +434,112 @@ int auplugin_event_feed(auparse_callback_ptr callback, unsigned int t_interval,
 	return 0;
 }
 
+/*
+ * This function is the entrypoint for event processing when you want to
+ * get the event records in groups. Up to max_batch records are handed to
+ * the callback at once as pointer and length pairs. After the first record
+ * of a batch arrives, we wait at most max_latency milliseconds for the
+ * batch to fill. A max_latency of 0 delivers whatever is already queued.
+ * The records are only valid until the callback returns. This function
+ * does not return until SIGTERM has been signalled via auplugin_stop().
+ * It returns 0 for success and -1 if the arguments are invalid.
+ */
+int auplugin_event_loop_batch(auplugin_batch_callback_ptr callback,
+			      unsigned int max_batch, unsigned int max_latency)
+{
+	int rc;
+
+	if (callback == NULL || max_batch == 0)
+		return -1;
+
+	batch_max = max_batch;
+	batch_latency = max_latency;
+
+	/* Create outbound thread */
+	rc = pthread_create(&outbound_thread, NULL,
+			    outbound_thread_loop_batch, callback);
+	if (rc) {
+		syslog(LOG_ERR, "pthread_create failed: %m");
+		destroy_queue();
+		return -1;
+	}
+	pthread_detach(outbound_thread);
+
+	common_inbound();
+	return 0;
+}
+
+static void batch_free(struct event_batch *b)
+{
+	if (b->au)
+		auparse_destroy(b->au);
+	free(b->records);
+	free(b->fixups);
+	free(b->events);
+	free(b->heap);
+	free(b);
+}
+
+/*
+ * This function is like auplugin_event_feed except that completed events
+ * are handed to the callback in groups of up to max_batch. Records are
+ * drained from the queue in bulk and fed to auparse which does the event
+ * assembly. The events and their record text are only valid until the
+ * callback returns. max_latency bounds how long, in milliseconds, we wait
+ * for a batch to fill once the first record arrives. The timer works the
+ * same as in auplugin_event_feed. This function does not return until
+ * SIGTERM has been signalled via auplugin_stop(). It will return 0 for
+ * success and -1 if something went wrong setting up auparse.
+ */
+int auplugin_event_feed_batch(auplugin_event_batch_callback_ptr callback,
+			      unsigned int max_batch, unsigned int max_latency,
+			      unsigned int t_interval,
+			      auplugin_timer_callback_ptr t_cb)
+{
+	struct event_batch *b;
+	int rc;
+
+	if (callback == NULL || max_batch == 0)
+		return -1;
+
+	b = calloc(1, sizeof(*b));
+	if (b == NULL)
+		return -1;
+	b->callback = callback;
+	b->events = malloc(max_batch * sizeof(auplugin_event_t));
+	b->fixups = malloc(max_batch * sizeof(struct batch_fixup));
+	b->max_records = max_batch * 4;
+	b->records = malloc(b->max_records * sizeof(auplugin_record_t));
+	b->au = auparse_init(AUSOURCE_FEED, 0);
+	if (b->events == NULL || b->fixups == NULL || b->records == NULL ||
+			b->au == NULL) {
+		printf("plugin is exiting due to auparse init errors");
+		batch_free(b);
+		return -1;
+	}
+	auparse_set_eoe_timeout(2);
+	auparse_add_callback(b->au, batch_collect, b, NULL);
+
+	batch_max = max_batch;
+	batch_latency = max_latency;
+	timer_interval = t_interval;
+	timer_cb = t_cb;
+
+	/* Create outbound thread */
+	rc = pthread_create(&outbound_thread, NULL,
+			    outbound_thread_feed_batch, b);
+	if (rc) {
+		syslog(LOG_ERR, "pthread_create failed: %m");
+		batch_free(b);
+		destroy_queue();
+		return -1;
+	}
+	pthread_detach(outbound_thread);
+
+	common_inbound();
+	return 0;
+}
+
 static void common_outbound_thread_init(void)
 {
         sigset_t sigs;
@@ -257,7 +578,9 @@ static void *outbound_thread_loop(void *arg)
 			free(e);
 			continue;
 		}
+		unsigned long long start = now_usec();
 		callback(e->data);
+		callback_done(start);
 		free(e);
 	}
 
@@ -273,6 +596,7 @@ static void *outbound_thread_loop(void *arg)
 static void *outbound_thread_feed(void *arg)
 {
 	auparse_state_t *au  = (auparse_state_t *)arg;
+	struct completions seen = { 0, 0 };
 	common_outbound_thread_init();
 
         /* Start event loop */
@@ -293,6 +617,7 @@ static void *outbound_thread_feed(void *arg)
 				if (timer_cb)
 					timer_cb(timer_interval);
 				auparse_feed_age_events(au);
+				count_completions(au, &seen);
 				continue;
 			}
 			if (AUDIT_ATOMIC_LOAD(stop))
@@ -305,9 +630,11 @@ static void *outbound_thread_feed(void *arg)
 			continue;
 		}
 		auparse_feed(au, e->data, e->hdr.size);
+		count_completions(au, &seen);
 		free(e);
 	}
 	auparse_flush_feed(au);
+	count_completions(au, &seen);
 	auparse_destroy(au);
 
 	// This side destroys the queue since it knows when it's done
@@ -316,6 +643,532 @@ static void *outbound_thread_feed(void *arg)
 	return NULL;
 }
 
+/*
+ * outbound thread - dequeue data in bulk to a callback that takes an
+ * array of records
+ */
+static void *outbound_thread_loop_batch(void *arg)
+{
+	auplugin_batch_callback_ptr callback = (auplugin_batch_callback_ptr)arg;
+	auplugin_record_t *records;
+	event_t **events;
+
+	common_outbound_thread_init();
+	events = malloc(batch_max * sizeof(event_t *));
+	records = malloc(batch_max * sizeof(auplugin_record_t));
+	if (events == NULL || records == NULL) {
+		syslog(LOG_ERR, "Out of memory allocating batch");
+		AUDIT_ATOMIC_STORE(stop, 1);
+	}
+
+        /* Start event loop */
+	while (AUDIT_ATOMIC_LOAD(stop) == 0) {
+		unsigned int i, n, cnt = 0;
+
+		/* This is where we block until we have events */
+		n = dequeue_batch(events, batch_max, NULL, batch_latency);
+		for (i = 0; i < n; i++) {
+			event_t *e = events[i];
+
+			if (e->hdr.ver != AUDISP_PROTOCOL_VER2)
+				continue;	// should never happen
+			records[cnt].data = e->data;
+			records[cnt].len = e->hdr.size;
+			cnt++;
+		}
+		if (cnt) {
+			unsigned long long start = now_usec();
+			callback(records, cnt);
+			callback_done(start);
+		}
+		for (i = 0; i < n; i++)
+			free(events[i]);
+	}
+	free(records);
+	free(events);
+
+	// This side destroys the queue since it knows when it's done
+	destroy_queue();
+
+	return NULL;
+}
+
+static void batch_clear(struct event_batch *b)
+{
+	b->cnt = 0;
+	b->nrecords = 0;
+	b->used = 0;
+}
+
+/* Returns the heap offset of the copied string or -1 on failure */
+static ssize_t batch_store(struct event_batch *b, const char *str, size_t len)
+{
+	size_t off = b->used;
+
+	if (b->used + len + 1 > b->size) {
+		size_t size = b->size ? b->size : 65536;
+		char *tmp;
+
+		while (b->used + len + 1 > size)
+			size *= 2;
+		tmp = realloc(b->heap, size);
+		if (tmp == NULL)
+			return -1;
+		b->heap = tmp;
+		b->size = size;
+	}
+	memcpy(b->heap + off, str, len);
+	b->heap[off + len] = 0;
+	b->used += len + 1;
+	return off;
+}
+
+/* Turn offsets into pointers and hand the batch to the plugin */
+static void batch_deliver(struct event_batch *b)
+{
+	unsigned long long start;
+	unsigned int i;
+
+	if (b->cnt == 0)
+		return;
+
+	for (i = 0; i < b->nrecords; i++)
+		b->records[i].data = b->heap + (size_t)b->records[i].data;
+	for (i = 0; i < b->cnt; i++) {
+		b->events[i].records = &b->records[b->fixups[i].first];
+		b->events[i].stamp.host = b->fixups[i].host ?
+			b->heap + b->fixups[i].host - 1 : NULL;
+	}
+	start = now_usec();
+	b->callback(b->events, b->cnt);
+	callback_done(start);
+	batch_clear(b);
+}
+
+/* auparse callback that copies each completed event into the batch */
+static void batch_collect(auparse_state_t *au, auparse_cb_event_t cb_event_type,
+			  void *user_data)
+{
+	struct event_batch *b = user_data;
+	const au_event_t *stamp;
+	auplugin_event_t *ev;
+	unsigned int first = b->nrecords;
+	ssize_t off;
+
+	if (cb_event_type != AUPARSE_CB_EVENT_READY)
+		return;
+
+	stamp = auparse_get_timestamp(au);
+	if (stamp == NULL || auparse_first_record(au) <= 0)
+		return;
+
+	ev = &b->events[b->cnt];
+	ev->stamp = *stamp;
+	ev->type = auparse_get_type(au);
+	ev->num_records = 0;
+	ev->records = NULL;
+	b->fixups[b->cnt].first = first;
+	b->fixups[b->cnt].host = 0;
+	if (stamp->host) {
+		off = batch_store(b, stamp->host, strlen(stamp->host));
+		if (off < 0)
+			goto nomem;
+		b->fixups[b->cnt].host = off + 1;
+	}
+
+	do {
+		const char *text = auparse_get_record_text(au);
+
+		if (text == NULL)
+			continue;
+		if (b->nrecords == b->max_records) {
+			unsigned int max = b->max_records * 2;
+			auplugin_record_t *tmp;
+
+			tmp = realloc(b->records,
+				      max * sizeof(auplugin_record_t));
+			if (tmp == NULL)
+				goto nomem;
+			b->records = tmp;
+			b->max_records = max;
+		}
+		off = batch_store(b, text, strlen(text));
+		if (off < 0)
+			goto nomem;
+		b->records[b->nrecords].data = (const char *)(size_t)off;
+		b->records[b->nrecords].len = strlen(text);
+		b->nrecords++;
+		ev->num_records++;
+	} while (auparse_next_record(au) > 0);
+
+	b->cnt++;
+	METRIC_ADD(counters.events, 1);
+	if (b->cnt == batch_max)
+		batch_deliver(b);
+	return;
+nomem:
+	/* Drop this event but keep what was collected before it */
+	syslog(LOG_ERR, "Out of memory collecting event batch");
+	b->nrecords = first;
+}
+
+/*
+ * outbound thread - dequeue data in bulk to auparse_feed and hand
+ * completed events to the callback in groups
+ */
+static void *outbound_thread_feed_batch(void *arg)
+{
+	struct event_batch *b = (struct event_batch *)arg;
+	event_t **events;
+
+	common_outbound_thread_init();
+	events = malloc(batch_max * sizeof(event_t *));
+	if (events == NULL) {
+		syslog(LOG_ERR, "Out of memory allocating batch");
+		AUDIT_ATOMIC_STORE(stop, 1);
+	}
+
+        /* Start event loop */
+	while (AUDIT_ATOMIC_LOAD(stop) == 0) {
+		unsigned int i, n;
+
+		/* This is where we block until we have events */
+		if (timer_interval) {
+			struct timespec ts;
+
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_sec += timer_interval;
+			n = dequeue_batch(events, batch_max, &ts,
+					  batch_latency);
+		} else
+			n = dequeue_batch(events, batch_max, NULL,
+					  batch_latency);
+
+		if (n == 0) {
+			if (timer_interval && errno == ETIMEDOUT) {
+				if (timer_cb)
+					timer_cb(timer_interval);
+				auparse_feed_age_events(b->au);
+				count_completions(b->au, &b->seen);
+				batch_deliver(b);
+			}
+			continue;
+		}
+		for (i = 0; i < n; i++) {
+			event_t *e = events[i];
+
+			if (e->hdr.ver == AUDISP_PROTOCOL_VER2)
+				auparse_feed(b->au, e->data, e->hdr.size);
+			free(e);
+		}
+		count_completions(b->au, &b->seen);
+		batch_deliver(b);
+	}
+	auparse_flush_feed(b->au);
+	count_completions(b->au, &b->seen);
+	batch_deliver(b);
+	batch_free(b);
+	free(events);
+
+	// This side destroys the queue since it knows when it's done
+	destroy_queue();
+
+	return NULL;
+}
+
+/*
+ * Pick the worker that owns the event a record belongs to. Records of
+ * one event share the node and the audit(sec.milli:serial) stamp.
+ * Anything that can't be parsed goes to the first worker.
+ */
+static unsigned int event_shard(const char *data)
+{
+	unsigned long long h = 0;
+	unsigned long sec, milli, serial;
+	const char *ptr;
+	char *end;
+
+	if (strncmp(data, "node=", 5) == 0) {
+		for (ptr = data + 5; *ptr && *ptr != ' '; ptr++)
+			h = h * 31 + (unsigned char)*ptr;
+	}
+	ptr = strstr(data, "audit(");
+	if (ptr == NULL)
+		return 0;
+	errno = 0;
+	sec = strtoul(ptr + 6, &end, 10);
+	if (errno || *end != '.')
+		return 0;
+	milli = strtoul(end + 1, &end, 10);
+	if (errno || *end != ':')
+		return 0;
+	serial = strtoul(end + 1, &end, 10);
+	if (errno)
+		return 0;
+
+	h = h * 31 + (sec * 1000ULL + milli) * 31 + serial;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return h % num_workers;
+}
+
+/* The ticket of the oldest item a worker still has to finish */
+static unsigned long long worker_pending(const struct worker *w)
+{
+	if (w->busy)
+		return w->ticket;
+	if (w->head)
+		return w->head->ticket;
+	return ~0ULL;
+}
+
+/* Called with pool_lock held. Nobody else may have older work. */
+static int worker_turn(const struct worker *w)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_workers; i++) {
+		if (&workers[i] != w && worker_pending(&workers[i]) < w->ticket)
+			return 0;
+	}
+	return 1;
+}
+
+/* auparse callback on a worker thread */
+static void worker_event(auparse_state_t *au, auparse_cb_event_t cb_event_type,
+			 void *user_data)
+{
+	struct worker *w = user_data;
+
+	if ((worker_flags & AUPLUGIN_CB_ORDERED) && !workers_flushing) {
+		pthread_mutex_lock(&pool_lock);
+		while (!worker_turn(w))
+			pthread_cond_wait(&pool_order, &pool_lock);
+		pthread_mutex_unlock(&pool_lock);
+	}
+	feed_event(au, cb_event_type, NULL);
+}
+
+static void *worker_thread(void *arg)
+{
+	struct worker *w = arg;
+
+	pthread_mutex_lock(&pool_lock);
+	while (1) {
+		struct work_item *item;
+
+		while (w->head == NULL && !workers_stop)
+			pthread_cond_wait(&w->nonempty, &pool_lock);
+		if (w->head == NULL)
+			break;
+
+		item = w->head;
+		w->head = item->next;
+		if (w->head == NULL)
+			w->tail = NULL;
+		w->depth--;
+		w->busy = 1;
+		w->ticket = item->ticket;
+		pthread_cond_signal(&pool_room);
+		pthread_mutex_unlock(&pool_lock);
+
+		if (item->e)
+			auparse_feed(w->au, item->e->data, item->e->hdr.size);
+		else
+			auparse_feed_age_events(w->au);
+		count_completions(w->au, &w->seen);
+		free(item->e);
+		free(item);
+
+		pthread_mutex_lock(&pool_lock);
+		w->busy = 0;
+		if (worker_flags & AUPLUGIN_CB_ORDERED)
+			pthread_cond_broadcast(&pool_order);
+	}
+	pthread_mutex_unlock(&pool_lock);
+
+	return NULL;
+}
+
+/* Hand an item to a worker. Waits while the worker is backed up. */
+static void worker_push(struct worker *w, event_t *e,
+			unsigned long long ticket)
+{
+	struct work_item *item = malloc(sizeof(*item));
+
+	if (item == NULL) {
+		syslog(LOG_ERR, "Out of memory dispatching event");
+		free(e);
+		return;
+	}
+	item->next = NULL;
+	item->ticket = ticket;
+	item->e = e;
+
+	pthread_mutex_lock(&pool_lock);
+	while (w->depth >= worker_max_depth && !AUDIT_ATOMIC_LOAD(stop))
+		pthread_cond_wait(&pool_room, &pool_lock);
+	if (w->tail)
+		w->tail->next = item;
+	else
+		w->head = item;
+	w->tail = item;
+	w->depth++;
+	pthread_cond_signal(&w->nonempty);
+	pthread_mutex_unlock(&pool_lock);
+}
+
+static void pool_free(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_workers; i++) {
+		if (workers[i].au)
+			auparse_destroy(workers[i].au);
+		pthread_cond_destroy(&workers[i].nonempty);
+	}
+	free(workers);
+	workers = NULL;
+}
+
+/*
+ * Set up a parser per worker and start the threads. Signals are blocked
+ * while creating them so that they stay with the main thread.
+ */
+static int pool_start(auparse_callback_ptr callback)
+{
+	sigset_t sigs, old;
+	unsigned int i;
+	int rc = 0;
+
+	workers = calloc(num_workers, sizeof(struct worker));
+	if (workers == NULL)
+		return -1;
+	for (i = 0; i < num_workers; i++)
+		pthread_cond_init(&workers[i].nonempty, NULL);
+	for (i = 0; i < num_workers; i++) {
+		workers[i].au = auparse_init(AUSOURCE_FEED, 0);
+		if (workers[i].au == NULL) {
+			printf("plugin is exiting due to auparse init errors");
+			pool_free();
+			return -1;
+		}
+		auparse_add_callback(workers[i].au, worker_event,
+				     &workers[i], NULL);
+	}
+	auparse_set_eoe_timeout(2);
+	feed_cb = callback;
+	worker_max_depth = q_config.q_depth ? q_config.q_depth : 1;
+	workers_stop = 0;
+	workers_flushing = 0;
+
+	sigfillset(&sigs);
+	pthread_sigmask(SIG_SETMASK, &sigs, &old);
+	for (i = 0; i < num_workers; i++) {
+		rc = pthread_create(&workers[i].thread, NULL, worker_thread,
+				    &workers[i]);
+		if (rc)
+			break;
+	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (rc) {
+		unsigned int started = i;
+
+		syslog(LOG_ERR, "pthread_create failed: %m");
+		pthread_mutex_lock(&pool_lock);
+		workers_stop = 1;
+		for (i = 0; i < started; i++)
+			pthread_cond_signal(&workers[i].nonempty);
+		pthread_mutex_unlock(&pool_lock);
+		for (i = 0; i < started; i++)
+			pthread_join(workers[i].thread, NULL);
+		pool_free();
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Let the workers drain what they were given, then complete whatever is
+ * still being assembled. The flush happens one worker at a time on this
+ * thread, so ordering no longer has to be enforced.
+ */
+static void pool_stop(void)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&pool_lock);
+	workers_stop = 1;
+	for (i = 0; i < num_workers; i++)
+		pthread_cond_signal(&workers[i].nonempty);
+	pthread_cond_broadcast(&pool_room);
+	pthread_mutex_unlock(&pool_lock);
+
+	for (i = 0; i < num_workers; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	workers_flushing = 1;
+	for (i = 0; i < num_workers; i++) {
+		auparse_flush_feed(workers[i].au);
+		count_completions(workers[i].au, &workers[i].seen);
+	}
+	pool_free();
+}
+
+/*
+ * outbound thread - dequeue data and route it to the worker pool
+ */
+static void *outbound_thread_dispatch(void *arg)
+{
+	unsigned long long ticket = 0;
+	(void)arg;
+
+	common_outbound_thread_init();
+
+        /* Start event loop */
+	while (AUDIT_ATOMIC_LOAD(stop) == 0) {
+		/* This is where we block until we have an event */
+		event_t *e;
+		if (timer_interval) {
+			struct timespec ts;
+
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_sec += timer_interval;
+			e = dequeue_timed(&ts);
+		} else
+			e = dequeue();
+
+		if (e == NULL) {
+			if (timer_interval && errno == ETIMEDOUT) {
+				unsigned int i;
+
+				if (timer_cb)
+					timer_cb(timer_interval);
+				for (i = 0; i < num_workers; i++)
+					worker_push(&workers[i], NULL,
+						    ticket++);
+				continue;
+			}
+			if (AUDIT_ATOMIC_LOAD(stop))
+				break;
+			continue;
+		}
+		if (e->hdr.ver != AUDISP_PROTOCOL_VER2) {
+			// should never be anything but v2
+			free(e);
+			continue;
+		}
+		worker_push(&workers[event_shard(e->data)], e, ticket++);
+	}
+	pool_stop();
+
+	// This side destroys the queue since it knows when it's done
+	destroy_queue();
+
+	return NULL;
+}
+
 void auplugin_register_stats_callback(auplugin_stats_callback_ptr cb)
 {
 	stats_cb = cb;
@@ -327,6 +1180,134 @@ void auplugin_report_stats(void)
 		stats_cb(queue_current_depth(), queue_max_depth(),
 			 queue_overflowed_p());
 	}
+	if (metrics_cb) {
+		auplugin_metrics_t m;
+
+		auplugin_get_metrics(&m);
+		metrics_cb(&m);
+	}
+}
+
+void auplugin_register_metrics_callback(auplugin_metrics_callback_ptr cb)
+{
+	metrics_cb = cb;
+}
+
+/*
+ * Take a snapshot of the performance counters. The rates cover the time
+ * since the previous snapshot, whoever asked for it.
+ */
+void auplugin_get_metrics(auplugin_metrics_t *m)
+{
+	unsigned long long now = now_usec(), elapsed;
+	unsigned int i;
+
+	memset(m, 0, sizeof(*m));
+	m->records = METRIC_LOAD(counters.records);
+	m->bytes = METRIC_LOAD(counters.bytes);
+	m->events = METRIC_LOAD(counters.events);
+	m->eoe_events = METRIC_LOAD(counters.eoe);
+	m->timeout_events = METRIC_LOAD(counters.timeout);
+	m->input_wait_usec = METRIC_LOAD(counters.input_wait_usec);
+	m->callbacks = METRIC_LOAD(counters.callbacks);
+	m->callback_usec = METRIC_LOAD(counters.callback_usec);
+	for (i = 0; i < AUPLUGIN_CB_HIST_BUCKETS; i++)
+		m->callback_hist[i] = METRIC_LOAD(counters.callback_hist[i]);
+	m->queue_depth = queue_current_depth();
+	m->queue_max_depth = queue_max_depth();
+	m->queue_overflow = queue_overflowed_p();
+
+	pthread_mutex_lock(&metrics_lock);
+	elapsed = now - last_snapshot.usec;
+	if (elapsed) {
+		m->records_per_sec = (m->records - last_snapshot.records) *
+					1000000.0 / elapsed;
+		m->events_per_sec = (m->events - last_snapshot.events) *
+					1000000.0 / elapsed;
+	}
+	last_snapshot.usec = now;
+	last_snapshot.records = m->records;
+	last_snapshot.events = m->events;
+	pthread_mutex_unlock(&metrics_lock);
+}
+
+/* Write a snapshot in the format used by the audit state reports */
+void auplugin_write_metrics(FILE *f)
+{
+	auplugin_metrics_t m;
+	unsigned int i;
+
+	auplugin_get_metrics(&m);
+	fprintf(f, "records received = %llu\n", m.records);
+	fprintf(f, "bytes received = %llu\n", m.bytes);
+	fprintf(f, "events completed = %llu\n", m.events);
+	fprintf(f, "events completed by eoe = %llu\n", m.eoe_events);
+	fprintf(f, "events completed by timeout = %llu\n", m.timeout_events);
+	fprintf(f, "records per second = %.1f\n", m.records_per_sec);
+	fprintf(f, "events per second = %.1f\n", m.events_per_sec);
+	fprintf(f, "time blocked on input = %llu usecs\n", m.input_wait_usec);
+	fprintf(f, "callbacks = %llu\n", m.callbacks);
+	fprintf(f, "time in callbacks = %llu usecs\n", m.callback_usec);
+	fprintf(f, "callback time histogram:\n");
+	for (i = 0; i < AUPLUGIN_CB_HIST_BUCKETS - 1; i++) {
+		if (m.callback_hist[i])
+			fprintf(f, "  < %u usecs = %llu\n", 1U << i,
+				m.callback_hist[i]);
+	}
+	if (m.callback_hist[i])
+		fprintf(f, "  >= %u usecs = %llu\n", 1U << (i - 1),
+			m.callback_hist[i]);
+	fprintf(f, "queue depth = %u\n", m.queue_depth);
+	fprintf(f, "max queue depth = %u\n", m.queue_max_depth);
+	fprintf(f, "queue overflowed = %s\n", m.queue_overflow ? "yes" : "no");
+}
+
+static void metrics_handler(int sig __attribute__((unused)))
+{
+	metrics_dump = 1;
+}
+
+/*
+ * Called from the inbound loop. Signals are only taken by the thread
+ * that called the event loop, so the dump happens there.
+ */
+static void metrics_dump_check(void)
+{
+	int saved = errno;
+	FILE *f;
+
+	if (!metrics_dump || metrics_path == NULL)
+		return;
+	metrics_dump = 0;
+
+	mode_t u = umask(0137); // allow 0640
+	f = fopen(metrics_path, "w");
+	umask(u);
+	if (f) {
+		auplugin_write_metrics(f);
+		fclose(f);
+	} else
+		syslog(LOG_WARNING, "Cannot write metrics to %s: %m",
+		       metrics_path);
+	errno = saved;
+}
+
+/*
+ * Have the library handle SIGUSR1 by writing its metrics to path. The
+ * path must stay valid while the event loop runs. Returns 0 on success
+ * and -1 if the handler could not be installed.
+ */
+int auplugin_metrics_on_sigusr1(const char *path)
+{
+	struct sigaction sa;
+
+	if (path == NULL)
+		return -1;
+	metrics_path = path;
+	memset(&sa, 0, sizeof(sa));
+	sigemptyset(&sa.sa_mask);
+	sa.sa_handler = metrics_handler;
+	return sigaction(SIGUSR1, &sa, NULL);
 }
 
 unsigned int auplugin_queue_depth(void)
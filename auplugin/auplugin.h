@@ -1,5 +1,5 @@
 /* auplugin.h --
- * Copyright 2025 Red Hat Inc.
+ * Copyright 2025-26 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -25,6 +25,7 @@
 #define _AUPLUGIN_H_
 
 #include <stddef.h>
+#include <stdio.h>
 #include <libaudit.h>
 #include <auparse.h>
 
@@ -65,12 +66,61 @@ enum {
        AUPLUGIN_Q_RESIZE    = 1 << 5,
 };
 
+/* Flags for auplugin_set_workers */
+enum {
+	AUPLUGIN_CB_THREAD_SAFE = 1 << 0,	/* callback may run concurrently */
+	AUPLUGIN_CB_ORDERED     = 1 << 1,	/* complete events in arrival order */
+};
+#define AUPLUGIN_MAX_WORKERS 64
+
+/* A record as delivered in a batch. It is not NUL terminated at len and
+ * is only valid until the batch callback returns. */
+typedef struct auplugin_record {
+	const char *data;
+	size_t len;
+} auplugin_record_t;
+
+/* A completed event as delivered in a batch */
+typedef struct auplugin_event {
+	au_event_t stamp;		/* time, serial and node */
+	int type;			/* type of the first record */
+	unsigned int num_records;
+	const auplugin_record_t *records;
+} auplugin_event_t;
+
+/* Performance counters kept by the library. The callback histogram has
+ * a bucket for under 1 usec, then one per power of two, with the last
+ * bucket counting everything slower. */
+#define AUPLUGIN_CB_HIST_BUCKETS 20
+typedef struct auplugin_metrics {
+	unsigned long long records;		/* records received */
+	unsigned long long bytes;		/* bytes received */
+	unsigned long long events;		/* events completed by auparse */
+	unsigned long long eoe_events;		/* ended by their last record */
+	unsigned long long timeout_events;	/* ended by timeout or flush */
+	double records_per_sec;			/* since the last snapshot */
+	double events_per_sec;
+	unsigned long long input_wait_usec;	/* time blocked on input */
+	unsigned long long callbacks;		/* plugin callbacks made */
+	unsigned long long callback_usec;	/* time spent in them */
+	unsigned long long callback_hist[AUPLUGIN_CB_HIST_BUCKETS];
+	unsigned int queue_depth;
+	unsigned int queue_max_depth;
+	int queue_overflow;
+} auplugin_metrics_t;
+
 /* Callback prototypes */
 typedef void (*auplugin_callback_ptr)(const char *record);
+typedef void (*auplugin_batch_callback_ptr)(const auplugin_record_t *records,
+					    unsigned int cnt);
+typedef void (*auplugin_event_batch_callback_ptr)(
+					const auplugin_event_t *events,
+					unsigned int cnt);
 typedef void (*auplugin_timer_callback_ptr)(unsigned int interval);
 typedef void (*auplugin_stats_callback_ptr)(unsigned int depth,
 					    unsigned int max_depth,
 					    int overflow);
+typedef void (*auplugin_metrics_callback_ptr)(const auplugin_metrics_t *m);
 
 /* fgets family of functions prototypes */
 void auplugin_fgets_clear(void);
@@ -80,6 +130,7 @@ int auplugin_fgets(char *buf, size_t blen, int fd)
 	__attr_access ((__write_only__, 1, 2)) __wur;
 int auplugin_setvbuf(void *buf, size_t buff_size, enum auplugin_mem how)
 	__attr_access ((__read_only__, 1, 2));
+int auplugin_fgets_view(const char **line, size_t *len, int fd) __wur;
 
 void auplugin_fgets_destroy(auplugin_fgets_state_t *st);
 auplugin_fgets_state_t *auplugin_fgets_init(void)
@@ -92,17 +143,30 @@ int auplugin_fgets_r(auplugin_fgets_state_t *st, char *buf, size_t blen, int fd)
 int auplugin_setvbuf_r(auplugin_fgets_state_t *st, void *buf, size_t buff_size,
 			enum auplugin_mem how)
 			__attr_access ((__read_only__, 2, 3));
+int auplugin_fgets_view_r(auplugin_fgets_state_t *st, const char **line,
+			  size_t *len, int fd) __wur;
 
 /* auplugin family of functions prototypes */
 int auplugin_init(int inbound_fd, unsigned queue_size, int q_flags,
 		  const char *path);
 void auplugin_stop(void);
 void auplugin_event_loop(auplugin_callback_ptr callback);
+int auplugin_set_workers(unsigned int count, int flags);
 int auplugin_event_feed(auparse_callback_ptr callback,
 			unsigned int timer_interval,
 			auplugin_timer_callback_ptr timer_cb);
+int auplugin_event_loop_batch(auplugin_batch_callback_ptr callback,
+			      unsigned int max_batch, unsigned int max_latency);
+int auplugin_event_feed_batch(auplugin_event_batch_callback_ptr callback,
+			      unsigned int max_batch, unsigned int max_latency,
+			      unsigned int timer_interval,
+			      auplugin_timer_callback_ptr timer_cb);
 void auplugin_register_stats_callback(auplugin_stats_callback_ptr cb);
 void auplugin_report_stats(void);
+void auplugin_register_metrics_callback(auplugin_metrics_callback_ptr cb);
+void auplugin_get_metrics(auplugin_metrics_t *m);
+void auplugin_write_metrics(FILE *f);
+int auplugin_metrics_on_sigusr1(const char *path);
 unsigned int auplugin_queue_depth(void);
 unsigned int auplugin_queue_max_depth(void);
 int auplugin_queue_overflow(void);
@@ -0,0 +1,186 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <auplugin.h>
+
+#define MAX_BATCH 16
+#define LATENCY 200	/* milliseconds */
+#define BURST 40
+#define PUSHER 1000	/* serials past this are not counted */
+
+static int delivered, batches, too_big, bad;
+static unsigned long long first_usec;
+
+static unsigned long long now_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void batch_seen(unsigned int cnt)
+{
+	if (cnt == 0)
+		return;
+	if (__atomic_add_fetch(&batches, 1, __ATOMIC_SEQ_CST) == 1)
+		__atomic_store_n(&first_usec, now_usec(), __ATOMIC_SEQ_CST);
+	if (cnt > MAX_BATCH)
+		__atomic_add_fetch(&too_big, 1, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&delivered, cnt, __ATOMIC_SEQ_CST);
+}
+
+static void record_cb(const auplugin_record_t *records, unsigned int cnt)
+{
+	unsigned int i;
+
+	for (i = 0; i < cnt; i++)
+		if (records[i].len == 0 || strncmp(records[i].data, "type=", 5))
+			__atomic_add_fetch(&bad, 1, __ATOMIC_SEQ_CST);
+	batch_seen(cnt);
+}
+
+static void event_cb(const auplugin_event_t *events, unsigned int cnt)
+{
+	unsigned int i, real = 0;
+
+	for (i = 0; i < cnt; i++) {
+		/* Later serials only push the real events through */
+		if (events[i].stamp.serial > PUSHER)
+			continue;
+		if (events[i].num_records != 2 ||
+		    events[i].stamp.serial != (unsigned long)
+			__atomic_load_n(&delivered, __ATOMIC_SEQ_CST) + real + 1)
+			__atomic_add_fetch(&bad, 1, __ATOMIC_SEQ_CST);
+		real++;
+	}
+	batch_seen(real);
+}
+
+static void wait_for(int want)
+{
+	int i;
+
+	for (i = 0; i < 500 && __atomic_load_n(&delivered, __ATOMIC_SEQ_CST)
+							< want; i++)
+		usleep(10000);
+}
+
+/* Each unit is one record, or one event of two records when feeding */
+static void write_units(FILE *f, int first, int cnt, int events)
+{
+	int i;
+
+	for (i = first; i < first + cnt; i++) {
+		fprintf(f, "type=SYSCALL msg=audit(1700000000.%03d:%d): "
+			"arch=c000003e syscall=2 success=yes exit=3 pid=%d\n",
+			i % 1000, i, i);
+		if (events)
+			fprintf(f, "type=EOE msg=audit(1700000000.%03d:%d): \n",
+				i % 1000, i);
+	}
+	fflush(f);
+}
+
+static int events_mode;
+static unsigned long long lone_usec;
+
+static void *writer(void *arg)
+{
+	FILE *f = fdopen(*(int *)arg, "w");
+
+	if (f == NULL)
+		return NULL;
+
+	/* Three units never fill a batch, so they wait out the latency.
+	 * auparse hands an event over once the next one starts, so the
+	 * last event of each group waits for what follows it. */
+	lone_usec = now_usec();
+	write_units(f, 1, 3, events_mode);
+	wait_for(3 - events_mode);
+
+	/* A burst is split into batches no bigger than the maximum */
+	write_units(f, 4, BURST, events_mode);
+	if (events_mode)
+		write_units(f, PUSHER + 1, 1, events_mode);
+	wait_for(3 + BURST);
+	fclose(f);
+	return NULL;
+}
+
+static int run(int events)
+{
+	pthread_t thread;
+	int fds[2], rc;
+
+	events_mode = events;
+	if (pipe(fds) || auplugin_init(fds[0], 1024, AUPLUGIN_Q_IN_MEMORY,
+				       NULL)) {
+		fprintf(stderr, "auplugin_init failed\n");
+		return 1;
+	}
+	pthread_create(&thread, NULL, writer, &fds[1]);
+
+	/* Returns when the inbound side hits end of file */
+	if (events)
+		rc = auplugin_event_feed_batch(event_cb, MAX_BATCH, LATENCY,
+					       0, NULL);
+	else
+		rc = auplugin_event_loop_batch(record_cb, MAX_BATCH, LATENCY);
+	if (rc) {
+		fprintf(stderr, "batch loop failed\n");
+		return 1;
+	}
+	pthread_join(thread, NULL);
+
+	if (delivered != 3 + BURST || too_big || bad) {
+		fprintf(stderr, "%s: %d of %d delivered, %d too big, %d bad\n",
+			events ? "events" : "records", delivered, 3 + BURST,
+			too_big, bad);
+		return 1;
+	}
+	/* The first units were held for the batch to fill */
+	if (first_usec - lone_usec < LATENCY * 1000 * 3 / 4) {
+		fprintf(stderr, "partial batch came after %llu usec\n",
+			first_usec - lone_usec);
+		return 1;
+	}
+	if (batches < (3 + BURST + MAX_BATCH - 1) / MAX_BATCH + 1) {
+		fprintf(stderr, "only %d batches\n", batches);
+		return 1;
+	}
+	printf("%s: %d in %d batches\n", events ? "events" : "records",
+	       delivered, batches);
+	fflush(stdout);
+	return 0;
+}
+
+int main(void)
+{
+	int i, status, rc = 0;
+
+	if (auplugin_event_loop_batch(record_cb, 0, LATENCY) != -1 ||
+	    auplugin_event_feed_batch(event_cb, 0, LATENCY, 0, NULL) != -1) {
+		fprintf(stderr, "a batch size of 0 was accepted\n");
+		return 1;
+	}
+
+	/* The library only runs one event loop per process */
+	for (i = 0; i < 2; i++) {
+		pid_t pid = fork();
+
+		if (pid < 0)
+			return 1;
+		if (pid == 0)
+			_exit(run(i));
+		if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+				WEXITSTATUS(status))
+			rc = 1;
+	}
+	return rc;
+}
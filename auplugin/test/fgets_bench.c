@@ -0,0 +1,130 @@
+/* fgets_bench.c -- compare the copy and view paths of auplugin_fgets
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; see the file COPYING.lib. If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor
+ * Boston, MA 02110-1335, USA.
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <auplugin.h>
+
+/*
+ * Build an in-memory log by repeating auparse/test/test.log and read it
+ * back through MEM_MMAP_FILE so only the line handling is measured.
+ * Usage: fgets_bench [megabytes]
+ */
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *load_corpus(size_t want, size_t *size)
+{
+	const char *srcdir = getenv("srcdir") ? getenv("srcdir") : ".";
+	char path[512], *log, *corpus;
+	size_t len = 0, off = 0;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/../../auparse/test/test.log", srcdir);
+	f = fopen(path, "r");
+	if (f == NULL)
+		return NULL;
+	log = malloc(65536);
+	if (log)
+		len = fread(log, 1, 65536, f);
+	fclose(f);
+	if (len == 0) {
+		free(log);
+		return NULL;
+	}
+
+	corpus = mmap(NULL, want, PROT_READ|PROT_WRITE,
+		      MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (corpus == MAP_FAILED) {
+		free(log);
+		return NULL;
+	}
+	while (off + len <= want) {
+		memcpy(corpus + off, log, len);
+		off += len;
+	}
+	free(log);
+	*size = off;
+	return corpus;
+}
+
+static void report(const char *name, unsigned long lines, size_t bytes,
+		   double secs)
+{
+	printf("%-5s %10lu lines %8.1f MB/s %10.0f lines/s\n", name, lines,
+	       bytes / secs / (1024 * 1024), lines / secs);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t size, want = 64;
+	char *corpus, buf[MAX_AUDIT_MESSAGE_LENGTH];
+	auplugin_fgets_state_t *st;
+	unsigned long lines;
+	const char *line;
+	size_t len;
+	double start;
+
+	if (argc > 1)
+		want = strtoul(argv[1], NULL, 10);
+	want *= 1024 * 1024;
+	corpus = load_corpus(want, &size);
+	if (corpus == NULL) {
+		fprintf(stderr, "Unable to build corpus\n");
+		return 1;
+	}
+
+	st = auplugin_fgets_init();
+	auplugin_setvbuf_r(st, corpus, size, MEM_MMAP_FILE);
+	lines = 0;
+	start = now();
+	do {
+		if (auplugin_fgets_r(st, buf, sizeof(buf), -1) > 0)
+			lines++;
+	} while (!auplugin_fgets_eof_r(st));
+	report("copy", lines, size, now() - start);
+	free(st);
+
+	st = auplugin_fgets_init();
+	auplugin_setvbuf_r(st, corpus, size, MEM_MMAP_FILE);
+	lines = 0;
+	start = now();
+	do {
+		if (auplugin_fgets_view_r(st, &line, &len, -1) == 1)
+			lines++;
+	} while (!auplugin_fgets_eof_r(st));
+	report("view", lines, size, now() - start);
+	free(st);
+
+	munmap(corpus, want);
+	return 0;
+}
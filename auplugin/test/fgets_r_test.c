@@ -118,11 +118,99 @@ static void test_mmap_file(void)
 	close(fd);
 }
 
+static void test_view_lines(void)
+{
+	int fds[2];
+	char buf[256];
+	char longline[200];
+	const char *line;
+	size_t len;
+	auplugin_fgets_state_t *st;
+
+	assert(pipe(fds) == 0);
+	st = auplugin_fgets_init();
+	assert(st);
+
+	/* a line long enough to cross several vector widths */
+	memset(longline, 'x', sizeof(longline) - 2);
+	longline[sizeof(longline) - 2] = '\n';
+	longline[sizeof(longline) - 1] = 0;
+
+	const char *input = "one\ntwo\n";
+	assert(write(fds[1], input, strlen(input)) == (ssize_t)strlen(input));
+	assert(write(fds[1], longline, strlen(longline)) ==
+	       (ssize_t)strlen(longline));
+	assert(write(fds[1], "tail", 4) == 4);
+	close(fds[1]);
+
+	/* views point into the internal buffer without a copy */
+	assert(auplugin_fgets_view_r(st, &line, &len, fds[0]) == 1);
+	assert(len == 4 && memcmp(line, "one\n", 4) == 0);
+
+	/* the copy and view paths can be mixed */
+	assert(auplugin_fgets_r(st, buf, sizeof(buf), fds[0]) == 4);
+	assert(strcmp(buf, "two\n") == 0);
+
+	assert(auplugin_fgets_view_r(st, &line, &len, fds[0]) == 1);
+	assert(len == strlen(longline));
+	assert(memcmp(line, longline, len) == 0);
+
+	/* no newline: the remainder comes back once EOF is seen */
+	assert(auplugin_fgets_view_r(st, &line, &len, fds[0]) == 1);
+	assert(auplugin_fgets_eof_r(st) == 1);
+	assert(len == 4 && memcmp(line, "tail", 4) == 0);
+	assert(auplugin_fgets_view_r(st, &line, &len, fds[0]) == 0);
+
+	close(fds[0]);
+	auplugin_fgets_destroy(st);
+}
+
+static void test_view_mmap_file(void)
+{
+	const char *srcdir = getenv("srcdir") ? getenv("srcdir") : ".";
+	char path[512];
+	const char *line;
+	size_t len;
+	int fd, lines = 0;
+	auplugin_fgets_state_t *st;
+	struct stat sb;
+
+	snprintf(path, sizeof(path), "%s/../../auparse/test/test.log", srcdir);
+	fd = open(path, O_RDONLY);
+	assert(fd >= 0);
+	assert(fstat(fd, &sb) == 0);
+	void *base = mmap(NULL, sb.st_size, PROT_READ | PROT_WRITE,
+			  MAP_PRIVATE, fd, 0);
+	if (base == MAP_FAILED)
+		exit(1);
+
+	st = auplugin_fgets_init();
+	assert(st);
+	assert(auplugin_setvbuf_r(st, base, sb.st_size, MEM_MMAP_FILE) == 0);
+
+	do {
+		if (auplugin_fgets_view_r(st, &line, &len, fd) == 1) {
+			assert(line[len - 1] == '\n');
+			if (lines == 0)
+				assert(strncmp(line, "type=AVC", 8) == 0);
+			lines++;
+		}
+	} while (!auplugin_fgets_eof_r(st));
+
+	/* views are not limited by a caller buffer, so no line is split */
+	assert(lines == 12);
+
+	auplugin_fgets_destroy(st);
+	close(fd);
+}
+
 int main(void)
 {
 	test_basic_state();
 	test_deferred_compaction();
 	test_mmap_file();
+	test_view_lines();
+	test_view_mmap_file();
 	printf("audit-fgets_r tests: all passed\n");
 	return 0;
 }
@@ -6,10 +6,22 @@ static void cb(unsigned int depth, unsigned int max, int ovf)
     printf("depth=%u max=%u ovf=%d\n", depth, max, ovf);
 }
 
+static int metrics_called;
+
+static void mcb(const auplugin_metrics_t *m)
+{
+    metrics_called = 1;
+    printf("records=%llu events=%llu\n", m->records, m->events);
+}
+
 int main(void)
 {
     auplugin_register_stats_callback(cb);
+    auplugin_register_metrics_callback(mcb);
     auplugin_report_stats();
+    if (!metrics_called)
+        return 1;
+    auplugin_write_metrics(stdout);
     return 0;
 }
 
@@ -0,0 +1,123 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <auplugin.h>
+
+#define EVENTS 2000
+
+static int events, bad, in_callback, overlap;
+
+static void event_cb(auparse_state_t *au, auparse_cb_event_t type, void *data)
+{
+	if (type != AUPARSE_CB_EVENT_READY)
+		return;
+	if (__atomic_add_fetch(&in_callback, 1, __ATOMIC_SEQ_CST) > 1)
+		__atomic_add_fetch(&overlap, 1, __ATOMIC_SEQ_CST);
+	/* Later serials only push the real events through */
+	if (auparse_get_timestamp(au)->serial > EVENTS)
+		goto out;
+	if (auparse_get_num_records(au) != 3)
+		__atomic_add_fetch(&bad, 1, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&events, 1, __ATOMIC_SEQ_CST);
+out:
+	__atomic_sub_fetch(&in_callback, 1, __ATOMIC_SEQ_CST);
+}
+
+/* Interleave the records of neighbouring events like a busy system does */
+static void *writer(void *arg)
+{
+	int fd = *(int *)arg;
+	FILE *f = fdopen(fd, "w");
+	int i;
+
+	if (f == NULL)
+		return NULL;
+	for (i = 1; i <= EVENTS; i += 2) {
+		fprintf(f, "type=SYSCALL msg=audit(1700000000.%03d:%d): "
+			"arch=c000003e syscall=2 success=yes exit=3 pid=%d "
+			"auid=1000 uid=0 comm=\"cat\" exe=\"/usr/bin/cat\"\n",
+			i % 1000, i, i);
+		fprintf(f, "type=SYSCALL msg=audit(1700000000.%03d:%d): "
+			"arch=c000003e syscall=2 success=yes exit=3 pid=%d "
+			"auid=1000 uid=0 comm=\"cat\" exe=\"/usr/bin/cat\"\n",
+			(i + 1) % 1000, i + 1, i + 1);
+		fprintf(f, "type=CWD msg=audit(1700000000.%03d:%d): "
+			"cwd=\"/root\"\n", i % 1000, i);
+		fprintf(f, "type=CWD msg=audit(1700000000.%03d:%d): "
+			"cwd=\"/tmp\"\n", (i + 1) % 1000, i + 1);
+		fprintf(f, "type=EOE msg=audit(1700000000.%03d:%d): \n",
+			i % 1000, i);
+		fprintf(f, "type=EOE msg=audit(1700000000.%03d:%d): \n",
+			(i + 1) % 1000, i + 1);
+	}
+	for (i = EVENTS + 1; i <= EVENTS + 64; i++)
+		fprintf(f, "type=EOE msg=audit(1700000001.%03d:%d): \n",
+			i % 1000, i);
+	fflush(f);
+
+	/* End of file stops the plugin, so wait for the pool to catch up */
+	for (i = 0; i < 500 && __atomic_load_n(&events, __ATOMIC_SEQ_CST)
+							< EVENTS; i++)
+		usleep(10000);
+	fclose(f);
+	return NULL;
+}
+
+static int run(unsigned int count, int flags)
+{
+	auplugin_metrics_t m;
+	pthread_t thread;
+	int fds[2];
+
+	if (pipe(fds) || auplugin_init(fds[0], 16384, AUPLUGIN_Q_IN_MEMORY,
+				       NULL)) {
+		fprintf(stderr, "auplugin_init failed\n");
+		return 1;
+	}
+	if (auplugin_set_workers(count, flags)) {
+		fprintf(stderr, "auplugin_set_workers failed\n");
+		return 1;
+	}
+	pthread_create(&thread, NULL, writer, &fds[1]);
+
+	/* Returns when the inbound side hits end of file */
+	if (auplugin_event_feed(event_cb, 0, NULL)) {
+		fprintf(stderr, "auplugin_event_feed failed\n");
+		return 1;
+	}
+	pthread_join(thread, NULL);
+
+	if (events != EVENTS || bad) {
+		fprintf(stderr, "%u workers: %d of %d events, %d bad\n",
+			count, events, EVENTS, bad);
+		return 1;
+	}
+	if ((flags & AUPLUGIN_CB_ORDERED) && overlap) {
+		fprintf(stderr, "ordered callbacks overlapped %d times\n",
+			overlap);
+		return 1;
+	}
+	auplugin_get_metrics(&m);
+	if (m.records != EVENTS * 3 + 64 || m.events < EVENTS ||
+	    m.eoe_events < EVENTS || m.callbacks < m.events) {
+		fprintf(stderr, "metrics: %llu records %llu events %llu eoe\n",
+			m.records, m.events, m.eoe_events);
+		return 1;
+	}
+	printf("%u workers%s: %d events\n", count,
+	       flags & AUPLUGIN_CB_ORDERED ? " ordered" : "", events);
+	return 0;
+}
+
+int main(void)
+{
+	if (auplugin_set_workers(4, 0) == 0) {
+		fprintf(stderr, "workers allowed without thread safe callback\n");
+		return 1;
+	}
+	/* The library only runs one event loop per process */
+	return run(4, AUPLUGIN_CB_THREAD_SAFE | AUPLUGIN_CB_ORDERED);
+}
@@ -256,6 +256,236 @@ typedef struct {
     auparse_state_t *au;
 } AuParser;
 
+/*
+ * Columns filled by auparse_get_batch, shared by get_batch() and the
+ * iterator events() returns. The field names are kept in a tuple so the
+ * strings handed to auparse stay alive as long as the buffers do.
+ */
+typedef struct {
+    auparse_batch_t b;
+    const char **names;
+    PyObject *keys;
+    unsigned int nfields;
+} BatchBuf;
+
+static void
+batch_buf_free(BatchBuf *bb)
+{
+    PyMem_Free(bb->names);
+    PyMem_Free(bb->b.sec);
+    PyMem_Free(bb->b.milli);
+    PyMem_Free(bb->b.serial);
+    PyMem_Free(bb->b.type);
+    PyMem_Free(bb->b.value);
+    PyMem_Free(bb->b.interp);
+    PyMem_Free(bb->b.heap);
+    Py_CLEAR(bb->keys);
+    memset(bb, 0, sizeof(*bb));
+}
+
+static int
+batch_buf_init(BatchBuf *bb, PyObject *fields, unsigned int size, int interpret)
+{
+    Py_ssize_t i, n;
+
+    memset(bb, 0, sizeof(*bb));
+    if (size == 0) {
+        PyErr_SetString(PyExc_ValueError, "size must be greater than 0");
+        return -1;
+    }
+    if ((bb->keys = PySequence_Tuple(fields)) == NULL) return -1;
+    n = PyTuple_GET_SIZE(bb->keys);
+    bb->nfields = n;
+    if ((bb->names = PyMem_New(const char *, n + 1)) == NULL) goto nomem;
+    for (i = 0; i < n; i++) {
+        PyObject *item = PyTuple_GET_ITEM(bb->keys, i);
+
+        if (!PYSTR_CHECK(item)) {
+            PyErr_SetString(PyExc_ValueError, "fields must be strings");
+            goto err;
+        }
+        if ((bb->names[i] = PYSTR_ASSTRING(item)) == NULL) goto err;
+    }
+    bb->names[n] = NULL;
+
+    bb->b.fields = bb->names;
+    bb->b.size = size;
+    bb->b.sec = PyMem_New(time_t, size);
+    bb->b.milli = PyMem_New(unsigned int, size);
+    bb->b.serial = PyMem_New(unsigned long, size);
+    bb->b.type = PyMem_New(int, size);
+    bb->b.value = PyMem_New(size_t, (size_t)size * n + 1);
+    if (interpret)
+        bb->b.interp = PyMem_New(size_t, (size_t)size * n + 1);
+    // Room for 64 bytes a field, it grows if events need more
+    bb->b.heap_size = (size_t)size * (n + 1) * 64;
+    bb->b.heap = PyMem_Malloc(bb->b.heap_size);
+    if (bb->b.sec == NULL || bb->b.milli == NULL || bb->b.serial == NULL ||
+        bb->b.type == NULL || bb->b.value == NULL || bb->b.heap == NULL ||
+        (interpret && bb->b.interp == NULL))
+        goto nomem;
+    return 0;
+nomem:
+    PyErr_NoMemory();
+err:
+    batch_buf_free(bb);
+    return -1;
+}
+
+/*
+ * Fill the columns with the next events. The GIL is released while
+ * auparse reads and parses so other threads can run. Returns the rows
+ * filled, 0 at the end of the events, or -1 with an exception set.
+ */
+static int
+batch_buf_fill(auparse_state_t *au, BatchBuf *bb)
+{
+    int rc, err;
+
+    for (;;) {
+        Py_BEGIN_ALLOW_THREADS
+        rc = auparse_get_batch(au, &bb->b);
+        err = errno;
+        Py_END_ALLOW_THREADS
+        if (rc >= 0) return rc;
+        if (err == ENOSPC) {
+            // One event is bigger than the heap, double it and retry
+            char *heap = PyMem_Realloc(bb->b.heap, bb->b.heap_size * 2);
+
+            if (heap == NULL) {
+                PyErr_NoMemory();
+                return -1;
+            }
+            bb->b.heap = heap;
+            bb->b.heap_size *= 2;
+            continue;
+        }
+        errno = err;
+        PyErr_SetFromErrno(PyExc_EnvironmentError);
+        return -1;
+    }
+}
+
+static PyObject *
+batch_buf_str(const BatchBuf *bb, size_t off)
+{
+    const char *s;
+
+    if (off == AUPARSE_BATCH_NONE) Py_RETURN_NONE;
+    s = bb->b.heap + off;
+    return PyUnicode_DecodeUTF8(s, strlen(s), "surrogateescape");
+}
+
+/* Value of field f in row i, interpreted if that was asked for */
+static PyObject *
+batch_buf_value(const BatchBuf *bb, unsigned int f, unsigned int i)
+{
+    size_t *col = bb->b.interp ? bb->b.interp : bb->b.value;
+
+    return batch_buf_str(bb, col[(size_t)f * bb->b.size + i]);
+}
+
+static PyObject *
+batch_buf_row(const BatchBuf *bb, unsigned int i, int as_dict)
+{
+    PyObject *row, *item;
+    unsigned int f;
+
+    if (as_dict) {
+        if ((row = PyDict_New()) == NULL) return NULL;
+        if ((item = Py_BuildValue("l", (long)bb->b.sec[i])) == NULL ||
+            PyDict_SetItemString(row, "sec", item)) goto err;
+        Py_DECREF(item);
+        if ((item = Py_BuildValue("I", bb->b.milli[i])) == NULL ||
+            PyDict_SetItemString(row, "milli", item)) goto err;
+        Py_DECREF(item);
+        if ((item = Py_BuildValue("k", bb->b.serial[i])) == NULL ||
+            PyDict_SetItemString(row, "serial", item)) goto err;
+        Py_DECREF(item);
+        if ((item = Py_BuildValue("i", bb->b.type[i])) == NULL ||
+            PyDict_SetItemString(row, "type", item)) goto err;
+        Py_DECREF(item);
+        for (f = 0; f < bb->nfields; f++) {
+            if ((item = batch_buf_value(bb, f, i)) == NULL ||
+                PyDict_SetItem(row, PyTuple_GET_ITEM(bb->keys, f), item))
+                goto err;
+            Py_DECREF(item);
+        }
+        return row;
+    }
+
+    if ((row = PyTuple_New(4 + bb->nfields)) == NULL) return NULL;
+    PyTuple_SET_ITEM(row, 0, Py_BuildValue("l", (long)bb->b.sec[i]));
+    PyTuple_SET_ITEM(row, 1, Py_BuildValue("I", bb->b.milli[i]));
+    PyTuple_SET_ITEM(row, 2, Py_BuildValue("k", bb->b.serial[i]));
+    PyTuple_SET_ITEM(row, 3, Py_BuildValue("i", bb->b.type[i]));
+    for (f = 0; f < bb->nfields; f++)
+        PyTuple_SET_ITEM(row, 4 + f, batch_buf_value(bb, f, i));
+    for (f = 0; f < 4 + bb->nfields; f++) {
+        if (PyTuple_GET_ITEM(row, f) == NULL) {
+            Py_DECREF(row);
+            return NULL;
+        }
+    }
+    return row;
+err:
+    Py_XDECREF(item);
+    Py_DECREF(row);
+    return NULL;
+}
+
+/*===========================================================================
+ *                                AuEventIter
+ *===========================================================================*/
+
+typedef struct {
+    PyObject_HEAD
+    AuParser *parser;
+    BatchBuf bb;
+    int as_dict;
+    unsigned int pos;
+} AuEventIter;
+
+static void
+AuEventIter_dealloc(AuEventIter *self)
+{
+    batch_buf_free(&self->bb);
+    Py_XDECREF(self->parser);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject *
+AuEventIter_next(AuEventIter *self)
+{
+    if (self->pos >= self->bb.b.rows) {
+        int rc;
+
+        if (self->parser->au == NULL) {
+            PyErr_SetString(NoParserError, "object has no parser associated with it");
+            return NULL;
+        }
+        rc = batch_buf_fill(self->parser->au, &self->bb);
+        if (rc <= 0) return NULL;
+        self->pos = 0;
+    }
+    return batch_buf_row(&self->bb, self->pos++, self->as_dict);
+}
+
+PyDoc_STRVAR(AuEventIter_doc,
+"Iterator over events returned by AuParser.events()\n\
+");
+
+static PyTypeObject AuEventIterType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "auparse.AuEventIter",
+    .tp_basicsize = sizeof(AuEventIter),
+    .tp_dealloc = (destructor)AuEventIter_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = AuEventIter_doc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc)AuEventIter_next,
+};
+
 typedef struct {
     AuParser *py_AuParser;
     PyObject *func;
@@ -1199,6 +1429,117 @@ AuParser_parse_next_event(AuParser *self)
     return NULL;
 }
 
+/********************************
+ * auparse_get_batch
+ ********************************/
+PyDoc_STRVAR(events_doc,
+"events(fields, as_dict=False, interpret=False, batch=256) Iterate over events.\n\
+\n\
+events() returns an iterator that yields every remaining event, or every\n\
+event matching the search criteria if any were added. Each event is a\n\
+tuple of (sec, milli, serial, type, value, ...) with one value for each\n\
+name in the fields sequence, or a dict with those keys when as_dict is\n\
+True. type is the type of the event's first record. A value is taken\n\
+from the first record in the event that has the field and is None if\n\
+no record has it. When interpret is True the values are interpreted.\n\
+\n\
+Events are parsed batch at a time, without holding the GIL, so this is\n\
+much faster than walking fields one call at a time. The parser must not\n\
+be used in another thread while iterating.\n\
+\n\
+Raises exception (EnvironmentError) on error.\n\
+");
+static PyObject *
+AuParser_events(AuParser *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"fields", "as_dict", "interpret", "batch", NULL};
+    PyObject *fields;
+    int as_dict = 0, interpret = 0;
+    unsigned int batch = 256;
+    AuEventIter *iter;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|ppI:events", kwlist,
+                                     &fields, &as_dict, &interpret, &batch))
+        return NULL;
+    PARSER_CHECK;
+    iter = PyObject_New(AuEventIter, &AuEventIterType);
+    if (iter == NULL) return NULL;
+    memset(&iter->bb, 0, sizeof(iter->bb));
+    Py_INCREF(self);
+    iter->parser = self;
+    iter->as_dict = as_dict;
+    iter->pos = 0;
+    if (batch_buf_init(&iter->bb, fields, batch, interpret)) {
+        Py_DECREF(iter);
+        return NULL;
+    }
+    return (PyObject *)iter;
+}
+
+PyDoc_STRVAR(get_batch_doc,
+"get_batch(fields, size=1024, interpret=False) Read events into columns.\n\
+\n\
+get_batch() reads up to size of the next events and returns them as a\n\
+dict of lists, one row per event. The sec, milli, serial and type keys\n\
+hold the timestamp and first record type of each event, and each name\n\
+in the fields sequence holds that field's values as described for\n\
+events(). The lists are ready to hand to column oriented tools.\n\
+\n\
+Returns None if there are no more events.\n\
+Raises exception (EnvironmentError) on error.\n\
+");
+static PyObject *
+AuParser_get_batch(AuParser *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"fields", "size", "interpret", NULL};
+    static const char *event_cols[] = {"sec", "milli", "serial", "type"};
+    PyObject *fields, *cols = NULL, *col;
+    int interpret = 0, rc;
+    unsigned int size = 1024, i, f;
+    BatchBuf bb;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|Ip:get_batch", kwlist,
+                                     &fields, &size, &interpret))
+        return NULL;
+    PARSER_CHECK;
+    if (batch_buf_init(&bb, fields, size, interpret)) return NULL;
+    if ((rc = batch_buf_fill(self->au, &bb)) <= 0) {
+        batch_buf_free(&bb);
+        if (rc < 0) return NULL;
+        Py_RETURN_NONE;
+    }
+
+    if ((cols = PyDict_New()) == NULL) goto err;
+    for (f = 0; f < 4 + bb.nfields; f++) {
+        if ((col = PyList_New(rc)) == NULL) goto err;
+        if (f < 4 ? PyDict_SetItemString(cols, event_cols[f], col) :
+            PyDict_SetItem(cols, PyTuple_GET_ITEM(bb.keys, f - 4), col)) {
+            Py_DECREF(col);
+            goto err;
+        }
+        Py_DECREF(col);
+        for (i = 0; i < (unsigned int)rc; i++) {
+            PyObject *item;
+
+            switch (f) {
+            case 0: item = Py_BuildValue("l", (long)bb.b.sec[i]); break;
+            case 1: item = Py_BuildValue("I", bb.b.milli[i]); break;
+            case 2: item = Py_BuildValue("k", bb.b.serial[i]); break;
+            case 3: item = Py_BuildValue("i", bb.b.type[i]); break;
+            default: item = batch_buf_value(&bb, f - 4, i); break;
+            }
+            if (item == NULL) goto err;
+            PyList_SET_ITEM(col, i, item);
+        }
+    }
+    batch_buf_free(&bb);
+    return cols;
+err:
+    Py_XDECREF(cols);
+    batch_buf_free(&bb);
+    return NULL;
+}
+
 
 
 /********************************
@@ -2321,6 +2662,8 @@ static PyMethodDef AuParser_methods[] = {
     {"search_clear",      (PyCFunction)AuParser_search_clear,      METH_NOARGS,  search_clear_doc},
     {"search_next_event", (PyCFunction)AuParser_search_next_event, METH_NOARGS,  search_next_event_doc},
     {"parse_next_event",  (PyCFunction)AuParser_parse_next_event,  METH_NOARGS,  parse_next_event_doc},
+    {"events",            (PyCFunction)AuParser_events,            METH_VARARGS | METH_KEYWORDS, events_doc},
+    {"get_batch",         (PyCFunction)AuParser_get_batch,         METH_VARARGS | METH_KEYWORDS, get_batch_doc},
     {"aup_normalize",     (PyCFunction)AuParser_aup_normalize,     METH_VARARGS, aup_normalize_doc},
     {"aup_normalize_get_event_kind",  (PyCFunction)AuParser_aup_normalize_get_event_kind, METH_NOARGS, aup_normalize_get_event_kind_doc},
     {"aup_normalize_session",  (PyCFunction)AuParser_aup_normalize_session, METH_NOARGS, aup_normalize_session_doc},
@@ -2428,6 +2771,7 @@ PyInit_auparse(void)
 
     if (PyType_Ready(&AuEventType) < 0) MODINITERROR;
     if (PyType_Ready(&AuParserType) < 0) MODINITERROR;
+    if (PyType_Ready(&AuEventIterType) < 0) MODINITERROR;
 
     m = PyModule_Create(&auparse_def);
     if (m == NULL)
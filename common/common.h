@@ -1,5 +1,5 @@
 /* common.h -- common utility functions used throughout
- * Copyright 2018-24 Red Hat Inc.
+ * Copyright 2018-24,2026 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -62,8 +62,31 @@ AUDIT_HIDDEN_START
 
 char *audit_strsplit_r(char *s, char **savedpp);
 char *audit_strsplit(char *s);
+const char *audit_memchr(const char *s, int c, size_t n);
+
+/* What audit_escape_count looks for besides control characters */
+typedef enum { AUDIT_ESC_CTRL, AUDIT_ESC_SHELL, AUDIT_ESC_SHELL_QUOTE,
+	AUDIT_ESC_ENCODE } audit_esc_class_t;
+size_t audit_escape_count(const char *s, size_t n, audit_esc_class_t cls);
+size_t audit_hex_decode(char *dst, const char *src, size_t n);
+void audit_hex_encode(char *dst, const char *src, size_t n);
 int audit_is_last_record(int type);
 
+/* Where audit_parse_stamp found the pieces of a record's header */
+typedef struct audit_stamp {
+	const char *node;	// Node name or NULL, not nul terminated
+	size_t node_len;
+	const char *type;	// Text after type= or NULL, not nul terminated
+	size_t type_len;
+	const char *stamp;	// Text inside audit(), for error messages
+	size_t stamp_len;
+	time_t sec;
+	unsigned int milli;
+	unsigned long serial;
+} audit_stamp_t;
+int audit_parse_stamp(const char *line, size_t len, long max_sec,
+		      audit_stamp_t *st);
+
 extern const char *SINGLE;
 extern const char *HALT;
 void change_runlevel(const char *level);
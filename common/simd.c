@@ -0,0 +1,341 @@
+/* simd.c -- vectorized scanning helpers
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ *
+ */
+#include "config.h"
+#include <stddef.h>
+#include <string.h>
+#include "common.h"
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define AUDIT_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Audit records are scanned for a newline every time a line is read. The
+ * scans below look at 16 or 32 bytes per step. AVX2 is picked at runtime
+ * since distro builds can't assume it. Other platforms use the C library's
+ * memchr which is already vectorized for them.
+ */
+
+#ifdef AUDIT_X86_SIMD
+static const char *scan_sse2(const char *s, int c, size_t n)
+{
+	const __m128i needle = _mm_set1_epi8((char)c);
+	size_t i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+		if (mask)
+			return s + i + __builtin_ctz(mask);
+	}
+	for (; i < n; i++)
+		if (s[i] == (char)c)
+			return s + i;
+	return NULL;
+}
+
+__attribute__((target("avx2")))
+static const char *scan_avx2(const char *s, int c, size_t n)
+{
+	const __m256i needle = _mm256_set1_epi8((char)c);
+	size_t i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+					_mm256_cmpeq_epi8(v, needle));
+		if (mask)
+			return s + i + __builtin_ctz(mask);
+	}
+	if (i < n)
+		return scan_sse2(s + i, c, n - i);
+	return NULL;
+}
+#endif
+
+/*
+ * Find the first c in the n bytes at s. Returns a pointer to it or NULL.
+ */
+const char *audit_memchr(const char *s, int c, size_t n)
+{
+#ifdef AUDIT_X86_SIMD
+	if (n >= 64 && __builtin_cpu_supports("avx2"))
+		return scan_avx2(s, c, n);
+	return scan_sse2(s, c, n);
+#else
+	return memchr(s, c, n);
+#endif
+}
+
+
+/*
+ * Hex fields (proctitle, paths, execve args) and the escape checks done
+ * on every interpreted value used to be walked a byte at a time. The
+ * kernels below do 16 bytes per step with SSE2, and the escape check
+ * moves to AVX2 on long strings. Everything has a plain C version for
+ * other platforms and for the tails.
+ */
+
+static const char sh_set[] = "\"'`$\\!()| ";
+static const char quote_set[] = "\"'`$\\!()| ;#&*?[]<>{}";
+
+static inline int escape_byte(unsigned char c, audit_esc_class_t cls)
+{
+	switch (cls) {
+	case AUDIT_ESC_CTRL:
+		return c < 0x20;
+	case AUDIT_ESC_SHELL:
+		return c < 0x20 || (c && strchr(sh_set, c));
+	case AUDIT_ESC_SHELL_QUOTE:
+		return c < 0x20 || (c && strchr(quote_set, c));
+	case AUDIT_ESC_ENCODE:
+		return c <= 0x20 || c >= 0x7F || c == '"';
+	}
+	return 0;
+}
+
+static size_t escape_count_c(const unsigned char *s, size_t n,
+			     audit_esc_class_t cls)
+{
+	size_t i, cnt = 0;
+
+	for (i = 0; i < n; i++)
+		cnt += escape_byte(s[i], cls);
+	return cnt;
+}
+
+static inline int hex_nibble(unsigned char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	c |= 0x20;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return 0;
+}
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+#ifdef AUDIT_X86_SIMD
+static const char *class_set(audit_esc_class_t cls)
+{
+	if (cls == AUDIT_ESC_SHELL)
+		return sh_set;
+	if (cls == AUDIT_ESC_SHELL_QUOTE)
+		return quote_set;
+	return "";
+}
+
+static size_t escape_count_sse2(const unsigned char *s, size_t n,
+				audit_esc_class_t cls)
+{
+	const char *set = class_set(cls);
+	__m128i needles[sizeof(quote_set)];
+	unsigned int j, nset = strlen(set);
+	size_t i = 0, cnt = 0;
+
+	for (j = 0; j < nset; j++)
+		needles[j] = _mm_set1_epi8(set[j]);
+	for (; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(s + i)), hit;
+
+		if (cls == AUDIT_ESC_ENCODE) {
+			// <= 0x20, >= 0x7F, or a double quote
+			hit = _mm_or_si128(
+			    _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x20)),
+					   v),
+			    _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x7F)),
+					   v));
+			hit = _mm_or_si128(hit,
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+		} else {
+			hit = _mm_cmpeq_epi8(_mm_min_epu8(v,
+						_mm_set1_epi8(0x1F)), v);
+			for (j = 0; j < nset; j++)
+				hit = _mm_or_si128(hit,
+					_mm_cmpeq_epi8(v, needles[j]));
+		}
+		cnt += __builtin_popcount(_mm_movemask_epi8(hit));
+	}
+	return cnt + escape_count_c(s + i, n - i, cls);
+}
+
+__attribute__((target("avx2")))
+static size_t escape_count_avx2(const unsigned char *s, size_t n,
+				audit_esc_class_t cls)
+{
+	const char *set = class_set(cls);
+	__m256i needles[sizeof(quote_set)];
+	unsigned int j, nset = strlen(set);
+	size_t i = 0, cnt = 0;
+
+	for (j = 0; j < nset; j++)
+		needles[j] = _mm256_set1_epi8(set[j]);
+	for (; i + 32 <= n; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(s + i)), hit;
+
+		if (cls == AUDIT_ESC_ENCODE) {
+			hit = _mm256_or_si256(
+			    _mm256_cmpeq_epi8(_mm256_min_epu8(v,
+					_mm256_set1_epi8(0x20)), v),
+			    _mm256_cmpeq_epi8(_mm256_max_epu8(v,
+					_mm256_set1_epi8(0x7F)), v));
+			hit = _mm256_or_si256(hit,
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+		} else {
+			hit = _mm256_cmpeq_epi8(_mm256_min_epu8(v,
+						_mm256_set1_epi8(0x1F)), v);
+			for (j = 0; j < nset; j++)
+				hit = _mm256_or_si256(hit,
+					_mm256_cmpeq_epi8(v, needles[j]));
+		}
+		cnt += __builtin_popcount(
+				(unsigned int)_mm256_movemask_epi8(hit));
+	}
+	return cnt + escape_count_sse2(s + i, n - i, cls);
+}
+
+/* Turn 16 hex digits into their nibble values, non hex digits become 0 */
+static inline __m128i hex_nibbles_sse2(__m128i v)
+{
+	__m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+	__m128i l = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)),
+				 _mm_set1_epi8('a'));
+	__m128i is_d = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+	__m128i is_l = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+
+	return _mm_or_si128(_mm_and_si128(is_d, d),
+		_mm_and_si128(is_l, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+
+/* Pair up nibbles into 8 bytes, high nibble first */
+static inline __m128i hex_pack_sse2(__m128i nib)
+{
+	__m128i hi = _mm_slli_epi16(_mm_and_si128(nib,
+					_mm_set1_epi16(0x00FF)), 4);
+	__m128i lo = _mm_srli_epi16(nib, 8);
+
+	return _mm_or_si128(hi, lo);
+}
+
+static size_t hex_decode_sse2(unsigned char *dst, const unsigned char *src,
+			      size_t n)
+{
+	size_t i = 0;
+
+	// dst may be src, each store lands behind what was already loaded
+	for (; i + 32 <= n; i += 32) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + i + 16));
+		__m128i out = _mm_packus_epi16(
+				hex_pack_sse2(hex_nibbles_sse2(a)),
+				hex_pack_sse2(hex_nibbles_sse2(b)));
+
+		_mm_storeu_si128((__m128i *)(dst + i / 2), out);
+	}
+	return i / 2;
+}
+
+static size_t hex_encode_sse2(char *dst, const unsigned char *src, size_t n)
+{
+	const __m128i mask = _mm_set1_epi8(0x0F), nine = _mm_set1_epi8(9);
+	size_t i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+		__m128i lo = _mm_and_si128(v, mask);
+
+		// 0-9 become '0'-'9', 10-15 skip ahead 7 more to 'A'-'F'
+		hi = _mm_add_epi8(_mm_add_epi8(hi, _mm_set1_epi8('0')),
+			_mm_and_si128(_mm_cmpgt_epi8(hi, nine),
+				      _mm_set1_epi8(7)));
+		lo = _mm_add_epi8(_mm_add_epi8(lo, _mm_set1_epi8('0')),
+			_mm_and_si128(_mm_cmpgt_epi8(lo, nine),
+				      _mm_set1_epi8(7)));
+		_mm_storeu_si128((__m128i *)(dst + 2 * i),
+				 _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i *)(dst + 2 * i + 16),
+				 _mm_unpackhi_epi8(hi, lo));
+	}
+	return i;
+}
+#endif
+
+/*
+ * Count the bytes of s that need escaping for the given class. Only the
+ * first n bytes are looked at, nul bytes count as control characters.
+ */
+size_t audit_escape_count(const char *s, size_t n, audit_esc_class_t cls)
+{
+	const unsigned char *u = (const unsigned char *)s;
+
+#ifdef AUDIT_X86_SIMD
+	if (n >= 64 && __builtin_cpu_supports("avx2"))
+		return escape_count_avx2(u, n, cls);
+	return escape_count_sse2(u, n, cls);
+#else
+	return escape_count_c(u, n, cls);
+#endif
+}
+
+/*
+ * Decode n hex digits from src into dst. Characters that are not hex
+ * digits decode as 0 and an odd digit at the end is the high nibble of
+ * the last byte. dst may be the same as src. Returns the bytes written.
+ */
+size_t audit_hex_decode(char *dst, const char *src, size_t n)
+{
+	unsigned char *d = (unsigned char *)dst;
+	const unsigned char *s = (const unsigned char *)src;
+	size_t i = 0, j = 0;
+
+#ifdef AUDIT_X86_SIMD
+	j = hex_decode_sse2(d, s, n);
+	i = j * 2;
+#endif
+	for (; i + 1 < n; i += 2)
+		d[j++] = (hex_nibble(s[i]) << 4) | hex_nibble(s[i + 1]);
+	if (i < n)
+		d[j++] = hex_nibble(s[i]) << 4;
+	return j;
+}
+
+/*
+ * Encode n bytes from src as upper case hex into dst, which must have
+ * room for 2 * n characters. No terminator is written.
+ */
+void audit_hex_encode(char *dst, const char *src, size_t n)
+{
+	const unsigned char *s = (const unsigned char *)src;
+	size_t i = 0;
+
+#ifdef AUDIT_X86_SIMD
+	i = hex_encode_sse2(dst, s, n);
+#endif
+	for (; i < n; i++) {
+		dst[2 * i] = hex_digits[s[i] >> 4];
+		dst[2 * i + 1] = hex_digits[s[i] & 0x0F];
+	}
+}
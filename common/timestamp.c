@@ -0,0 +1,172 @@
+/* timestamp.c -- find the time stamp of an audit record
+ * Copyright 2026 Red Hat Inc.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Steve Grubb <sgrubb@redhat.com>
+ *
+ */
+#include "config.h"
+#include <string.h>
+#include "common.h"
+#pragma GCC optimize("O3")
+
+/*
+ * Return the next space separated word in [*pp, *endp) and its length.
+ * A nul ends the line early, just like the copy the old code made did.
+ */
+static const char *next_word(const char **pp, const char **endp,
+			     size_t *wlen)
+{
+	const char *p = *pp, *end = *endp, *w;
+
+	while (p < end && *p == ' ')
+		p++;
+	if (p == end || *p == 0) {
+		*endp = p;
+		return NULL;
+	}
+	w = p;
+	while (p < end && *p != ' ' && *p)
+		p++;
+	if (p < end && *p == 0)
+		*endp = p;
+	*wlen = p - w;
+	*pp = p;
+	return w;
+}
+
+/*
+ * Convert a number the way strtoul(s, NULL, 10) would, including the
+ * leading white space and sign it allows. Returns -1 where strtoul
+ * would set ERANGE.
+ */
+static int stamp_ul(const char *p, const char *end, unsigned long *val)
+{
+	unsigned long v = 0;
+	int neg = 0, over = 0;
+
+	// A word has no spaces, but the other white space can be there
+	while (p < end && (*p == '\t' || *p == '\n' || *p == '\v' ||
+				*p == '\f' || *p == '\r'))
+		p++;
+	if (p < end && (*p == '+' || *p == '-')) {
+		neg = *p == '-';
+		p++;
+	}
+	for (; p < end && *p >= '0' && *p <= '9'; p++) {
+		unsigned int d = *p - '0';
+
+		if (v > ULONG_MAX / 10 ||
+				(v == ULONG_MAX / 10 && d > ULONG_MAX % 10))
+			over = 1;
+		v = v * 10 + d;
+	}
+	if (over)
+		return -1;
+	*val = neg ? -v : v;
+	return 0;
+}
+
+/*
+ * This function picks the node, type, and time stamp out of the
+ * "node=... type=... msg=audit(SEC.MILLI:SERIAL)" header of a record
+ * without copying it. Only the first 80 bytes are looked at, or 340 if
+ * there is a node name. Seconds past max_sec are an error.
+ *
+ * Returns 0 on success, 1 if there is no time stamp, and -1 if there is
+ * one that does not convert. The spans in st point into line.
+ */
+int audit_parse_stamp(const char *line, size_t len, long max_sec,
+		      audit_stamp_t *st)
+{
+	const char *p = line, *end, *w, *q, *dot, *colon;
+	unsigned long v;
+	size_t wlen;
+
+	st->node = NULL;
+	st->node_len = 0;
+	st->type = NULL;
+	st->type_len = 0;
+	st->stamp = NULL;
+	st->stamp_len = 0;
+	if (len && *line == 'n')
+		end = line + (len < 340 ? len : 340);
+	else
+		end = line + (len < 80 ? len : 80);
+
+	w = next_word(&p, &end, &wlen);
+	if (w == NULL)
+		return 1;
+	// Optionally grab the node - may or may not be included
+	if (*w == 'n' && wlen > 5) {
+		st->node = w + 5;
+		st->node_len = wlen - 5;
+		w = next_word(&p, &end, &wlen);
+		if (w == NULL)
+			return 1;
+	}
+
+	// at this point we have type=
+	if (wlen >= 5) {
+		st->type = w + 5;
+		st->type_len = wlen - 5;
+	}
+
+	// Now should be pointing to msg=
+	w = next_word(&p, &end, &wlen);
+	// length check is for fuzzers that make invalid lines
+	if (w == NULL || wlen < 19)
+		return 1;
+	if (w[9] == '(')
+		p = w + 10;
+	else {
+		p = memchr(w, '(', wlen);
+		if (p == NULL)
+			return 1;
+		p++;
+	}
+	q = memchr(p, ')', w + wlen - p);
+	if (q == NULL)
+		q = w + wlen;
+	st->stamp = p;
+	st->stamp_len = q - p;
+
+	if (stamp_ul(p, q, &v) || (time_t)v > max_sec)
+		return -1;
+	st->sec = v;
+	dot = memchr(p, '.', q - p);
+	if (dot) {
+		p = dot + 1;
+		if (stamp_ul(p, q, &v))
+			return -1;
+		// Check what au_event_t can hold, like the old code did
+		st->milli = v;
+		if (st->milli > 999)
+			return -1;
+	} else
+		st->milli = 0;
+
+	colon = memchr(p, ':', q - p);
+	if (colon) {
+		if (stamp_ul(colon + 1, q, &v))
+			return -1;
+		st->serial = v;
+	} else
+		st->serial = 0;
+	return 0;
+}
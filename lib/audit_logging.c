@@ -1,5 +1,5 @@
 /* audit_logging.c -- 
- * Copyright 2005-2008,2010,2011,2013,2017 Red Hat Inc.
+ * Copyright 2005-2008,2010,2011,2013,2017,2026 Red Hat Inc.
  * All Rights Reserved.
  *
  * This library is free software; you can redistribute it and/or
@@ -36,6 +36,7 @@
 
 #include "libaudit.h"
 #include "private.h"
+#include "common.h"
 
 #define TTY_PATH	32
 #define MAX_USER	((UT_NAMESIZE * 2) + 8)
@@ -84,17 +85,10 @@ static void _resolve_addr(char buf[], const char *host)
  */
 int audit_value_needs_encoding(const char *str, unsigned int size)
 {
-	unsigned int i;
-
 	if (str == NULL)
 		return 0;
 
-	for (i=0; i<size; i++) {
-		// we don't test for > 0x7f because str[] is signed.
-		if (str[i] == '"' || str[i] < 0x21 || str[i] == 0x7F)
-			return 1;
-	}
-	return 0;
+	return audit_escape_count(str, size, AUDIT_ESC_ENCODE) != 0;
 }
 
 /*
@@ -102,10 +96,6 @@ int audit_value_needs_encoding(const char *str, unsigned int size)
  */
 char *audit_encode_value(char *final, const char *buf, unsigned int size)
 {
-	unsigned int i;
-	char *ptr = final;
-	const char *hex = "0123456789ABCDEF";
-
 	if (final == NULL)
 		return NULL;
 
@@ -114,11 +104,8 @@ char *audit_encode_value(char *final, const char *buf, unsigned int size)
 		return final;
 	}
 
-	for (i=0; i<size; i++) {
-		*ptr++ = hex[(buf[i] & 0xF0)>>4]; /* Upper nibble */
-		*ptr++ = hex[buf[i] & 0x0F];      /* Lower nibble */
-	}
-	*ptr = 0;
+	audit_hex_encode(final, buf, size);
+	final[2 * size] = 0;
 	return final;
 }
 
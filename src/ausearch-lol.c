@@ -1,6 +1,6 @@
 /*
 * ausearch-lol.c - linked list of linked lists library
-* Copyright (c) 2008,2010,2014,2016,2019,2021 Red Hat Inc.
+* Copyright (c) 2008,2010,2014,2016,2019,2021,2026 Red Hat Inc.
 * All Rights Reserved.
 *
 * This software may be freely redistributed and/or modified under the
@@ -24,6 +24,7 @@
 
 #include "ausearch-lol.h"
 #include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
 #include <string.h>
 #include <stdio.h>
@@ -99,35 +100,6 @@ static void lol_append(lol *lo, llist *l)
 	}
 }
 
-static int str2event(char *s, event *e)
-{
-	char *ptr;
-
-	errno = 0;
-	e->sec = strtoul(s, NULL, 10);
-	if (errno || e->sec > (LONG_MAX - eoe_timeout -1))
-		return -1;
-	ptr = strchr(s, '.');
-	if (ptr) {
-		ptr++;
-		e->milli = strtoul(ptr, NULL, 10);
-		if (errno || e->milli > 999)
-			return -1;
-		s = ptr;
-	} else
-		e->milli = 0;
-
-	ptr = strchr(s, ':');
-	if (ptr) {
-		ptr++;
-		e->serial = strtoul(ptr, NULL, 10);
-		if (errno)
-			return -1;
-	} else
-		e->serial = 0;
-	return 0;
-}
-
 static int inline events_are_equal(event *e1, event *e2)
 {
 	if (!(e1->serial == e2->serial && e1->milli == e2->milli &&
@@ -162,89 +134,51 @@ static int compare_event_time(event *e1, event *e2)
 	return 0;
 }
 
-#ifndef HAVE_STRNDUPA
-#define strndupa(s, n)								\
-	({												\
-		const char *__old = (s);					\
-		size_t __len = strnlen (__old, (n));		\
-		char *__new = (char *) alloca(__len + 1);	\
-		__new[__len] = '\0';						\
-		(char *) memcpy (__new, __old, __len);		\
-	})
-#endif
-
 /*
  * This function will look at the line and pick out pieces of it.
  */
 static int extract_timestamp(const char *b, event *e)
 {
-	char *ptr, *tmp, *tnode, *ttype;
+	audit_stamp_t st;
+	char ttype[340];
+	int rc;
 
 	e->node = NULL;
-	if (*b == 'n')
-		tmp = strndupa(b, 340);
-	else
-		tmp = strndupa(b, 80);
-	ptr = audit_strsplit(tmp);
-	if (ptr) {
-		// Check to see if this is the node info
-		if (*ptr == 'n') {
-			tnode = ptr+5;
-			ptr = audit_strsplit(NULL);
-			if (ptr == NULL)
-				return 0;
-		} else
-			tnode = NULL;
-
-		// at this point we have type=
-		ttype = ptr+5;
-
-		// Now should be pointing to msg=
-		ptr = audit_strsplit(NULL);
-		// strlen is for fuzzers that make invalid lines
-		if (ptr && strnlen(ptr, 20) > 18) {
-			if (*(ptr+9) == '(')
-				ptr+=9;
-			else
-				ptr = strchr(ptr, '(');
-			if (ptr) {
-			// now we should be pointed at the timestamp
-				char *eptr;
-				ptr++;
-				eptr = strchr(ptr, ')');
-				if (eptr)
-					*eptr = 0;
-				if (str2event(ptr, e)) {
-					fprintf(stderr,
-					  "Error extracting time stamp (%s)\n",
-						ptr);
-					return 0;
-				} else if ((start_time && e->sec < start_time)
-					|| (end_time && e->sec > end_time)) {
-					if (very_first_event.sec == 0) {
-						very_first_event.sec = e->sec;
-						very_first_event.milli = e->milli;
-					}
-					return 0;
-				} else {
-					// If no start time, any event is 1st
-					if (very_first_event.sec == 0 &&
-							start_time == 0) {
-						very_first_event.sec = e->sec;
-						very_first_event.milli = e->milli;
-					}
-					if (tnode)
-						e->node = strdup(tnode);
-					e->type = audit_name_to_msg_type(ttype);
-				}
-				return 1;
-			}
-			// else we have a bad line
+	rc = audit_parse_stamp(b, SIZE_MAX, LONG_MAX - eoe_timeout - 1, &st);
+	if (rc < 0) {
+		fprintf(stderr, "Error extracting time stamp (%.*s)\n",
+			(int)st.stamp_len, st.stamp);
+		return 0;
+	} else if (rc)
+		return 0;	// else we have a bad line
+
+	e->sec = st.sec;
+	e->milli = st.milli;
+	e->serial = st.serial;
+	if ((start_time && e->sec < start_time)
+			|| (end_time && e->sec > end_time)) {
+		if (very_first_event.sec == 0) {
+			very_first_event.sec = e->sec;
+			very_first_event.milli = e->milli;
 		}
-		// else we have a bad line
+		return 0;
 	}
-	// else we have a bad line
-	return 0;
+
+	// If no start time, any event is 1st
+	if (very_first_event.sec == 0 && start_time == 0) {
+		very_first_event.sec = e->sec;
+		very_first_event.milli = e->milli;
+	}
+	if (st.node)
+		e->node = strndup(st.node, st.node_len);
+	if (st.type) {
+		// The header never runs past 340 bytes
+		memcpy(ttype, st.type, st.type_len);
+		ttype[st.type_len] = 0;
+		e->type = audit_name_to_msg_type(ttype);
+	} else
+		e->type = -1;
+	return 1;
 }
 
 // This function will check events to see if they are complete
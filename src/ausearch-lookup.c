@@ -1,6 +1,6 @@
 /*
 * ausearch-lookup.c - Lookup values to something more readable
-* Copyright (c) 2005-06,2011-12,2015-17 Red Hat Inc.
+* Copyright (c) 2005-06,2011-12,2015-17,2026 Red Hat Inc.
 * All Rights Reserved. 
 *
 * This software may be freely redistributed and/or modified under the
@@ -32,6 +32,7 @@
 #include "ausearch-options.h"
 #include "ausearch-nvpair.h"
 #include "auparse-idata.h"
+#include "common.h"
 
 static int interp_init = 0;
 static auparse_state_t *au = NULL;
@@ -277,30 +278,10 @@ static int is_hex_string(const char *str)
 	}
 	return 1;
 }
-/*
- * This function will take a pointer to a 2 byte Ascii character buffer and 
- * return the actual hex value.
- */
-static unsigned char x2c(unsigned char *buf)
-{
-	static const char AsciiArray[17] = "0123456789ABCDEF";
-	char *ptr;
-	unsigned char total=0;
-
-	ptr = strchr(AsciiArray, (char)toupper(buf[0]));
-	if (ptr)
-		total = (unsigned char)(((ptr-AsciiArray) & 0x0F)<<4);
-	ptr = strchr(AsciiArray, (char)toupper(buf[1]));
-	if (ptr)
-		total += (unsigned char)((ptr-AsciiArray) & 0x0F);
-
-	return total;
-}
-
 /* returns a freshly malloc'ed and converted buffer */
 char *unescape(const char *buf)
 {
-	int len, i;
+	int len;
 	char *str, *strptr;
 	const char *ptr = buf;
 
@@ -335,26 +316,11 @@ char *unescape(const char *buf)
 		free(str);
 		return NULL;
 	}
-	strptr = str;
-	for (i=0; i<len; i+=2) {
-		*strptr = x2c((unsigned char *)&str[i]);
-		strptr++;
-	}
+	strptr = str + audit_hex_decode(str, str, len);
 	*strptr = 0;
 	return str;
 }
 
-static int need_tty_escape(const unsigned char *s, unsigned int len)
-{
-	unsigned int i = 0;
-	while (i < len) {
-		if (s[i] < 32)
-			return 1;
-		i++;
-	}
-	return 0;
-}
-
 static void tty_escape(const char *s, unsigned int len)
 {
 	unsigned int i = 0;
@@ -371,19 +337,6 @@ static void tty_escape(const char *s, unsigned int len)
 }
 
 static const char sh_set[] = "\"'`$\\!()| ";
-static unsigned int need_shell_escape(const char *s, unsigned int len)
-{
-	unsigned int i = 0, cnt = 0;
-	while (i < len) {
-		if (s[i] < 32)
-			cnt++;
-		else if (strchr(sh_set, s[i]))
-			cnt++;
-		i++;
-	}
-	return cnt;
-}
-
 static void shell_escape(const char *s, unsigned int len)
 {
 	unsigned int i = 0;
@@ -403,19 +356,6 @@ static void shell_escape(const char *s, unsigned int len)
 }
 
 static const char quote_set[] = "\"'`$\\!()| ;#&*?[]<>{}";
-static unsigned int need_shell_quote_escape(const unsigned char *s, unsigned int len)
-{
-	unsigned int i = 0, cnt = 0;
-	while (i < len) {
-		if (s[i] < 32)
-			cnt++;
-		else if (strchr(quote_set, s[i]))
-			cnt++;
-		i++;
-	}
-	return cnt;
-}
-
 static void shell_quote_escape(const char *s, unsigned int len)
 {
 	unsigned int i = 0;
@@ -441,11 +381,12 @@ static unsigned int need_escaping(const char *s, unsigned int len)
 		case AUPARSE_ESC_RAW:
 			break;
 		case AUPARSE_ESC_TTY:
-			return need_tty_escape(s, len);
+			return audit_escape_count(s, len, AUDIT_ESC_CTRL);
 		case AUPARSE_ESC_SHELL:
-			return need_shell_escape(s, len);
+			return audit_escape_count(s, len, AUDIT_ESC_SHELL);
 		case AUPARSE_ESC_SHELL_QUOTE:
-			return need_shell_quote_escape(s, len);
+			return audit_escape_count(s, len,
+						  AUDIT_ESC_SHELL_QUOTE);
 	}
 	return 0;
 }
@@ -1,6 +1,6 @@
 /*
  * aulast.c - A last program based on audit logs 
- * Copyright (c) 2008-2009,2011,2016 Red Hat Inc., Durham, North Carolina.
+ * Copyright (c) 2008-2009,2011,2016,2026 Red Hat Inc., Durham, North Carolina.
  * All Rights Reserved.
  *
  * This software may be freely redistributed and/or modified under the
@@ -155,6 +155,14 @@ no_end:
 	}
 }
 
+/* The only records and fields the report is made from */
+static const int proj_types[] = { AUDIT_LOGIN, AUDIT_USER_LOGIN,
+	AUDIT_USER_END, AUDIT_SYSTEM_BOOT, AUDIT_SYSTEM_SHUTDOWN,
+	AUDIT_DAEMON_START, 0 };
+static const char *proj_fields[] = { "pid", "auid", "old-auid", "ses",
+	"old-ses", "uid", "id", "hostname", "addr", "terminal", "res", "acct",
+	"kernel", NULL };
+
 static void extract_record(auparse_state_t *au)
 {
 	if (f == NULL)
@@ -553,6 +561,11 @@ int main(int argc, char *argv[])
 		fprintf(stderr, "Error - %s\n", strerror(errno));
 		goto error_exit_1;
 	}
+	if (auparse_set_projection(au, proj_types, proj_fields)) {
+		fprintf(stderr, "Error - %s\n", strerror(errno));
+		auparse_destroy(au);
+		goto error_exit_1;
+	}
 
 	// The theory: iterate though events
 	// 1) when LOGIN is found, create a new session node
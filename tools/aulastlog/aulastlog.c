@@ -1,6 +1,6 @@
 /*
  * aulastlog.c - A lastlog program based on audit logs 
- * Copyright (c) 2008-2009,2011 Red Hat Inc., Durham, North Carolina.
+ * Copyright (c) 2008-2009,2011,2026 Red Hat Inc., Durham, North Carolina.
  * All Rights Reserved.
  *
  * This software may be freely redistributed and/or modified under the
@@ -27,9 +27,15 @@
 #include <string.h>
 #include <errno.h>
 #include <pwd.h>
+#include "libaudit.h"
 #include "auparse.h"
 #include "aulastlog-llist.h"
 
+/* A successful login is all the report needs */
+static const int proj_types[] = { AUDIT_USER_LOGIN, 0 };
+static const char *proj_fields[] = { "type", "res", "auid", "hostname",
+	"terminal", NULL };
+
 static void usage(void)
 {
 	fprintf(stderr, "usage: aulastlog [--stdin] [--user name]\n");
@@ -95,6 +101,10 @@ int main(int argc, char *argv[])
 		printf("Error - %s\n", strerror(errno));
 		goto error_exit_1;
 	}
+	if (auparse_set_projection(au, proj_types, proj_fields)) {
+		printf("auparse_set_projection error - %s\n", strerror(errno));
+		goto error_exit_2;
+	}
 	if (ausearch_add_item(au, "type", "=", "USER_LOGIN",
 						 AUSEARCH_RULE_CLEAR)){
 		printf("ausearch_add_item error - %s\n", strerror(errno));